@@ -47,4 +47,11 @@ set(VTK_OPT # whether to use VTK
         "OFF"
         CACHE BOOL "Choose whether to use VTK or not")
 
+set(DTK_MIXED_PRECISION_OPT # whether to store batched data in float
+        "OFF"
+        CACHE BOOL "Choose whether to define DTK_MIXED_PRECISION or not")
+
 # Add global definitions to project
+if (DTK_MIXED_PRECISION_OPT)
+    add_compile_definitions(DTK_MIXED_PRECISION)
+endif ()
@@ -32,12 +32,12 @@ namespace dtk {
 // 两个图元进行相交测试
 bool dtkCollisionDetectBasic::DoIntersect(dtkCollisionDetectPrimitive *pri_1,
                                           dtkCollisionDetectPrimitive *pri_2,
-                                          IntersectResult::Ptr &result,
+                                          IntersectResult &result,
                                           bool self, bool ignore_extend) {
   if (self) // 自交
   {
-    for (dtkID i = 0; i < pri_1->mIDs.size(); i++) {
-      for (dtkID j = 0; j < pri_2->mIDs.size(); j++) {
+    for (dtkID i = 0; i < pri_1->GetNumberOfPoints(); i++) {
+      for (dtkID j = 0; j < pri_2->GetNumberOfPoints(); j++) {
         if (pri_1->mIDs[i] == pri_2->mIDs[j]) {
           return false;
         }
@@ -118,11 +118,11 @@ bool dtkCollisionDetectBasic::DoIntersect(dtkCollisionDetectPrimitive *pri_1,
 
   if (intersected) {
     if (exchanged) {
-      result->SetProperty(dtkIntersectTest::INTERSECT_PRIMITIVE_2, pri_1);
-      result->SetProperty(dtkIntersectTest::INTERSECT_PRIMITIVE_1, pri_2);
+      result.primitive_2 = pri_1;
+      result.primitive_1 = pri_2;
     } else {
-      result->SetProperty(dtkIntersectTest::INTERSECT_PRIMITIVE_1, pri_1);
-      result->SetProperty(dtkIntersectTest::INTERSECT_PRIMITIVE_2, pri_2);
+      result.primitive_1 = pri_1;
+      result.primitive_2 = pri_2;
     }
     pri_1->SetIntersected(true);
     pri_2->SetIntersected(true);
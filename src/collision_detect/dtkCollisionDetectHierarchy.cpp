@@ -20,6 +20,8 @@
 #ifdef DTKCOLLISIONDETECTHIERARCHY_DEBUG
 #include <iostream>
 #endif
+#include <algorithm>
+#include <new>
 #include <set>
 
 #ifdef DTK_TBB
@@ -27,12 +29,20 @@
 using namespace tbb;
 #endif
 
+#include <boost/bind/bind.hpp>
+
 #include "dtkCollisionDetectHierarchy.h"
 
 using namespace std;
 using namespace boost;
+using namespace boost::placeholders;
 
 namespace dtk {
+// 每个子任务更新的图元数, 图元数不超过它时不拆分.
+static const size_t primitive_grain_size = 512;
+// 图元内存块的最小容量.
+static const size_t primitive_block_size = 256;
+
 #ifdef DTK_TBB
 class ApplyUpdate {
 public:
@@ -54,35 +64,16 @@ private:
 };
 #endif
 
-void update(dtkID id, size_t numberOfThreads, barrier *enter_barrier,
-            barrier *exit_barrier, bool *running,
-            std::vector<dtkCollisionDetectPrimitive *> *primitives) {
-  do {
-    enter_barrier->wait();
-
-    if (!(*running))
-      break;
-
-    for (dtkID i = id; i < (dtkID)primitives->size(); i = i + numberOfThreads) {
-      (*primitives)[i]->Update();
-    }
-
-    exit_barrier->wait();
-  } while (true);
-}
-
 dtkCollisionDetectHierarchy::dtkCollisionDetectHierarchy() {
 #ifdef DTKCOLLISIONDETECTHIERARCHY_DEBUG
   cout << "[dtkCollisionDetectHierarchy::dtkCollisionDetectHierarchy]" << endl;
 #endif
-  mRoot = 0;
+  mBlockCapacity = 0;
+  mBlockUsed = 0;
   mOrigin = GK::Point3(0, 0, 0);
   mMaxLevel = -1;
-
-  mNumberOfThreads = 0;
-  mThreadGroup = 0;
-  mEnterBarrier = 0;
-  mExitBarrier = 0;
+  mSleeping = false;
+  mSleepRefitted = false;
 #ifdef DTKCOLLISIONDETECTHIERARCHY_DEBUG
   cout << "[/dtkCollisionDetectHierarchy::dtkCollisionDetectHierarchy]" << endl;
   cout << endl;
@@ -93,24 +84,11 @@ dtkCollisionDetectHierarchy::~dtkCollisionDetectHierarchy() {
 #ifdef DTKCOLLISIONDETECTHIERARCHY_DEBUG
   cout << "[dtkCollisionDetectHierarchy::~dtkCollisionDetectHierarchy]" << endl;
 #endif
-  if (mNumberOfThreads > 0) {
-    mLive = false;
-    mEnterBarrier->wait();
-    mThreadGroup->join_all();
-    delete mThreadGroup;
-    delete mEnterBarrier;
-    delete mExitBarrier;
-  }
-
-  if (mRoot != 0)
-    delete mRoot;
-
-  for (dtkID i = 0; i < GetNumberOfPrimitives(); i++) {
-#ifdef DTKCOLLISIONDETECTHIERARCHY_DEBUG
-    cout << "delete mPrimitives[" << i << "]" << endl;
-#endif
-    delete mPrimitives[i];
-  }
+  // 图元在块中原位构造, 逐个析构后整块释放.
+  for (dtkID i = 0; i < GetNumberOfPrimitives(); i++)
+    mPrimitives[i]->~Primitive();
+  for (dtkID i = 0; i < mPrimitiveBlocks.size(); i++)
+    ::operator delete(mPrimitiveBlocks[i]);
 #ifdef DTKCOLLISIONDETECTHIERARCHY_DEBUG
   cout << "[/dtkCollisionDetectHierarchy::~dtkCollisionDetectHierarchy]"
        << endl;
@@ -118,47 +96,54 @@ dtkCollisionDetectHierarchy::~dtkCollisionDetectHierarchy() {
 #endif
 }
 
-void dtkCollisionDetectHierarchy::SetNumberOfThreads(size_t n) {
-  if (n <= 0)
+void dtkCollisionDetectHierarchy::ReservePrimitives(size_t num) {
+  mPrimitives.reserve(mPrimitives.size() + num);
+  if (mBlockCapacity - mBlockUsed >= num)
     return;
-  mNumberOfThreads = n;
-  mLive = true;
-  mThreadGroup = new thread_group();
-  mEnterBarrier = new barrier(mNumberOfThreads + 1);
-  mExitBarrier = new barrier(mNumberOfThreads + 1);
-  for (dtkID i = 0; i < mNumberOfThreads; i++) {
-    mThreadGroup->add_thread(new boost::thread(update, i, mNumberOfThreads,
-                                        mEnterBarrier, mExitBarrier, &mLive,
-                                        &mPrimitives));
-  }
+  // 剩余空间不足时直接换一块, 保证这批图元连续.
+  mPrimitiveBlocks.push_back(
+      static_cast<Primitive *>(::operator new(sizeof(Primitive) * num)));
+  mBlockCapacity = num;
+  mBlockUsed = 0;
 }
 
-void dtkCollisionDetectHierarchy::AddPrimitive(Primitive *primitive) {
+dtkCollisionDetectPrimitive *dtkCollisionDetectHierarchy::NewPrimitive() {
+  if (mBlockUsed == mBlockCapacity)
+    ReservePrimitives(max(primitive_block_size, mPrimitives.size()));
+  return mPrimitiveBlocks.back() + mBlockUsed++;
+}
+
+void dtkCollisionDetectHierarchy::AddPrimitive(Primitive *primitive,
+                                               dtkPoints::Ptr pts) {
+  if (find(mPointSets.begin(), mPointSets.end(), pts) == mPointSets.end())
+    mPointSets.push_back(pts);
   primitive->mLocalID = (int)mPrimitives.size();
   mPrimitives.push_back(primitive);
 }
 
 dtkCollisionDetectPrimitive *
 dtkCollisionDetectHierarchy::InsertTriangle(dtkPoints::Ptr pts, dtkID3 ids) {
-  Primitive *primitive = new Primitive(dtkCollisionDetectPrimitive::TRIANGLE,
-                                       pts, ids[0], ids[1], ids[2]);
-  AddPrimitive(primitive);
+  Primitive *primitive =
+      new (NewPrimitive()) Primitive(dtkCollisionDetectPrimitive::TRIANGLE,
+                                     pts.get(), ids[0], ids[1], ids[2]);
+  AddPrimitive(primitive, pts);
   return primitive;
 }
 
 dtkCollisionDetectPrimitive *
 dtkCollisionDetectHierarchy::InsertSegment(dtkPoints::Ptr pts, dtkID2 ids) {
   Primitive *primitive =
-      new Primitive(dtkCollisionDetectPrimitive::SEGMENT, pts, ids[0], ids[1]);
-  AddPrimitive(primitive);
+      new (NewPrimitive()) Primitive(dtkCollisionDetectPrimitive::SEGMENT,
+                                     pts.get(), ids[0], ids[1]);
+  AddPrimitive(primitive, pts);
   return primitive;
 }
 
 dtkCollisionDetectPrimitive *
 dtkCollisionDetectHierarchy::InsertSphere(dtkPoints::Ptr pts, dtkID id) {
-  Primitive *primitive =
-      new Primitive(dtkCollisionDetectPrimitive::SPHERE, pts, id);
-  AddPrimitive(primitive);
+  Primitive *primitive = new (NewPrimitive())
+      Primitive(dtkCollisionDetectPrimitive::SPHERE, pts.get(), id);
+  AddPrimitive(primitive, pts);
   return primitive;
 }
 
@@ -167,6 +152,7 @@ void dtkCollisionDetectHierarchy::InsertTriangleMesh(
   triMesh->Rebuild();
   dtkPoints::Ptr pts = triMesh->GetPoints();
   const std::vector<dtkID3> &ecTable = triMesh->GetECTable();
+  ReservePrimitives(ecTable.size());
   Primitive *primitive = 0;
   for (dtkID i = 0; i < ecTable.size(); i++) /* 对每个三角形 */
   {
@@ -187,6 +173,11 @@ void dtkCollisionDetectHierarchy::InsertTetraMesh(
   dtkPoints::Ptr pts = tetraMesh->GetPoints();
   const std::vector<dtkID4> &ecTable = tetraMesh->GetECTable();
   std::vector<dtkID> b2fTable = tetraMesh->GetB2FTable();
+  // 边界面各属于一个四面体, 内部面被两个四面体共用.
+  if (opt == SURFACE)
+    ReservePrimitives(b2fTable.size());
+  else
+    ReservePrimitives((ecTable.size() * 4 - b2fTable.size()) / 2);
   Primitive *primitive = 0;
   std::set<dtkID3> tempFaceSet;
   std::set<dtkID3>::iterator setIt;
@@ -227,7 +218,7 @@ void dtkCollisionDetectHierarchy::InsertTetraMesh(
 }
 
 void dtkCollisionDetectHierarchy::UpdateAllPrimitives() {
-  if (mNumberOfThreads > 0)
+  if (mScheduler && mPrimitives.size() > primitive_grain_size)
     _UpdateAllPrimitives_mt();
   else
     _UpdateAllPrimitives_s();
@@ -256,10 +247,11 @@ void dtkCollisionDetectHierarchy::_UpdateAllPrimitives_mt() {
   parallel_for(blocked_range<size_t>(0, mPrimitives.size()),
                ApplyUpdate(&mPrimitives[0]), ap);
 #else
-  // boost thread
-
-  mEnterBarrier->wait();
-  mExitBarrier->wait();
+  // 分块交给共用的调度器, 在核心的任务中调用时嵌套执行.
+  mScheduler->ForkJoinRange(
+      mPrimitives.size(), primitive_grain_size,
+      boost::bind(&dtkCollisionDetectHierarchy::_UpdatePrimitiveRange, this,
+                  _1, _2));
 #endif
 
 #ifdef DTKCOLLISIONDETECTHIERARCHY_DEBUG
@@ -268,6 +260,12 @@ void dtkCollisionDetectHierarchy::_UpdateAllPrimitives_mt() {
 #endif
 }
 
+void dtkCollisionDetectHierarchy::_UpdatePrimitiveRange(dtkID begin,
+                                                        dtkID end) {
+  for (dtkID i = begin; i < end; i++)
+    mPrimitives[i]->Update();
+}
+
 size_t dtkCollisionDetectHierarchy::GetNumberOfIntersectedPrimitives() const {
   size_t num = 0;
   for (dtkID i = 0; i < mPrimitives.size(); i++) {
@@ -59,14 +59,26 @@ void dtkCollisionDetectHierarchyKDOPS::Build() {
 #ifdef DTKCOLLISIONDETECTHIERARCHYKDOPS_DEBUG
   cout << "[dtkCollisionDetectHierarchyKDOPS::Build]" << endl;
 #endif
-  mRoot = new dtkCollisionDetectNodeKDOPS(this, mHalfK);
-  mRoot->SetMaxLevel(mMaxLevel);
-  AddNode(mRoot);
-
-  for (dtkID i = 0; i < mPrimitives.size(); i++)
-    mRoot->AddPrimitive(i);
-
-  mRoot->Split();
+  size_t numOfPrimitives = mPrimitives.size();
+  mPrimitiveOrder.resize(numOfPrimitives);
+  for (dtkID i = 0; i < numOfPrimitives; i++)
+    mPrimitiveOrder[i] = i;
+
+  // 每个叶结点至少一个图元, 结点数不超过 2n - 1, 划分时数组不会重新分配.
+  mNodeArray.clear();
+  mNodeArray.reserve(numOfPrimitives > 0 ? numOfPrimitives * 2 - 1 : 1);
+  mNodeArray.push_back(dtkCollisionDetectNodeKDOPS(this, mHalfK));
+  mNodeArray[0].SetMaxLevel(mMaxLevel);
+  mNodeArray[0].mEnd = numOfPrimitives;
+
+  // 按数组顺序划分, 新的子结点追加在末尾, 得到广度优先的布局.
+  for (dtkID i = 0; i < mNodeArray.size(); i++) {
+    mNodeArray[i].Split();
+    if (!mNodeArray[i].IsLeaf()) {
+      mNodeArray[mNodeArray[i].mFirstChild].mParent = i;
+      mNodeArray[mNodeArray[i].mFirstChild + 1].mParent = i;
+    }
+  }
 #ifdef DTKCOLLISIONDETECTHIERARCHYKDOPS_DEBUG
   cout << "[/dtkCollisionDetectHierarchyKDOPS::Build]" << endl;
   cout << endl;
@@ -77,13 +89,20 @@ void dtkCollisionDetectHierarchyKDOPS::Update() {
 #ifdef DTKCOLLISIONDETECTHIERARCHYKDOPS_DEBUG
   cout << "[dtkCollisionDetectHierarchyKDOPS::Update]" << endl;
 #endif
+  if (mSleeping && mSleepRefitted)
+    return;
+  mSleepRefitted = mSleeping;
+
   UpdateAllPrimitives(); // 更新所有图元
 
-  size_t numOfNodes = mNodes.size();
+  // 子结点总在父结点之后, 逆序遍历即自底向上.
+  size_t numOfNodes = mNodeArray.size();
   for (int i = numOfNodes - 1; i > -1; i--)
-    static_cast<dtkCollisionDetectNodeKDOPS *>(mNodes[i])->Update();
+    mNodeArray[i].Update();
 
-  const GK::KDOP &kdop = ((dtkCollisionDetectNodeKDOPS *)mRoot)->GetKDOP();
+  if (numOfNodes == 0)
+    return;
+  const GK::KDOP &kdop = mNodeArray[0].GetKDOP();
 
   mBox = GK::BBox3(kdop[0], kdop[2], kdop[4], kdop[1], kdop[3], kdop[5]);
 
@@ -95,11 +114,7 @@ void dtkCollisionDetectHierarchyKDOPS::Update() {
 }
 
 void dtkCollisionDetectHierarchyKDOPS::Rebuild() {
-  if (mRoot != 0)
-    delete mRoot;
-
-  mNodes.clear();
-
+  // Build 清空结点数组并复用其容量.
   Build();
 }
 } // namespace dtk
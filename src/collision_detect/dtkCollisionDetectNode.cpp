@@ -34,6 +34,10 @@ dtkCollisionDetectNode::dtkCollisionDetectNode(
   cout << endl;
 #endif
   mHierarchy = father;
+  mParent = dtkErrorID;
+  mFirstChild = dtkErrorID;
+  mBegin = 0;
+  mEnd = 0;
   mLeaf = true;
   mLevel = 0;
 
@@ -46,12 +50,63 @@ dtkCollisionDetectNode::~dtkCollisionDetectNode() {
   cout << "[/dtkCollisionDetectNode::~dtkCollisionDetectNode]" << endl;
   cout << endl;
 #endif
-  for (dtkID i = 0; i < GetNumOfChildren(); i++) {
-    delete mChildren[i];
+}
+
+void dtkCollisionDetectNode::AddPrimitive(dtkID id) {
+  // 插入到本结点图元段末尾, 之后的结点整体后移.
+  dtkID pos = mEnd;
+  std::vector<dtkID> &order = mHierarchy->mPrimitiveOrder;
+  order.insert(order.begin() + pos, id);
+  for (dtkID i = 0; i < mHierarchy->GetNumberOfNodes(); i++) {
+    dtkCollisionDetectNode *node = mHierarchy->GetNode(i);
+    if (node->mBegin >= pos) {
+      node->mBegin++;
+      node->mEnd++;
+    }
+  }
+  // 本结点与祖先结点包含插入位置: 被误移的起点退回, 其余扩展终点.
+  for (dtkCollisionDetectNode *node = this; node != 0;
+       node = node->GetParent()) {
+    if (node->mBegin > pos)
+      node->mBegin--;
+    else
+      node->mEnd++;
+  }
+}
+
+void dtkCollisionDetectNode::DeletePrimitive(
+    dtkCollisionDetectPrimitive *primitive) {
+  primitive->mActive = false;
+  std::vector<dtkID> &order = mHierarchy->mPrimitiveOrder;
+  std::vector<dtkID>::iterator it;
+  it = std::find(order.begin() + mBegin, order.begin() + mEnd,
+                 dtkID(primitive->mLocalID));
+  assert(it != order.begin() + mEnd);
+  dtkID pos = dtkID(it - order.begin());
+  order.erase(it);
+  for (dtkID i = 0; i < mHierarchy->GetNumberOfNodes(); i++) {
+    dtkCollisionDetectNode *node = mHierarchy->GetNode(i);
+    if (node->mBegin > pos) {
+      node->mBegin--;
+      node->mEnd--;
+    }
   }
+  for (dtkCollisionDetectNode *node = this; node != 0;
+       node = node->GetParent())
+    node->mEnd--;
 }
 
 dtkCollisionDetectPrimitive *dtkCollisionDetectNode::GetPrimitive(dtkID id) {
-  return mHierarchy->GetPrimitive(mPrimitiveIDs[id]);
+  return mHierarchy->GetPrimitive(mHierarchy->mPrimitiveOrder[mBegin + id]);
+}
+
+dtkCollisionDetectNode *dtkCollisionDetectNode::GetChild(size_t id) {
+  return mHierarchy->GetNode(mFirstChild + id);
+}
+
+dtkCollisionDetectNode *dtkCollisionDetectNode::GetParent() {
+  if (mParent == dtkErrorID)
+    return 0;
+  return mHierarchy->GetNode(mParent);
 }
 } // namespace dtk
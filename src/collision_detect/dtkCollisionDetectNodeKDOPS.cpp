@@ -69,69 +69,62 @@ void dtkCollisionDetectNodeKDOPS::Split() {
     return;
   }
 
-#ifdef DTKCOLLISIONDETECTNODEKDOPS_DEBUG
-  cout << "Creating two children..." << endl;
-#endif
-
-  // Creating two children
-  dtkCollisionDetectNodeKDOPS *leftChild =
-      new dtkCollisionDetectNodeKDOPS(mHierarchy, mKDOP.mHalfK);
-  leftChild->mLevel = mLevel + 1;
-  leftChild->mMaxLevel = mMaxLevel;
-  dtkCollisionDetectNodeKDOPS *rightChild =
-      new dtkCollisionDetectNodeKDOPS(mHierarchy, mKDOP.mHalfK);
-  rightChild->mLevel = mLevel + 1;
-  rightChild->mMaxLevel = mMaxLevel;
-
-  mChildren.push_back(leftChild);
-  mChildren.push_back(rightChild);
-
-  SplitRule();
+  dtkID middle = SplitRule();
 
   // 检测划分是否成功。
-
-  for (dtkID i = 0; i < GetNumOfChildren(); i++) {
-    if (mChildren[i]->GetNumOfPrimitives() < 1) {
-      for (dtkID j = 0; j < GetNumOfChildren(); j++) {
-        delete mChildren[j];
-      }
-      mChildren.clear();
-
+  if (middle == mBegin || middle == mEnd) {
 #ifdef DTKCOLLISIONDETECTNODEKDOPS_DEBUG
-      cout << "Split failed." << endl;
-      cout << "[/dtkCollisionDetectNodeKDOPS::Split]" << endl;
-      cout << endl;
+    cout << "Split failed." << endl;
+    cout << "[/dtkCollisionDetectNodeKDOPS::Split]" << endl;
+    cout << endl;
 #endif
-      return;
-    }
+    return;
   }
 
 #ifdef DTKCOLLISIONDETECTNODEKDOPS_DEBUG
-  cout << "... Succeed." << endl;
+  cout << "Creating two children..." << endl;
 #endif
-  mHierarchy->AddNode(leftChild);
-  mHierarchy->AddNode(rightChild);
-  // recursive split
-  leftChild->Split();
-  rightChild->Split();
 
+  // Creating two children
+  dtkCollisionDetectNodeKDOPS leftChild(mHierarchy, mKDOP.mHalfK);
+  leftChild.mLevel = mLevel + 1;
+  leftChild.mMaxLevel = mMaxLevel;
+  leftChild.mBegin = mBegin;
+  leftChild.mEnd = middle;
+  dtkCollisionDetectNodeKDOPS rightChild(mHierarchy, mKDOP.mHalfK);
+  rightChild.mLevel = mLevel + 1;
+  rightChild.mMaxLevel = mMaxLevel;
+  rightChild.mBegin = middle;
+  rightChild.mEnd = mEnd;
+
+  // 追加子结点后不再访问本结点.
+  std::vector<dtkCollisionDetectNodeKDOPS> &nodes =
+      static_cast<dtkCollisionDetectHierarchyKDOPS *>(mHierarchy)->mNodeArray;
+  mFirstChild = nodes.size();
   mLeaf = false;
+  nodes.push_back(leftChild);
+  nodes.push_back(rightChild);
 #ifdef DTKCOLLISIONDETECTNODEKDOPS_DEBUG
+  cout << "... Succeed." << endl;
   cout << "[/dtkCollisionDetectNodeKDOPS::Split]" << endl;
   cout << endl;
 #endif
 }
 
-void dtkCollisionDetectNodeKDOPS::SplitRule() {
+dtkID dtkCollisionDetectNodeKDOPS::SplitRule() {
+  dtkCollisionDetectHierarchyKDOPS *hierarchy =
+      static_cast<dtkCollisionDetectHierarchyKDOPS *>(mHierarchy);
+  dtkID *ids = &hierarchy->mPrimitiveOrder[0];
+
   // split primitive
   // choose split axis
   double mean[] = {0.0, 0.0, 0.0};
   double variance[] = {0.0, 0.0, 0.0};
 
   size_t numOfPrimitives = GetNumOfPrimitives();
-  for (dtkID i = 0; i < numOfPrimitives; i++) {
+  for (dtkID i = mBegin; i < mEnd; i++) {
     const GK::Point3 &centroid =
-        mHierarchy->GetPrimitive(mPrimitiveIDs[i])->GetCentroid();
+        hierarchy->GetPrimitive(ids[i])->GetCentroid();
 
     for (dtkID j = 0; j < 3; j++)
       mean[j] += centroid[j];
@@ -139,9 +132,9 @@ void dtkCollisionDetectNodeKDOPS::SplitRule() {
   for (dtkID j = 0; j < 3; j++)
     mean[j] /= numOfPrimitives;
 
-  for (dtkID i = 0; i < numOfPrimitives; i++) {
+  for (dtkID i = mBegin; i < mEnd; i++) {
     const GK::Point3 &centroid =
-        mHierarchy->GetPrimitive(mPrimitiveIDs[i])->GetCentroid();
+        hierarchy->GetPrimitive(ids[i])->GetCentroid();
 
     for (dtkID j = 0; j < 3; j++)
       variance[j] += pow(centroid[j] - mean[j], 2);
@@ -163,17 +156,21 @@ void dtkCollisionDetectNodeKDOPS::SplitRule() {
   // choose split point
   double splitPoint = mean[chooseAxis];
 
-  // split
-  assert(mChildren.size() == 2);
-  for (dtkID i = 0; i < numOfPrimitives; i++) {
+  // split, 左分支原位前移, 右分支暂存后接在其后, 两边都保持原有顺序.
+  std::vector<dtkID> &rightIDs = hierarchy->mSplitBuffer;
+  rightIDs.clear();
+  dtkID middle = mBegin;
+  for (dtkID i = mBegin; i < mEnd; i++) {
     const GK::Point3 &centroid =
-        mHierarchy->GetPrimitive(mPrimitiveIDs[i])->GetCentroid();
+        hierarchy->GetPrimitive(ids[i])->GetCentroid();
 
     if (centroid[chooseAxis] < splitPoint)
-      mChildren[0]->AddPrimitive(mPrimitiveIDs[i]);
+      ids[middle++] = ids[i];
     else
-      mChildren[1]->AddPrimitive(mPrimitiveIDs[i]);
+      rightIDs.push_back(ids[i]);
   }
+  std::copy(rightIDs.begin(), rightIDs.end(), ids + middle);
+  return middle;
 }
 
 void dtkCollisionDetectNodeKDOPS::Update() {
@@ -198,18 +195,15 @@ void dtkCollisionDetectNodeKDOPS::Update() {
         mKDOP.mIntervals[k][0] = mKDOP.mIntervals[k][1] = extend;
     }
     */
-    for (dtkID k = 0; k < mKDOP.mHalfK; k++) {
-      // 包围盒每一维设置上下限
-
-      mKDOP.mIntervals[k][0] = dtkDoubleMax;
-      mKDOP.mIntervals[k][1] = dtkDoubleMin;
-    }
+    // 包围盒每一维设置上下限
+    mKDOP.Reset();
 
-    size_t numOfPrimitives = GetNumOfPrimitives();
-    const GK::Point3 &origin = mHierarchy->GetOrigin();
-    for (dtkID i = 0; i < numOfPrimitives; i++) {
+    dtkCollisionDetectHierarchyKDOPS *hierarchy =
+        static_cast<dtkCollisionDetectHierarchyKDOPS *>(mHierarchy);
+    const GK::Point3 &origin = hierarchy->GetOrigin();
+    for (dtkID i = mBegin; i < mEnd; i++) {
       dtkCollisionDetectPrimitive *primitive =
-          mHierarchy->GetPrimitive(mPrimitiveIDs[i]);
+          hierarchy->GetPrimitive(hierarchy->mPrimitiveOrder[i]);
       size_t numOfPoints = primitive->GetNumberOfPoints();
       for (dtkID j = 0; j < numOfPoints; j++) {
         const GK::Point3 &point = primitive->GetPoint(j);
@@ -219,7 +213,7 @@ void dtkCollisionDetectNodeKDOPS::Update() {
             GK::Float extend =
                 GK::DotProduct(vec, GK::KDOP::mPredefinedAxis[k]);
 
-            mKDOP.mIntervals[k].Extend(extend);
+            mKDOP.Extend(k, extend);
             // mKDOP.mIntervals[k].Extend( extend + primitive->GetExtend() );
             // mKDOP.mIntervals[k].Extend( extend - primitive->GetExtend() );
           }
@@ -227,7 +221,7 @@ void dtkCollisionDetectNodeKDOPS::Update() {
             GK::Float extend =
                 GK::DotProduct(vec, GK::KDOP::mPredefinedAxis[k + 4]);
 
-            mKDOP.mIntervals[k].Extend(extend);
+            mKDOP.Extend(k, extend);
             // mKDOP.mIntervals[k].Extend( extend + primitive->GetExtend() );
             // mKDOP.mIntervals[k].Extend( extend - primitive->GetExtend() );
           }
@@ -236,8 +230,8 @@ void dtkCollisionDetectNodeKDOPS::Update() {
             GK::Float extend =
                 GK::DotProduct(vec, GK::KDOP::mPredefinedAxis[k]);
 
-            mKDOP.mIntervals[k].Extend(extend + primitive->GetExtend());
-            mKDOP.mIntervals[k].Extend(extend - primitive->GetExtend());
+            mKDOP.Extend(k, extend + primitive->GetExtend());
+            mKDOP.Extend(k, extend - primitive->GetExtend());
           }
         }
       }
@@ -247,8 +241,9 @@ void dtkCollisionDetectNodeKDOPS::Update() {
 #endif
 
   } else { // 非叶节点
-    GK::Merge(mKDOP, ((dtkCollisionDetectNodeKDOPS *)mChildren[0])->mKDOP,
-              ((dtkCollisionDetectNodeKDOPS *)mChildren[1])->mKDOP);
+    const std::vector<dtkCollisionDetectNodeKDOPS> &nodes =
+        static_cast<dtkCollisionDetectHierarchyKDOPS *>(mHierarchy)->mNodeArray;
+    GK::Merge(mKDOP, nodes[mFirstChild].mKDOP, nodes[mFirstChild + 1].mKDOP);
   }
 #ifdef DTKCOLLISIONDETECTNODEKDOPS_DEBUG
   cout << mKDOP << endl;
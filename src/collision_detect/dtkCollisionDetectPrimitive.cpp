@@ -23,8 +23,7 @@ using namespace std;
 namespace dtk {
 // the object of behind pts is vertex list of objects.
 dtkCollisionDetectPrimitive::dtkCollisionDetectPrimitive(Type type,
-                                                         dtkPoints::Ptr pts,
-                                                         ...) {
+                                                         dtkPoints *pts, ...) {
   mType = type;
   mPts = pts;
   mModified = true;
@@ -50,7 +49,9 @@ dtkCollisionDetectPrimitive::dtkCollisionDetectPrimitive(Type type,
 
   va_start(arguments, pts);
   for (i = 0; i < mNumberOfPoints; i++)
-    mIDs.push_back(va_arg(arguments, dtkID));
+    mIDs[i] = va_arg(arguments, dtkID);
+  for (; i < 3; i++)
+    mIDs[i] = dtkErrorID;
   va_end(arguments);
 
   mExtend = 0;
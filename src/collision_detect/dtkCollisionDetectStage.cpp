@@ -22,51 +22,26 @@
 #endif
 #include <map>
 
+#include <boost/bind/bind.hpp>
+
 #include "dtkCollisionDetectStage.h"
 
 using namespace boost;
+using namespace boost::placeholders;
 using namespace std;
 
 namespace dtk {
 std::vector<std::pair<size_t, size_t>>
     dtkCollisionDetectStage::mPossibleIntersectPairIDs;
 
-void thread_update(dtkID id, size_t numberOfThreads, barrier *enter_barrier,
-                   barrier *exit_barrier, bool *running,
-                   std::vector<dtkCollisionDetectHierarchy::Ptr> *hierarchies) {
-  do {
-    enter_barrier->wait();
-
-    if (!(*running))
-      break;
-
-    for (dtkID i = id; i < hierarchies->size(); i = i + numberOfThreads) {
-#ifdef DTKCOLLISIONDETECTSTAGE_DEBUG
-      cout << "update: " << id << " - " << i << endl;
-#endif
-      (*hierarchies)[i]->Update();
-    }
-
-    exit_barrier->wait();
-  } while (true);
-}
-
 dtkCollisionDetectStage::dtkCollisionDetectStage() {
-  mNumberOfThreads = 0;
-  mThreadGroup = 0;
-  mEnterBarrier = 0;
-  mExitBarrier = 0;
+  mSplitDepth = 3;
+  mSplitThreshold = 100000;
 }
 
 dtkCollisionDetectStage::~dtkCollisionDetectStage() {
-  if (mNumberOfThreads > 0) {
-    mLive = false;
-    mEnterBarrier->wait();
-    mThreadGroup->join_all();
-    delete mThreadGroup;
-    delete mEnterBarrier;
-    delete mExitBarrier;
-  }
+  for (dtkID i = 0; i < mScratches.size(); i++)
+    delete mScratches[i];
 }
 
 const std::vector<dtkCollisionDetectStage::HierarchyPair> &
@@ -109,7 +84,7 @@ void dtkCollisionDetectStage::Update() {
 #endif
   mIntersectResults.clear();
 
-  if (mNumberOfThreads > 0)
+  if (mScheduler)
     _Update_mt();
   else
     _Update_s();
@@ -125,15 +100,15 @@ void dtkCollisionDetectStage::_Update_s() {
 }
 
 void dtkCollisionDetectStage::_Update_mt() {
-  for (dtkID i = 0; i < GetNumberOfHierarchies(); i++)
-    mHierarchies[i]->Update();
-
-  // multi_thread
+  mScheduler->ForkJoinRange(
+      GetNumberOfHierarchies(), 1,
+      boost::bind(&dtkCollisionDetectStage::_UpdateHierarchyRange, this, _1,
+                  _2));
+}
 
-  /*
-   * mEnterBarrier->wait();
-   * mExitBarrier->wait();
-   */
+void dtkCollisionDetectStage::_UpdateHierarchyRange(dtkID begin, dtkID end) {
+  for (dtkID i = begin; i < end; i++)
+    mHierarchies[i]->Update();
 }
 
 void dtkCollisionDetectStage::BoxIntersectCallBack(const Box &a, const Box &b) {
@@ -142,21 +117,105 @@ void dtkCollisionDetectStage::BoxIntersectCallBack(const Box &a, const Box &b) {
 }
 
 void dtkCollisionDetectStage::DoIntersect(
-    HierarchyPair pair, vector<IntersectResult::Ptr> &intersectResults,
+    HierarchyPair pair, vector<IntersectResult> &intersectResults,
     bool self, bool ignore_extend) {
-  TraverseHierarchy(pair.first->GetRoot(), pair.second->GetRoot(),
-                    intersectResults, self, ignore_extend);
+  if (!mScheduler || mSplitDepth == 0 ||
+      pair.first->GetNumberOfPrimitives() *
+              pair.second->GetNumberOfPrimitives() <
+          mSplitThreshold) {
+    TraverseHierarchy(pair.first->GetRoot(), pair.second->GetRoot(),
+                      intersectResults, self, ignore_extend);
+    return;
+  }
+
+  // 大的层次对拆成子任务, 每个子任务写自己的结果, 按展开顺序拼接保证确定性.
+  Scratch *scratch = AcquireScratch(0);
+  SplitHierarchy(pair.first->GetRoot(), pair.second->GetRoot(), mSplitDepth,
+                 scratch->node_pairs);
+  size_t numberOfNodePairs = scratch->node_pairs.size();
+  if (scratch->results.size() < numberOfNodePairs)
+    scratch->results.resize(numberOfNodePairs);
+  for (dtkID i = 0; i < numberOfNodePairs; i++)
+    scratch->results[i].clear();
+
+  mScheduler->ForkJoinRange(
+      numberOfNodePairs, 1,
+      boost::bind(&dtkCollisionDetectStage::_TraverseNodePairs, this, scratch,
+                  self, ignore_extend, _1, _2));
+
+  for (dtkID i = 0; i < numberOfNodePairs; i++)
+    intersectResults.insert(intersectResults.end(),
+                            scratch->results[i].begin(),
+                            scratch->results[i].end());
+  ReleaseScratch(scratch);
+}
+
+void dtkCollisionDetectStage::_TraverseNodePairs(Scratch *scratch, bool self,
+                                                 bool ignore_extend,
+                                                 dtkID begin, dtkID end) {
+  for (dtkID i = begin; i < end; i++)
+    TraverseHierarchy(scratch->node_pairs[i].first,
+                      scratch->node_pairs[i].second, scratch->results[i],
+                      self, ignore_extend);
+}
+
+dtkCollisionDetectStage::Scratch *
+dtkCollisionDetectStage::AcquireScratch(size_t numberOfResults) {
+  Scratch *scratch;
+  {
+    boost::unique_lock<boost::mutex> lock(mScratchMutex);
+    if (mScratches.empty()) {
+      scratch = new Scratch();
+    } else {
+      scratch = mScratches.back();
+      mScratches.pop_back();
+    }
+  }
+  scratch->node_pairs.clear();
+  if (scratch->results.size() < numberOfResults)
+    scratch->results.resize(numberOfResults);
+  for (dtkID i = 0; i < numberOfResults; i++)
+    scratch->results[i].clear();
+  return scratch;
+}
+
+void dtkCollisionDetectStage::ReleaseScratch(Scratch *scratch) {
+  boost::unique_lock<boost::mutex> lock(mScratchMutex);
+  mScratches.push_back(scratch);
+}
+
+void dtkCollisionDetectStage::SplitHierarchy(dtkCollisionDetectNode *node_1,
+                                             dtkCollisionDetectNode *node_2,
+                                             size_t depth,
+                                             vector<NodePair> &nodePairs) {
+  if (depth == 0 || (node_1->IsLeaf() && node_2->IsLeaf())) {
+    nodePairs.push_back(make_pair(node_1, node_2));
+    return;
+  }
+
+  if (!CDBasic::DoIntersect(node_1, node_2))
+    return;
+
+  // 与 TraverseHierarchy 的分支一致.
+  if (!node_1->IsLeaf() &&
+      (node_2->IsLeaf() || node_1->GetLevel() > node_2->GetLevel())) {
+    for (dtkID i = 0; i < node_1->GetNumOfChildren(); i++)
+      SplitHierarchy(node_1->GetChild(i), node_2, depth - 1, nodePairs);
+  } else {
+    for (dtkID i = 0; i < node_2->GetNumOfChildren(); i++)
+      SplitHierarchy(node_1, node_2->GetChild(i), depth - 1, nodePairs);
+  }
 }
 
 void dtkCollisionDetectStage::TraverseHierarchy(
     dtkCollisionDetectNode *node_1, dtkCollisionDetectNode *node_2,
-    vector<IntersectResult::Ptr> &intersectResults, bool self,
+    vector<IntersectResult> &intersectResults, bool self,
     bool ignore_extend) {
   if (CDBasic::DoIntersect(node_1, node_2)) // 粗相交检测.
   {
     if (node_1->IsLeaf()) {
       if (node_2->IsLeaf()) { // 叶子与叶子相交测试.
-        IntersectResult::Ptr result;
+        IntersectResult result;
         for (dtkID i = 0; i < node_1->GetNumOfPrimitives(); i++) {
           for (dtkID j = 0; j < node_2->GetNumOfPrimitives(); j++) {
             if (CDBasic::DoIntersect(node_1->GetPrimitive(i),
@@ -199,24 +258,38 @@ void dtkCollisionDetectStage::SelfIntersect(
 
 void dtkCollisionDetectStage::AllIntersect() {
   const std::vector<HierarchyPair> &pairs = GetPossibleIntersectPairs();
-  for (dtkID i = 0; i < pairs.size(); i++) {
-    DoIntersect(pairs[i], mIntersectResults, false, false);
+  if (!mScheduler) {
+    for (dtkID i = 0; i < pairs.size(); i++) {
+      DoIntersect(pairs[i], mIntersectResults, false, false);
+    }
+    return;
   }
+
+  // 每个层次对写自己的结果, 按层次对顺序拼接, 与单线程结果一致.
+  Scratch *scratch = AcquireScratch(pairs.size());
+  mScheduler->ForkJoinRange(
+      pairs.size(), 1,
+      boost::bind(&dtkCollisionDetectStage::_IntersectPairs, this, &pairs,
+                  scratch, _1, _2));
+
+  for (dtkID i = 0; i < pairs.size(); i++)
+    mIntersectResults.insert(mIntersectResults.end(),
+                             scratch->results[i].begin(),
+                             scratch->results[i].end());
+  ReleaseScratch(scratch);
 }
 
-void dtkCollisionDetectStage::SetNumberOfThreads(size_t n) {
-  if (n <= 0)
-    return;
+void dtkCollisionDetectStage::_IntersectPairs(
+    const std::vector<HierarchyPair> *pairs, Scratch *scratch, dtkID begin,
+    dtkID end) {
+  for (dtkID i = begin; i < end; i++)
+    DoIntersect((*pairs)[i], scratch->results[i], false, false);
+}
 
-  mNumberOfThreads = n;
-  mLive = true;
-  mThreadGroup = new thread_group();
-  mEnterBarrier = new barrier(mNumberOfThreads + 1);
-  mExitBarrier = new barrier(mNumberOfThreads + 1);
-  for (dtkID i = 0; i < mNumberOfThreads; i++) {
-    mThreadGroup->add_thread(
-        new boost::thread(thread_update, i, mNumberOfThreads, mEnterBarrier,
-                          mExitBarrier, &mLive, &mHierarchies));
-  }
+void dtkCollisionDetectStage::SetTaskScheduler(
+    dtkTaskScheduler::Ptr scheduler) {
+  mScheduler = scheduler;
+  for (dtkID i = 0; i < mHierarchies.size(); i++)
+    mHierarchies[i]->SetTaskScheduler(mScheduler);
 }
 }; // namespace dtk
@@ -40,7 +40,7 @@ public:
    * @brief 两个图元进行相交测试
    * @param[in]    pri_1 : 图元1
    * @param[in]	pri_2 : 图元2
-   * @param[in]	result : 指向相交测试的具体结果的智能指针引用
+   * @param[out]	result : 相交测试的具体结果, 相交时写入
    * @param[in]	self : 自相交
    * @param[in]	ignore_extend : 相交测试间隔
    * @note	间隔是存在于图元间的距离，只要小于间隔就视为相交。
@@ -50,7 +50,7 @@ public:
    */
   static bool DoIntersect(dtkCollisionDetectPrimitive *pri_1,
                           dtkCollisionDetectPrimitive *pri_2,
-                          IntersectResult::Ptr &result, bool self = false,
+                          IntersectResult &result, bool self = false,
                           bool ignore_extend = false);
 
   static bool DoIntersect(const dtkCollisionDetectNode *node_1,
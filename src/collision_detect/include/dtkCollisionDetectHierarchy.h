@@ -17,9 +17,8 @@
 #define SIMPLEPHYSICSENGINE_DTKCOLLISIONDETECTHIERARCHY_H
 
 #include <memory>
+#include <vector>
 
-#include <boost/thread/barrier.hpp>
-#include <boost/thread/thread.hpp>
 #include <boost/utility.hpp>
 
 #include "dtkCollisionDetectBasic.h"
@@ -27,9 +26,19 @@
 #include "dtkIDTypes.h"
 #include "dtkStaticTetraMesh.h"
 #include "dtkStaticTriangleMesh.h"
+#include "dtkTaskScheduler.h"
 
 namespace dtk {
+/**
+ * @class <dtkCollisionDetectHierarchy>
+ * @brief 冲突检测树基类
+ * @note
+ * 图元在按块分配的连续内存中原位构造, 地址在树的生命周期内不变,
+ * 析构时整块释放. 结点由派生类按值存放在数组中, 以下标互相引用.
+ */
 class dtkCollisionDetectHierarchy : public boost::noncopyable {
+  friend class dtkCollisionDetectNode;
+
 public:
   enum InsertOption { SURFACE, INTERIOR };
   typedef std::shared_ptr<dtkCollisionDetectHierarchy> Ptr;
@@ -63,7 +72,26 @@ public:
 
   void AutoSetMaxLevel();
 
-  void SetNumberOfThreads(size_t n);
+  /**
+   * @brief 设置更新图元所用的调度器, 为空时单线程更新
+   * @param[in]	scheduler : 与物理核心共用的任务调度器
+   */
+  inline void SetTaskScheduler(dtkTaskScheduler::Ptr scheduler) {
+    mScheduler = scheduler;
+  }
+
+  /**
+   * @brief 所属对象是否休眠
+   * @note 休眠对象的点不再移动, 入睡后的第一次 Update 仍然刷新,
+   * 之后跳过, 直到唤醒.
+   */
+  inline void SetSleeping(bool sleeping) {
+    if (!sleeping)
+      mSleepRefitted = false;
+    mSleeping = sleeping;
+  }
+
+  inline bool IsSleeping() const { return mSleeping; }
 
   inline Primitive *GetPrimitive(dtkID id) {
     assert(id < mPrimitives.size());
@@ -79,44 +107,55 @@ public:
 
   inline const GK::Point3 &GetOrigin() const { return mOrigin; }
 
-  inline dtkCollisionDetectNode *GetRoot() { return mRoot; }
+  inline dtkCollisionDetectNode *GetRoot() {
+    return GetNumberOfNodes() > 0 ? GetNode(0) : 0;
+  }
 
-  size_t GetNumberOfNodes() const { return mNodes.size(); }
+  virtual size_t GetNumberOfNodes() const = 0;
 
-  inline void AddNode(dtkCollisionDetectNode *node) { mNodes.push_back(node); }
+  virtual dtkCollisionDetectNode *GetNode(dtkID i) = 0;
 
-  inline dtkCollisionDetectNode *GetNode(dtkID i) { return mNodes[i]; }
+  /**
+   * @brief 为随后插入的图元预留连续空间
+   * @param[in]	num : 图元数
+   */
+  void ReservePrimitives(size_t num);
 
 protected:
   dtkCollisionDetectHierarchy();
 
-  void AddPrimitive(Primitive *primitive);
+  Primitive *NewPrimitive();
 
-  dtkCollisionDetectNode *mRoot; /**< 碰撞检测树根结点 */
-
-  std::vector<dtkCollisionDetectNode *> mNodes; /**< 当前层结点集 */
+  void AddPrimitive(Primitive *primitive, dtkPoints::Ptr pts);
 
   std::vector<Primitive *> mPrimitives; /**< 图元集 */
 
+  std::vector<dtkID> mPrimitiveOrder; /**< 图元顺序表, 结点的图元段在其中 */
+
+  std::vector<Primitive *> mPrimitiveBlocks; /**< 图元内存块 */
+  size_t mBlockCapacity; /**< 最后一块可容纳的图元数 */
+  size_t mBlockUsed;     /**< 最后一块已用的图元数 */
+
+  std::vector<dtkPoints::Ptr> mPointSets; /**< 图元引用的点集 */
+
   GK::BBox3 mBox; /**< AABB包围盒 */
 
   GK::Point3 mOrigin; /**< 原点 */
 
-  bool mLive; /**< 碰撞检测更新线程是否运行 */
-
   size_t mMaxLevel; /**< 最大层数 */
 
+  bool mSleeping;      /**< 所属对象休眠 */
+  bool mSleepRefitted; /**< 休眠后已经刷新过一次 */
+
 private:
   void _UpdateAllPrimitives_s(); /**< 单线程更新图元 */
 
   void _UpdateAllPrimitives_mt(); /**< 多线程更新图元 */
 
-private:
-  size_t mNumberOfThreads;
+  void _UpdatePrimitiveRange(dtkID begin, dtkID end); /**< 更新一段图元 */
 
-  boost::thread_group *mThreadGroup;
-  boost::barrier *mEnterBarrier;
-  boost::barrier *mExitBarrier;
+private:
+  dtkTaskScheduler::Ptr mScheduler; /**< 更新图元所用的调度器 */
 };
 } // namespace dtk
 
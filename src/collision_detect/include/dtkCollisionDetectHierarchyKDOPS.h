@@ -31,8 +31,12 @@ namespace dtk {
  * @author <>
  * @note
  * k-DOPs算法冲突检测树的构建，碰撞检测的执行， 图元的更新等。
+ * 结点按广度优先顺序存放在一个数组中, 子结点总在父结点之后,
+ * 重建时清空数组而保留容量.
  */
 class dtkCollisionDetectHierarchyKDOPS : public dtkCollisionDetectHierarchy {
+  friend class dtkCollisionDetectNodeKDOPS;
+
 public:
   typedef std::shared_ptr<dtkCollisionDetectHierarchyKDOPS> Ptr;
 
@@ -63,11 +67,19 @@ public:
 
   void Update();
 
+  size_t GetNumberOfNodes() const { return mNodeArray.size(); }
+
+  inline dtkCollisionDetectNode *GetNode(dtkID i) { return &mNodeArray[i]; }
+
 private:
   dtkCollisionDetectHierarchyKDOPS(size_t half_k);
 
 private:
   size_t mHalfK; /**< k-Dops算法轴向包围盒维度 */
+
+  std::vector<dtkCollisionDetectNodeKDOPS> mNodeArray; /**< 结点数组 */
+
+  std::vector<dtkID> mSplitBuffer; /**< 划分时暂存右分支的图元 */
 };
 } // namespace dtk
 
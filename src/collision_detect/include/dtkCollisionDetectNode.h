@@ -17,6 +17,7 @@
 #ifndef SIMPLEPHYSICSENGINE_DTKCOLLISIONDETECTNODE_H
 #define SIMPLEPHYSICSENGINE_DTKCOLLISIONDETECTNODE_H
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -35,6 +36,9 @@ class dtkCollisionDetectHierarchy;
  * @author <>
  * @note
  * 冲突检测树结点类，包含一个dtkCollisionDetectHierarchy针，指向一组图元。
+ * 结点按值存放在所属树的结点数组中, 子结点与父结点以下标表示, 两个子结点相邻.
+ * 图元保存在树的图元顺序表中, 每个结点对应其中连续的一段 [mBegin, mEnd),
+ * 子树的图元段连续, 内部结点的段覆盖整棵子树.
  */
 class dtkCollisionDetectNode {
 public:
@@ -50,42 +54,46 @@ public:
 
   inline void SetLeaf(bool leaf) { mLeaf = leaf; }
 
-  inline void AddPrimitive(dtkID id) { mPrimitiveIDs.push_back(id); }
+  /**
+   * @brief 建树后向结点追加图元, 祖先结点的图元段随之扩展
+   * @param[in]	id : 图元在树中的编号
+   */
+  void AddPrimitive(dtkID id);
 
   inline void AddPrimitive(dtkCollisionDetectPrimitive *primitive) {
-    mPrimitiveIDs.push_back(primitive->mLocalID);
+    AddPrimitive(primitive->mLocalID);
   }
 
-  inline void DeletePrimitive(dtkCollisionDetectPrimitive *primitive) {
-    primitive->mActive = false;
-    std::vector<dtkID>::iterator it;
-    it = std::find(mPrimitiveIDs.begin(), mPrimitiveIDs.end(),
-                   primitive->mLocalID);
-    assert(it != mPrimitiveIDs.end());
-    mPrimitiveIDs.erase(it);
-  }
+  /**
+   * @brief 从结点删除图元并置为非活动, 祖先结点的图元段随之收缩
+   * @param[in]	primitive : 结点中的图元
+   */
+  void DeletePrimitive(dtkCollisionDetectPrimitive *primitive);
 
-  inline size_t GetNumOfPrimitives() const { return mPrimitiveIDs.size(); }
+  inline size_t GetNumOfPrimitives() const { return mEnd - mBegin; }
 
   dtkCollisionDetectPrimitive *GetPrimitive(dtkID id);
 
-  inline size_t GetNumOfChildren() const { return mChildren.size(); }
+  inline size_t GetNumOfChildren() const { return mLeaf ? 0 : 2; }
 
   inline size_t GetLevel() const { return mLevel; }
 
   inline void SetMaxLevel(size_t level) { mMaxLevel = level; }
 
-  inline dtkCollisionDetectNode *GetChild(size_t id) { return mChildren[id]; }
+  dtkCollisionDetectNode *GetChild(size_t id);
+
+  dtkCollisionDetectNode *GetParent();
 
 protected:
   dtkCollisionDetectHierarchy
       *mHierarchy; /**< 冲突检测树一个层，包含一组图元 */
-  std::vector<dtkID> mPrimitiveIDs;                /**< 图元ID的集合 */
-  std::vector<dtkCollisionDetectNode *> mChildren; /**< 冲突检测树的子节点 */
-  bool mLeaf;    /**< 当前节点是否为叶节点 */
-  size_t mLevel; /**< 当前节点所处层数 */
-
-  size_t mMaxLevel; /**< 最大层数 */
+  dtkID mParent;     /**< 父结点下标, 根结点为 dtkErrorID */
+  dtkID mFirstChild; /**< 第一个子结点下标 */
+  dtkID mBegin;      /**< 图元段起点 */
+  dtkID mEnd;        /**< 图元段终点 */
+  bool mLeaf;        /**< 当前节点是否为叶节点 */
+  size_t mLevel;     /**< 当前节点所处层数 */
+  size_t mMaxLevel;  /**< 最大层数 */
 };
 } // namespace dtk
 
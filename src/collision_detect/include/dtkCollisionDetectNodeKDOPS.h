@@ -30,9 +30,12 @@ class dtkCollisionDetectHierarchyKDOPS;
  * @author <>
  * @note
  * k-Dops算法冲突检测树结点类，继承于dtkCollisionDetectNode基类。
+ * 包围盒内联存放, 结点按值连续存放在树的结点数组中.
  */
 
 class dtkCollisionDetectNodeKDOPS : public dtkCollisionDetectNode {
+  friend class dtkCollisionDetectHierarchyKDOPS;
+
 public:
   dtkCollisionDetectNodeKDOPS(dtkCollisionDetectHierarchy *father,
                               size_t half_k);
@@ -40,10 +43,11 @@ public:
   ~dtkCollisionDetectNodeKDOPS();
 
   /**
-   * @brief 递归划分k-Dops冲突检测树。
+   * @brief 划分k-Dops冲突检测树结点, 两个子结点追加到结点数组末尾。
+   * @note 不递归, 由树按数组顺序逐个划分.
    */
 
-  // 递归划分
+  // 划分为左右分支
   void Split();
 
   /**
@@ -55,10 +59,11 @@ public:
 
   /**
    * @brief 根据图元重心平均值划分为节点为左右分支。
+   * @return 分界位置, 图元段 [mBegin, 分界) 属于左分支, 其余属于右分支
    */
   // 根据图元重心平均值划分为左右分支。
 
-  void SplitRule();
+  dtkID SplitRule();
 
   inline const GK::KDOP &GetKDOP() const { return mKDOP; }
 
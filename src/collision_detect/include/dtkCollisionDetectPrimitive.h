@@ -33,6 +33,7 @@ namespace dtk {
  * @author <>
  * @note
  * 碰撞检测图元，描述每个碰撞检测的物体。
+ * 图元由碰撞检测树在连续的内存块中构造, 点集也由树持有, 图元只保存裸指针.
  */
 class dtkCollisionDetectPrimitive {
 public:
@@ -41,7 +42,7 @@ public:
 public:
   typedef dtkCollisionDetectPrimitiveType Type;
 
-  dtkCollisionDetectPrimitive(Type type, dtkPoints::Ptr pts, ...);
+  dtkCollisionDetectPrimitive(Type type, dtkPoints *pts, ...);
 
   ~dtkCollisionDetectPrimitive() {}
 
@@ -76,8 +77,8 @@ public:
 
 public:
   Type mType;              /**< 图元类型 */
-  std::vector<dtkID> mIDs; /**< 点ID集 */
-  dtkPoints::Ptr mPts;     /**< 点集 */
+  dtkID mIDs[3];  /**< 点ID集, 前 mNumberOfPoints 个有效 */
+  dtkPoints *mPts; /**< 点集 */
 
   dtkID mInvert; /**< represent the positive and inverse of triangle
                     三角形正反、内外朝向 */
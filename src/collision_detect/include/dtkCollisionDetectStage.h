@@ -21,12 +21,12 @@
 #include <vector>
 
 #include <CGAL/box_intersection_d.h>
-#include <boost/thread/barrier.hpp>
-#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/utility.hpp>
 
 #include "dtkConfig.h"
 #include "dtkIDTypes.h"
+#include "dtkTaskScheduler.h"
 
 #include "dtkCollisionDetectHierarchy.h"
 
@@ -52,6 +52,9 @@ public:
 
   typedef CGAL::Box_intersection_d::Box_d<double, 3> Box;
 
+  typedef std::pair<dtkCollisionDetectNode *, dtkCollisionDetectNode *>
+      NodePair;
+
   static dtkCollisionDetectStage::Ptr New() {
     return dtkCollisionDetectStage::Ptr(new dtkCollisionDetectStage());
   }
@@ -68,7 +71,7 @@ public:
    * @note
    */
   void DoIntersect(HierarchyPair pair,
-                   std::vector<IntersectResult::Ptr> &intersectResults,
+                   std::vector<IntersectResult> &intersectResults,
                    bool self = false, bool ignore_extend = false);
 
   /**
@@ -82,7 +85,7 @@ public:
    */
   void TraverseHierarchy(dtkCollisionDetectNode *node_1,
                          dtkCollisionDetectNode *node_2,
-                         std::vector<IntersectResult::Ptr> &intersectResults,
+                         std::vector<IntersectResult> &intersectResults,
                          bool self = false, bool ignore_extend = false);
 
   /**
@@ -107,13 +110,14 @@ public:
   /**
    * @brief 更新每一层的图元包围盒
    * @note
-   * 更新每一层的图元包围盒， 根据mNumberOfThreads决定使用多线程还是单线程.
+   * 更新每一层的图元包围盒， 设置了调度器时多线程更新.
    */
   void Update();
 
   inline size_t GetNumberOfHierarchies() const { return mHierarchies.size(); }
 
   inline void AddHierarchy(dtkCollisionDetectHierarchy::Ptr hierarchy) {
+    hierarchy->SetTaskScheduler(mScheduler);
     mHierarchies.push_back(hierarchy);
   }
 
@@ -128,13 +132,32 @@ public:
     return mHierarchies[i];
   }
 
-  void SetNumberOfThreads(size_t n);
+  /**
+   * @brief 设置更新与拆分遍历所用的调度器
+   * @param[in]	scheduler : 与物理核心共用的任务调度器, 为空时单线程
+   * @note 同时传给已加入的碰撞检测树, 之后加入的树在 AddHierarchy 时设置.
+   */
+  void SetTaskScheduler(dtkTaskScheduler::Ptr scheduler);
+
+  /**
+   * @brief 设置拆分深度
+   * @param[in]	depth : 从根节点向下展开的层数, 0 表示不拆分
+   */
+  inline void SetSplitDepth(size_t depth) { mSplitDepth = depth; }
+
+  /**
+   * @brief 设置拆分阈值
+   * @param[in]	threshold : 两棵树图元数之积不小于该值时才拆分
+   */
+  inline void SetSplitThreshold(size_t threshold) {
+    mSplitThreshold = threshold;
+  }
 
   inline size_t GetNumberOfIntersectResults() {
     return mIntersectResults.size();
   }
 
-  inline IntersectResult::Ptr GetIntersectResult(dtkID i) {
+  inline const IntersectResult &GetIntersectResult(dtkID i) const {
     assert(i < mIntersectResults.size());
     return mIntersectResults[i];
   }
@@ -164,26 +187,64 @@ private:
   /**
    * @brief 单线程更新每一层的图元包围盒
    * @note
-   * 更新每一层的图元包围盒， 根据mNumberOfThreads决定使用多线程还是单线程.
+   * 更新每一层的图元包围盒.
    */
   void _Update_s();
 
   /**
    * @brief 多线程更新每一层的图元包围盒
    * @note
-   * 更新每一层的图元包围盒， 根据mNumberOfThreads决定使用多线程还是单线程.
+   * 每棵树一个子任务, 树内的图元更新再嵌套拆分.
    */
   void _Update_mt();
 
+  /**
+   * @brief 按 TraverseHierarchy 的顺序展开 depth 层, 收集待遍历的节点对
+   * @param[in]	node_1 : 碰撞检测树节点1
+   * @param[in]	node_2 : 碰撞检测树节点2
+   * @param[in]	depth : 剩余展开层数
+   * @param[out]	nodePairs : 节点对, 各自遍历后按顺序拼接即为串行结果
+   */
+  void SplitHierarchy(dtkCollisionDetectNode *node_1,
+                      dtkCollisionDetectNode *node_2, size_t depth,
+                      std::vector<NodePair> &nodePairs);
+
+  /**
+   * @brief 拆分遍历与 AllIntersect 的临时缓冲
+   * @note 用完放回池中, 容量跨帧保留, 稳态下不再分配内存.
+   */
+  typedef struct {
+    std::vector<NodePair> node_pairs; /**< 展开得到的节点对 */
+    std::vector<std::vector<IntersectResult>>
+        results; /**< 每个子任务的结果, 只增不减 */
+  } Scratch;
+
+  /**
+   * @brief 从池中取一个缓冲
+   * @param[in]	numberOfResults : 需要的结果数组数, 取出时已清空
+   * @note 嵌套与并发的调用各自取得不同的缓冲
+   */
+  Scratch *AcquireScratch(size_t numberOfResults);
+
+  void ReleaseScratch(Scratch *scratch);
+
+  void _UpdateHierarchyRange(dtkID begin, dtkID end);
+
+  void _TraverseNodePairs(Scratch *scratch, bool self, bool ignore_extend,
+                          dtkID begin, dtkID end);
+
+  void _IntersectPairs(const std::vector<HierarchyPair> *pairs,
+                       Scratch *scratch, dtkID begin, dtkID end);
+
 private:
-  size_t mNumberOfThreads; /**< 多线程树 */
-  bool mLive;
+  std::vector<IntersectResult> mIntersectResults;
 
-  std::vector<IntersectResult::Ptr> mIntersectResults;
+  std::vector<Scratch *> mScratches; /**< 空闲的临时缓冲 */
+  boost::mutex mScratchMutex;        /**< 保护 mScratches */
 
-  boost::thread_group *mThreadGroup;
-  boost::barrier *mEnterBarrier;
-  boost::barrier *mExitBarrier;
+  dtkTaskScheduler::Ptr mScheduler; /**< 拆分遍历所用的调度器 */
+  size_t mSplitDepth;               /**< 拆分深度 */
+  size_t mSplitThreshold;           /**< 拆分阈值, 图元数之积 */
 };
 
 inline std::ostream &operator<<(std::ostream &stream,
@@ -325,10 +325,7 @@ GK::KDOP GK::Merge(const GK::KDOP &kdop_1, const GK::KDOP &kdop_2) {
   assert(kdop_1.mHalfK == kdop_2.mHalfK);
 
   GK::KDOP merge_kdop(kdop_1.mHalfK);
-  for (dtkID i = 0; i < kdop_1.mHalfK; i++) {
-    merge_kdop.mIntervals[i] =
-        GK::Merge(kdop_1.mIntervals[i], kdop_2.mIntervals[i]);
-  }
+  GK::Merge(merge_kdop, kdop_1, kdop_2);
 
   return merge_kdop;
 }
@@ -341,8 +338,12 @@ void GK::Merge(GK::Interval &int_r, const GK::Interval &int_1,
 
 void GK::Merge(GK::KDOP &kdop_r, const GK::KDOP &kdop_1,
                const GK::KDOP &kdop_2) {
+  // KDOP 的区间可能是单精度, 不经过 GK::Interval.
   for (dtkID i = 0; i < kdop_1.mHalfK; i++) {
-    GK::Merge(kdop_r.mIntervals[i], kdop_1.mIntervals[i], kdop_2.mIntervals[i]);
+    kdop_r.mIntervals[i][0] =
+        std::min(kdop_1.mIntervals[i][0], kdop_2.mIntervals[i][0]);
+    kdop_r.mIntervals[i][1] =
+        std::max(kdop_1.mIntervals[i][1], kdop_2.mIntervals[i][1]);
   }
 }
 
@@ -311,7 +311,7 @@ bool dtkIntersectTest::IsOverlap(GK::Float min0, GK::Float max0, GK::Float min1,
 bool dtkIntersectTest::DoDistanceIntersect(const GK::Triangle3 &tri,
                                            const GK::Segment3 &seg,
                                            double distance,
-                                           IntersectResult::Ptr &result,
+                                           IntersectResult &result,
                                            dtkID invert) {
   assert(distance > 0);
 
@@ -430,7 +430,7 @@ bool dtkIntersectTest::DoDistanceIntersect(const GK::Triangle3 &tri,
   if (intersected) {
     // depth_1 <= 0 : present no touching of the point of segment and triangle
     // which has stickness. depth_1 > 0:  present touching.
-    result = IntersectResult::New();
+    result = IntersectResult();
     assert(depth_1 >= 0 || depth_2 >= 0);
     dtkDouble2 uv_seg;
     if (depth_1 > 0) {
@@ -483,47 +483,43 @@ bool dtkIntersectTest::DoDistanceIntersect(const GK::Triangle3 &tri,
     if (depth_2 > 0)
       sum_depth += depth_2;
 
-    result->SetProperty(INTERSECT_WEIGHT_1, uvw_tri);
-    result->SetProperty(INTERSECT_WEIGHT_2, uv_seg);
-    result->SetProperty(INTERSECT_NORMAL, tri_unit_normal * sum_depth);
+    result.weight_1 = uvw_tri;
+    result.weight_2 = dtkDouble3(uv_seg[0], uv_seg[1], 0);
+    result.normal = tri_unit_normal * sum_depth;
   } else {
     if (DoDistanceIntersect(GK::Segment3(triP1, triP2), seg, distance,
                             result)) {
 #ifdef DTK_INTERSECTTEST_DEBUG
       cout << "intersect with side line" << endl;
 #endif
-      dtkDouble2 uv;
-      result->GetProperty(INTERSECT_WEIGHT_1, uv);
-      result->SetProperty(INTERSECT_WEIGHT_1, dtkDouble3(uv[0], uv[1], 0));
+      dtkDouble3 uv = result.weight_1;
+      result.weight_1 = dtkDouble3(uv[0], uv[1], 0);
       intersected = true;
     } else if (DoDistanceIntersect(GK::Segment3(triP2, triP3), seg, distance,
                                    result)) {
 #ifdef DTK_INTERSECTTEST_DEBUG
       cout << "intersect with side line" << endl;
 #endif
-      dtkDouble2 uv;
-      result->GetProperty(INTERSECT_WEIGHT_1, uv);
-      result->SetProperty(INTERSECT_WEIGHT_1, dtkDouble3(0, uv[0], uv[1]));
+      dtkDouble3 uv = result.weight_1;
+      result.weight_1 = dtkDouble3(0, uv[0], uv[1]);
       intersected = true;
     } else if (DoDistanceIntersect(GK::Segment3(triP3, triP1), seg, distance,
                                    result)) {
 #ifdef DTK_INTERSECTTEST_DEBUG
       cout << "intersect with side line" << endl;
 #endif
-      dtkDouble2 uv;
-      result->GetProperty(INTERSECT_WEIGHT_1, uv);
-      result->SetProperty(INTERSECT_WEIGHT_1, dtkDouble3(uv[1], 0, uv[0]));
+      dtkDouble3 uv = result.weight_1;
+      result.weight_1 = dtkDouble3(uv[1], 0, uv[0]);
       intersected = true;
     }
 
     if (intersected) {
-      GK::Vector3 normal;
-      result->GetProperty(INTERSECT_NORMAL, normal);
+      GK::Vector3 normal = result.normal;
       double tempDepth = GK::DotProduct(normal, tri_unit_normal);
       if (tempDepth < 0) {
         normal = normal - tri_unit_normal * tempDepth * 2;
       }
-      result->SetProperty(INTERSECT_NORMAL, normal);
+      result.normal = normal;
     }
   }
   return intersected;
@@ -532,7 +528,7 @@ bool dtkIntersectTest::DoDistanceIntersect(const GK::Triangle3 &tri,
 bool dtkIntersectTest::DoDistanceIntersect(const GK::Segment3 &seg_0,
                                            const GK::Segment3 &seg_1,
                                            double distance,
-                                           IntersectResult::Ptr &result) {
+                                           IntersectResult &result) {
   assert(distance > 0);
 
   GK::Point3 p11 = seg_0[0];
@@ -582,17 +578,15 @@ bool dtkIntersectTest::DoDistanceIntersect(const GK::Segment3 &seg_0,
 
     if (intersect) // parallel line intersect
     {
-      vector<double> l;
-      l.resize(4);
-      vector<double> l_ori;
-      l_ori.resize(4);
+      double l[4];
+      double l_ori[4];
 
       l[0] = l_ori[0] = 0;
       l[1] = l_ori[1] = v_edge_1_length;
       l[2] = l_ori[2] = project_21_1;
       l[3] = l_ori[3] = project_22_1;
 
-      sort(l.begin(), l.end());
+      std::sort(l, l + 4);
 
       // compute the intersect_weight of seg_0 and seg_1.
       double mid = (l[2] + l[1]) / 2.0;
@@ -601,15 +595,15 @@ bool dtkIntersectTest::DoDistanceIntersect(const GK::Segment3 &seg_0,
       uv2[0] = abs(mid - l_ori[3]) / abs(l_ori[3] - l_ori[2]);
       uv2[1] = 1.0 - uv2[0];
 
-      result = IntersectResult::New();
+      result = IntersectResult();
 #ifdef DTK_INTERSECTTEST_DEBUG
       cout << "paralell segments intersect." << endl;
 #endif
       assert(length >= 0);
       // compute the common normal of two parallel line.
-      result->SetProperty(INTERSECT_NORMAL, normal * (distance - length) * 2.0);
-      result->SetProperty(INTERSECT_WEIGHT_1, uv1);
-      result->SetProperty(INTERSECT_WEIGHT_2, uv2);
+      result.normal = normal * (distance - length) * 2.0;
+      result.weight_1 = dtkDouble3(uv1[0], uv1[1], 0);
+      result.weight_2 = dtkDouble3(uv2[0], uv2[1], 0);
     }
   } else {
     // normal is Common perpendicular of seg1 and seg2.
@@ -683,11 +677,10 @@ bool dtkIntersectTest::DoDistanceIntersect(const GK::Segment3 &seg_0,
       cout << "segments intersect." << endl;
 #endif
       assert(length >= 0);
-      result = IntersectResult::New();
-      result->SetProperty(INTERSECT_NORMAL,
-                          apply_normal * (distance - length) * 2.0);
-      result->SetProperty(INTERSECT_WEIGHT_1, uv1);
-      result->SetProperty(INTERSECT_WEIGHT_2, uv2);
+      result = IntersectResult();
+      result.normal = apply_normal * (distance - length) * 2.0;
+      result.weight_1 = dtkDouble3(uv1[0], uv1[1], 0);
+      result.weight_2 = dtkDouble3(uv2[0], uv2[1], 0);
     }
   }
 
@@ -732,15 +725,14 @@ bool dtkIntersectTest::DoDistanceIntersect(const GK::Segment3 &seg_0,
       // );
       length = GK::Length(P2 - P1) * 2.0;
 
-      result = IntersectResult::New();
+      result = IntersectResult();
 #ifdef DTK_INTERSECTTEST_DEBUG
       cout << "segment endpoints intersect." << endl;
 #endif
       assert(length >= 0);
-      result->SetProperty(INTERSECT_NORMAL,
-                          apply_normal * (distance * 2.0 - length));
-      result->SetProperty(INTERSECT_WEIGHT_1, uv1);
-      result->SetProperty(INTERSECT_WEIGHT_2, uv2);
+      result.normal = apply_normal * (distance * 2.0 - length);
+      result.weight_1 = dtkDouble3(uv1[0], uv1[1], 0);
+      result.weight_2 = dtkDouble3(uv2[0], uv2[1], 0);
     }
   }
 
@@ -921,7 +913,7 @@ bool dtkIntersectTest::DoDistanceIntersect(const GK::Segment3 &seg_0,
 bool dtkIntersectTest::DoDistanceIntersect(const GK::Triangle3 &tri_1,
                                            const GK::Triangle3 &tri_2,
                                            double distance,
-                                           IntersectResult::Ptr &result,
+                                           IntersectResult &result,
                                            dtkID invert) {
   bool intersect = false;
 
@@ -946,8 +938,8 @@ bool dtkIntersectTest::DoDistanceIntersect(const GK::Triangle3 &tri_1,
     }
 
     if (intersect) {
-      result = IntersectResult::New();
-      result->SetProperty(INTERSECT_WEIGHT_1, uvw1);
+      result = IntersectResult();
+      result.weight_1 = uvw1;
     }
 
     return intersect;
@@ -1068,11 +1060,11 @@ bool dtkIntersectTest::DoDistanceIntersect(const GK::Triangle3 &tri_1,
     uvw2[1] = pro22 / sum2;
     uvw2[2] = pro23 / sum2;
 
-    result = IntersectResult::New();
+    result = IntersectResult();
     normal = n * (sum1 + sum2);
-    result->SetProperty(INTERSECT_NORMAL, normal);
-    result->SetProperty(INTERSECT_WEIGHT_1, uvw1);
-    result->SetProperty(INTERSECT_WEIGHT_2, uvw2);
+    result.normal = normal;
+    result.weight_1 = uvw1;
+    result.weight_2 = uvw2;
   }
   return intersect;
 }
@@ -1080,7 +1072,7 @@ bool dtkIntersectTest::DoDistanceIntersect(const GK::Triangle3 &tri_1,
 bool dtkIntersectTest::DoDistanceIntersect(const GK::Triangle3 &tri,
                                            const GK::Sphere3 &sphere,
                                            double distance,
-                                           IntersectResult::Ptr &result) {
+                                           IntersectResult &result) {
   bool intersect = false;
   GK::Vector3 normal_tri = unit_normal(tri[0], tri[2], tri[1]);
 
@@ -1106,20 +1098,19 @@ bool dtkIntersectTest::DoDistanceIntersect(const GK::Triangle3 &tri,
       uvw[2] > 1)
     return false;
 
-  double weight2 = 1.0;
-  result = IntersectResult::New();
-  result->SetProperty(INTERSECT_NORMAL, normal);
-  result->SetProperty(INTERSECT_WEIGHT_1, uvw);
-  result->SetProperty(INTERSECT_WEIGHT_2, weight2);
+  result = IntersectResult();
+  result.normal = normal;
+  result.weight_1 = uvw;
+  result.weight_2 = dtkDouble3(1.0, 0, 0);
 
   return true;
 }
 
 bool dtkIntersectTest::DoIntersect(const GK::Triangle3 &triangle_1,
                                    const GK::Triangle3 &triangle_2,
-                                   IntersectResult::Ptr &result) {
+                                   IntersectResult &result) {
   if (CGAL::do_intersect(triangle_1, triangle_2)) {
-    result = IntersectResult::New();
+    result = IntersectResult();
     return true;
   } else
     return false;
@@ -1127,11 +1118,15 @@ bool dtkIntersectTest::DoIntersect(const GK::Triangle3 &triangle_1,
 
 bool dtkIntersectTest::DoIntersect(const GK::Triangle3 &triangle,
                                    const GK::Segment3 &segment,
-                                   IntersectResult::Ptr &result) {
+                                   IntersectResult &result) {
   if (CGAL::do_intersect(triangle, segment)) {
-    result = IntersectResult::New();
+    result = IntersectResult();
+    // 交于一段时没有单个交点, 由调用者跳过.
     GK::Object object = CGAL::intersection(triangle, segment);
-    result->SetProperty(INTERSECT_OBJECT, object);
+    if (const GK::Point3 *point = CGAL::object_cast<GK::Point3>(&object)) {
+      result.point = *point;
+      result.has_point = true;
+    }
     return true;
   } else
     return false;
@@ -1139,19 +1134,19 @@ bool dtkIntersectTest::DoIntersect(const GK::Triangle3 &triangle,
 
 bool dtkIntersectTest::DoIntersect(const GK::Segment3 &seg_1,
                                    const GK::Segment3 &seg_2,
-                                   IntersectResult::Ptr &result) {
+                                   IntersectResult &result) {
   // wait for CGAL 3.7
   /*
   if( CGAL::do_intersect(seg_1, seg_2) )
   {
-      result = IntersectResult::New();
+      result = IntersectResult();
       return true;
   }
   else
       return false;
   */
   if (CGAL::do_intersect(seg_1, seg_2)) {
-    result = IntersectResult::New();
+    result = IntersectResult();
     return true;
   } else
     return false;
@@ -1244,8 +1239,14 @@ bool dtkIntersectTest::DoIntersect(const GK::KDOP &kdop_1,
                                    const GK::KDOP &kdop_2) {
   assert(kdop_1.mHalfK == kdop_2.mHalfK);
 
+  // 与 GK::Interval 的判断相同, KDOP 的区间可能是单精度.
   for (dtkID i = 0; i < kdop_1.mHalfK; i++) {
-    if (!DoIntersect(kdop_1.mIntervals[i], kdop_2.mIntervals[i]))
+    const GK::KDOP::Interval &int_1 = kdop_1.mIntervals[i];
+    const GK::KDOP::Interval &int_2 = kdop_2.mIntervals[i];
+    if (int_2.mLower > int_2.mUpper)
+      return false;
+    if (!int_1.Contain(int_2.mLower) && !int_1.Contain(int_2.mUpper) &&
+        !int_2.Contain(int_1.mLower))
       return false;
   }
   return true;
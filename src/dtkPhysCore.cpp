@@ -17,6 +17,8 @@
 #include "dtkPhysCore.h"
 #include "dtkStaticTetraMeshReader.h"
 #include "dtkStaticTriangleMeshReader.h"
+#include <boost/bind/bind.hpp>
+#include <boost/chrono.hpp>
 #include <fstream>
 #include <queue>
 #include <set>
@@ -25,221 +27,54 @@
 
 using namespace std;
 using namespace boost;
+using namespace boost::placeholders;
 
 namespace dtk {
-void dtkphyscore_mt_update(dtkID id, dtkPhysCore *core) {
-  vector<dtkInterval<int>> emptyIntervals;
-
-  do {
-    /*
-    //const std::vector< dtkID >* massSpringRange = &( core->mAllocator[id][0]
-    );
-    //const std::vector< dtkID >* collisionPairRange = &(
-    core->mAllocator[id][1] );
-
-    //const std::vector< dtkID >& massSpringRange = core->mAllocator[id][0];
-    //const std::vector< dtkID >& collisionPairRange = core->mAllocator[id][1];
-
-    // Phase 1
-    */
-    core->mEnterBarrier->wait();
-
-    if (!core->mLive)
-      break;
-
-    std::vector<dtkID> massSpringRange;
-    for (dtkID i = 0;
-         i < core->mAllocator[id][core->mAllocatePosMassSpring].size(); i++)
-      massSpringRange.push_back(
-          core->mAllocator[id][core->mAllocatePosMassSpring][i]);
-
-    std::vector<dtkID> primitiveRange;
-    for (dtkID i = 0;
-         i < core->mAllocator[id][core->mAllocatePosPrimitive].size(); i++)
-      primitiveRange.push_back(
-          core->mAllocator[id][core->mAllocatePosPrimitive][i]);
-
-    std::vector<dtkID> collisionPairRange;
-    for (dtkID i = 0;
-         i < core->mAllocator[id][core->mAllocatePosCollisionDetect].size();
-         i++)
-      collisionPairRange.push_back(
-          core->mAllocator[id][core->mAllocatePosCollisionDetect][i]);
-
-    std::vector<dtkID> internalCollisionPairRange;
-    for (dtkID i = 0;
-         i <
-         core->mAllocator[id][core->mAllocatePosInternalCollisionDetect].size();
-         i++)
-      internalCollisionPairRange.push_back(
-          core->mAllocator[id][core->mAllocatePosInternalCollisionDetect][i]);
-
-    for (dtkID i = 0; i < massSpringRange.size(); i++) {
-      if (core->mTimeslice == 0 ||
-          core->mMassSprings[massSpringRange[i]]->IsUnderControl())
-        continue;
-      core->mMassSprings[massSpringRange[i]]->PreUpdate(core->mTimeslice,
-                                                        Collision, 0);
-      core->mMassSprings[massSpringRange[i]]->UpdateStrings(core->mTimeslice,
-                                                            Collision, 0, true);
-    }
-
-    // Phase 2
-    core->mEnterBarrier->wait();
-
-    for (dtkID i = 0; i < massSpringRange.size(); i++) {
-      if (core->mTimeslice == 0 ||
-          core->mMassSprings[massSpringRange[i]]->IsUnderControl())
-        continue;
-      core->mMassSprings[massSpringRange[i]]->TransportForce(core->mTimeslice);
-      core->mMassSprings[massSpringRange[i]]->UpdateMassPoints(core->mTimeslice,
-                                                               Collision, 0);
-      // core->mMassSprings[ massSpringRange[i] ]->PostUpdate(Collision, 0);
-    }
-
-    // Phase 2.1
-    core->mEnterBarrier->wait();
-
-    for (dtkID i = 0; i < primitiveRange.size(); i++) {
-      dtkID type = primitiveRange[i] / core->mPairOffset;
-      dtkID id = primitiveRange[i] % core->mPairOffset;
-      switch (type) {
-      case 0:
-        core->mCollisionDetectHierarchies[id]->Update();
-        break;
-      case 1:
-        core->mThreadCollisionDetectHierarchies[id]->Update();
-        break;
-      case 2:
-        core->mInteriorCollisionDetectHierarchies[id]->Update();
-        break;
-      case 3:
-        core->mThreadHeadCollisionDetectHierarchies[id]->Update();
-        break;
-      default:
-        break;
-      }
-    }
-
-    // Phase 2.2
-    core->mEnterBarrier->wait();
-
-    for (dtkID i = 0; i < collisionPairRange.size(); i++) {
-      vector<dtkIntersectTest::IntersectResult::Ptr> intersectResults;
-      core->mStage->DoIntersect(
-          core->mCollisionDetectResponseSets[collisionPairRange[i]]
-              .hierarchy_pair,
-          intersectResults,
-          core->mCollisionDetectResponseSets[collisionPairRange[i]].self,
-          false);
-      if (core->mCollisionDetectResponseSets[collisionPairRange[i]]
-              .responseType == dtkPhysCore::THREAD_SURFACE) {
-        core->mCollisionDetectResponse->Update(
-            core->mTimeslice, intersectResults, emptyIntervals,
-            core->mThreadCollisionDetectResponse->GetAvoidIntervals(
-                collisionPairRange[i] % core->mPairOffset),
-            core->mCollisionDetectResponseSets[collisionPairRange[i]].strength);
-      } else if (core->mCollisionDetectResponseSets[collisionPairRange[i]]
-                     .responseType == dtkPhysCore::KNOTPLANNING) {
-        core->mCollisionDetectResponse->Update(
-            core->mTimeslice, intersectResults,
-            core->mKnotPlanners[collisionPairRange[i] % core->mPairOffset]
-                ->GetAvoidIntervals(),
-            core->mKnotPlanners[collisionPairRange[i] % core->mPairOffset]
-                ->GetAvoidIntervals(),
-            core->mCollisionDetectResponseSets[collisionPairRange[i]].strength);
-      } else if (core->mCollisionDetectResponseSets[collisionPairRange[i]]
-                     .responseType == dtkPhysCore::INTERIOR_THREADHEAD) {
-        assert(false);
-      } else {
-        core->mCollisionDetectResponse->Update(
-            core->mTimeslice, intersectResults, emptyIntervals, emptyIntervals,
-            core->mCollisionDetectResponseSets[collisionPairRange[i]].strength);
-      }
-
-      if (core->mCollisionDetectResponseSets[collisionPairRange[i]]
-              .responseType == dtkPhysCore::KNOTPLANNING) {
-        core->mKnotPlanners[collisionPairRange[i] / core->mPairOffset]
-            ->KnotRecognition(intersectResults);
-      }
-
-      if (intersectResults.size() != 0 &&
-          core->mCollisionDetectResponseSets[collisionPairRange[i]]
-                  .custom_handle != 0)
-        core->mCollisionDetectResponseSets[collisionPairRange[i]].custom_handle(
-            intersectResults,
-            core->mCollisionDetectResponseSets[collisionPairRange[i]].pContext);
-    }
-
-    // Phase 2.3
-    core->mEnterBarrier->wait();
-
-    for (dtkID i = 0; i < internalCollisionPairRange.size(); i++) {
-      vector<dtkIntersectTest::IntersectResult::Ptr> intersectResults;
-      core->mStage->DoIntersect(core->mInternalCollisionDetectResponseSets
-                                    [internalCollisionPairRange[i]]
-                                        .hierarchy_pair,
-                                intersectResults,
-                                core->mInternalCollisionDetectResponseSets
-                                    [internalCollisionPairRange[i]]
-                                        .self,
-                                false);
-      core->mThreadCollisionDetectResponse->Update(core->mTimeslice,
-                                                   intersectResults);
-
-      const std::vector<dtkInterval<int>> &internalIntervals =
-          core->mThreadCollisionDetectResponse->GetInternalIntervals(
-              internalCollisionPairRange[i] % core->mPairOffset);
-      dtkCollisionDetectHierarchyKDOPS::Ptr threadHierarchy =
-          core->mThreadCollisionDetectHierarchies
-              [internalCollisionPairRange[i] % core->mPairOffset];
-      for (dtkID n = 0; n < threadHierarchy->GetNumberOfPrimitives(); n++) {
-        threadHierarchy->GetPrimitive(n)->mInvert = 0;
-      }
-      for (dtkID n = 0; n < internalIntervals.size(); n++) {
-        for (int l = internalIntervals[n][0]; l <= internalIntervals[n][1];
-             l++) {
-          threadHierarchy->GetPrimitive(l)->mInvert = 1;
-        }
-      }
-    }
-
-    // Phase 3
-    core->mEnterBarrier->wait();
-
-    for (dtkID i = 0; i < massSpringRange.size(); i++) {
-      if (core->mTimeslice == 0)
-        continue;
-
-      if (core->mMassSprings[massSpringRange[i]]->IsUnderControl()) {
-        core->mMassSprings[massSpringRange[i]]->ConvertImpulseToForce(
-            core->mTimeslice);
-        continue;
-      }
+// 查找对象在 Reallocate 中分配到的线程, 未分配时返回 dtkErrorID.
+static dtkID find_worker(const map<dtkID, dtkID> &workers, dtkID id) {
+  map<dtkID, dtkID>::const_iterator itr = workers.find(id);
+  if (itr == workers.end())
+    return dtkErrorID;
+  return itr->second;
+}
 
-      core->mMassSprings[massSpringRange[i]]->ApplyImpulse(core->mTimeslice);
-      core->mMassSprings[massSpringRange[i]]->PreUpdate(core->mTimeslice,
-                                                        Collision, 1);
-      core->mMassSprings[massSpringRange[i]]->UpdateStrings(core->mTimeslice,
-                                                            Collision, 1, true);
-    }
+// 子步 substep 是否包含该对象, 受控与休眠的对象不参与.
+static bool in_substep(dtkPhysMassSpring *massSpring, dtkID substep) {
+  return massSpring->GetSubsteps() > substep &&
+         !massSpring->IsUnderControl() && !massSpring->IsSleeping();
+}
 
-    // exit_barrier->wait();
+// 缝合线第 i 个端点处的平滑方向, 取相邻两段方向之和.
+static dtkDouble3 smoothed_direction(dtkPhysMassSpringThread *thread,
+                                     dtkID i) {
+  dtkDouble3 curPoint = thread->GetMassPoint(i * 2)->GetPosition();
+  dtkDouble3 smoothedDirection(0, 0, 0);
+  int num = 0;
+  if (i != 0) {
+    smoothedDirection = smoothedDirection + curPoint -
+                        thread->GetMassPoint(i * 2 - 2)->GetPosition();
+    num++;
+  }
+  if (i != thread->GetNumberOfSegments()) {
+    smoothedDirection = smoothedDirection +
+                        thread->GetMassPoint(i * 2 + 2)->GetPosition() -
+                        curPoint;
+    num++;
+  }
+  if (num == 0)
+    assert(false);
+  return normalize(smoothedDirection);
+}
 
-    // Phase 4
-    core->mEnterBarrier->wait();
+// 任务图中的汇合点, 本身不做任何事.
+static void join_tasks() {}
 
-    for (dtkID i = 0; i < massSpringRange.size(); i++) {
-      if (core->mTimeslice == 0 ||
-          core->mMassSprings[massSpringRange[i]]->IsUnderControl())
-        continue;
-      core->mMassSprings[massSpringRange[i]]->UpdateMassPoints(core->mTimeslice,
-                                                               Collision, 1);
-      core->mMassSprings[massSpringRange[i]]->PostUpdate(Collision, 1);
-    }
-
-    core->mExitBarrier->wait();
-  } while (true);
+static void collect_workers(const vector<vector<vector<dtkID>>> &allocator,
+                            dtkID pos, map<dtkID, dtkID> &workers) {
+  for (dtkID i = 0; i < allocator.size(); i++) {
+    for (dtkID j = 0; j < allocator[i][pos].size(); j++)
+      workers[allocator[i][pos][j]] = i;
+  }
 }
 
 dtkPhysCore::dtkPhysCore(double clothDepth) {
@@ -250,141 +85,413 @@ dtkPhysCore::dtkPhysCore(double clothDepth) {
   mStaticMeshEliminator = dtkStaticMeshEliminator::New();
 
   mNumberOfThreads = 0;
-  mThreadGroup = 0;
-  mEnterBarrier = 0;
-  mExitBarrier = 0;
+  mPinThreads = false;
+
+  mRebalanceThreshold = 1.25;
+  mImbalanceRatio = 1;
+  mFramesSinceRebalance = 0;
+
+  mPipelined = false;
+  mFrame = 0;
+
+  mLatestFrame = 0;
+  mDriverLive = false;
+  mFixedTimeslice = 0;
 
   mClothDepth = clothDepth;
 }
 
 dtkPhysCore::~dtkPhysCore() {
-  if (mNumberOfThreads > 0) {
-    mLive = false;
-    mEnterBarrier->wait();
-    mThreadGroup->join_all();
-    delete mThreadGroup;
-    delete mEnterBarrier;
-    delete mExitBarrier;
-  }
+  StopFixedRateUpdate();
+
+  // 任务图中保存了 this, 先结束工作线程.
+  // 各子系统也持有调度器, 一并释放后线程才会退出.
+  mScheduler.reset();
+  ShareTaskScheduler();
 }
 
 void dtkPhysCore::Update(double timeslice) {
+  mFrame++;
+  if (mPipelined)
+    PrepareSnapshot();
+
   if (mNumberOfThreads > 1)
     _Update_mt(timeslice);
   else
     _Update_s(timeslice);
+
+  if (mPipelined)
+    PublishSnapshot();
+  mLatestFrame = mFrame;
 }
 
-void dtkPhysCore::_Update_s(double timeslice) {
-  mTimeslice = timeslice;
+std::future<size_t> dtkPhysCore::UpdateAsync(double timeslice) {
+  boost::unique_lock<boost::mutex> lock(mDriverMutex);
+  mAsyncRequests.push_back(
+      std::make_pair(timeslice, std::promise<size_t>()));
+  std::future<size_t> future = mAsyncRequests.back().second.get_future();
+  StartDriver(lock);
+  mDriverCondition.notify_all();
+  return future;
+}
 
-  // update mass-spring model:iteration 0
-  for (map<dtkID, dtkPhysMassSpring::Ptr>::iterator itr = mMassSprings.begin();
-       itr != mMassSprings.end(); itr++) {
-    if (timeslice == 0 || itr->second->IsUnderControl())
-      continue;
-    itr->second->PreUpdate(timeslice, Collision, 0);
-    itr->second->UpdateStrings(timeslice, Collision, 0, true);
+void dtkPhysCore::StartFixedRateUpdate(double timeslice) {
+  assert(timeslice > 0);
+  boost::unique_lock<boost::mutex> lock(mDriverMutex);
+  mFixedTimeslice = timeslice;
+  StartDriver(lock);
+  mDriverCondition.notify_all();
+}
+
+void dtkPhysCore::StopFixedRateUpdate() {
+  boost::thread finished;
+  // 未执行的请求在锁内取出, 之后的 UpdateAsync 只会看到空队列;
+  // 函数返回时随 promise 析构得到 broken_promise.
+  std::deque<std::pair<double, std::promise<size_t>>> dropped;
+  {
+    boost::unique_lock<boost::mutex> lock(mDriverMutex);
+    dropped.swap(mAsyncRequests);
+    mDriverLive = false;
+    mFixedTimeslice = 0;
+    finished = boost::move(mDriverThread);
   }
-  for (map<dtkID, dtkPhysMassSpring::Ptr>::iterator itr = mMassSprings.begin();
-       itr != mMassSprings.end(); itr++) {
-    if (timeslice == 0 || itr->second->IsUnderControl())
-      continue;
-    itr->second->TransportForce(timeslice);
-    itr->second->UpdateMassPoints(timeslice, Collision, 0);
-    itr->second->PostUpdate(Collision, 0);
+  mDriverCondition.notify_all();
+  if (finished.joinable())
+    finished.join();
+}
+
+void dtkPhysCore::StartDriver(boost::unique_lock<boost::mutex> &lock) {
+  // 仿真线程退出前还要取 mDriverMutex, 不能持锁 join.
+  // 把旧线程移出后释放锁, 期间其他调用者可能已经启动了新线程.
+  while (!mDriverLive && mDriverThread.joinable()) {
+    boost::thread finished = boost::move(mDriverThread);
+    lock.unlock();
+    finished.join();
+    lock.lock();
   }
+  if (mDriverLive)
+    return;
+  mDriverLive = true;
+  mDriverThread = boost::thread(&dtkPhysCore::DriverLoop, this);
+}
 
-  // update hierachy
-  mStage->Update();
+void dtkPhysCore::DriverLoop() {
+  typedef boost::chrono::steady_clock clock;
+  clock::time_point next = clock::now();
+
+  boost::unique_lock<boost::mutex> lock(mDriverMutex);
+  while (mDriverLive) {
+    if (!mAsyncRequests.empty()) {
+      std::pair<double, std::promise<size_t>> request =
+          std::move(mAsyncRequests.front());
+      mAsyncRequests.pop_front();
+      lock.unlock();
+      Update(request.first);
+      request.second.set_value(mLatestFrame);
+      lock.lock();
+      continue;
+    }
 
-  // update collision response result
-  vector<dtkInterval<int>> emptyIntervals;
-  for (map<dtkID, CollisionResponseSet>::iterator itr =
-           mCollisionDetectResponseSets.begin();
-       itr != mCollisionDetectResponseSets.end(); itr++) {
-    vector<dtkIntersectTest::IntersectResult::Ptr> intersectResults;
-    mStage->DoIntersect(itr->second.hierarchy_pair, intersectResults,
-                        itr->second.self, false);
-    if (itr->second.responseType == THREAD_SURFACE) {
-      mCollisionDetectResponse->Update(
-          timeslice, intersectResults, emptyIntervals,
-          mThreadCollisionDetectResponse->GetAvoidIntervals(itr->first %
-                                                            mPairOffset),
-          itr->second.strength);
-    } else if (itr->second.responseType == KNOTPLANNING) {
-      mCollisionDetectResponse->Update(
-          timeslice, intersectResults,
-          mKnotPlanners[itr->first % mPairOffset]->GetAvoidIntervals(),
-          mKnotPlanners[itr->first % mPairOffset]->GetAvoidIntervals(),
-          itr->second.strength);
-    } else if (itr->second.responseType == INTERIOR_THREADHEAD) {
-      assert(false);
-    } else {
-      mCollisionDetectResponse->Update(timeslice, intersectResults,
-                                       emptyIntervals, emptyIntervals,
-                                       itr->second.strength);
+    if (mFixedTimeslice <= 0) {
+      mDriverCondition.wait(lock);
+      next = clock::now();
+      continue;
     }
 
-    if (itr->second.responseType == KNOTPLANNING) {
-      mKnotPlanners[itr->first / mPairOffset]->KnotRecognition(
-          intersectResults);
+    clock::time_point now = clock::now();
+    if (now < next) {
+      mDriverCondition.wait_until(lock, next);
+      continue;
     }
 
-    if (intersectResults.size() != 0 && itr->second.custom_handle != 0)
-      itr->second.custom_handle(intersectResults, itr->second.pContext);
+    double timeslice = mFixedTimeslice;
+    lock.unlock();
+    Update(timeslice);
+    lock.lock();
+
+    // 落后超过一个周期时不追帧, 避免越追越慢.
+    next += boost::chrono::duration_cast<clock::duration>(
+        boost::chrono::duration<double>(timeslice));
+    now = clock::now();
+    if (next < now)
+      next = now;
   }
+}
 
-  // update internal collision response result
-  for (map<dtkID, CollisionResponseSet>::iterator itr =
-           mInternalCollisionDetectResponseSets.begin();
-       itr != mInternalCollisionDetectResponseSets.end(); itr++) {
-    vector<dtkIntersectTest::IntersectResult::Ptr> intersectResults;
-    mStage->DoIntersect(itr->second.hierarchy_pair, intersectResults,
-                        itr->second.self, false);
-    mThreadCollisionDetectResponse->Update(timeslice, intersectResults);
-
-    const std::vector<dtkInterval<int>> &internalIntervals =
-        mThreadCollisionDetectResponse->GetInternalIntervals(itr->first %
-                                                             mPairOffset);
-    dtkCollisionDetectHierarchyKDOPS::Ptr threadHierarchy =
-        mThreadCollisionDetectHierarchies[itr->first % mPairOffset];
-    for (dtkID n = 0; n < threadHierarchy->GetNumberOfPrimitives(); n++) {
-      threadHierarchy->GetPrimitive(n)->mInvert = 0;
+void dtkPhysCore::SetPipelined(bool pipelined) {
+  mPipelined = pipelined;
+  if (mNumberOfThreads > 1)
+    BuildTaskGraph();
+}
+
+// 按编号写入拷贝项, 已有的项原位改写.
+static void prepare_snapshot_copies(
+    std::map<dtkID, std::pair<const dtkPoints *, dtkPointsVector *>> &copies,
+    dtkPhysSnapshot *snapshot, dtkID id, bool thread,
+    const dtkPoints *source) {
+  std::pair<const dtkPoints *, dtkPointsVector *> &copy = copies[id];
+  copy.first = source;
+  copy.second = snapshot->Acquire(id, thread, source->GetNumberOfPoints());
+}
+
+void dtkPhysCore::PrepareSnapshot() {
+  // 读者仍持有旧快照时换一个新的, 已发布的快照从不被改写.
+  if (!mBackSnapshot || mBackSnapshot.use_count() > 1)
+    mBackSnapshot = dtkPhysSnapshot::New();
+
+  // 拷贝任务按编号查找, 与这里的遍历顺序无关.
+  mBackSnapshot->BeginFrame(mFrame);
+  for (SnapshotCopies::iterator itr = mSnapshotCopies.begin();
+       itr != mSnapshotCopies.end();) {
+    if (mMassSprings.find(itr->first) == mMassSprings.end())
+      mSnapshotCopies.erase(itr++);
+    else
+      itr++;
+  }
+  for (SnapshotCopies::iterator itr = mThreadSnapshotCopies.begin();
+       itr != mThreadSnapshotCopies.end();) {
+    if (mThreadPoints.find(itr->first) == mThreadPoints.end())
+      mThreadSnapshotCopies.erase(itr++);
+    else
+      itr++;
+  }
+  for (map<dtkID, dtkPhysMassSpring::Ptr>::iterator itr = mMassSprings.begin();
+       itr != mMassSprings.end(); itr++) {
+    prepare_snapshot_copies(mSnapshotCopies, mBackSnapshot.get(), itr->first,
+                            false, itr->second->GetPoints().get());
+  }
+  for (map<dtkID, dtkPoints::Ptr>::iterator itr = mThreadPoints.begin();
+       itr != mThreadPoints.end(); itr++) {
+    prepare_snapshot_copies(mThreadSnapshotCopies, mBackSnapshot.get(),
+                            itr->first, true, itr->second.get());
+  }
+  mBackSnapshot->EndFrame();
+}
+
+void dtkPhysCore::_CopySnapshotPoints(dtkID id, bool thread) {
+  const SnapshotCopies &copies =
+      thread ? mThreadSnapshotCopies : mSnapshotCopies;
+  SnapshotCopies::const_iterator itr = copies.find(id);
+  if (itr == copies.end())
+    return;
+  const dtkPoints *source = itr->second.first;
+  dtkPointsVector *target = itr->second.second;
+  for (dtkID i = 0; i < target->GetNumberOfPoints(); i++)
+    target->SetPoint(i, source->GetPoint(i));
+}
+
+void dtkPhysCore::PublishSnapshot() {
+  mBackSnapshot = std::atomic_exchange(&mFrontSnapshot, mBackSnapshot);
+}
+
+void dtkPhysCore::_UpdateBundle(dtkID bundle, dtkID iteration) {
+  if (mTimeslice == 0)
+    return;
+
+  // 弹簧束中的对象子步数相同, 最后一个子步与碰撞检测衔接.
+  const vector<dtkPhysMassSpring *> &massSprings = mBundles[bundle];
+  if (iteration == 0) {
+    for (dtkID i = 0; i < massSprings.size(); i++) {
+      massSprings[i]->WakeDisturbed();
+      _SyncHierarchySleeping(mBundleIDs[bundle][i], massSprings[i]);
+    }
+    _UpdateFreeSubsteps(massSprings);
+    for (dtkID i = 0; i < massSprings.size(); i++) {
+      dtkPhysMassSpring *massSpring = massSprings[i];
+      if (massSpring->IsUnderControl() || massSpring->IsSleeping())
+        continue;
+      size_t substeps = massSpring->GetSubsteps();
+      if (substeps > 1)
+        massSpring->InterpolateBoundary(substeps);
+      massSpring->PreUpdate(mTimeslice / substeps, Collision, 0);
+      massSpring->UpdateStrings(mTimeslice / substeps, Collision, 0, true);
     }
-    for (dtkID n = 0; n < internalIntervals.size(); n++) {
-      for (int l = internalIntervals[n][0]; l <= internalIntervals[n][1]; l++) {
-        threadHierarchy->GetPrimitive(l)->mInvert = 1;
+    for (dtkID i = 0; i < massSprings.size(); i++)
+      massSprings[i]->ResolveTwinForces();
+    for (dtkID i = 0; i < massSprings.size(); i++) {
+      dtkPhysMassSpring *massSpring = massSprings[i];
+      if (massSpring->IsUnderControl() || massSpring->IsSleeping())
+        continue;
+      double timeslice = mTimeslice / massSpring->GetSubsteps();
+      massSpring->TransportForce(timeslice);
+      massSpring->UpdateMassPoints(timeslice, Collision, 0);
+    }
+  } else {
+    for (dtkID i = 0; i < massSprings.size(); i++)
+      massSprings[i]->ResolveTwinImpulses();
+    for (dtkID i = 0; i < massSprings.size(); i++) {
+      dtkPhysMassSpring *massSpring = massSprings[i];
+      if (massSpring->IsUnderControl()) {
+        massSpring->ConvertImpulseToForce(mTimeslice);
+        continue;
       }
+      // 碰撞响应写入的冲量会唤醒休眠的对象.
+      massSpring->WakeDisturbed();
+      if (massSpring->IsSleeping())
+        continue;
+      double timeslice = mTimeslice / massSpring->GetSubsteps();
+      massSpring->ApplyImpulse(timeslice);
+      massSpring->PreUpdate(timeslice, Collision, 1);
+      massSpring->UpdateStrings(timeslice, Collision, 1, true);
+    }
+    for (dtkID i = 0; i < massSprings.size(); i++)
+      massSprings[i]->ResolveTwinForces();
+    for (dtkID i = 0; i < massSprings.size(); i++) {
+      dtkPhysMassSpring *massSpring = massSprings[i];
+      if (massSpring->IsUnderControl() || massSpring->IsSleeping())
+        continue;
+      double timeslice = mTimeslice / massSpring->GetSubsteps();
+      massSpring->UpdateMassPoints(timeslice, Collision, 1);
+      massSpring->PostUpdate(Collision, 1);
+      massSpring->UpdateSleeping();
     }
   }
+}
 
-  // apply impulse into the mass points and update mass-spring model iteration :
-  // 1
-  for (map<dtkID, dtkPhysMassSpring::Ptr>::iterator itr = mMassSprings.begin();
-       itr != mMassSprings.end(); itr++) {
-    if (timeslice == 0)
+void dtkPhysCore::_UpdateFreeSubsteps(
+    const vector<dtkPhysMassSpring *> &massSprings) {
+  size_t substeps = 1;
+  for (dtkID i = 0; i < massSprings.size(); i++) {
+    if (!in_substep(massSprings[i], 1))
       continue;
+    massSprings[i]->BeginSubsteps();
+    substeps = max(substeps, massSprings[i]->GetSubsteps());
+  }
 
-    if (itr->second->IsUnderControl()) {
-      itr->second->ConvertImpulseToForce(timeslice);
-      continue;
+  // 与宏步相同的两次迭代, 但不做碰撞检测, 也没有冲量.
+  for (dtkID substep = 1; substep < substeps; substep++) {
+    for (dtkID iteration = 0; iteration < 2; iteration++) {
+      for (dtkID i = 0; i < massSprings.size(); i++) {
+        dtkPhysMassSpring *massSpring = massSprings[i];
+        if (!in_substep(massSpring, substep))
+          continue;
+        double timeslice = mTimeslice / massSpring->GetSubsteps();
+        if (iteration == 0)
+          massSpring->InterpolateBoundary(substep);
+        massSpring->PreUpdate(timeslice, Collision, iteration);
+        massSpring->UpdateStrings(timeslice, Collision, iteration, true);
+      }
+      for (dtkID i = 0; i < massSprings.size(); i++) {
+        if (in_substep(massSprings[i], substep))
+          massSprings[i]->ResolveTwinForces();
+      }
+      for (dtkID i = 0; i < massSprings.size(); i++) {
+        dtkPhysMassSpring *massSpring = massSprings[i];
+        if (!in_substep(massSpring, substep))
+          continue;
+        double timeslice = mTimeslice / massSpring->GetSubsteps();
+        massSpring->UpdateMassPoints(timeslice, Collision, iteration);
+        massSpring->PostUpdate(Collision, iteration);
+      }
     }
+  }
+}
 
-    itr->second->ApplyImpulse(timeslice);
-    itr->second->PreUpdate(timeslice, Collision, 1);
-    itr->second->UpdateStrings(timeslice, Collision, 1, true);
+void dtkPhysCore::_SyncHierarchySleeping(dtkID id,
+                                         dtkPhysMassSpring *massSpring) {
+  // 与 BuildTaskGraph 中的四类碰撞检测树一致.
+  map<dtkID, dtkCollisionDetectHierarchyKDOPS::Ptr> *hierarchies[4] = {
+      &mCollisionDetectHierarchies, &mThreadCollisionDetectHierarchies,
+      &mInteriorCollisionDetectHierarchies,
+      &mThreadHeadCollisionDetectHierarchies};
+  bool sleeping = massSpring->IsSleeping() && !massSpring->IsUnderControl();
+  for (dtkID type = 0; type < 4; type++) {
+    map<dtkID, dtkCollisionDetectHierarchyKDOPS::Ptr>::iterator itr =
+        hierarchies[type]->find(id);
+    if (itr != hierarchies[type]->end())
+      itr->second->SetSleeping(sleeping);
   }
-  for (map<dtkID, dtkPhysMassSpring::Ptr>::iterator itr = mMassSprings.begin();
-       itr != mMassSprings.end(); itr++) {
-    if (timeslice == 0 || itr->second->IsUnderControl())
-      continue;
-    itr->second->UpdateMassPoints(timeslice, Collision, 1);
-    itr->second->PostUpdate(Collision, 1);
+}
+
+void dtkPhysCore::ResolveResponseSet(dtkID id, bool internal,
+                                     ResponseDescriptor &descriptor) {
+  static const vector<dtkInterval<int>> emptyIntervals;
+
+  descriptor.id = id;
+  descriptor.avoid_1 = &emptyIntervals;
+  descriptor.avoid_2 = &emptyIntervals;
+  descriptor.knot_planner = 0;
+  descriptor.thread_hierarchy = 0;
+  descriptor.internal_intervals = 0;
+  descriptor.intersect_results.clear();
+
+  if (internal) {
+    descriptor.response_set = &mInternalCollisionDetectResponseSets[id];
+    descriptor.thread_hierarchy =
+        mThreadCollisionDetectHierarchies[id % mPairOffset].get();
+    descriptor.internal_intervals =
+        &mThreadCollisionDetectResponse->GetInternalIntervals(id %
+                                                              mPairOffset);
+    return;
   }
 
+  descriptor.response_set = &mCollisionDetectResponseSets[id];
+  if (descriptor.response_set->responseType == THREAD_SURFACE) {
+    descriptor.avoid_2 =
+        &mThreadCollisionDetectResponse->GetAvoidIntervals(id % mPairOffset);
+  } else if (descriptor.response_set->responseType == KNOTPLANNING) {
+    descriptor.avoid_1 = &mKnotPlanners[id % mPairOffset]->GetAvoidIntervals();
+    descriptor.avoid_2 = descriptor.avoid_1;
+    descriptor.knot_planner = mKnotPlanners[id / mPairOffset].get();
+  }
+}
+
+void dtkPhysCore::_UpdateCollisionResponseSet(ResponseDescriptor &descriptor) {
+  CollisionResponseSet &responseSet = *descriptor.response_set;
+  vector<dtkIntersectTest::IntersectResult> &intersectResults =
+      descriptor.intersect_results;
+
+  mStage->DoIntersect(responseSet.hierarchy_pair, intersectResults,
+                      responseSet.self, false);
+  if (responseSet.responseType == INTERIOR_THREADHEAD) {
+    assert(false);
+  } else {
+    mCollisionDetectResponse->Update(mTimeslice, intersectResults,
+                                     *descriptor.avoid_1, *descriptor.avoid_2,
+                                     responseSet.strength);
+  }
+
+  if (descriptor.knot_planner != 0)
+    descriptor.knot_planner->KnotRecognition(intersectResults);
+
+  if (intersectResults.size() != 0 && responseSet.custom_handle != 0)
+    responseSet.custom_handle(intersectResults, responseSet.pContext);
+
+  // 保留容量, 下一帧不再分配.
+  intersectResults.clear();
+}
+
+void dtkPhysCore::_UpdateInternalCollisionResponseSet(
+    ResponseDescriptor &descriptor) {
+  CollisionResponseSet &responseSet = *descriptor.response_set;
+  vector<dtkIntersectTest::IntersectResult> &intersectResults =
+      descriptor.intersect_results;
+
+  mStage->DoIntersect(responseSet.hierarchy_pair, intersectResults,
+                      responseSet.self, false);
+  mThreadCollisionDetectResponse->Update(mTimeslice, intersectResults);
+
+  const std::vector<dtkInterval<int>> &internalIntervals =
+      *descriptor.internal_intervals;
+  dtkCollisionDetectHierarchyKDOPS *threadHierarchy =
+      descriptor.thread_hierarchy;
+  for (dtkID n = 0; n < threadHierarchy->GetNumberOfPrimitives(); n++) {
+    threadHierarchy->GetPrimitive(n)->mInvert = 0;
+  }
+  for (dtkID n = 0; n < internalIntervals.size(); n++) {
+    for (int l = internalIntervals[n][0]; l <= internalIntervals[n][1]; l++) {
+      threadHierarchy->GetPrimitive(l)->mInvert = 1;
+    }
+  }
+
+  intersectResults.clear();
+}
+
+void dtkPhysCore::_UpdateAdherePointSets() {
   for (dtkID i = 0; i < mAdherePointSets.size(); i++) {
     AdherePointSet &adherePointSet = mAdherePointSets[i];
+
+    // 重心
     GK::Point3 p_tri = barycenter(
         adherePointSet.dominate_pts->GetPoint(adherePointSet.dominate_tri[0]),
         adherePointSet.uvw[0],
@@ -399,11 +506,13 @@ void dtkPhysCore::_Update_s(double timeslice) {
         mMassSprings[adherePointSet.dominate_ID];
     dtkPhysMassSpring::Ptr slave_ms = mMassSprings[adherePointSet.slave_ID];
 
+    // 主三角形点更新
     for (dtkID j = 0; j < 3; j++) {
       dtkPhysMassPoint *dominate_mp =
           dominate_ms->GetMassPoint(adherePointSet.dominate_tri[j]);
       GK::Vector3 dominate_vel =
           normal * adherePointSet.slave_ratio * adherePointSet.uvw[j];
+
       GK::Point3 tmp_p = adherePointSet.dominate_pts->GetPoint(
                              adherePointSet.dominate_tri[j]) +
                          dominate_vel;
@@ -414,8 +523,10 @@ void dtkPhysCore::_Update_s(double timeslice) {
           dtkT3<double>(dominate_vel[0], dominate_vel[1], dominate_vel[2]));
     }
 
+    // 从点更新
     dtkPhysMassPoint *slave_mp = slave_ms->GetMassPoint(adherePointSet.slave_p);
     GK::Vector3 slave_vel = -normal * (1.0 - adherePointSet.slave_ratio);
+
     GK::Point3 tmp_p =
         adherePointSet.slave_pts->GetPoint(adherePointSet.slave_p) + slave_vel;
     slave_mp->SetPoint(tmp_p);
@@ -423,119 +534,246 @@ void dtkPhysCore::_Update_s(double timeslice) {
     slave_mp->SetVel(slave_mp->GetVel() +
                      dtkT3<double>(slave_vel[0], slave_vel[1], slave_vel[2]));
   }
+}
+
+void dtkPhysCore::_UpdateParticleSystem(
+    dtkPhysParticleSystem *particleSystem) {
+  if (mTimeslice == 0)
+    return;
+  particleSystem->Update(mTimeslice);
+}
+
+void dtkPhysCore::_UpdateObstacleSet(ObstacleSet &obstacleSet) {
+  if (mTimeslice == 0)
+    return;
+
+  // 两个结果缓冲都保留容量, 下一帧不再分配.
+  vector<dtkIntersectTest::IntersectResult> &particleIntersectResult =
+      obstacleSet.particle_intersect_results;
+  particleIntersectResult.clear();
+  for (dtkID i = 0; i < obstacleSet.particlesystem->GetNumberOfParticles();
+       i++) {
+    GK::Point3 particle = obstacleSet.particlesystem->GetPoint(i);
+    obstacleSet.pts->SetPoint(0, particle);
+
+    // 更新包围盒
+    obstacleSet.hierarchy_pair.second->Update();
+    vector<dtkIntersectTest::IntersectResult> &intersectResults =
+        obstacleSet.intersect_results;
+    intersectResults.clear();
+
+    // kDOPS相交测试
+    mStage->DoIntersect(obstacleSet.hierarchy_pair, intersectResults, false,
+                        false);
+    for (dtkID j = 0; j < intersectResults.size(); j++) {
+      // 更新粒子
+      const GK::Vector3 &normal = intersectResults[j].normal;
+      obstacleSet.particlesystem->SetPoint(i, particle + normal);
+      obstacleSet.particlesystem->GetParticle(i)->AddForce(
+          dtkDouble3(-normal[0], -normal[1], -normal[2]) *
+          obstacleSet.viscosityCoef);
+
+      particleIntersectResult.push_back(intersectResults[j]);
+    }
+  }
+  if (particleIntersectResult.size() != 0 && obstacleSet.custom_handle != 0)
+    obstacleSet.custom_handle(particleIntersectResult, obstacleSet.pContext);
+  obstacleSet.intersect_results.clear();
+  particleIntersectResult.clear();
+}
+
+void dtkPhysCore::_UpdateDeviceForceFeedback(dtkID deviceLabel,
+                                             dtkT3<double> &forceFeedback) {
+  // GetTransportForce 不修改质量弹簧, 多个设备可以同时归约;
+  // 求和顺序固定, 结果与线程数无关.
+  forceFeedback = dtkT3<double>(0, 0, 0);
+  for (map<dtkID, dtkPhysMassSpring::Ptr>::const_iterator itr_ms =
+           mMassSprings.begin();
+       itr_ms != mMassSprings.end(); itr_ms++) {
+    forceFeedback =
+        forceFeedback + itr_ms->second->GetTransportForce(deviceLabel);
+  }
+  if (forceFeedback[0] == 0 && forceFeedback[1] == 0 &&
+      forceFeedback[2] == 0) {
+    const vector<dtkID> &objects = mDeviceLabels.find(deviceLabel)->second;
+    for (dtkID i = 0; i < objects.size(); i++) {
+      forceFeedback = forceFeedback +
+                      mMassSprings.find(objects[i])->second->GetImpulseForce();
+    }
+  }
+}
+
+void dtkPhysCore::_UpdateKnotPlanner(dtkPhysKnotPlanner *knotPlanner) {
+  knotPlanner->DoKnotFormation();
+  knotPlanner->UpdateKnot(mTimeslice);
+}
+
+void dtkPhysCore::_SmoothSutureThread(dtkPhysMassSpringThread *thread,
+                                      dtkPoints *threadPoints) {
+  double interval = thread->GetInterval() * 0.5;
+
+  // 每段的四个控制点由两端点及其平滑方向得到, 沿线依次计算, 不再缓存.
+  dtkDouble3 curPoint = thread->GetMassPoint(0)->GetPosition();
+  dtkDouble3 curDirection = smoothed_direction(thread, 0);
+
+  dtkID mSmoothedNumber = 10;
+  for (dtkID i = 0; i < thread->GetNumberOfSegments(); i++) {
+    dtkDouble3 nextPoint = thread->GetMassPoint(i * 2 + 2)->GetPosition();
+    dtkDouble3 nextDirection = smoothed_direction(thread, i + 1);
+    dtkDouble3 control_1 = curPoint + curDirection * interval;
+    dtkDouble3 control_2 = nextPoint - nextDirection * interval;
+
+    double step = 1.0 / (double)mSmoothedNumber;
+    double t;
+    for (dtkID j = 0; j < mSmoothedNumber; j++) {
+      t = step * j;
+      dtkDouble3 smoothedPoint = curPoint * ((1 - t) * (1 - t) * (1 - t)) +
+                                 control_1 * (3.0 * t * (1 - t) * (1 - t)) +
+                                 control_2 * (3.0 * t * t * (1 - t)) +
+                                 nextPoint * (t * t * t);
+      threadPoints->SetPoint(
+          i * mSmoothedNumber + j,
+          GK::Point3(smoothedPoint[0], smoothedPoint[1], smoothedPoint[2]));
+    }
+    curPoint = nextPoint;
+    curDirection = nextDirection;
+  }
+}
+
+void dtkPhysCore::_Update_s(double timeslice) {
+  mTimeslice = timeslice;
+
+  // update mass-spring model:iteration 0
+  mSubstepMassSprings.clear();
+  for (map<dtkID, dtkPhysMassSpring::Ptr>::iterator itr = mMassSprings.begin();
+       itr != mMassSprings.end(); itr++) {
+    itr->second->WakeDisturbed();
+    _SyncHierarchySleeping(itr->first, itr->second.get());
+    mSubstepMassSprings.push_back(itr->second.get());
+  }
+  if (timeslice != 0)
+    _UpdateFreeSubsteps(mSubstepMassSprings);
+  for (map<dtkID, dtkPhysMassSpring::Ptr>::iterator itr = mMassSprings.begin();
+       itr != mMassSprings.end(); itr++) {
+    if (timeslice == 0 || itr->second->IsUnderControl() ||
+        itr->second->IsSleeping())
+      continue;
+    size_t substeps = itr->second->GetSubsteps();
+    if (substeps > 1)
+      itr->second->InterpolateBoundary(substeps);
+    itr->second->PreUpdate(timeslice / substeps, Collision, 0);
+    itr->second->UpdateStrings(timeslice / substeps, Collision, 0, true);
+  }
+  for (map<dtkID, dtkPhysMassSpring::Ptr>::iterator itr = mMassSprings.begin();
+       itr != mMassSprings.end(); itr++)
+    itr->second->ResolveTwinForces();
+  for (map<dtkID, dtkPhysMassSpring::Ptr>::iterator itr = mMassSprings.begin();
+       itr != mMassSprings.end(); itr++) {
+    if (timeslice == 0 || itr->second->IsUnderControl() ||
+        itr->second->IsSleeping())
+      continue;
+    double substepTimeslice = timeslice / itr->second->GetSubsteps();
+    itr->second->TransportForce(substepTimeslice);
+    itr->second->UpdateMassPoints(substepTimeslice, Collision, 0);
+    itr->second->PostUpdate(Collision, 0);
+  }
+
+  // update hierachy
+  mStage->Update();
+
+  // update collision response result
+  for (map<dtkID, CollisionResponseSet>::iterator itr =
+           mCollisionDetectResponseSets.begin();
+       itr != mCollisionDetectResponseSets.end(); itr++) {
+    ResolveResponseSet(itr->first, false, mSerialDescriptor);
+    _UpdateCollisionResponseSet(mSerialDescriptor);
+  }
+
+  // update internal collision response result
+  for (map<dtkID, CollisionResponseSet>::iterator itr =
+           mInternalCollisionDetectResponseSets.begin();
+       itr != mInternalCollisionDetectResponseSets.end(); itr++) {
+    ResolveResponseSet(itr->first, true, mSerialDescriptor);
+    _UpdateInternalCollisionResponseSet(mSerialDescriptor);
+  }
+
+  // apply impulse into the mass points and update mass-spring model iteration :
+  // 1
+  for (map<dtkID, dtkPhysMassSpring::Ptr>::iterator itr = mMassSprings.begin();
+       itr != mMassSprings.end(); itr++)
+    itr->second->ResolveTwinImpulses();
+  for (map<dtkID, dtkPhysMassSpring::Ptr>::iterator itr = mMassSprings.begin();
+       itr != mMassSprings.end(); itr++) {
+    if (timeslice == 0)
+      continue;
+
+    if (itr->second->IsUnderControl()) {
+      itr->second->ConvertImpulseToForce(timeslice);
+      continue;
+    }
+
+    // 碰撞响应写入的冲量会唤醒休眠的对象.
+    itr->second->WakeDisturbed();
+    if (itr->second->IsSleeping())
+      continue;
+    double substepTimeslice = timeslice / itr->second->GetSubsteps();
+    itr->second->ApplyImpulse(substepTimeslice);
+    itr->second->PreUpdate(substepTimeslice, Collision, 1);
+    itr->second->UpdateStrings(substepTimeslice, Collision, 1, true);
+  }
+  for (map<dtkID, dtkPhysMassSpring::Ptr>::iterator itr = mMassSprings.begin();
+       itr != mMassSprings.end(); itr++)
+    itr->second->ResolveTwinForces();
+  for (map<dtkID, dtkPhysMassSpring::Ptr>::iterator itr = mMassSprings.begin();
+       itr != mMassSprings.end(); itr++) {
+    if (timeslice == 0 || itr->second->IsUnderControl() ||
+        itr->second->IsSleeping())
+      continue;
+    double substepTimeslice = timeslice / itr->second->GetSubsteps();
+    itr->second->UpdateMassPoints(substepTimeslice, Collision, 1);
+    itr->second->PostUpdate(Collision, 1);
+    itr->second->UpdateSleeping();
+  }
+
+  _UpdateAdherePointSets();
 
   for (map<dtkID, dtkPhysParticleSystem::Ptr>::iterator itr =
            mParticleSystems.begin();
        itr != mParticleSystems.end(); itr++) {
-    if (timeslice == 0)
-      continue;
-    itr->second->Update(timeslice);
+    _UpdateParticleSystem(itr->second.get());
   }
 
   for (map<dtkID, ObstacleSet>::iterator itr = mObstacleSets.begin();
        itr != mObstacleSets.end(); itr++) {
-    vector<dtkIntersectTest::IntersectResult::Ptr> particleIntersectResult;
-    if (timeslice == 0)
-      continue;
-    for (dtkID i = 0; i < itr->second.particlesystem->GetNumberOfParticles();
-         i++) {
-      GK::Point3 particle = itr->second.particlesystem->GetPoint(i);
-      itr->second.pts->SetPoint(0, particle);
-      itr->second.hierarchy_pair.second->Update();
-      vector<dtkIntersectTest::IntersectResult::Ptr> intersectResults;
-      mStage->DoIntersect(itr->second.hierarchy_pair, intersectResults, false,
-                          false);
-      for (dtkID j = 0; j < intersectResults.size(); j++) {
-        dtkIntersectTest::IntersectResult::Ptr result = intersectResults[j];
-        GK::Vector3 normal;
-        result->GetProperty(dtkIntersectTest::INTERSECT_NORMAL, normal);
-        itr->second.particlesystem->SetPoint(i, particle + normal);
-        itr->second.particlesystem->GetParticle(i)->AddForce(
-            dtkDouble3(-normal[0], -normal[1], -normal[2]) *
-            itr->second.viscosityCoef);
-
-        particleIntersectResult.push_back(intersectResults[j]);
-      }
-    }
-    if (particleIntersectResult.size() != 0 && itr->second.custom_handle != 0)
-      itr->second.custom_handle(particleIntersectResult, itr->second.pContext);
+    _UpdateObstacleSet(itr->second);
   }
 
   for (std::map<dtkID, std::vector<dtkID>>::iterator itr_device =
            mDeviceLabels.begin();
        itr_device != mDeviceLabels.end(); itr_device++) {
-    dtkT3<double> forceFeedback(0, 0, 0);
-    for (map<dtkID, dtkPhysMassSpring::Ptr>::iterator itr_ms =
-             mMassSprings.begin();
-         itr_ms != mMassSprings.end(); itr_ms++) {
-      forceFeedback =
-          forceFeedback + itr_ms->second->GetTransportForce(itr_device->first);
-    }
-    if (forceFeedback[0] == 0 && forceFeedback[1] == 0 &&
-        forceFeedback[2] == 0) {
-      for (dtkID i = 0; i < itr_device->second.size(); i++) {
-        forceFeedback = forceFeedback +
-                        mMassSprings[itr_device->second[i]]->GetImpulseForce();
-      }
-    } else {
-      forceFeedback = forceFeedback * 1.0;
-    }
-    mDeviceForceFeedbacks[itr_device->first] = forceFeedback;
+    _UpdateDeviceForceFeedback(itr_device->first,
+                               mDeviceForceFeedbacks[itr_device->first]);
   }
 
   for (map<dtkID, dtkPhysMassSpringThread::Ptr>::iterator itr =
            mSutureThreads.begin();
        itr != mSutureThreads.end(); itr++) {
-    mKnotPlanners[itr->first]->DoKnotFormation();
-    mKnotPlanners[itr->first]->UpdateKnot(timeslice);
+    _UpdateKnotPlanner(mKnotPlanners[itr->first].get());
   }
 
   for (map<dtkID, dtkPhysMassSpringThread::Ptr>::iterator itr =
            mSutureThreads.begin();
        itr != mSutureThreads.end(); itr++) {
-    vector<dtkDouble3> controlPoints;
-
-    double interval = itr->second->GetInterval() * 0.5;
-
-    for (dtkID i = 0; i < itr->second->GetNumberOfSegments() + 1; i++) {
-      dtkDouble3 curPoint = itr->second->GetMassPoint(i * 2)->GetPosition();
-      dtkDouble3 smoothedDirection(0, 0, 0);
-      int num = 0;
-      if (i != 0) {
-        smoothedDirection = smoothedDirection + curPoint -
-                            itr->second->GetMassPoint(i * 2 - 2)->GetPosition();
-        num++;
-      }
-      if (i != itr->second->GetNumberOfSegments()) {
-        smoothedDirection =
-            smoothedDirection +
-            itr->second->GetMassPoint(i * 2 + 2)->GetPosition() - curPoint;
-        num++;
-      }
-      if (num == 0)
-        assert(false);
-      smoothedDirection = normalize(smoothedDirection);
-      controlPoints.push_back(curPoint - smoothedDirection * interval);
-      controlPoints.push_back(curPoint);
-      controlPoints.push_back(curPoint + smoothedDirection * interval);
-    }
+    _SmoothSutureThread(itr->second.get(), mThreadPoints[itr->first].get());
+  }
 
-    dtkID mSmoothedNumber = 10;
-    for (dtkID i = 0; i < itr->second->GetNumberOfSegments(); i++) {
-      double step = 1.0 / (double)mSmoothedNumber;
-      double t;
-      for (dtkID j = 0; j < mSmoothedNumber; j++) {
-        t = step * j;
-        dtkDouble3 smoothedPoint =
-            controlPoints[i * 3 + 1] * ((1 - t) * (1 - t) * (1 - t)) +
-            controlPoints[i * 3 + 2] * (3.0 * t * (1 - t) * (1 - t)) +
-            controlPoints[i * 3 + 3] * (3.0 * t * t * (1 - t)) +
-            controlPoints[i * 3 + 4] * (t * t * t);
-        mThreadPoints[itr->first]->SetPoint(
-            i * mSmoothedNumber + j,
-            GK::Point3(smoothedPoint[0], smoothedPoint[1], smoothedPoint[2]));
-      }
-    }
+  if (mPipelined) {
+    for (SnapshotCopies::iterator itr = mSnapshotCopies.begin();
+         itr != mSnapshotCopies.end(); itr++)
+      _CopySnapshotPoints(itr->first, false);
+    for (SnapshotCopies::iterator itr = mThreadSnapshotCopies.begin();
+         itr != mThreadSnapshotCopies.end(); itr++)
+      _CopySnapshotPoints(itr->first, true);
   }
 }
 
@@ -543,24 +781,102 @@ void dtkPhysCore::SetNumberOfThreads(size_t n) {
   if (n < 2)
     return;
   mNumberOfThreads = n;
-  mLive = true;
-  mThreadGroup = new thread_group();
-  mEnterBarrier = new barrier(mNumberOfThreads + 1);
-  mExitBarrier = new barrier(mNumberOfThreads + 1);
+  mScheduler = dtkTaskScheduler::New(mNumberOfThreads);
+  if (mPinThreads)
+    mScheduler->PinWorkers();
+  ShareTaskScheduler();
 
   Reallocate();
+}
 
-  // create threads
-  for (dtkID i = 0; i < mNumberOfThreads; i++) {
-    mThreadGroup->add_thread(
-        new boost::thread(dtkphyscore_mt_update, i, this
-                          // mNumberOfThreads, &(mAllocator[i]),
-                          // mEnterBarrier, mExitBarrier, &mLive,
-                          //&mMassSprings, &mCollisionDetectHierarchies,
-                          //&mCollisionDetectResponseSets, &mStage,
-                          //&mCollisionDetectResponse, &mTimeslice
-                          ));
+void dtkPhysCore::SetThreadAffinity(bool pinned) {
+  mPinThreads = pinned;
+  if (!pinned || mNumberOfThreads < 2)
+    return;
+  mScheduler->PinWorkers();
+  Reallocate();
+}
+
+size_t dtkPhysCore::CalibrateNumberOfThreads(
+    double timeslice, size_t frames, size_t maxThreads,
+    vector<ThreadCalibration> *report) {
+  if (maxThreads == 0)
+    maxThreads = max<size_t>(1, boost::thread::hardware_concurrency());
+  if (frames == 0)
+    frames = 1;
+
+  // 单线程, 2 的幂, 以及上限本身.
+  vector<size_t> candidates(1, 1);
+  for (size_t n = 2; n < maxThreads; n *= 2)
+    candidates.push_back(n);
+  if (maxThreads > 1)
+    candidates.push_back(maxThreads);
+
+  if (report != 0)
+    report->clear();
+  size_t best = 1;
+  double bestTime = 0;
+  for (dtkID i = 0; i < candidates.size(); i++) {
+    if (candidates[i] == 1) {
+      // 之前设置过的调度器仍在碰撞检测与质量弹簧中, 一并释放才是单线程.
+      mNumberOfThreads = 1;
+      mScheduler.reset();
+      ShareTaskScheduler();
+    } else {
+      SetNumberOfThreads(candidates[i]);
+    }
+
+    // 第一帧包含首次写入与缓冲重建, 不计时.
+    Update(timeslice);
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    for (dtkID frame = 0; frame < frames; frame++)
+      Update(timeslice);
+    double frameTime = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count() /
+                       frames;
+
+    if (report != 0) {
+      ThreadCalibration calibration = {candidates[i], frameTime};
+      report->push_back(calibration);
+    }
+    if (i == 0 || frameTime < bestTime) {
+      best = candidates[i];
+      bestTime = frameTime;
+    }
+  }
+
+  if (best > 1) {
+    if (best != mNumberOfThreads)
+      SetNumberOfThreads(best);
+    return best;
   }
+
+  // 回到单线程, 释放工作线程.
+  mNumberOfThreads = 1;
+  mScheduler.reset();
+  ShareTaskScheduler();
+  return best;
+}
+
+void dtkPhysCore::ShareTaskScheduler() {
+  mStage->SetTaskScheduler(mScheduler);
+
+  // 不在碰撞检测阶段中的树与质量弹簧单独设置.
+  map<dtkID, dtkCollisionDetectHierarchyKDOPS::Ptr> *hierarchies[4] = {
+      &mCollisionDetectHierarchies, &mThreadCollisionDetectHierarchies,
+      &mInteriorCollisionDetectHierarchies,
+      &mThreadHeadCollisionDetectHierarchies};
+  for (dtkID type = 0; type < 4; type++) {
+    for (map<dtkID, dtkCollisionDetectHierarchyKDOPS::Ptr>::iterator itr =
+             hierarchies[type]->begin();
+         itr != hierarchies[type]->end(); itr++)
+      itr->second->SetTaskScheduler(mScheduler);
+  }
+  for (map<dtkID, dtkPhysMassSpring::Ptr>::iterator itr = mMassSprings.begin();
+       itr != mMassSprings.end(); itr++)
+    itr->second->SetTaskScheduler(mScheduler);
 }
 
 // allocate different id group to different thread.
@@ -624,21 +940,7 @@ void dtkPhysCore::Reallocate() {
 
   mAllocatePosMassSpring =
       AllocateDetails(sortedMassSprings, averageOfMassSpringPoints);
-
-  for (dtkID i = 0; i < mNumberOfThreads; i++) {
-    vector<dtkID> &massSprings = mAllocator[i][mAllocatePosMassSpring];
-    vector<dtkID> newMassSprings;
-    for (dtkID j = 0; j < massSprings.size(); j++) {
-      if (mConnectMasterMap.find(massSprings[j]) != mConnectMasterMap.end()) {
-        set<dtkID> &bundle = mConnectMasterMap[massSprings[j]];
-        newMassSprings.insert(newMassSprings.end(), bundle.begin(),
-                              bundle.end());
-      } else {
-        newMassSprings.push_back(massSprings[j]);
-      }
-    }
-    mAllocator[i][mAllocatePosMassSpring] = newMassSprings;
-  }
+  ExpandConnectedMassSprings();
 
   // 1: allocate collision primitives update
   size_t sumOfPrimitives = 0;
@@ -719,199 +1021,380 @@ void dtkPhysCore::Reallocate() {
       AllocateDetails(sortedInternalCollisionDetectResponseSets,
                       averageOfInternalCollisionDetectPairs);
 
-  return;
+  BuildTaskGraph();
 }
 
-void dtkPhysCore::_Update_mt(double timeslice) {
-  mTimeslice = timeslice;
-
-  // Phase 1
-  mEnterBarrier->wait();
-
-  // Phase 2
-  mEnterBarrier->wait();
-
-  // Phase 2.1
-  mEnterBarrier->wait();
-
-  // Phase 2.2
-  mEnterBarrier->wait();
+void dtkPhysCore::ExpandConnectedMassSprings() {
+  for (dtkID i = 0; i < mNumberOfThreads; i++) {
+    vector<dtkID> &massSprings = mAllocator[i][mAllocatePosMassSpring];
+    vector<dtkID> newMassSprings;
+    for (dtkID j = 0; j < massSprings.size(); j++) {
+      if (mConnectMasterMap.find(massSprings[j]) != mConnectMasterMap.end()) {
+        set<dtkID> &bundle = mConnectMasterMap[massSprings[j]];
+        newMassSprings.insert(newMassSprings.end(), bundle.begin(),
+                              bundle.end());
+      } else {
+        newMassSprings.push_back(massSprings[j]);
+      }
+    }
+    mAllocator[i][mAllocatePosMassSpring] = newMassSprings;
+  }
+}
 
-  // Phase 2.3
-  mEnterBarrier->wait();
+void dtkPhysCore::Rebalance() {
+  mAllocator.clear();
+  for (dtkID i = 0; i < mNumberOfThreads; i++) {
+    mAllocator.push_back(std::vector<std::vector<dtkID>>());
+  }
 
-  // Phase 3
-  mEnterBarrier->wait();
+  // 与 Reallocate 的四个阶段一一对应, 权重为微秒计的实测耗时.
+  dtkID *allocatePos[4] = {
+      &mAllocatePosMassSpring, &mAllocatePosPrimitive,
+      &mAllocatePosCollisionDetect, &mAllocatePosInternalCollisionDetect};
+  for (dtkID phase = 0; phase < mBalanceTasks.size(); phase++) {
+    const multimap<dtkID, dtkID> &tasks = mBalanceTasks[phase];
+    map<dtkID, double> costs;
+    for (multimap<dtkID, dtkID>::const_iterator itr = tasks.begin();
+         itr != tasks.end(); itr++) {
+      costs[itr->first] += mScheduler->GetTaskCost(itr->second);
+    }
 
-  // Phase 4
-  mEnterBarrier->wait();
-  mExitBarrier->wait();
+    size_t sumOfCosts = 0;
+    multimap<dtkID, dtkID, greater<dtkID>> sortedCosts;
+    for (map<dtkID, double>::iterator itr = costs.begin(); itr != costs.end();
+         itr++) {
+      dtkID cost = max<dtkID>(1, dtkID(itr->second * 1e6));
+      sumOfCosts += cost;
+      sortedCosts.insert(pair<dtkID, dtkID>(cost, itr->first));
+    }
+    *allocatePos[phase] =
+        AllocateDetails(sortedCosts, sumOfCosts / mNumberOfThreads);
+    if (phase == 0)
+      ExpandConnectedMassSprings();
+
+    map<dtkID, dtkID> workers;
+    collect_workers(mAllocator, *allocatePos[phase], workers);
+    for (multimap<dtkID, dtkID>::const_iterator itr = tasks.begin();
+         itr != tasks.end(); itr++) {
+      mScheduler->SetTaskWorker(itr->second, find_worker(workers, itr->first));
+    }
+  }
+}
 
-  for (dtkID i = 0; i < mAdherePointSets.size(); i++) {
-    AdherePointSet &adherePointSet = mAdherePointSets[i];
+void dtkPhysCore::_FirstTouch(
+    const vector<vector<dtkPhysMassSpring *>> *touches, dtkID worker) {
+  const vector<dtkPhysMassSpring *> &massSprings = (*touches)[worker];
+  for (dtkID i = 0; i < massSprings.size(); i++)
+    massSprings[i]->FirstTouch();
+}
 
-    // 重心
-    GK::Point3 p_tri = barycenter(
-        adherePointSet.dominate_pts->GetPoint(adherePointSet.dominate_tri[0]),
-        adherePointSet.uvw[0],
-        adherePointSet.dominate_pts->GetPoint(adherePointSet.dominate_tri[1]),
-        adherePointSet.uvw[1],
-        adherePointSet.dominate_pts->GetPoint(adherePointSet.dominate_tri[2]),
-        adherePointSet.uvw[2]);
-    GK::Point3 p_p = adherePointSet.slave_pts->GetPoint(adherePointSet.slave_p);
-    GK::Vector3 normal = p_p - p_tri;
+void dtkPhysCore::BuildTaskGraph() {
+  mScheduler->ClearTasks();
+  mBundles.clear();
+  mBundleIDs.clear();
+  mResponseDescriptors.clear();
+  mInternalResponseDescriptors.clear();
+  mBalanceTasks.assign(4, multimap<dtkID, dtkID>());
+  mFramesSinceRebalance = 0;
+
+  // 任务首选的线程沿用 Reallocate 的分配结果, 空闲线程再去窃取.
+  map<dtkID, dtkID> massSpringWorkers;
+  map<dtkID, dtkID> primitiveWorkers;
+  map<dtkID, dtkID> collisionDetectWorkers;
+  map<dtkID, dtkID> internalCollisionDetectWorkers;
+  collect_workers(mAllocator, mAllocatePosMassSpring, massSpringWorkers);
+  collect_workers(mAllocator, mAllocatePosPrimitive, primitiveWorkers);
+  collect_workers(mAllocator, mAllocatePosCollisionDetect,
+                  collisionDetectWorkers);
+  collect_workers(mAllocator, mAllocatePosInternalCollisionDetect,
+                  internalCollisionDetectWorkers);
+
+  // 0: 弹簧束, twins 簇跨对象合并力与冲量, 相连的质量弹簧放在同一个任务中.
+  // 任务中直接使用对象指针, 不再查找 mMassSprings.
+  vector<vector<dtkID>> bundleIDs;
+  vector<dtkID> bundleMasters; // 弹簧束在 mConnectMasterMap 中的键
+  map<dtkID, dtkID> bundleOfMassSpring;
+  for (map<dtkID, set<dtkID>>::iterator itr = mConnectMasterMap.begin();
+       itr != mConnectMasterMap.end(); itr++) {
+    vector<dtkID> bundle;
+    for (set<dtkID>::iterator bundleItr = itr->second.begin();
+         bundleItr != itr->second.end(); bundleItr++) {
+      if (mMassSprings.find(*bundleItr) != mMassSprings.end())
+        bundle.push_back(*bundleItr);
+    }
+    if (bundle.empty())
+      continue;
+    for (dtkID i = 0; i < bundle.size(); i++)
+      bundleOfMassSpring[bundle[i]] = bundleIDs.size();
+    bundleIDs.push_back(bundle);
+    bundleMasters.push_back(itr->first);
+  }
+  for (map<dtkID, dtkPhysMassSpring::Ptr>::iterator itr = mMassSprings.begin();
+       itr != mMassSprings.end(); itr++) {
+    if (bundleOfMassSpring.find(itr->first) != bundleOfMassSpring.end())
+      continue;
+    bundleOfMassSpring[itr->first] = bundleIDs.size();
+    bundleIDs.push_back(vector<dtkID>(1, itr->first));
+    bundleMasters.push_back(itr->first);
+  }
+  // 新建的对象与树也要共用调度器, 大对象在任务内部再用 ForkJoin 拆分.
+  ShareTaskScheduler();
+
+  mBundles.resize(bundleIDs.size());
+  mBundleIDs = bundleIDs;
+  vector<dtkID> iteration0Tasks;
+  vector<dtkID> iteration1Tasks;
+  for (dtkID i = 0; i < bundleIDs.size(); i++) {
+    for (dtkID j = 0; j < bundleIDs[i].size(); j++)
+      mBundles[i].push_back(mMassSprings[bundleIDs[i][j]].get());
+
+    dtkID worker = find_worker(massSpringWorkers, bundleIDs[i][0]);
+    iteration0Tasks.push_back(mScheduler->AddTask(
+        boost::bind(&dtkPhysCore::_UpdateBundle, this, i, 0), worker));
+    iteration1Tasks.push_back(mScheduler->AddTask(
+        boost::bind(&dtkPhysCore::_UpdateBundle, this, i, 1), worker));
+    mScheduler->AddDependency(iteration0Tasks[i], iteration1Tasks[i]);
+
+    // 弹簧束按主质量弹簧分配, 键与 mConnectMasterMap 一致,
+    // 主质量弹簧已删除时 bundleIDs[i][0] 不是键, 展开时会漏掉整个弹簧束.
+    mBalanceTasks[0].insert(
+        pair<dtkID, dtkID>(bundleMasters[i], iteration0Tasks[i]));
+    mBalanceTasks[0].insert(
+        pair<dtkID, dtkID>(bundleMasters[i], iteration1Tasks[i]));
+  }
 
-    dtkPhysMassSpring::Ptr dominate_ms =
-        mMassSprings[adherePointSet.dominate_ID];
-    dtkPhysMassSpring::Ptr slave_ms = mMassSprings[adherePointSet.slave_ID];
+  // 绑核时在弹簧束的首选线程上重新分配点集, 内存落在该线程的 NUMA 节点.
+  if (mPinThreads) {
+    vector<vector<dtkPhysMassSpring *>> touches(mNumberOfThreads);
+    for (dtkID i = 0; i < mBundles.size(); i++) {
+      dtkID worker = mScheduler->GetTaskWorker(iteration0Tasks[i]);
+      touches[worker].insert(touches[worker].end(), mBundles[i].begin(),
+                             mBundles[i].end());
+    }
+    mScheduler->RunOnEachWorker(
+        boost::bind(&dtkPhysCore::_FirstTouch, this, &touches, _1));
+  }
 
-    // 主三角形点更新
+  // 1: 碰撞检测树, 在所属对象第一次迭代之后, 第二次迭代之前更新.
+  map<dtkID, dtkCollisionDetectHierarchyKDOPS::Ptr> *hierarchies[4] = {
+      &mCollisionDetectHierarchies, &mThreadCollisionDetectHierarchies,
+      &mInteriorCollisionDetectHierarchies,
+      &mThreadHeadCollisionDetectHierarchies};
+  map<dtkCollisionDetectHierarchy *, dtkID> hierarchyTasks;
+  for (dtkID type = 0; type < 4; type++) {
+    for (map<dtkID, dtkCollisionDetectHierarchyKDOPS::Ptr>::iterator itr =
+             hierarchies[type]->begin();
+         itr != hierarchies[type]->end(); itr++) {
+      dtkID task = mScheduler->AddTask(
+          boost::bind(&dtkCollisionDetectHierarchy::Update,
+                      dtkCollisionDetectHierarchy::Ptr(itr->second)),
+          find_worker(primitiveWorkers, itr->first + mPairOffset * type));
+      hierarchyTasks[itr->second.get()] = task;
+      mBalanceTasks[1].insert(
+          pair<dtkID, dtkID>(itr->first + mPairOffset * type, task));
+
+      map<dtkID, dtkID>::iterator bundleItr =
+          bundleOfMassSpring.find(itr->first);
+      if (bundleItr != bundleOfMassSpring.end()) {
+        mScheduler->AddDependency(iteration0Tasks[bundleItr->second], task);
+        mScheduler->AddDependency(task, iteration1Tasks[bundleItr->second]);
+      }
+    }
+  }
 
-    for (dtkID j = 0; j < 3; j++) {
-      dtkPhysMassPoint *dominate_mp =
-          dominate_ms->GetMassPoint(adherePointSet.dominate_tri[j]);
-      GK::Vector3 dominate_vel =
-          normal * adherePointSet.slave_ratio * adherePointSet.uvw[j];
+  // 2: 碰撞响应集, 两棵树更新后检测,
+  // 响应写入的冲量在两个对象的第二次迭代中应用.
+  // 任务绑定表项的引用, 先定长再填充.
+  map<dtkID, vector<dtkID>> collisionTasksOfObject;
+  mResponseDescriptors.resize(mCollisionDetectResponseSets.size());
+  dtkID descriptor = 0;
+  for (map<dtkID, CollisionResponseSet>::iterator itr =
+           mCollisionDetectResponseSets.begin();
+       itr != mCollisionDetectResponseSets.end(); itr++, descriptor++) {
+    ResolveResponseSet(itr->first, false, mResponseDescriptors[descriptor]);
+    dtkID task = mScheduler->AddTask(
+        boost::bind(&dtkPhysCore::_UpdateCollisionResponseSet, this,
+                    boost::ref(mResponseDescriptors[descriptor])),
+        find_worker(collisionDetectWorkers, itr->first));
+    mBalanceTasks[2].insert(pair<dtkID, dtkID>(itr->first, task));
+
+    dtkCollisionDetectHierarchy *pair[2] = {
+        itr->second.hierarchy_pair.first.get(),
+        itr->second.hierarchy_pair.second.get()};
+    for (dtkID i = 0; i < 2; i++) {
+      if (i == 1 && pair[1] == pair[0])
+        break;
+      map<dtkCollisionDetectHierarchy *, dtkID>::iterator hierarchyItr =
+          hierarchyTasks.find(pair[i]);
+      if (hierarchyItr != hierarchyTasks.end())
+        mScheduler->AddDependency(hierarchyItr->second, task);
+    }
 
-      GK::Point3 tmp_p = adherePointSet.dominate_pts->GetPoint(
-                             adherePointSet.dominate_tri[j]) +
-                         dominate_vel;
-      dominate_mp->SetPoint(tmp_p);
-      dominate_vel = dominate_vel * (1 / mTimeslice);
-      dominate_mp->SetVel(
-          dominate_mp->GetVel() +
-          dtkT3<double>(dominate_vel[0], dominate_vel[1], dominate_vel[2]));
+    set<dtkID> bundles;
+    dtkID objects[2] = {dtkID(itr->first / mPairOffset),
+                        dtkID(itr->first % mPairOffset)};
+    for (dtkID i = 0; i < 2; i++) {
+      collisionTasksOfObject[objects[i]].push_back(task);
+      map<dtkID, dtkID>::iterator bundleItr =
+          bundleOfMassSpring.find(objects[i]);
+      if (bundleItr != bundleOfMassSpring.end() &&
+          bundles.insert(bundleItr->second).second)
+        mScheduler->AddDependency(task, iteration1Tasks[bundleItr->second]);
     }
+  }
 
-    // 从点更新
-    dtkPhysMassPoint *slave_mp = slave_ms->GetMassPoint(adherePointSet.slave_p);
-    GK::Vector3 slave_vel = -normal * (1.0 - adherePointSet.slave_ratio);
+  // 3: 内部碰撞响应集, 会修改线的避让区间和图元 mInvert,
+  // 因此排在涉及同一对象的碰撞响应集之后.
+  mInternalResponseDescriptors.resize(
+      mInternalCollisionDetectResponseSets.size());
+  descriptor = 0;
+  for (map<dtkID, CollisionResponseSet>::iterator itr =
+           mInternalCollisionDetectResponseSets.begin();
+       itr != mInternalCollisionDetectResponseSets.end();
+       itr++, descriptor++) {
+    ResolveResponseSet(itr->first, true,
+                       mInternalResponseDescriptors[descriptor]);
+    dtkID task = mScheduler->AddTask(
+        boost::bind(&dtkPhysCore::_UpdateInternalCollisionResponseSet, this,
+                    boost::ref(mInternalResponseDescriptors[descriptor])),
+        find_worker(internalCollisionDetectWorkers, itr->first));
+    mBalanceTasks[3].insert(pair<dtkID, dtkID>(itr->first, task));
+
+    dtkCollisionDetectHierarchy *pair[2] = {
+        itr->second.hierarchy_pair.first.get(),
+        itr->second.hierarchy_pair.second.get()};
+    for (dtkID i = 0; i < 2; i++) {
+      if (i == 1 && pair[1] == pair[0])
+        break;
+      map<dtkCollisionDetectHierarchy *, dtkID>::iterator hierarchyItr =
+          hierarchyTasks.find(pair[i]);
+      if (hierarchyItr != hierarchyTasks.end())
+        mScheduler->AddDependency(hierarchyItr->second, task);
+    }
 
-    GK::Point3 tmp_p =
-        adherePointSet.slave_pts->GetPoint(adherePointSet.slave_p) + slave_vel;
-    slave_mp->SetPoint(tmp_p);
-    slave_vel = slave_vel * (1 / mTimeslice);
-    slave_mp->SetVel(slave_mp->GetVel() +
-                     dtkT3<double>(slave_vel[0], slave_vel[1], slave_vel[2]));
+    set<dtkID> bundles;
+    set<dtkID> collisionTasks;
+    dtkID objects[2] = {dtkID(itr->first / mPairOffset),
+                        dtkID(itr->first % mPairOffset)};
+    for (dtkID i = 0; i < 2; i++) {
+      const vector<dtkID> &tasks = collisionTasksOfObject[objects[i]];
+      for (dtkID j = 0; j < tasks.size(); j++) {
+        if (collisionTasks.insert(tasks[j]).second)
+          mScheduler->AddDependency(tasks[j], task);
+      }
+      map<dtkID, dtkID>::iterator bundleItr =
+          bundleOfMassSpring.find(objects[i]);
+      if (bundleItr != bundleOfMassSpring.end() &&
+          bundles.insert(bundleItr->second).second)
+        mScheduler->AddDependency(task, iteration1Tasks[bundleItr->second]);
+    }
   }
 
+  // 4: 固定点集, 需要所有质量弹簧完成第二次迭代, 同时作为后续阶段的汇合点.
+  dtkID adhereTask = mScheduler->AddTask(
+      boost::bind(&dtkPhysCore::_UpdateAdherePointSets, this));
+  for (dtkID i = 0; i < iteration1Tasks.size(); i++)
+    mScheduler->AddDependency(iteration1Tasks[i], adhereTask);
+
+  // 5: 粒子系统与质量弹簧无关, 可以和前面的阶段重叠.
+  // 同一粒子系统的障碍集按顺序写粒子, 串成一条链.
+  vector<dtkID> beforeKnotTasks; // 打结之前须完成的任务
+  map<dtkID, dtkID> lastParticleTasks;
   for (map<dtkID, dtkPhysParticleSystem::Ptr>::iterator itr =
            mParticleSystems.begin();
        itr != mParticleSystems.end(); itr++) {
-    if (timeslice == 0)
-      continue;
-    itr->second->Update(timeslice);
+    lastParticleTasks[itr->first] = mScheduler->AddTask(boost::bind(
+        &dtkPhysCore::_UpdateParticleSystem, this, itr->second.get()));
   }
-
   for (map<dtkID, ObstacleSet>::iterator itr = mObstacleSets.begin();
        itr != mObstacleSets.end(); itr++) {
-    vector<dtkIntersectTest::IntersectResult::Ptr> particleIntersectResult;
-    if (timeslice == 0)
-      continue;
-    for (dtkID i = 0; i < itr->second.particlesystem->GetNumberOfParticles();
-         i++) {
-      GK::Point3 particle = itr->second.particlesystem->GetPoint(i);
-      itr->second.pts->SetPoint(0, particle);
-
-      // 更新包围盒
-      itr->second.hierarchy_pair.second->Update();
-      vector<dtkIntersectTest::IntersectResult::Ptr> intersectResults;
-
-      // kDOPS相交测试
-      mStage->DoIntersect(itr->second.hierarchy_pair, intersectResults, false,
-                          false);
-      for (dtkID j = 0; j < intersectResults.size(); j++) {
-        // 更新粒子
-        dtkIntersectTest::IntersectResult::Ptr result = intersectResults[j];
-        GK::Vector3 normal;
-        result->GetProperty(dtkIntersectTest::INTERSECT_NORMAL, normal);
-        itr->second.particlesystem->SetPoint(i, particle + normal);
-        itr->second.particlesystem->GetParticle(i)->AddForce(
-            dtkDouble3(-normal[0], -normal[1], -normal[2]) *
-            itr->second.viscosityCoef);
-
-        particleIntersectResult.push_back(intersectResults[j]);
-      }
-    }
-    if (particleIntersectResult.size() != 0 && itr->second.custom_handle != 0)
-      itr->second.custom_handle(particleIntersectResult, itr->second.pContext);
+    dtkID task = mScheduler->AddTask(boost::bind(
+        &dtkPhysCore::_UpdateObstacleSet, this, boost::ref(itr->second)));
+    mScheduler->AddDependency(adhereTask, task);
+    beforeKnotTasks.push_back(task);
+
+    dtkID particleSystem = itr->first / mPairOffset;
+    map<dtkID, dtkID>::iterator particleItr =
+        lastParticleTasks.find(particleSystem);
+    if (particleItr != lastParticleTasks.end())
+      mScheduler->AddDependency(particleItr->second, task);
+    lastParticleTasks[particleSystem] = task;
   }
 
-  for (std::map<dtkID, std::vector<dtkID>>::iterator itr_device =
-           mDeviceLabels.begin();
-       itr_device != mDeviceLabels.end(); itr_device++) {
-    dtkT3<double> forceFeedback(0, 0, 0);
-    for (map<dtkID, dtkPhysMassSpring::Ptr>::iterator itr_ms =
-             mMassSprings.begin();
-         itr_ms != mMassSprings.end(); itr_ms++) {
-      forceFeedback =
-          forceFeedback + itr_ms->second->GetTransportForce(itr_device->first);
-    }
-    if (forceFeedback[0] == 0 && forceFeedback[1] == 0 &&
-        forceFeedback[2] == 0) {
-      for (dtkID i = 0; i < itr_device->second.size(); i++) {
-        forceFeedback = forceFeedback +
-                        mMassSprings[itr_device->second[i]]->GetImpulseForce();
-      }
-    } else {
-      forceFeedback = forceFeedback * 1.0;
-    }
-    mDeviceForceFeedbacks[itr_device->first] = forceFeedback;
+  // 6: 设备力反馈, 每个设备一个任务, 结果预先放入 mDeviceForceFeedbacks.
+  for (map<dtkID, vector<dtkID>>::iterator itr = mDeviceLabels.begin();
+       itr != mDeviceLabels.end(); itr++) {
+    dtkID task = mScheduler->AddTask(
+        boost::bind(&dtkPhysCore::_UpdateDeviceForceFeedback, this,
+                    itr->first, boost::ref(mDeviceForceFeedbacks[itr->first])));
+    mScheduler->AddDependency(adhereTask, task);
+    beforeKnotTasks.push_back(task);
   }
 
+  // 7: 打结与缝合线平滑, 每条线各自一条链.
+  // 打结通过 AddTwin 修改线和质量弹簧的点, 障碍集的自定义回调可以任意
+  // 读写对象, 因此与原先的串行顺序一致, 等障碍集和设备力反馈完成后再开始.
+  map<dtkID, dtkID> smoothTasks;
+  vector<dtkID> knotTasks;
   for (map<dtkID, dtkPhysMassSpringThread::Ptr>::iterator itr =
            mSutureThreads.begin();
        itr != mSutureThreads.end(); itr++) {
-    mKnotPlanners[itr->first]->DoKnotFormation();
-    mKnotPlanners[itr->first]->UpdateKnot(timeslice);
+    dtkID knotTask = mScheduler->AddTask(
+        boost::bind(&dtkPhysCore::_UpdateKnotPlanner, this,
+                    mKnotPlanners[itr->first].get()));
+    dtkID smoothTask = mScheduler->AddTask(
+        boost::bind(&dtkPhysCore::_SmoothSutureThread, this, itr->second.get(),
+                    mThreadPoints[itr->first].get()));
+    mScheduler->AddDependency(adhereTask, knotTask);
+    for (dtkID i = 0; i < beforeKnotTasks.size(); i++)
+      mScheduler->AddDependency(beforeKnotTasks[i], knotTask);
+    mScheduler->AddDependency(knotTask, smoothTask);
+    knotTasks.push_back(knotTask);
+    smoothTasks[itr->first] = smoothTask;
   }
 
-  for (map<dtkID, dtkPhysMassSpringThread::Ptr>::iterator itr =
-           mSutureThreads.begin();
-       itr != mSutureThreads.end(); itr++) {
-    vector<dtkDouble3> controlPoints;
-
-    double interval = itr->second->GetInterval() * 0.5;
-
-    for (dtkID i = 0; i < itr->second->GetNumberOfSegments() + 1; i++) {
-      dtkDouble3 curPoint = itr->second->GetMassPoint(i * 2)->GetPosition();
-      dtkDouble3 smoothedDirection(0, 0, 0);
-      int num = 0;
-      if (i != 0) {
-        smoothedDirection = smoothedDirection + curPoint -
-                            itr->second->GetMassPoint(i * 2 - 2)->GetPosition();
-        num++;
-      }
-      if (i != itr->second->GetNumberOfSegments()) {
-        smoothedDirection =
-            smoothedDirection +
-            itr->second->GetMassPoint(i * 2 + 2)->GetPosition() - curPoint;
-        num++;
-      }
-      if (num == 0)
-        assert(false);
-      smoothedDirection = normalize(smoothedDirection);
-      controlPoints.push_back(curPoint - smoothedDirection * interval);
-      controlPoints.push_back(curPoint);
-      controlPoints.push_back(curPoint + smoothedDirection * interval);
-    }
+  if (!mPipelined)
+    return;
 
-    dtkID mSmoothedNumber = 10;
-    for (dtkID i = 0; i < itr->second->GetNumberOfSegments(); i++) {
-      double step = 1.0 / (double)mSmoothedNumber;
-      double t;
-      for (dtkID j = 0; j < mSmoothedNumber; j++) {
-        t = step * j;
-        dtkDouble3 smoothedPoint =
-            controlPoints[i * 3 + 1] * ((1 - t) * (1 - t) * (1 - t)) +
-            controlPoints[i * 3 + 2] * (3.0 * t * (1 - t) * (1 - t)) +
-            controlPoints[i * 3 + 3] * (3.0 * t * t * (1 - t)) +
-            controlPoints[i * 3 + 4] * (t * t * t);
-        mThreadPoints[itr->first]->SetPoint(
-            i * mSmoothedNumber + j,
-            GK::Point3(smoothedPoint[0], smoothedPoint[1], smoothedPoint[2]));
-      }
-    }
+  // 8: 快照拷贝, 每个点集一个任务, 按编号查找 PrepareSnapshot 准备的目标.
+  // 障碍集回调与打结都可能改写任意对象的点, 与串行路径一样在它们全部
+  // 完成之后再拷贝, 所有拷贝任务都依赖同一个汇合点.
+  dtkID joinTask = mScheduler->AddTask(&join_tasks);
+  mScheduler->AddDependency(adhereTask, joinTask);
+  for (dtkID i = 0; i < beforeKnotTasks.size(); i++)
+    mScheduler->AddDependency(beforeKnotTasks[i], joinTask);
+  for (dtkID i = 0; i < knotTasks.size(); i++)
+    mScheduler->AddDependency(knotTasks[i], joinTask);
+  for (map<dtkID, dtkID>::iterator itr = smoothTasks.begin();
+       itr != smoothTasks.end(); itr++)
+    mScheduler->AddDependency(itr->second, joinTask);
+
+  for (map<dtkID, dtkPhysMassSpring::Ptr>::iterator itr = mMassSprings.begin();
+       itr != mMassSprings.end(); itr++) {
+    dtkID task = mScheduler->AddTask(boost::bind(
+        &dtkPhysCore::_CopySnapshotPoints, this, itr->first, false));
+    mScheduler->AddDependency(joinTask, task);
+  }
+  for (map<dtkID, dtkPoints::Ptr>::iterator itr = mThreadPoints.begin();
+       itr != mThreadPoints.end(); itr++) {
+    dtkID task = mScheduler->AddTask(boost::bind(
+        &dtkPhysCore::_CopySnapshotPoints, this, itr->first, true));
+    mScheduler->AddDependency(joinTask, task);
+  }
+}
+
+void dtkPhysCore::_Update_mt(double timeslice) {
+  mTimeslice = timeslice;
+
+  // 整帧的任务图, 各阶段按依赖关系并行执行.
+  mScheduler->Run();
+
+  // 实测耗时不均衡时按耗时重新分配首选线程, 间隔若干帧避免抖动.
+  mImbalanceRatio = mScheduler->GetImbalanceRatio();
+  if (++mFramesSinceRebalance >= mRebalanceInterval &&
+      mImbalanceRatio > mRebalanceThreshold) {
+    Rebalance();
+    mFramesSinceRebalance = 0;
   }
 }
 
@@ -978,7 +1461,7 @@ void dtkPhysCore::CreateTetraMassSpring(
     dtkStaticMeshEliminator::MeshEliminatorResultsCallback callback,
     void *pContext) {
   // Target Mesh
-  dtkPoints::Ptr targetPts = dtkPointsVector::New();
+  dtkPoints::Ptr targetPts = dtkPointsAligned::New();
   dtkStaticTetraMesh::Ptr targetMesh = dtkStaticTetraMesh::New();
   targetMesh->SetPoints(targetPts);
 
@@ -1027,7 +1510,7 @@ void dtkPhysCore::CreateTriangleMassSpring(const char *filename, dtkID id,
                                            double damp, double pointDamp,
                                            double pointResistence,
                                            dtkDouble3 gravityAccel) {
-  dtkPoints::Ptr targetPts = dtkPointsVector::New();
+  dtkPoints::Ptr targetPts = dtkPointsAligned::New();
   dtkStaticTriangleMesh::Ptr targetMesh = dtkStaticTriangleMesh::New();
   targetMesh->SetPoints(targetPts);
 
@@ -1066,7 +1549,7 @@ void dtkPhysCore::CreateMassSpring(const char *filename, dtkID id,
                                    double pointResistence,
                                    dtkDouble3 gravityAccel,
                                    double specialExtend) {
-  dtkPoints::Ptr targetPts = dtkPointsVector::New();
+  dtkPoints::Ptr targetPts = dtkPointsAligned::New();
 
   dtkPhysMassSpring::Ptr massSpring = dtkPhysMassSpring::New(
       point_mass, stiffness, damp, pointDamp, pointResistence, gravityAccel);
@@ -1209,8 +1692,7 @@ dtkPhysKnotPlanner::Ptr dtkPhysCore::GetKnotPlanner(dtkID plannerID) {
 void dtkPhysCore::CreateCollisionResponse(
     dtkID object1_id, dtkID object2_id, double strength,
     void (*custom_handle)(
-        const std::vector<dtkIntersectTest::IntersectResult::Ptr>
-            &intersectResults,
+        dtkIntersectTest::IntersectResultView intersectResults,
         void *pContext),
     void *pContext) {
   CreateCollisionResponse(object1_id, SURFACE, object2_id, SURFACE, strength,
@@ -1221,7 +1703,7 @@ void dtkPhysCore::CreateCollisionResponse(
     dtkID object1_id, CollisionHierarchyType obj1_type, dtkID object2_id,
     CollisionHierarchyType obj2_type, double strength,
     void (*custom_handle)(
-        const vector<dtkIntersectTest::IntersectResult::Ptr> &intersectResults,
+        dtkIntersectTest::IntersectResultView intersectResults,
         void *pContext),
     void *pContext) {
   dtkID response_id = object1_id * mPairOffset + object2_id;
@@ -1258,7 +1740,7 @@ void dtkPhysCore::CreateCollisionResponse(
 void dtkPhysCore::CreateSutureResponse(
     dtkID object_id, dtkID thread_id, double strength,
     void (*custom_handle)(
-        const vector<dtkIntersectTest::IntersectResult::Ptr> &intersectResults,
+        dtkIntersectTest::IntersectResultView intersectResults,
         void *pContext),
     void *pContext) {
   // create hierarchies for object interior
@@ -1307,11 +1789,10 @@ dtkPoints::Ptr dtkPhysCore::CreateCustomDetectTriangleArea(dtkID id,
 void dtkPhysCore::ExecuteCustomDetectTriangleArea(
     dtkID id, dtkID targetID,
     void (*custom_handle)(
-        const std::vector<dtkIntersectTest::IntersectResult::Ptr>
-            &intersectResults,
+        dtkIntersectTest::IntersectResultView intersectResults,
         void *pContext),
     void *pContext) {
-  vector<dtkIntersectTest::IntersectResult::Ptr> intersectResults;
+  vector<dtkIntersectTest::IntersectResult> intersectResults;
   mCollisionDetectHierarchies[id]->Update();
   mStage->DoIntersect(dtkCollisionDetectStage::HierarchyPair(
                           mCollisionDetectHierarchies[targetID],
@@ -1378,6 +1859,39 @@ void dtkPhysCore::RebundleConnectedMassSpring() {
       mConnectMasterMap[*(possibleBundle.begin())] = possibleBundle;
     }
   }
+  ResolveSubsteps();
+}
+
+void dtkPhysCore::SetSubsteps(dtkID id, size_t substeps) {
+  mSubsteps[id] = max<size_t>(substeps, 1);
+  ResolveSubsteps();
+}
+
+size_t dtkPhysCore::GetSubsteps(dtkID id) const {
+  map<dtkID, size_t>::const_iterator itr = mSubsteps.find(id);
+  return itr == mSubsteps.end() ? 1 : itr->second;
+}
+
+void dtkPhysCore::ResolveSubsteps() {
+  for (map<dtkID, dtkPhysMassSpring::Ptr>::iterator itr = mMassSprings.begin();
+       itr != mMassSprings.end(); itr++) {
+    itr->second->SetSubsteps(GetSubsteps(itr->first));
+  }
+  for (map<dtkID, set<dtkID>>::iterator itr = mConnectMasterMap.begin();
+       itr != mConnectMasterMap.end(); itr++) {
+    size_t substeps = 1;
+    for (set<dtkID>::iterator bundleItr = itr->second.begin();
+         bundleItr != itr->second.end(); bundleItr++) {
+      substeps = max(substeps, GetSubsteps(*bundleItr));
+    }
+    for (set<dtkID>::iterator bundleItr = itr->second.begin();
+         bundleItr != itr->second.end(); bundleItr++) {
+      map<dtkID, dtkPhysMassSpring::Ptr>::iterator massSpringItr =
+          mMassSprings.find(*bundleItr);
+      if (massSpringItr != mMassSprings.end())
+        massSpringItr->second->SetSubsteps(substeps);
+    }
+  }
 }
 
 size_t dtkPhysCore::AdhereMassSpring(dtkID from_id, dtkID to_id, double range) {
@@ -1395,17 +1909,15 @@ size_t dtkPhysCore::AdhereMassSpring(dtkID from_id, dtkID to_id, double range) {
   hierarchy_points->AutoSetMaxLevel();
   hierarchy_points->Build();
 
-  vector<dtkIntersectTest::IntersectResult::Ptr> intersectResults;
+  vector<dtkIntersectTest::IntersectResult> intersectResults;
   mStage->DoIntersect(dtkCollisionDetectStage::HierarchyPair(
                           mCollisionDetectHierarchies[to_id], hierarchy_points),
                       intersectResults, false, false);
 
   for (dtkID i = 0; i < intersectResults.size(); i++) {
-    dtkIntersectTest::IntersectResult::Ptr result = intersectResults[i];
-    dtkCollisionDetectPrimitive *pri_1;
-    dtkCollisionDetectPrimitive *pri_2;
-    result->GetProperty(dtkIntersectTest::INTERSECT_PRIMITIVE_1, pri_1);
-    result->GetProperty(dtkIntersectTest::INTERSECT_PRIMITIVE_2, pri_2);
+    const dtkIntersectTest::IntersectResult &result = intersectResults[i];
+    dtkCollisionDetectPrimitive *pri_1 = result.primitive_1;
+    dtkCollisionDetectPrimitive *pri_2 = result.primitive_2;
 
     AdherePointSet newset;
     newset.dominate_pts = mMassSprings[pri_1->mMajorID]->GetPoints();
@@ -1424,7 +1936,7 @@ size_t dtkPhysCore::AdhereMassSpring(dtkID from_id, dtkID to_id, double range) {
     newset.slave_pts = mMassSprings[pri_2->mMajorID]->GetPoints();
     newset.slave_p = pri_2->mDetailIDs[0];
     newset.slave_ID = pri_2->mMajorID;
-    result->GetProperty(dtkIntersectTest::INTERSECT_WEIGHT_1, newset.uvw);
+    newset.uvw = result.weight_1;
     mAdherePointSets.push_back(newset);
   }
 
@@ -1450,14 +1962,16 @@ dtkPhysCore::CreateParticleSystem(dtkID id, double particleRadius,
   mParticleSystems[id] = dtkPhysParticleSystem::New(
       particleRadius - mClothDepth, particleMass, particleLifetime);
 
+  if (mNumberOfThreads > 1)
+    BuildTaskGraph();
+
   return mParticleSystems[id];
 }
 
 void dtkPhysCore::CreateObstacleForParticleSystem(
     dtkID particlesystem_id, dtkID object_id, double viscosityCoef,
     void (*custom_handle)(
-        const std::vector<dtkIntersectTest::IntersectResult::Ptr>
-            &intersectResults,
+        dtkIntersectTest::IntersectResultView intersectResults,
         void *pContext),
     void *pContext) {
   dtkID obstacleid = particlesystem_id * mPairOffset + object_id;
@@ -1487,10 +2001,14 @@ void dtkPhysCore::CreateObstacleForParticleSystem(
   newset.pContext = pContext;
 
   mObstacleSets[obstacleid] = newset;
+
+  if (mNumberOfThreads > 1)
+    BuildTaskGraph();
 }
 
 void dtkPhysCore::DestroyMassSpring(dtkID id) {
   mMassSprings.erase(id);
+  mSubsteps.erase(id);
 
   mStage->RemoveHierarchy(mCollisionDetectHierarchies[id]);
   mCollisionDetectHierarchies.erase(id);
@@ -1503,6 +2021,7 @@ void dtkPhysCore::DestroyMassSpring(dtkID id) {
 
 void dtkPhysCore::DestroyTriangleMassSpring(dtkID id) {
   mMassSprings.erase(id);
+  mSubsteps.erase(id);
 
   mStage->RemoveHierarchy(mCollisionDetectHierarchies[id]);
   mCollisionDetectHierarchies.erase(id);
@@ -1517,6 +2036,7 @@ void dtkPhysCore::DestroyTriangleMassSpring(dtkID id) {
 
 void dtkPhysCore::DestroyTetraMassSpring(dtkID id) {
   mMassSprings.erase(id);
+  mSubsteps.erase(id);
   mTetraMassSprings.erase(id);
 
   dtkCollisionDetectHierarchy::Ptr hierarchy = mCollisionDetectHierarchies[id];
@@ -1576,12 +2096,18 @@ void dtkPhysCore::DestroyCustomDetectTriangleArea(dtkID id) {
 
 void dtkPhysCore::DestroyParticleSystem(dtkID id) {
   mParticleSystems.erase(id);
+
+  if (mNumberOfThreads > 1)
+    BuildTaskGraph();
 }
 
 void dtkPhysCore::DestroyObstacleForParticleSystem(dtkID particlesystem_id,
                                                    dtkID object_id) {
   dtkID obstacleid = particlesystem_id * mPairOffset + object_id;
   mObstacleSets.erase(obstacleid);
+
+  if (mNumberOfThreads > 1)
+    BuildTaskGraph();
 }
 
 void dtkPhysCore::DisconnectMassSpring(dtkID object1_id, dtkID object2_id) {
@@ -1600,6 +2126,9 @@ void dtkPhysCore::EliminateTriangles(dtkID id, size_t originalFaceNum,
 
 void dtkPhysCore::RegisterDevice(dtkID deviceLabel) {
   mDeviceLabels[deviceLabel] = std::vector<dtkID>();
+
+  if (mNumberOfThreads > 1)
+    BuildTaskGraph();
 }
 
 void dtkPhysCore::LabelObjectAsDevice(dtkID objectID, dtkID deviceLabel) {
@@ -0,0 +1,313 @@
+
+/**
+ * @file dtkPhysImplicitSolver.cpp
+ * @brief dtkPhysImplicitSolver 实现
+ * @author agent (agent@local)
+ * @version 1.0
+ * @date 2026-10-16
+ * @copyright MIT LICENSE
+ * https://github.com/Simple-XX/SimplePhysicsEngine
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-16<td>agent<td>创建文件
+ * </table>
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include <boost/bind/bind.hpp>
+
+#include "dtkPhysImplicitSolver.h"
+
+using namespace std;
+using namespace boost::placeholders;
+
+namespace dtk {
+
+dtkPhysImplicitSolver::dtkPhysImplicitSolver() {
+  mScheduler = 0;
+  mGrainSize = 1024;
+  mTolerance = 1e-6;
+  mMaxIterations = 200;
+  mIterations = 0;
+  mResidual = 0;
+}
+
+void dtkPhysImplicitSolver::BuildStructure(size_t numberOfPoints,
+                                           const vector<dtkID> &ends) {
+  // 每行的列: 自身与所有相邻质点, 按列排序.
+  vector<vector<dtkID>> rows(numberOfPoints);
+  for (dtkID i = 0; i < numberOfPoints; i++)
+    rows[i].push_back(i);
+  for (dtkID i = 0; i < ends.size(); i += 2) {
+    rows[ends[i]].push_back(ends[i + 1]);
+    rows[ends[i + 1]].push_back(ends[i]);
+  }
+
+  mRowOffsets.assign(1, 0);
+  mColumns.clear();
+  mDiagonals.resize(numberOfPoints);
+  for (dtkID i = 0; i < numberOfPoints; i++) {
+    sort(rows[i].begin(), rows[i].end());
+    rows[i].erase(unique(rows[i].begin(), rows[i].end()), rows[i].end());
+    mColumns.insert(mColumns.end(), rows[i].begin(), rows[i].end());
+    mRowOffsets.push_back(mColumns.size());
+    mDiagonals[i] = FindBlock(i, i);
+  }
+
+  mSpringBlocks.resize(ends.size() * 2);
+  for (dtkID i = 0; i < ends.size(); i += 2) {
+    dtkID a = ends[i];
+    dtkID b = ends[i + 1];
+    mSpringBlocks[i * 2] = mDiagonals[a];
+    mSpringBlocks[i * 2 + 1] = mDiagonals[b];
+    mSpringBlocks[i * 2 + 2] = FindBlock(a, b);
+    mSpringBlocks[i * 2 + 3] = FindBlock(b, a);
+  }
+
+  mBlocks.resize(mColumns.size() * 9);
+  mInvDiagonals.resize(numberOfPoints * 9);
+  mFixed.resize(numberOfPoints);
+  mRhs.resize(numberOfPoints * 3);
+  mX.resize(numberOfPoints * 3);
+  mR.resize(numberOfPoints * 3);
+  mZ.resize(numberOfPoints * 3);
+  mP.resize(numberOfPoints * 3);
+  mQ.resize(numberOfPoints * 3);
+}
+
+dtkID dtkPhysImplicitSolver::FindBlock(dtkID row, dtkID column) const {
+  vector<dtkID>::const_iterator first = mColumns.begin() + mRowOffsets[row];
+  vector<dtkID>::const_iterator last = mColumns.begin() + mRowOffsets[row + 1];
+  return dtkID(lower_bound(first, last, column) - mColumns.begin());
+}
+
+size_t dtkPhysImplicitSolver::Solve(dtkPhysMassPointStorage &points,
+                                    const dtkPhysSpringStorage &springs,
+                                    const dtkReal *const pos[3],
+                                    const dtkReal *const vel[3],
+                                    double timeslice,
+                                    dtkTaskScheduler *scheduler,
+                                    size_t grainSize) {
+  mScheduler = scheduler;
+  mGrainSize = max(grainSize, size_t(1));
+  Assemble(points, springs, pos, vel, timeslice);
+
+  fill(mX.begin(), mX.end(), 0.0);
+  fill(mP.begin(), mP.end(), 0.0);
+  mR = mRhs;
+  double rhsNorm = 0;
+  for (dtkID i = 0; i < mRhs.size(); i++)
+    rhsNorm += mRhs[i] * mRhs[i];
+
+  mIterations = 0;
+  mResidual = 0;
+  if (rhsNorm > 0) {
+    double threshold = mTolerance * mTolerance * rhsNorm;
+    ForEachChunk(boost::bind(&dtkPhysImplicitSolver::_Precondition, this, _1,
+                             _2));
+    double rz = SumPartials();
+    ForEachChunk(boost::bind(&dtkPhysImplicitSolver::_Direction, this, _1, _2,
+                             0.0));
+    double rr = rhsNorm;
+    while (mIterations < mMaxIterations && rr > threshold) {
+      ForEachChunk(boost::bind(&dtkPhysImplicitSolver::_Multiply, this, _1,
+                               _2));
+      double pq = SumPartials();
+      if (!(pq > 0))
+        break;
+      ForEachChunk(boost::bind(&dtkPhysImplicitSolver::_Step, this, _1, _2,
+                               rz / pq));
+      rr = SumPartials();
+      mIterations++;
+      if (rr <= threshold)
+        break;
+      ForEachChunk(boost::bind(&dtkPhysImplicitSolver::_Precondition, this,
+                               _1, _2));
+      double rzNew = SumPartials();
+      ForEachChunk(boost::bind(&dtkPhysImplicitSolver::_Direction, this, _1,
+                               _2, rzNew / rz));
+      rz = rzNew;
+    }
+    mResidual = sqrt(rr / rhsNorm);
+  }
+
+  for (dtkID i = 0; i < mDiagonals.size(); i++)
+    points.mAccel[i] = dtkT3<double>(mX[i * 3], mX[i * 3 + 1], mX[i * 3 + 2]) /
+                       timeslice;
+  mScheduler = 0;
+  return mIterations;
+}
+
+void dtkPhysImplicitSolver::Assemble(dtkPhysMassPointStorage &points,
+                                     const dtkPhysSpringStorage &springs,
+                                     const dtkReal *const pos[3],
+                                     const dtkReal *const vel[3],
+                                     double timeslice) {
+  const double h = timeslice;
+  fill(mBlocks.begin(), mBlocks.end(), 0.0);
+
+  // 质量矩阵与外力.
+  for (dtkID i = 0; i < mDiagonals.size(); i++) {
+    double *block = &mBlocks[mDiagonals[i] * 9];
+    block[0] = block[4] = block[8] = points.mMass[i];
+    dtkT3<double> force =
+        points.mForceAccum[i] + points.mForceDecorator[i] + points.mGravity[i];
+    for (dtkID k = 0; k < 3; k++)
+      mRhs[i * 3 + k] = h * force[k];
+    // 休眠质点与固定质点一样, 速度增量为 0.
+    mFixed[i] = !points.mActive[i] || points.mSleeping[i];
+  }
+
+  // 弹簧: S = h cd dd^T + h^2 P, P 为刚度部分, 右端项加 -h^2 P (vb - va).
+  for (dtkID s = 0; s < springs.GetNumberOfSprings(); s++) {
+    dtkID a = springs.mEnds[s * 2];
+    dtkID b = springs.mEnds[s * 2 + 1];
+    double dir[3];
+    double curLength = 0;
+    for (dtkID k = 0; k < 3; k++) {
+      dir[k] = double(pos[k][b]) - double(pos[k][a]);
+      curLength += dir[k] * dir[k];
+    }
+    curLength = sqrt(curLength);
+    if (!(curLength > 0))
+      continue;
+    for (dtkID k = 0; k < 3; k++)
+      dir[k] /= curLength;
+
+    double oriLength = springs.mOriLength[s];
+    double ks = double(springs.mStiffness[s]) / oriLength;
+    double cd = h * ks + springs.mDamp[s];
+    double geometric = max(0.0, 1.0 - oriLength / curLength);
+
+    double *aa = &mBlocks[mSpringBlocks[s * 4] * 9];
+    double *bb = &mBlocks[mSpringBlocks[s * 4 + 1] * 9];
+    double *ab = &mBlocks[mSpringBlocks[s * 4 + 2] * 9];
+    double *ba = &mBlocks[mSpringBlocks[s * 4 + 3] * 9];
+    for (dtkID r = 0; r < 3; r++) {
+      double w = 0;
+      for (dtkID c = 0; c < 3; c++) {
+        double outer = dir[r] * dir[c];
+        double stiff =
+            ks * (outer + geometric * ((r == c ? 1.0 : 0.0) - outer));
+        double value = h * cd * outer + h * h * stiff;
+        aa[r * 3 + c] += value;
+        bb[r * 3 + c] += value;
+        ab[r * 3 + c] -= value;
+        ba[r * 3 + c] -= value;
+        w += stiff * (double(vel[c][b]) - double(vel[c][a]));
+      }
+      mRhs[b * 3 + r] -= h * h * w;
+      mRhs[a * 3 + r] += h * h * w;
+    }
+  }
+
+  // 固定质点不参与求解, 对角块求逆作预条件.
+  for (dtkID i = 0; i < mDiagonals.size(); i++) {
+    double *inv = &mInvDiagonals[i * 9];
+    if (mFixed[i]) {
+      fill(inv, inv + 9, 0.0);
+      for (dtkID k = 0; k < 3; k++)
+        mRhs[i * 3 + k] = 0;
+      continue;
+    }
+    const double *m = &mBlocks[mDiagonals[i] * 9];
+    inv[0] = m[4] * m[8] - m[5] * m[7];
+    inv[1] = m[2] * m[7] - m[1] * m[8];
+    inv[2] = m[1] * m[5] - m[2] * m[4];
+    inv[3] = m[5] * m[6] - m[3] * m[8];
+    inv[4] = m[0] * m[8] - m[2] * m[6];
+    inv[5] = m[2] * m[3] - m[0] * m[5];
+    inv[6] = m[3] * m[7] - m[4] * m[6];
+    inv[7] = m[1] * m[6] - m[0] * m[7];
+    inv[8] = m[0] * m[4] - m[1] * m[3];
+    double det = m[0] * inv[0] + m[1] * inv[3] + m[2] * inv[6];
+    for (dtkID k = 0; k < 9; k++)
+      inv[k] /= det;
+  }
+}
+
+template <typename Function>
+void dtkPhysImplicitSolver::ForEachChunk(const Function &body) {
+  size_t rows = mDiagonals.size();
+  size_t chunks = (rows + mGrainSize - 1) / mGrainSize;
+  mPartials.assign(chunks, 0.0);
+  if (mScheduler && chunks > 1) {
+    mScheduler->ForkJoinRange(
+        rows, mGrainSize,
+        boost::bind(&dtkPhysImplicitSolver::_Chunk<Function>, this, &body, _1,
+                    _2));
+    return;
+  }
+  for (dtkID c = 0; c < chunks; c++)
+    _Chunk(&body, dtkID(c * mGrainSize),
+           dtkID(min(rows, (c + 1) * mGrainSize)));
+}
+
+template <typename Function>
+void dtkPhysImplicitSolver::_Chunk(const Function *body, dtkID begin,
+                                   dtkID end) {
+  mPartials[begin / mGrainSize] = (*body)(begin, end);
+}
+
+double dtkPhysImplicitSolver::SumPartials() const {
+  // 按块顺序求和, 结果与线程数无关.
+  double sum = 0;
+  for (dtkID i = 0; i < mPartials.size(); i++)
+    sum += mPartials[i];
+  return sum;
+}
+
+double dtkPhysImplicitSolver::_Multiply(dtkID begin, dtkID end) {
+  double partial = 0;
+  for (dtkID i = begin; i < end; i++) {
+    double *q = &mQ[i * 3];
+    q[0] = q[1] = q[2] = 0;
+    if (mFixed[i])
+      continue;
+    for (dtkID j = mRowOffsets[i]; j < mRowOffsets[i + 1]; j++) {
+      const double *block = &mBlocks[j * 9];
+      const double *p = &mP[mColumns[j] * 3];
+      for (dtkID r = 0; r < 3; r++)
+        q[r] += block[r * 3] * p[0] + block[r * 3 + 1] * p[1] +
+                block[r * 3 + 2] * p[2];
+    }
+    for (dtkID k = 0; k < 3; k++)
+      partial += mP[i * 3 + k] * q[k];
+  }
+  return partial;
+}
+
+double dtkPhysImplicitSolver::_Step(dtkID begin, dtkID end, double alpha) {
+  double partial = 0;
+  for (dtkID i = begin * 3; i < end * 3; i++) {
+    mX[i] += alpha * mP[i];
+    mR[i] -= alpha * mQ[i];
+    partial += mR[i] * mR[i];
+  }
+  return partial;
+}
+
+double dtkPhysImplicitSolver::_Precondition(dtkID begin, dtkID end) {
+  double partial = 0;
+  for (dtkID i = begin; i < end; i++) {
+    const double *inv = &mInvDiagonals[i * 9];
+    const double *r = &mR[i * 3];
+    for (dtkID k = 0; k < 3; k++) {
+      mZ[i * 3 + k] = inv[k * 3] * r[0] + inv[k * 3 + 1] * r[1] +
+                      inv[k * 3 + 2] * r[2];
+      partial += r[k] * mZ[i * 3 + k];
+    }
+  }
+  return partial;
+}
+
+double dtkPhysImplicitSolver::_Direction(dtkID begin, dtkID end,
+                                         double beta) {
+  for (dtkID i = begin * 3; i < end * 3; i++)
+    mP[i] = mZ[i] + beta * mP[i];
+  return 0;
+}
+} // namespace dtk
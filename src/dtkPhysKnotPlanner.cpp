@@ -33,16 +33,13 @@ dtkPhysKnotPlanner::dtkPhysKnotPlanner(
 dtkPhysKnotPlanner::~dtkPhysKnotPlanner() {}
 
 void dtkPhysKnotPlanner::KnotRecognition(
-    vector<dtkIntersectTest::IntersectResult::Ptr> &intersectResults) {
+    dtkIntersectTest::IntersectResultView intersectResults) {
   if (mDoKnotPlanning) {
     set<dtkID> collisionSegments;
     for (dtkID i = 0; i < intersectResults.size(); i++) {
-      dtkIntersectTest::IntersectResult::Ptr result = intersectResults[i];
-      dtkCollisionDetectPrimitive *pri_1;
-      dtkCollisionDetectPrimitive *pri_2;
-
-      result->GetProperty(dtkIntersectTest::INTERSECT_PRIMITIVE_1, pri_1);
-      result->GetProperty(dtkIntersectTest::INTERSECT_PRIMITIVE_2, pri_2);
+      const dtkIntersectTest::IntersectResult &result = intersectResults[i];
+      dtkCollisionDetectPrimitive *pri_1 = result.primitive_1;
+      dtkCollisionDetectPrimitive *pri_2 = result.primitive_2;
 
       int pairDistance = abs((int)pri_1->mMinorID - (int)pri_2->mMinorID);
       if (pairDistance > 3 && pairDistance < 15) {
@@ -14,289 +14,395 @@
  * </table>
  */
 
+#include <algorithm>
+
 #include "dtkPhysMassPoint.h"
 #include "dtkTx.h"
 
 namespace dtk {
 
-dtkPhysMassPoint::dtkPhysMassPoint(dtkID id, dtkPoints::Ptr pts,
-                                   const double &mass, const dtkT3<double> &vel,
-                                   double pointDamp, double pointResistence,
-                                   dtkDouble3 gravityAccel) {
-  mID = id;
-  mPts = pts;
-  mMass = mass;
-  mVel = vel;
+std::atomic<size_t> dtkPhysTwinCluster::sGeneration(0);
 
-  mPosBuffers.resize(3);
-  mVelBuffers.resize(3);
-  mAccelBuffers.resize(3);
-
-  mGravity = gravityAccel * mMass;
+void dtkPhysTwinCluster::Merge(dtkPhysMassPoint *point1,
+                               dtkPhysMassPoint *point2) {
+  dtkPhysMassPoint *points[2] = {point1, point2};
+  for (dtkID k = 0; k < 2; k++) {
+    if (points[k]->mTwinCluster)
+      continue;
+    points[k]->mTwinCluster = New();
+    points[k]->mTwinCluster->mMembers.push_back(points[k]);
+  }
+  Ptr large = point1->mTwinCluster;
+  Ptr small = point2->mTwinCluster;
+  if (large == small)
+    return;
+  if (large->mMembers.size() < small->mMembers.size())
+    std::swap(large, small);
+  for (dtkID i = 0; i < small->mMembers.size(); i++) {
+    small->mMembers[i]->mTwinCluster = large;
+    large->mMembers.push_back(small->mMembers[i]);
+  }
+  sGeneration++;
+}
 
-  mActive = true;
-  mForceAccum = dtkT3<double>(0, 0, 0);
-  mResistance = dtkT3<double>(0, 0, 0);
+void dtkPhysTwinCluster::Leave(dtkPhysMassPoint *point) {
+  Ptr cluster = point->mTwinCluster;
+  std::vector<dtkPhysMassPoint *> &members = cluster->mMembers;
+  members.erase(std::find(members.begin(), members.end(), point));
+  point->mTwinCluster.reset();
+  sGeneration++;
+}
 
-  mResistCoef = pointResistence;
-  GK::Point3 p = pts->GetPoint(id);
-  mPosLastFrame = dtkT3<double>(p[0], p[1], p[2]);
+void dtkPhysTwinCluster::ResolveForces() {
+  // 休眠成员的力在唤醒时清空, 质量与力都不参与合并, 合力全部分给未休眠成员.
+  double mass = 0;
+  dtkT3<double> force(0, 0, 0);
+  for (dtkID i = 0; i < mMembers.size(); i++) {
+    if (mMembers[i]->IsSleeping())
+      continue;
+    mass += mMembers[i]->GetMass();
+    force = force + mMembers[i]->GetForceAccum();
+  }
+  if (!(mass > 0))
+    return;
+  for (dtkID i = 0; i < mMembers.size(); i++) {
+    if (!mMembers[i]->IsSleeping())
+      mMembers[i]->SetForceAccum(force * (mMembers[i]->GetMass() / mass));
+  }
+}
 
-  mImpulse = dtkT3<double>(0, 0, 0);
-  mImpulseNum = 0;
-  mPointDamp = pointDamp;
+void dtkPhysTwinCluster::ResolveImpulses() {
+  dtkT3<double> impulse(0, 0, 0);
+  size_t impulseNum = 0;
+  for (dtkID i = 0; i < mMembers.size(); i++) {
+    dtkPhysMassPointStorage &storage = *mMembers[i]->mStorage;
+    dtkID index = mMembers[i]->mIndex;
+    impulse = impulse + storage.mImpulse[index];
+    impulseNum += storage.mImpulseNum[index];
+  }
+  if (impulseNum == 0)
+    return;
+  for (dtkID i = 0; i < mMembers.size(); i++) {
+    dtkPhysMassPointStorage &storage = *mMembers[i]->mStorage;
+    dtkID index = mMembers[i]->mIndex;
+    storage.mImpulse[index] = impulse;
+    storage.mImpulseNum[index] = impulseNum;
+    storage.Disturb(index);
+  }
 }
 
-dtkPhysMassPoint::~dtkPhysMassPoint() {}
+dtkID dtkPhysMassPointStorage::AddPoint(dtkID pointID, const double &mass,
+                                        const dtkT3<double> &vel,
+                                        double pointDamp,
+                                        double pointResistence,
+                                        dtkDouble3 gravityAccel) {
+  const dtkT3<double> zero(0, 0, 0);
+  GK::Point3 p = mPts->GetPoint(pointID);
+
+  mPointIDs.push_back(pointID);
+  mVel.push_back(vel);
+  mAccel.push_back(zero);
+  mForceAccum.push_back(zero);
+  mGravity.push_back(gravityAccel * mass);
+  mResistance.push_back(zero);
+  mPosLastFrame.push_back(dtkT3<double>(p[0], p[1], p[2]));
+  mForceDecorator.push_back(zero);
+  mImpulse.push_back(zero);
+
+  mMass.push_back(mass);
+  mResistCoef.push_back(pointResistence);
+  mPointDamp.push_back(pointDamp);
+  mImpulseNum.push_back(0);
+
+  mActive.push_back(true);
+  mCollide.push_back(false);
+  mLabel.push_back(0);
+  mSleeping.push_back(false);
+  mWake.push_back(false);
+
+  for (dtkID k = 0; k < 3; k++) {
+    mPosBuffers[k].push_back(zero);
+    mVelBuffers[k].push_back(zero);
+    mAccelBuffers[k].push_back(zero);
+  }
+  return mPointIDs.size() - 1;
+}
 
-bool dtkPhysMassPoint::Update(double timeslice, ItrMethod method,
-                              dtkID iteration) {
-  // mActive represent the mass point's accel is zero, points don't leave in
-  // this iteration.
-  dtkT3<double> p;
-  if (!mActive) {
-    // 无速度， 提前返回，实现固定点.
-    switch (method) {
-    case Euler: {
-      mAccel = dtkT3<double>(0, 0, 0);
-      mForceAccum = dtkT3<double>(0, 0, 0);
-      mVel = (GetPosition() - mPosLastFrame) / timeslice;
-      mPosLastFrame = GetPosition();
-      // mPts->SetPoint(mID, GetPosition()); // meaningless but complete
-      //
-      mImpulse = dtkT3<double>(0, 0, 0);
-      mImpulseNum = 0;
-      return true;
-    }
-    case Mid:
-    case Heun:
-    case Collision: {
-      if (iteration == 0) {
-        mVel = (GetPosition() - mPosLastFrame) / timeslice;
-        mAccel = dtkT3<double>(0, 0, 0);
-        mForceAccum = dtkT3<double>(0, 0, 0);
-        mPosBuffers[iteration] = GetPosition();
-        mVelBuffers[iteration] = mVel; // dtkT3<T>(0, 0, 0);
-        mImpulse = dtkT3<double>(0, 0, 0);
-        mImpulseNum = 0;
-      } else {
-        mVel = (GetPosition() - mPosLastFrame) / timeslice;
-        mPosBuffers[0] = GetPosition();
-        mPosLastFrame = GetPosition();
-        mAccelBuffers[iteration - 1] = dtkT3<double>(0, 0, 0);
-        mForceAccum = dtkT3<double>(0, 0, 0);
+void dtkPhysMassPointStorage::Update(dtkID begin, dtkID end, double timeslice,
+                                     ItrMethod method, dtkID iteration) {
+  for (dtkID i = begin; i < end; i++) {
+    // 休眠质点保持原位, 唤醒前不参与积分.
+    if (mSleeping[i])
+      continue;
+    dtkT3<double> &vel = mVel[i];
+    dtkT3<double> &accel = mAccel[i];
+    dtkT3<double> &forceAccum = mForceAccum[i];
+    dtkT3<double> &resistance = mResistance[i];
+    dtkT3<double> &posLastFrame = mPosLastFrame[i];
+    const dtkT3<double> &gravity = mGravity[i];
+    const dtkT3<double> &forceDecorator = mForceDecorator[i];
+    const double mass = mMass[i];
+    const double resistCoef = mResistCoef[i];
+    const double pointDamp = mPointDamp[i];
+
+    // mActive represent the mass point's accel is zero, points don't leave in
+    // this iteration.
+    dtkT3<double> p;
+    if (!mActive[i]) {
+      // 无速度， 提前返回，实现固定点.
+      switch (method) {
+      case Euler:
+      case Implicit: {
+        accel = dtkT3<double>(0, 0, 0);
+        forceAccum = dtkT3<double>(0, 0, 0);
+        vel = (GetPosition(i) - posLastFrame) / timeslice;
+        posLastFrame = GetPosition(i);
         // mPts->SetPoint(mID, GetPosition()); // meaningless but complete
-        mImpulse = dtkT3<double>(0, 0, 0);
-        mImpulseNum = 0;
+        //
+        mImpulse[i] = dtkT3<double>(0, 0, 0);
+        mImpulseNum[i] = 0;
+        continue;
+      }
+      case Mid:
+      case Heun:
+      case Collision: {
+        if (iteration == 0) {
+          vel = (GetPosition(i) - posLastFrame) / timeslice;
+          accel = dtkT3<double>(0, 0, 0);
+          forceAccum = dtkT3<double>(0, 0, 0);
+          mPosBuffers[iteration][i] = GetPosition(i);
+          mVelBuffers[iteration][i] = vel; // dtkT3<T>(0, 0, 0);
+          mImpulse[i] = dtkT3<double>(0, 0, 0);
+          mImpulseNum[i] = 0;
+        } else {
+          vel = (GetPosition(i) - posLastFrame) / timeslice;
+          mPosBuffers[0][i] = GetPosition(i);
+          posLastFrame = GetPosition(i);
+          mAccelBuffers[iteration - 1][i] = dtkT3<double>(0, 0, 0);
+          forceAccum = dtkT3<double>(0, 0, 0);
+          // mPts->SetPoint(mID, GetPosition()); // meaningless but complete
+          mImpulse[i] = dtkT3<double>(0, 0, 0);
+          mImpulseNum[i] = 0;
+        }
+        continue;
+      }
+      case RK4: {
+        if (iteration < 3) {
+          vel = (GetPosition(i) - posLastFrame) / timeslice;
+          accel = dtkT3<double>(0, 0, 0);
+          forceAccum = dtkT3<double>(0, 0, 0);
+          mPosBuffers[iteration][i] = GetPosition(i);
+          mVelBuffers[iteration][i] = vel; // dtkT3<T>(0, 0, 0);
+          mImpulse[i] = dtkT3<double>(0, 0, 0);
+          mImpulseNum[i] = 0;
+        } else {
+          vel = (GetPosition(i) - posLastFrame) / timeslice;
+          mAccelBuffers[iteration - 1][i] = dtkT3<double>(0, 0, 0);
+          forceAccum = dtkT3<double>(0, 0, 0);
+          mImpulse[i] = dtkT3<double>(0, 0, 0);
+          mImpulseNum[i] = 0;
+          // mPts->SetPoint(mID, GetPosition()); // meaningless but complete
+        }
+        continue;
+      }
+      default: {
+        // not handle
       }
-      return true;
-    }
-    case RK4: {
-      if (iteration < 3) {
-        mVel = (GetPosition() - mPosLastFrame) / timeslice;
-        mAccel = dtkT3<double>(0, 0, 0);
-        mForceAccum = dtkT3<double>(0, 0, 0);
-        mPosBuffers[iteration] = GetPosition();
-        mVelBuffers[iteration] = mVel; // dtkT3<T>(0, 0, 0);
-        mImpulse = dtkT3<double>(0, 0, 0);
-        mImpulseNum = 0;
-      } else {
-        mVel = (GetPosition() - mPosLastFrame) / timeslice;
-        mAccelBuffers[iteration - 1] = dtkT3<double>(0, 0, 0);
-        mForceAccum = dtkT3<double>(0, 0, 0);
-        mImpulse = dtkT3<double>(0, 0, 0);
-        mImpulseNum = 0;
-        // mPts->SetPoint(mID, GetPosition()); // meaningless but complete
       }
-      return true;
-    }
-    default: {
-      // not handle
-    }
     }
-  }
 
-  switch (method) {
-  case Euler:
-    // forward Eular
-    // compute acceleration
-    mAccel = (mForceAccum + mForceDecorator + mGravity) / mMass;
-    mForceAccum = dtkT3<double>(0, 0, 0);
+    switch (method) {
+    case Euler:
+      // forward Eular
+      // compute acceleration
+      accel = (forceAccum + forceDecorator + gravity) / mass;
+      forceAccum = dtkT3<double>(0, 0, 0);
 
-    // get point
-    p = GetPosition();
-    mPosLastFrame = p;
+      // get point
+      p = GetPosition(i);
+      posLastFrame = p;
 
-    // Euler step
-    p = p + mVel * timeslice;
-    mVel = mVel + mAccel * timeslice;
+      // Euler step
+      p = p + vel * timeslice;
+      vel = vel + accel * timeslice;
 
-    // set point
-    mPts->SetPoint(mID, GK::Point3(p.x, p.y, p.z));
+      // set point
+      StorePosition(i, p);
 
-    break;
-  case Mid:
-    if (iteration == 0) {
-      // compute acceleration
-      mAccel = (mForceAccum + mForceDecorator + mGravity) / mMass;
-      mForceAccum = dtkT3<double>(0, 0, 0);
+      break;
+    case Implicit:
+      // backward Euler, accel 为 dtkPhysImplicitSolver 求得的 dv / h
+      forceAccum = dtkT3<double>(0, 0, 0);
 
-      mPosBuffers[iteration] = GetPosition() + mVel * timeslice * 0.5;
-      mVelBuffers[iteration] = mVel + mAccel * timeslice * 0.5;
-    } else {
-      mAccelBuffers[iteration - 1] =
-          (mForceAccum + mForceDecorator + mGravity) / mMass;
-      mForceAccum = dtkT3<double>(0, 0, 0);
-
-      mPosLastFrame = GetPosition();
-      p = GetPosition() + mVelBuffers[iteration - 1] * timeslice;
-      mPts->SetPoint(mID, GK::Point3(p.x, p.y, p.z));
-      mVel = mVel + mAccelBuffers[iteration - 1] * timeslice;
-    }
-    break;
-  case Heun:
-    if (iteration == 0) {
-      // compute acceleration
-      mResistance = mVel * (-mResistCoef);
-      mAccel = (mForceAccum + mForceDecorator + mGravity + mResistance) / mMass;
-      mForceAccum = dtkT3<double>(0, 0, 0);
+      p = GetPosition(i);
+      posLastFrame = p;
 
-      mPosBuffers[iteration] = GetPosition() + mVel * timeslice * 1.0;
-      mVelBuffers[iteration] = mVel + mAccel * timeslice * 1.0;
-    } else {
-      mResistance = mVelBuffers[iteration - 1] * (-mResistCoef);
-      mAccelBuffers[iteration - 1] =
-          (mForceAccum + mForceDecorator + mGravity + mResistance) / mMass;
-      mForceAccum = dtkT3<double>(0, 0, 0);
-
-      p = GetPosition() + (mVel + mVelBuffers[iteration - 1]) * 0.5 * timeslice;
-      mPosLastFrame = GetPosition();
-      mPts->SetPoint(mID, GK::Point3(p.x, p.y, p.z));
-      mVel = mVel + (mAccel + mAccelBuffers[iteration - 1]) * 0.5 * timeslice;
-      // mVelBuffers[iteration] = mVel;
-    }
-    break;
-  case Collision:
-    if (iteration == 0) {
-      mPosBuffers[iteration] = GetPosition();
-      mVelBuffers[iteration] = mVel;
+      vel = vel + accel * timeslice;
+      p = p + vel * timeslice;
 
-      // compute acceleration
-      mResistance = mVelBuffers[iteration] * (-mResistCoef);
-      mAccelBuffers[iteration] =
-          (mForceAccum + mForceDecorator + mGravity + mResistance) / mMass;
-      mForceAccum = dtkT3<double>(0, 0, 0);
-
-      p = mPosBuffers[iteration] + mVelBuffers[iteration] * timeslice * 1.0;
-      mPts->SetPoint(mID, GK::Point3(p.x, p.y, p.z));
-      mVel =
-          mVelBuffers[iteration] + mAccelBuffers[iteration] * timeslice * 1.0;
-      mVel = (mVel + mVelBuffers[iteration]) * 0.5;
-      mVel = mVel * mPointDamp;
-    } else {
-      mResistance = mVel * (-mResistCoef);
-      mAccel = (mForceAccum + mForceDecorator + mGravity + mResistance) / mMass;
-      mForceAccum = dtkT3<double>(0, 0, 0);
-
-      p = mPosBuffers[iteration - 1] + mVel * timeslice;
-      mPosLastFrame = mPosBuffers[iteration - 1];
-      mPts->SetPoint(mID, GK::Point3(p.x, p.y, p.z));
-      mVel = mVelBuffers[iteration - 1] +
-             (mAccel + mAccelBuffers[iteration - 1]) * 0.5 * timeslice;
-      mVel = mVel * mPointDamp;
-      // mVelBuffers[iteration] = mVel;
-    }
-    break;
-  case RK4:
-    if (iteration == 0) {
-      // compute acceleration
-      mAccel = (mForceAccum + mForceDecorator + mGravity) / mMass;
-      mForceAccum = dtkT3<double>(0, 0, 0);
+      StorePosition(i, p);
 
-      mPosBuffers[iteration] = GetPosition() + mVel * timeslice * 0.5;
-      mVelBuffers[iteration] = mVel + mAccel * timeslice * 0.5;
-    } else if (iteration == 1) {
-      // compute acceleration
-      mAccelBuffers[iteration - 1] =
-          (mForceAccum + mForceDecorator + mGravity) / mMass;
-      mForceAccum = dtkT3<double>(0, 0, 0);
+      break;
+    case Mid:
+      if (iteration == 0) {
+        // compute acceleration
+        accel = (forceAccum + forceDecorator + gravity) / mass;
+        forceAccum = dtkT3<double>(0, 0, 0);
 
-      mPosBuffers[iteration] = GetPosition() + mVel * timeslice * 0.5;
-      mVelBuffers[iteration] = mVel + mAccel * timeslice * 0.5;
-    } else if (iteration == 2) {
-      // compute acceleration
-      mAccelBuffers[iteration - 1] =
-          (mForceAccum + mForceDecorator + mGravity) / mMass;
-      mForceAccum = dtkT3<double>(0, 0, 0);
+        mPosBuffers[iteration][i] = GetPosition(i) + vel * timeslice * 0.5;
+        mVelBuffers[iteration][i] = vel + accel * timeslice * 0.5;
+      } else {
+        mAccelBuffers[iteration - 1][i] =
+            (forceAccum + forceDecorator + gravity) / mass;
+        forceAccum = dtkT3<double>(0, 0, 0);
+
+        posLastFrame = GetPosition(i);
+        p = GetPosition(i) + mVelBuffers[iteration - 1][i] * timeslice;
+        StorePosition(i, p);
+        vel = vel + mAccelBuffers[iteration - 1][i] * timeslice;
+      }
+      break;
+    case Heun:
+      if (iteration == 0) {
+        // compute acceleration
+        resistance = vel * (-resistCoef);
+        accel = (forceAccum + forceDecorator + gravity + resistance) / mass;
+        forceAccum = dtkT3<double>(0, 0, 0);
 
-      mPosBuffers[iteration] = GetPosition() + mVel * timeslice * 0.5;
-      mVelBuffers[iteration] = mVel + mAccel * timeslice * 0.5;
-    } else {
-      mAccelBuffers[iteration - 1] =
-          (mForceAccum + mForceDecorator + mGravity) / mMass;
-      mForceAccum = dtkT3<double>(0, 0, 0);
-
-      mPosLastFrame = GetPosition();
-      p = GetPosition() + (mVel + mVelBuffers[0] * 2.0 + mVelBuffers[1] * 2.0 +
-                           mVelBuffers[2]) /
-                              6.0 * timeslice;
-      mPts->SetPoint(mID, GK::Point3(p.x, p.y, p.z));
-      mVel = mVel + (mAccel + mAccelBuffers[0] * 2.0 + mAccelBuffers[1] * 2.0 +
-                     mAccelBuffers[2]) /
-                        6.0 * timeslice;
-    }
-    break;
+        mPosBuffers[iteration][i] = GetPosition(i) + vel * timeslice * 1.0;
+        mVelBuffers[iteration][i] = vel + accel * timeslice * 1.0;
+      } else {
+        resistance = mVelBuffers[iteration - 1][i] * (-resistCoef);
+        mAccelBuffers[iteration - 1][i] =
+            (forceAccum + forceDecorator + gravity + resistance) / mass;
+        forceAccum = dtkT3<double>(0, 0, 0);
+
+        p = GetPosition(i) +
+            (vel + mVelBuffers[iteration - 1][i]) * 0.5 * timeslice;
+        posLastFrame = GetPosition(i);
+        StorePosition(i, p);
+        vel = vel + (accel + mAccelBuffers[iteration - 1][i]) * 0.5 * timeslice;
+        // mVelBuffers[iteration][i] = vel;
+      }
+      break;
+    case Collision:
+      if (iteration == 0) {
+        mPosBuffers[iteration][i] = GetPosition(i);
+        mVelBuffers[iteration][i] = vel;
+
+        // compute acceleration
+        resistance = mVelBuffers[iteration][i] * (-resistCoef);
+        mAccelBuffers[iteration][i] =
+            (forceAccum + forceDecorator + gravity + resistance) / mass;
+        forceAccum = dtkT3<double>(0, 0, 0);
+
+        p = mPosBuffers[iteration][i] +
+            mVelBuffers[iteration][i] * timeslice * 1.0;
+        StorePosition(i, p);
+        vel = mVelBuffers[iteration][i] +
+              mAccelBuffers[iteration][i] * timeslice * 1.0;
+        vel = (vel + mVelBuffers[iteration][i]) * 0.5;
+        vel = vel * pointDamp;
+      } else {
+        resistance = vel * (-resistCoef);
+        accel = (forceAccum + forceDecorator + gravity + resistance) / mass;
+        forceAccum = dtkT3<double>(0, 0, 0);
+
+        p = mPosBuffers[iteration - 1][i] + vel * timeslice;
+        posLastFrame = mPosBuffers[iteration - 1][i];
+        StorePosition(i, p);
+        vel = mVelBuffers[iteration - 1][i] +
+               (accel + mAccelBuffers[iteration - 1][i]) * 0.5 * timeslice;
+        vel = vel * pointDamp;
+        // mVelBuffers[iteration][i] = vel;
+      }
+      break;
+    case RK4:
+      if (iteration == 0) {
+        // compute acceleration
+        accel = (forceAccum + forceDecorator + gravity) / mass;
+        forceAccum = dtkT3<double>(0, 0, 0);
+
+        mPosBuffers[iteration][i] = GetPosition(i) + vel * timeslice * 0.5;
+        mVelBuffers[iteration][i] = vel + accel * timeslice * 0.5;
+      } else if (iteration == 1) {
+        // compute acceleration
+        mAccelBuffers[iteration - 1][i] =
+            (forceAccum + forceDecorator + gravity) / mass;
+        forceAccum = dtkT3<double>(0, 0, 0);
+
+        mPosBuffers[iteration][i] = GetPosition(i) + vel * timeslice * 0.5;
+        mVelBuffers[iteration][i] = vel + accel * timeslice * 0.5;
+      } else if (iteration == 2) {
+        // compute acceleration
+        mAccelBuffers[iteration - 1][i] =
+            (forceAccum + forceDecorator + gravity) / mass;
+        forceAccum = dtkT3<double>(0, 0, 0);
+
+        mPosBuffers[iteration][i] = GetPosition(i) + vel * timeslice * 0.5;
+        mVelBuffers[iteration][i] = vel + accel * timeslice * 0.5;
+      } else {
+        mAccelBuffers[iteration - 1][i] =
+            (forceAccum + forceDecorator + gravity) / mass;
+        forceAccum = dtkT3<double>(0, 0, 0);
+
+        posLastFrame = GetPosition(i);
+        p = GetPosition(i) + (vel + mVelBuffers[0][i] * 2.0 +
+                              mVelBuffers[1][i] * 2.0 + mVelBuffers[2][i]) /
+                                6.0 * timeslice;
+        StorePosition(i, p);
+        vel = vel + (accel + mAccelBuffers[0][i] * 2.0 +
+                     mAccelBuffers[1][i] * 2.0 + mAccelBuffers[2][i]) /
+                          6.0 * timeslice;
+      }
+      break;
 
-  case Verlet:
-    if (iteration == 0) {
-      mPosBuffers[iteration] = GetPosition();
-      mVelBuffers[iteration] = mVel;
-      mAccelBuffers[iteration] = mAccel;
-      p = mPosBuffers[iteration] + mVelBuffers[iteration] * timeslice +
-          mAccelBuffers[iteration] * (timeslice * timeslice * 0.5);
-      mPts->SetPoint(mID, GK::Point3(p.x, p.y, p.z));
-      mVel =
-          mVelBuffers[iteration] + mAccelBuffers[iteration] * timeslice * 0.5;
-      mVel = mVel * mPointDamp;
-    } else {
-      mResistance = mVel * (-mResistCoef);
-      mAccel = (mForceAccum + mForceDecorator + mResistance) / mMass;
-      mForceAccum = dtkT3<double>(0, 0, 0);
+    case Verlet:
+      if (iteration == 0) {
+        mPosBuffers[iteration][i] = GetPosition(i);
+        mVelBuffers[iteration][i] = vel;
+        mAccelBuffers[iteration][i] = accel;
+        p = mPosBuffers[iteration][i] + mVelBuffers[iteration][i] * timeslice +
+            mAccelBuffers[iteration][i] * (timeslice * timeslice * 0.5);
+        StorePosition(i, p);
+        vel = mVelBuffers[iteration][i] +
+              mAccelBuffers[iteration][i] * timeslice * 0.5;
+        vel = vel * pointDamp;
+      } else {
+        resistance = vel * (-resistCoef);
+        accel = (forceAccum + forceDecorator + resistance) / mass;
+        forceAccum = dtkT3<double>(0, 0, 0);
 
-      mVel = mVel + mAccel * (timeslice * 0.5);
-      mVel = mVel * mPointDamp;
+        vel = vel + accel * (timeslice * 0.5);
+        vel = vel * pointDamp;
+      }
+      break;
+    default: {
+      // not handle
+    }
     }
-    break;
-  default: {
-    // not handle
-  }
   }
-  return true;
-}
-
-void dtkPhysMassPoint::SetPosition(dtkT3<double> newPos, dtkID iteration) {
-  mPosBuffers[iteration] = newPos;
 }
 
-dtkT3<double> dtkPhysMassPoint::GetPosition(ItrMethod method, dtkID iteration) {
+dtkT3<double> dtkPhysMassPointStorage::GetPosition(dtkID i, ItrMethod method,
+                                                   dtkID iteration) const {
   switch (method) {
-  case Euler: {
-    const GK::Point3 &vec = mPts->GetPoint(mID);
-    return dtkT3<double>(vec.x(), vec.y(), vec.z());
+  case Euler:
+  case Implicit:
+  case XPBD: {
+    return LoadPosition(i);
   }
   case Mid:
   case Heun:
   case RK4: {
     if (iteration == 0) {
-      const GK::Point3 &vec = mPts->GetPoint(mID);
-      return dtkT3<double>(vec.x(), vec.y(), vec.z());
+      return LoadPosition(i);
     } else {
-      return mPosBuffers[iteration - 1];
+      return mPosBuffers[iteration - 1][i];
     }
   }
   case Collision: {
-    const GK::Point3 &vec = mPts->GetPoint(mID);
-    return dtkT3<double>(vec.x(), vec.y(), vec.z());
+    return LoadPosition(i);
   }
   default: {
     // not handle
@@ -305,24 +411,23 @@ dtkT3<double> dtkPhysMassPoint::GetPosition(ItrMethod method, dtkID iteration) {
   return dtkT3<double>(0.0, 0.0, 0.0);
 }
 
-void dtkPhysMassPoint::SetVel(dtkT3<double> newVel, dtkID iteration) {
-  mVelBuffers[iteration] = newVel;
-}
-
-dtkT3<double> dtkPhysMassPoint::GetVel(ItrMethod method, dtkID iteration) {
+dtkT3<double> dtkPhysMassPointStorage::GetVel(dtkID i, ItrMethod method,
+                                              dtkID iteration) const {
   switch (method) {
   case Euler:
-    return mVel;
+  case Implicit:
+  case XPBD:
+    return mVel[i];
   case Mid:
   case Heun:
   case RK4:
     if (iteration == 0) {
-      return mVel;
+      return mVel[i];
     } else {
-      return mVelBuffers[iteration - 1];
+      return mVelBuffers[iteration - 1][i];
     }
   case Collision:
-    return mVel;
+    return mVel[i];
   default: {
     // not handle
   }
@@ -330,20 +435,23 @@ dtkT3<double> dtkPhysMassPoint::GetVel(ItrMethod method, dtkID iteration) {
   return dtkT3<double>(0.0, 0.0, 0.0);
 }
 
-dtkT3<double> dtkPhysMassPoint::GetAccel(ItrMethod method, dtkID iteration) {
+dtkT3<double> dtkPhysMassPointStorage::GetAccel(dtkID i, ItrMethod method,
+                                                dtkID iteration) const {
   switch (method) {
   case Euler:
-    return mAccel;
+  case Implicit:
+  case XPBD:
+    return mAccel[i];
   case Mid:
   case Heun:
   case RK4:
     if (iteration == 0) {
-      return mAccel;
+      return mAccel[i];
     } else {
-      return mAccelBuffers[iteration - 1];
+      return mAccelBuffers[iteration - 1][i];
     }
   case Collision:
-    return mAccel;
+    return mAccel[i];
   default: {
     // not handle
   }
@@ -351,40 +459,145 @@ dtkT3<double> dtkPhysMassPoint::GetAccel(ItrMethod method, dtkID iteration) {
   return dtkT3<double>(0.0, 0.0, 0.0);
 }
 
-void dtkPhysMassPoint::SetActive(bool newActive, bool passToTwin) {
-  mActive = newActive;
-  if (!mActive) {
-    mVel = dtkT3<double>(0, 0, 0);
-    mAccel = dtkT3<double>(0, 0, 0);
-
-    for (unsigned int i = 0; i < 3; i++) {
-      mPosBuffers[i] = GetPosition();
-      mVelBuffers[i] = dtkT3<double>(0, 0, 0);
-      mAccelBuffers[i] = dtkT3<double>(0, 0, 0);
-    }
-  }
-  if (mTwins.size() > 0 && passToTwin) {
-    for (dtkID i = 0; i < mTwins.size(); i++) {
-      mTwins[i]->SetActive(newActive, false);
+void dtkPhysMassPointStorage::SetActive(dtkID i, bool newActive) {
+  mActive[i] = newActive;
+  if (!newActive) {
+    mVel[i] = dtkT3<double>(0, 0, 0);
+    mAccel[i] = dtkT3<double>(0, 0, 0);
+
+    for (unsigned int k = 0; k < 3; k++) {
+      mPosBuffers[k][i] = GetPosition(i);
+      mVelBuffers[k][i] = dtkT3<double>(0, 0, 0);
+      mAccelBuffers[k][i] = dtkT3<double>(0, 0, 0);
     }
   }
 }
 
-void dtkPhysMassPoint::ApplyImpulse() {
-  if (mImpulseNum != 0) {
-    mImpulseNum = 1;
-    if (mActive)
-      mVel = mVel + mImpulse * (1.0 / (mMass * (double)mImpulseNum));
-    mImpulse = dtkT3<double>(0, 0, 0);
-    mImpulseNum = 0;
+void dtkPhysMassPointStorage::ApplyImpulse(dtkID i) {
+  if (mImpulseNum[i] != 0) {
+    mImpulseNum[i] = 1;
+    if (mActive[i])
+      mVel[i] =
+          mVel[i] + mImpulse[i] * (1.0 / (mMass[i] * (double)mImpulseNum[i]));
+    mImpulse[i] = dtkT3<double>(0, 0, 0);
+    mImpulseNum[i] = 0;
   }
 }
 
-dtkT3<double> dtkPhysMassPoint::GetAndClearImpulse() {
-  mImpulseNum = 1;
-  dtkT3<double> temp = mImpulse * (1.0 / (double)mImpulseNum);
-  mImpulse = dtkT3<double>(0, 0, 0);
-  mImpulseNum = 0;
+dtkT3<double> dtkPhysMassPointStorage::GetAndClearImpulse(dtkID i) {
+  mImpulseNum[i] = 1;
+  dtkT3<double> temp = mImpulse[i] * (1.0 / (double)mImpulseNum[i]);
+  mImpulse[i] = dtkT3<double>(0, 0, 0);
+  mImpulseNum[i] = 0;
   return temp;
 }
+
+void dtkPhysMassPointStorage::ResetDynamicState(dtkID i) {
+  mVel[i] = dtkT3<double>(0, 0, 0);
+  mAccel[i] = dtkT3<double>(0, 0, 0);
+  for (dtkID k = 0; k < 3; k++) {
+    mVelBuffers[k][i] = dtkT3<double>(0, 0, 0);
+    mAccelBuffers[k][i] = dtkT3<double>(0, 0, 0);
+  }
+}
+
+void dtkPhysMassPointStorage::Sleep(dtkID i) {
+  const dtkT3<double> zero(0, 0, 0);
+  dtkT3<double> pos = LoadPosition(i);
+  mSleeping[i] = true;
+  mWake[i] = false;
+  mVel[i] = zero;
+  mAccel[i] = zero;
+  mForceAccum[i] = zero;
+  mPosLastFrame[i] = pos;
+  for (dtkID k = 0; k < 3; k++) {
+    mPosBuffers[k][i] = pos;
+    mVelBuffers[k][i] = zero;
+    mAccelBuffers[k][i] = zero;
+  }
+}
+
+void dtkPhysMassPointStorage::Wake(dtkID i) {
+  mSleeping[i] = false;
+  mWake[i] = false;
+  // 休眠期间转发来的弹簧力没有意义, 冲量保留到下一次应用.
+  mForceAccum[i] = dtkT3<double>(0, 0, 0);
+}
+
+template <typename T> static void RelocateArray(std::vector<T> &v) {
+  std::vector<T>(v.begin(), v.end()).swap(v);
+}
+
+void dtkPhysMassPointStorage::Relocate() {
+  RelocateArray(mPointIDs);
+  RelocateArray(mVel);
+  RelocateArray(mAccel);
+  RelocateArray(mForceAccum);
+  RelocateArray(mGravity);
+  RelocateArray(mResistance);
+  RelocateArray(mPosLastFrame);
+  RelocateArray(mForceDecorator);
+  RelocateArray(mImpulse);
+  RelocateArray(mMass);
+  RelocateArray(mResistCoef);
+  RelocateArray(mPointDamp);
+  RelocateArray(mImpulseNum);
+  RelocateArray(mActive);
+  RelocateArray(mCollide);
+  RelocateArray(mLabel);
+  RelocateArray(mSleeping);
+  RelocateArray(mWake);
+  for (dtkID k = 0; k < 3; k++) {
+    RelocateArray(mPosBuffers[k]);
+    RelocateArray(mVelBuffers[k]);
+    RelocateArray(mAccelBuffers[k]);
+  }
+}
+
+dtkPhysMassPoint::dtkPhysMassPoint(dtkID id, dtkPoints::Ptr pts,
+                                   const double &mass, const dtkT3<double> &vel,
+                                   double pointDamp, double pointResistence,
+                                   dtkDouble3 gravityAccel) {
+  // 单独创建的质点使用自己的存储.
+  mStorage = dtkPhysMassPointStorage::New(pts);
+  mIndex = mStorage->AddPoint(id, mass, vel, pointDamp, pointResistence,
+                              gravityAccel);
+}
+
+dtkPhysMassPoint::dtkPhysMassPoint(dtkPhysMassPointStorage::Ptr storage,
+                                   dtkID index) {
+  assert(index < storage->GetNumberOfPoints());
+  mStorage = storage;
+  mIndex = index;
+}
+
+dtkPhysMassPoint::~dtkPhysMassPoint() { AbandonTwins(); }
+
+bool dtkPhysMassPoint::Update(double timeslice, ItrMethod method,
+                              dtkID iteration) {
+  mStorage->Update(mIndex, mIndex + 1, timeslice, method, iteration);
+  return true;
+}
+
+void dtkPhysMassPoint::SetPosition(dtkT3<double> newPos, bool passToTwin) {
+  if (!passToTwin || !mTwinCluster) {
+    mStorage->SetPosition(mIndex, newPos);
+    mStorage->Disturb(mIndex);
+    return;
+  }
+  const std::vector<dtkPhysMassPoint *> &members = mTwinCluster->GetMembers();
+  for (dtkID i = 0; i < members.size(); i++)
+    members[i]->SetPosition(newPos, false);
+}
+
+void dtkPhysMassPoint::SetActive(bool newActive, bool passToTwin) {
+  if (!passToTwin || !mTwinCluster) {
+    mStorage->SetActive(mIndex, newActive);
+    mStorage->Disturb(mIndex);
+    return;
+  }
+  const std::vector<dtkPhysMassPoint *> &members = mTwinCluster->GetMembers();
+  for (dtkID i = 0; i < members.size(); i++)
+    members[i]->SetActive(newActive, false);
+}
 } // namespace dtk
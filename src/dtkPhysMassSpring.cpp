@@ -21,17 +21,99 @@
 #ifdef DTK_PHYSMASSSPRINGIMPL_DEBUG
 #include <iostream>
 #endif
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <iostream>
 #include <set>
 #include <string>
 
+#include <boost/bind/bind.hpp>
+
 #include "dtkPhysMassSpring.h"
 
 using namespace std;
+using namespace boost::placeholders;
 
 namespace dtk {
 
+namespace {
+// FindTwins 的均匀网格中的一项, 按格子坐标排序, 同一格子内按质点下标.
+struct TwinCell {
+  long long x, y, z;
+  dtkID point;
+
+  bool operator<(const TwinCell &rhs) const {
+    if (x != rhs.x)
+      return x < rhs.x;
+    if (y != rhs.y)
+      return y < rhs.y;
+    if (z != rhs.z)
+      return z < rhs.z;
+    return point < rhs.point;
+  }
+};
+
+struct TwinSearch {
+  dtkPhysMassSpring *other;              /**< 被搜索的质量弹簧 */
+  std::vector<dtkT3<double>> positions;  /**< 本对象质点的位置 */
+  std::vector<dtkT3<double>> candidates; /**< 被搜索对象质点的位置 */
+  std::vector<TwinCell> cells;           /**< 尚无 twin 的被搜索质点 */
+  std::vector<dtkID> nearest;            /**< 每个质点最近的候选 */
+  double distance;                       /**< 搜索距离, 不含 */
+  double cellSize;                       /**< 格子边长, 不小于搜索距离 */
+};
+
+long long twin_cell_coord(double value, double cellSize) {
+  // 很小的格子上远处的坐标会溢出, 截断后仍然只与相邻格子比较.
+  double coord = std::floor(value / cellSize);
+  const double limit = 4.0e18;
+  return (long long)(max(-limit, min(limit, coord)));
+}
+
+/**
+ * 在相邻的 27 个格子里找距离小于搜索距离的最近质点, 相等时取下标小的.
+ * live 为 true 时跳过已经有 twin 的质点, 对应逐点匹配时的实时状态.
+ */
+dtkID nearest_twin(const TwinSearch &search, const dtkT3<double> &pos,
+                   bool live) {
+  long long cx = twin_cell_coord(pos.x, search.cellSize);
+  long long cy = twin_cell_coord(pos.y, search.cellSize);
+  long long cz = twin_cell_coord(pos.z, search.cellSize);
+  dtkID best = dtkErrorID;
+  double bestDistance = search.distance;
+  for (long long dx = -1; dx <= 1; dx++) {
+    for (long long dy = -1; dy <= 1; dy++) {
+      for (long long dz = -1; dz <= 1; dz++) {
+        TwinCell key = {cx + dx, cy + dy, cz + dz, 0};
+        vector<TwinCell>::const_iterator itr =
+            lower_bound(search.cells.begin(), search.cells.end(), key);
+        for (; itr != search.cells.end() && itr->x == key.x &&
+               itr->y == key.y && itr->z == key.z;
+             itr++) {
+          dtkID j = itr->point;
+          if (live && search.other->GetMassPoint(j)->HasTwin())
+            continue;
+          double tempDistance = length(pos - search.candidates[j]);
+          if (tempDistance < bestDistance ||
+              (tempDistance == bestDistance && best != dtkErrorID &&
+               j < best)) {
+            bestDistance = tempDistance;
+            best = j;
+          }
+        }
+      }
+    }
+  }
+  return best;
+}
+
+void query_twins(TwinSearch *search, dtkID begin, dtkID end) {
+  for (dtkID i = begin; i < end; i++)
+    search->nearest[i] = nearest_twin(*search, search->positions[i], false);
+}
+} // namespace
+
 dtkPhysMassSpring::dtkPhysMassSpring(double defaultMass, double defaultStiff,
                                      double defaultDamp,
                                      double defaultPointDamp,
@@ -64,6 +146,23 @@ dtkPhysMassSpring::dtkPhysMassSpring(double defaultMass, double defaultStiff,
   mSpringDampData = NULL;
 #endif
   mUnderControl = false;
+  mSubsteps = 1;
+  mTwinGeneration = 0;
+  mStorage = dtkPhysMassPointStorage::New();
+  mSpringStorage = dtkPhysSpringStorage::New();
+  mForceMode = SerialForce;
+  mGrainSize = 1024;
+  mForceLayoutDirty = true;
+  mImplicitLayoutDirty = true;
+  mPositionLayoutDirty = true;
+  mSleepEnabled = false;
+  mSleepThreshold = 0;
+  mSleepFrames = 30;
+  mSleepRegionSize = 256;
+  mSleepLayoutDirty = true;
+  mAwakeRunsDirty = true;
+  mStageSleeping = true;
+  mNumberOfSleepingRegions = 0;
 }
 
 dtkPhysMassSpring::~dtkPhysMassSpring() {
@@ -79,6 +178,7 @@ dtkPhysMassSpring::~dtkPhysMassSpring() {
 void dtkPhysMassSpring::SetPoints(dtkPoints::Ptr points) {
   dtkAssert(points.get() != NULL, NULL_POINTER);
   mPts = points;
+  mStorage->SetPoints(points);
 }
 
 dtkPoints::Ptr dtkPhysMassSpring::GetPoints() { return mPts; }
@@ -97,13 +197,18 @@ dtkID dtkPhysMassSpring::AddMassPoint(dtkID id, const double &mass,
                                       const dtkT3<double> &vel,
                                       double pointDamp, double pointResistence,
                                       dtkDouble3 defaultGravityAccel) {
-  mMassPoints.push_back(new dtkPhysMassPoint(
-      id, mPts, mass, vel, pointDamp, pointResistence, defaultGravityAccel));
+  dtkID index = mStorage->AddPoint(id, mass, vel, pointDamp, pointResistence,
+                                   defaultGravityAccel);
+  mMassPoints.push_back(new dtkPhysMassPoint(mStorage, index));
 
 #ifdef DTK_PHYSMASSSPRINGIMPL_DEBUG
   mAltitudeSpringForces.push_back(dtkT3<double>(0, 0, 0));
 #endif
 
+  mForceLayoutDirty = true;
+  mImplicitLayoutDirty = true;
+  mPositionLayoutDirty = true;
+  mSleepLayoutDirty = true;
   return mMassPoints.size() - 1;
 }
 
@@ -112,10 +217,18 @@ dtkID dtkPhysMassSpring::AddSpring(dtkID p1, dtkID p2, const double &stiff,
   if (p1 > p2)
     swap(p1, p2);
   if (mEdgeMap.find(dtkID2(p1, p2)) == mEdgeMap.end()) {
-    dtkPhysSpring *newSpring =
-        new dtkPhysSpring(mMassPoints[p1], mMassPoints[p2], stiff, damp);
+    GK::Vector3 vec =
+        mMassPoints[p2]->GetPoint() - mMassPoints[p1]->GetPoint();
+    dtkID index = mSpringStorage->AddSpring(
+        p1, p2, length(dtkT3<double>(vec.x(), vec.y(), vec.z())), stiff, damp);
+    dtkPhysSpring *newSpring = new dtkPhysSpring(
+        mSpringStorage, index, mMassPoints[p1], mMassPoints[p2]);
     mSprings.push_back(newSpring);
     mEdgeMap[dtkID2(p1, p2)] = newSpring;
+    mForceLayoutDirty = true;
+    mImplicitLayoutDirty = true;
+    mPositionLayoutDirty = true;
+    mSleepLayoutDirty = true;
   }
   return mSprings.size() - 1;
 }
@@ -124,17 +237,36 @@ bool dtkPhysMassSpring::Update_s(double timeslice, ItrMethod method,
                                  bool limitDeformation) {
   if (timeslice == 0)
     return true;
+  WakeDisturbed();
+  if (IsSleeping())
+    return true;
   switch (method) {
   case Euler:
     PreUpdate(timeslice, method);
     UpdateStrings(timeslice, method, 0, limitDeformation);
+    ResolveTwinForces();
     UpdateMassPoints(timeslice, method, 0);
     PostUpdate(method);
     break;
+  case Implicit:
+    PreUpdate(timeslice, method);
+    UpdateStrings(timeslice, method, 0, limitDeformation);
+    ResolveTwinForces();
+    SolveImplicit(timeslice);
+    UpdateMassPoints(timeslice, method, 0);
+    PostUpdate(method);
+    break;
+  case XPBD:
+    // 弹簧由约束投影代替, 不再累加弹簧力.
+    PreUpdate(timeslice, method);
+    SolvePositions(timeslice);
+    PostUpdate(method);
+    break;
   case Mid:
     for (dtkID i = 0; i < 2; i++) {
       PreUpdate(timeslice, method, i);
       UpdateStrings(timeslice, method, i, limitDeformation);
+      ResolveTwinForces();
       UpdateMassPoints(timeslice, method, i);
       PostUpdate(method, i);
     }
@@ -143,6 +275,7 @@ bool dtkPhysMassSpring::Update_s(double timeslice, ItrMethod method,
     for (dtkID i = 0; i < 4; i++) {
       PreUpdate(timeslice, method, i);
       UpdateStrings(timeslice, method, i, limitDeformation);
+      ResolveTwinForces();
       UpdateMassPoints(timeslice, method, i);
       PostUpdate(method, i);
     }
@@ -158,6 +291,7 @@ bool dtkPhysMassSpring::Update_s(double timeslice, ItrMethod method,
       }
 #endif
       UpdateStrings(timeslice, method, i, limitDeformation);
+      ResolveTwinForces();
       UpdateMassPoints(timeslice, method, i);
       PostUpdate(method, i);
     }
@@ -172,6 +306,7 @@ bool dtkPhysMassSpring::Update_s(double timeslice, ItrMethod method,
       }
 #endif
       UpdateStrings(timeslice, method, i, limitDeformation);
+      ResolveTwinForces();
       UpdateMassPoints(timeslice, method, i);
       PostUpdate(method, i);
     }
@@ -180,6 +315,7 @@ bool dtkPhysMassSpring::Update_s(double timeslice, ItrMethod method,
   }
   }
 
+  UpdateSleeping();
   return true;
 }
 
@@ -197,6 +333,7 @@ bool dtkPhysMassSpring::Update_iteration(double timeslice, ItrMethod method,
   }
 #endif
   UpdateStrings(timeslice, method, iteration, limitDeformation);
+  ResolveTwinForces();
   UpdateMassPoints(timeslice, method, iteration);
   PostUpdate(method, iteration);
   return true;
@@ -212,22 +349,610 @@ bool dtkPhysMassSpring::Update(double timeslice, ItrMethod method,
     return Update_s(timeslice, method, limitDeformation);
 }
 
+bool dtkPhysMassSpring::UpdateConnected(
+    const vector<dtkPhysMassSpring *> &massSprings, double timeslice,
+    ItrMethod method, bool limitDeformation) {
+  if (timeslice == 0)
+    return true;
+  // 约束投影不累加弹簧力, 没有需要合并的 twins 力.
+  if (method == XPBD) {
+    for (dtkID i = 0; i < massSprings.size(); i++)
+      massSprings[i]->Update_s(timeslice, method, limitDeformation);
+    return true;
+  }
+
+  size_t iterations = 1;
+  if (method == Mid || method == Heun || method == Collision)
+    iterations = 2;
+  else if (method == RK4)
+    iterations = 4;
+
+  for (dtkID i = 0; i < massSprings.size(); i++)
+    massSprings[i]->WakeDisturbed();
+  // 每次迭代先让所有对象累加弹簧力, 再合并簇上的合外力, 最后各自积分.
+  for (dtkID iteration = 0; iteration < iterations; iteration++) {
+    for (dtkID i = 0; i < massSprings.size(); i++) {
+      dtkPhysMassSpring *massSpring = massSprings[i];
+      if (massSpring->IsSleeping())
+        continue;
+      massSpring->PreUpdate(timeslice, method, iteration);
+      massSpring->UpdateStrings(timeslice, method, iteration,
+                                limitDeformation);
+    }
+    for (dtkID i = 0; i < massSprings.size(); i++)
+      massSprings[i]->ResolveTwinForces();
+    for (dtkID i = 0; i < massSprings.size(); i++) {
+      dtkPhysMassSpring *massSpring = massSprings[i];
+      if (massSpring->IsSleeping())
+        continue;
+      if (method == Implicit)
+        massSpring->SolveImplicit(timeslice);
+      massSpring->UpdateMassPoints(timeslice, method, iteration);
+      massSpring->PostUpdate(method, iteration);
+    }
+  }
+  for (dtkID i = 0; i < massSprings.size(); i++) {
+    if (!massSprings[i]->IsSleeping())
+      massSprings[i]->UpdateSleeping();
+  }
+  return true;
+}
+
 bool dtkPhysMassSpring::UpdateStrings(double timeslice, ItrMethod method,
                                       dtkID iteration, bool limitDeformation) {
-  for (dtkID i = 0; i < mSprings.size(); i++)
-    mSprings[i]->Update(timeslice, method, iteration, limitDeformation);
+  // limitDeformation 分支在 dtkPhysSpring::ComputeForce 中不改变结果,
+  // 批量内核不再处理.
+  WakeDisturbed();
+  if (mAwakeRunsDirty)
+    BuildAwakeRuns();
+
+  if (!IsParallelForce(mSprings.size())) {
+    ResizeForceBuffers();
+    _StageMassPoints(0, mMassPoints.size(), method, iteration);
+    mStageSleeping = false;
+    _ComputeAwakeSpringForces(0, mSprings.size(), timeslice);
+    // 按弹簧顺序写入质点, 与逐根 Update 的累加顺序相同.
+    // 休眠端点上的力在唤醒时清空.
+    dtkID cursor = 0, first, last;
+    while (NextAwakeRange(mAwakeSpringRuns, 0, mSprings.size(), cursor, first,
+                          last)) {
+      for (dtkID i = first; i < last; i++) {
+        dtkT3<double> force(mSpringForces[0][i], mSpringForces[1][i],
+                            mSpringForces[2][i]);
+        mSprings[i]->GetFirstVertex()->AddForce(force * (-1.0));
+        mSprings[i]->GetSecondVertex()->AddForce(force);
+      }
+    }
+    return true;
+  }
+
+  if (mForceLayoutDirty)
+    BuildForceLayout();
 
+  if (mForceMode == ColoredForce) {
+    for (dtkID i = 0; i < mSpringColors.size(); i++) {
+      ForkJoinRange(mSpringColors[i].size(),
+                    boost::bind(&dtkPhysMassSpring::_UpdateColoredSprings,
+                                this, &mSpringColors[i], _1, _2, timeslice,
+                                method, iteration, limitDeformation));
+    }
+    return true;
+  }
+
+  ResizeForceBuffers();
+  ForkJoinRange(mMassPoints.size(),
+                boost::bind(&dtkPhysMassSpring::_StageMassPoints, this, _1, _2,
+                            method, iteration));
+  mStageSleeping = false;
+
+  if (mForceMode == GatherForce) {
+    // 每个子任务只写自己负责的质点, 不需要弹簧力缓冲与原子操作.
+    ForkJoinRange(mMassPoints.size(),
+                  boost::bind(&dtkPhysMassSpring::_GatherIncidentForces, this,
+                              _1, _2, timeslice));
+    return true;
+  }
+
+  ForkJoinRange(mSprings.size(),
+                boost::bind(&dtkPhysMassSpring::_ComputeAwakeSpringForces,
+                            this, _1, _2, timeslice));
+  ForkJoinRange(mMassPoints.size(),
+                boost::bind(&dtkPhysMassSpring::_GatherSpringForces, this, _1,
+                            _2));
   return true;
 }
 
 bool dtkPhysMassSpring::UpdateMassPoints(double timeslice, ItrMethod method,
                                          dtkID iteration) {
-  for (dtkID i = 0; i < mMassPoints.size(); i++)
-    mMassPoints[i]->Update(timeslice, method, iteration);
+  // 质点更新只写自身状态, 可以直接分块并行.
+  if (IsParallelForce(mMassPoints.size())) {
+    ForkJoinRange(mMassPoints.size(),
+                  boost::bind(&dtkPhysMassSpring::_UpdateMassPointRange, this,
+                              _1, _2, timeslice, method, iteration));
+    return true;
+  }
+
+  // 质点状态按数组连续存放, 整段顺序更新.
+  mStorage->Update(0, mMassPoints.size(), timeslice, method, iteration);
+
+  return true;
+}
+
+bool dtkPhysMassSpring::SolveImplicit(double timeslice) {
+  if (!mImplicitSolver)
+    mImplicitSolver = dtkPhysImplicitSolver::New();
+  if (mImplicitLayoutDirty) {
+    mImplicitSolver->BuildStructure(mMassPoints.size(),
+                                    mSpringStorage->mEnds);
+    mImplicitLayoutDirty = false;
+  }
+
+  // 着色模式不暂存质点状态, 这里统一重新暂存.
+  bool parallel = IsParallelForce(mMassPoints.size());
+  ResizeForceBuffers();
+  if (parallel)
+    ForkJoinRange(mMassPoints.size(),
+                  boost::bind(&dtkPhysMassSpring::_StageMassPoints, this, _1,
+                              _2, Implicit, 0));
+  else
+    _StageMassPoints(0, mMassPoints.size(), Implicit, 0);
+  mStageSleeping = false;
+
+  const dtkReal *const pos[3] = {mStagePos[0].data(), mStagePos[1].data(),
+                                mStagePos[2].data()};
+  const dtkReal *const vel[3] = {mStageVel[0].data(), mStageVel[1].data(),
+                                mStageVel[2].data()};
+  mImplicitSolver->Solve(*mStorage, *mSpringStorage, pos, vel, timeslice,
+                         parallel ? mScheduler.get() : 0, mGrainSize);
+  return true;
+}
 
+bool dtkPhysMassSpring::SolvePositions(double timeslice) {
+  WakeDisturbed();
+  if (!mPositionSolver)
+    mPositionSolver = dtkPhysPositionSolver::New();
+  if (mPositionLayoutDirty) {
+    CollectVolumes(*mPositionSolver);
+    mPositionSolver->BuildStructure(mMassPoints.size(), *mSpringStorage);
+    mPositionLayoutDirty = false;
+  }
+
+  bool parallel = IsParallelForce(mMassPoints.size());
+  mPositionSolver->Solve(*mStorage, *mSpringStorage, timeslice,
+                         parallel ? mScheduler.get() : 0, mGrainSize);
   return true;
 }
 
+void dtkPhysMassSpring::CollectVolumes(dtkPhysPositionSolver &solver) {
+  solver.ClearVolumes();
+}
+
+void dtkPhysMassSpring::FirstTouch() {
+  if (mPts)
+    mPts->Relocate();
+  mStorage->Relocate();
+  // 力缓冲在下一次并行更新时由工作线程重建.
+  vector<vector<dtkID>>().swap(mSpringColors);
+  for (dtkID k = 0; k < 3; k++) {
+    vector<dtkReal>().swap(mSpringForces[k]);
+    vector<dtkReal>().swap(mStagePos[k]);
+    vector<dtkReal>().swap(mStageVel[k]);
+  }
+  vector<dtkID>().swap(mIncidentOffsets);
+  vector<dtkID>().swap(mIncidentSprings);
+  vector<dtkID>().swap(mIncidentNeighbors);
+  mForceLayoutDirty = true;
+  mStageSleeping = true;
+}
+
+bool dtkPhysMassSpring::IsParallelForce(size_t count) const {
+  return mForceMode != SerialForce && mScheduler &&
+         mScheduler->IsWorkerThread() && count > mGrainSize;
+}
+
+void dtkPhysMassSpring::BuildForceLayout() {
+  // 端点下标就是质点在 mMassPoints 中的下标.
+  const vector<dtkID> &ends = mSpringStorage->mEnds;
+
+  // 贪心着色: 按弹簧顺序取两个端点都未使用的最小颜色, 结果与线程数无关.
+  mSpringColors.clear();
+  vector<vector<dtkID>> pointColors(mMassPoints.size());
+  for (dtkID i = 0; i < mSprings.size(); i++) {
+    const vector<dtkID> &first = pointColors[ends[i * 2]];
+    const vector<dtkID> &second = pointColors[ends[i * 2 + 1]];
+    dtkID color = 0;
+    while (find(first.begin(), first.end(), color) != first.end() ||
+           find(second.begin(), second.end(), color) != second.end())
+      color++;
+    if (color == mSpringColors.size())
+      mSpringColors.push_back(vector<dtkID>());
+    mSpringColors[color].push_back(i);
+    pointColors[ends[i * 2]].push_back(color);
+    pointColors[ends[i * 2 + 1]].push_back(color);
+  }
+
+  // 质点到关联弹簧的压缩表, 归约时按弹簧id顺序累加.
+  mIncidentOffsets.assign(mMassPoints.size() + 1, 0);
+  for (dtkID i = 0; i < ends.size(); i++)
+    mIncidentOffsets[ends[i] + 1]++;
+  for (dtkID i = 0; i < mMassPoints.size(); i++)
+    mIncidentOffsets[i + 1] += mIncidentOffsets[i];
+  mIncidentSprings.resize(ends.size());
+  mIncidentNeighbors.resize(ends.size());
+  vector<dtkID> cursor(mIncidentOffsets.begin(), mIncidentOffsets.end() - 1);
+  for (dtkID i = 0; i < ends.size(); i++) {
+    mIncidentNeighbors[cursor[ends[i]]] = ends[i ^ 1];
+    mIncidentSprings[cursor[ends[i]]++] = i;
+  }
+
+  mForceLayoutDirty = false;
+}
+
+void dtkPhysMassSpring::ResizeForceBuffers() {
+  for (dtkID k = 0; k < 3; k++) {
+    mSpringForces[k].resize(mSprings.size());
+    mStagePos[k].resize(mMassPoints.size());
+    mStageVel[k].resize(mMassPoints.size());
+  }
+}
+
+void dtkPhysMassSpring::_UpdateColoredSprings(const vector<dtkID> *batch,
+                                              dtkID begin, dtkID end,
+                                              double timeslice,
+                                              ItrMethod method,
+                                              dtkID iteration,
+                                              bool limitDeformation) {
+  for (dtkID i = begin; i < end; i++) {
+    dtkPhysSpring *spring = mSprings[(*batch)[i]];
+    if (spring->GetFirstVertex()->IsSleeping() &&
+        spring->GetSecondVertex()->IsSleeping())
+      continue;
+    spring->Update(timeslice, method, iteration, limitDeformation);
+  }
+}
+
+void dtkPhysMassSpring::_StageMassPoints(dtkID begin, dtkID end,
+                                         ItrMethod method, dtkID iteration) {
+  for (dtkID i = begin; i < end; i++) {
+    // 休眠质点的暂存状态在入睡后只刷新一次.
+    if (!mStageSleeping && mStorage->mSleeping[i])
+      continue;
+    dtkT3<double> pos = mStorage->GetPosition(i, method, iteration);
+    dtkT3<double> vel = mStorage->GetVel(i, method, iteration);
+    for (dtkID k = 0; k < 3; k++) {
+      mStagePos[k][i] = dtkReal(pos[k]);
+      mStageVel[k][i] = dtkReal(vel[k]);
+    }
+  }
+}
+
+void dtkPhysMassSpring::_ComputeSpringForces(dtkID begin, dtkID end,
+                                             double timeslice) {
+  const dtkReal *const pos[3] = {mStagePos[0].data(), mStagePos[1].data(),
+                                mStagePos[2].data()};
+  const dtkReal *const vel[3] = {mStageVel[0].data(), mStageVel[1].data(),
+                                mStageVel[2].data()};
+  dtkReal *const force[3] = {mSpringForces[0].data(), mSpringForces[1].data(),
+                            mSpringForces[2].data()};
+  mSpringStorage->ComputeForces(begin, end, pos, vel, timeslice, force);
+}
+
+void dtkPhysMassSpring::_GatherSpringForces(dtkID begin, dtkID end) {
+  for (dtkID i = begin; i < end; i++) {
+    dtkPhysMassPoint *point = mMassPoints[i];
+    if (mStorage->mSleeping[i] ||
+        mIncidentOffsets[i] == mIncidentOffsets[i + 1])
+      continue;
+    // 第一个端点受反向的力.
+    dtkT3<double> force(0, 0, 0);
+    for (dtkID j = mIncidentOffsets[i]; j < mIncidentOffsets[i + 1]; j++) {
+      dtkID slot = mIncidentSprings[j];
+      dtkT3<double> f(mSpringForces[0][slot / 2], mSpringForces[1][slot / 2],
+                      mSpringForces[2][slot / 2]);
+      if (slot % 2 == 0)
+        force = force - f;
+      else
+        force = force + f;
+    }
+    point->AddForce(force);
+  }
+}
+
+void dtkPhysMassSpring::_GatherIncidentForces(dtkID begin, dtkID end,
+                                              double timeslice) {
+  const dtkReal *const pos[3] = {mStagePos[0].data(), mStagePos[1].data(),
+                                mStagePos[2].data()};
+  const dtkReal *const vel[3] = {mStageVel[0].data(), mStageVel[1].data(),
+                                mStageVel[2].data()};
+  // 分块计算, 结果放在栈上.
+  const dtkID blockSize = 64;
+  double block[3][blockSize];
+  double *const force[3] = {block[0], block[1], block[2]};
+  // 只计算活动的质点, 休眠的邻居按暂存状态参与.
+  dtkID cursor = 0, awakeBegin, awakeEnd;
+  while (NextAwakeRange(mAwakePointRuns, begin, end, cursor, awakeBegin,
+                        awakeEnd)) {
+    for (dtkID first = awakeBegin; first < awakeEnd; first += blockSize) {
+      dtkID last = min(awakeEnd, first + blockSize);
+      mSpringStorage->GatherForces(first, last, mIncidentOffsets.data(),
+                                   mIncidentNeighbors.data(),
+                                   mIncidentSprings.data(), pos, vel,
+                                   timeslice, force);
+      for (dtkID i = first; i < last; i++) {
+        dtkPhysMassPoint *point = mMassPoints[i];
+        if (mIncidentOffsets[i] == mIncidentOffsets[i + 1])
+          continue;
+        point->AddForce(dtkT3<double>(block[0][i - first],
+                                      block[1][i - first],
+                                      block[2][i - first]));
+      }
+    }
+  }
+}
+
+void dtkPhysMassSpring::_UpdateMassPointRange(dtkID begin, dtkID end,
+                                              double timeslice,
+                                              ItrMethod method,
+                                              dtkID iteration) {
+  mStorage->Update(begin, end, timeslice, method, iteration);
+}
+
+void dtkPhysMassSpring::_ComputeAwakeSpringForces(dtkID begin, dtkID end,
+                                                  double timeslice) {
+  dtkID cursor = 0, first, last;
+  while (NextAwakeRange(mAwakeSpringRuns, begin, end, cursor, first, last))
+    _ComputeSpringForces(first, last, timeslice);
+}
+
+bool dtkPhysMassSpring::NextAwakeRange(const vector<dtkID> &runs,
+                                       dtkID begin, dtkID end, dtkID &cursor,
+                                       dtkID &first, dtkID &last) const {
+  if (mNumberOfSleepingRegions == 0) {
+    if (cursor != 0 || begin >= end)
+      return false;
+    cursor = 1;
+    first = begin;
+    last = end;
+    return true;
+  }
+
+  // 游标为下一段区间的位置加 1, 第一次调用时二分查找.
+  dtkID run;
+  if (cursor == 0) {
+    dtkID low = 0, high = dtkID(runs.size() / 2);
+    while (low < high) {
+      dtkID middle = (low + high) / 2;
+      if (runs[middle * 2 + 1] <= begin)
+        low = middle + 1;
+      else
+        high = middle;
+    }
+    run = low * 2;
+  } else {
+    run = cursor - 1;
+  }
+  while (run < runs.size() && runs[run] < end) {
+    first = max(begin, runs[run]);
+    last = min(end, runs[run + 1]);
+    run += 2;
+    if (first < last) {
+      cursor = run + 1;
+      return true;
+    }
+  }
+  cursor = run + 1;
+  return false;
+}
+
+void dtkPhysMassSpring::EnableSleeping(double threshold, size_t frames,
+                                       size_t regionSize) {
+  mSleepEnabled = true;
+  mSleepThreshold = threshold;
+  mSleepFrames = frames;
+  mSleepRegionSize = regionSize > 0 ? regionSize : 1;
+  mSleepLayoutDirty = true;
+}
+
+void dtkPhysMassSpring::DisableSleeping() {
+  WakeUp();
+  mSleepEnabled = false;
+}
+
+void dtkPhysMassSpring::BuildSleepLayout() {
+  // 拓扑改变后全部唤醒, 重新统计.
+  for (dtkID i = 0; i < mMassPoints.size(); i++) {
+    if (mStorage->mSleeping[i])
+      mStorage->Wake(i);
+  }
+  mStorage->mWakePending = 0;
+
+  size_t numberOfRegions =
+      (mMassPoints.size() + mSleepRegionSize - 1) / mSleepRegionSize;
+  mRegionSleeping.assign(numberOfRegions, 0);
+  mRegionRestless.assign(numberOfRegions, 0);
+  mRegionCalmFrames.assign(numberOfRegions, 0);
+  mNumberOfSleepingRegions = 0;
+
+  // 跨区域的弹簧决定区域的邻接, 活动区域会唤醒相邻的休眠区域.
+  const vector<dtkID> &ends = mSpringStorage->mEnds;
+  vector<dtkID2> pairs;
+  for (dtkID i = 0; i < ends.size(); i += 2) {
+    dtkID a = ends[i] / mSleepRegionSize;
+    dtkID b = ends[i + 1] / mSleepRegionSize;
+    if (a != b) {
+      pairs.push_back(dtkID2(a, b));
+      pairs.push_back(dtkID2(b, a));
+    }
+  }
+  sort(pairs.begin(), pairs.end());
+  pairs.erase(unique(pairs.begin(), pairs.end()), pairs.end());
+  mRegionOffsets.assign(numberOfRegions + 1, 0);
+  mRegionNeighbors.resize(pairs.size());
+  for (dtkID i = 0; i < pairs.size(); i++) {
+    mRegionOffsets[pairs[i].a + 1]++;
+    mRegionNeighbors[i] = pairs[i].b;
+  }
+  for (dtkID r = 0; r < numberOfRegions; r++)
+    mRegionOffsets[r + 1] += mRegionOffsets[r];
+
+  mAwakeRunsDirty = true;
+  mSleepLayoutDirty = false;
+}
+
+void dtkPhysMassSpring::BuildAwakeRuns() {
+  mAwakePointRuns.clear();
+  mAwakeSpringRuns.clear();
+  for (dtkID i = 0; i < mMassPoints.size(); i++) {
+    if (mStorage->mSleeping[i])
+      continue;
+    if (!mAwakePointRuns.empty() && mAwakePointRuns.back() == i) {
+      mAwakePointRuns.back() = i + 1;
+    } else {
+      mAwakePointRuns.push_back(i);
+      mAwakePointRuns.push_back(i + 1);
+    }
+  }
+  const vector<dtkID> &ends = mSpringStorage->mEnds;
+  for (dtkID i = 0; i < mSprings.size(); i++) {
+    if (mStorage->mSleeping[ends[i * 2]] &&
+        mStorage->mSleeping[ends[i * 2 + 1]])
+      continue;
+    if (!mAwakeSpringRuns.empty() && mAwakeSpringRuns.back() == i) {
+      mAwakeSpringRuns.back() = i + 1;
+    } else {
+      mAwakeSpringRuns.push_back(i);
+      mAwakeSpringRuns.push_back(i + 1);
+    }
+  }
+  mAwakeRunsDirty = false;
+}
+
+void dtkPhysMassSpring::SleepRegion(dtkID region) {
+  dtkID end = dtkID(min(mMassPoints.size(), (region + 1) * mSleepRegionSize));
+  for (dtkID i = region * mSleepRegionSize; i < end; i++)
+    mStorage->Sleep(i);
+  mRegionSleeping[region] = 1;
+  mNumberOfSleepingRegions++;
+  mAwakeRunsDirty = true;
+  mStageSleeping = true;
+}
+
+void dtkPhysMassSpring::WakeRegion(dtkID region) {
+  dtkID end = dtkID(min(mMassPoints.size(), (region + 1) * mSleepRegionSize));
+  for (dtkID i = region * mSleepRegionSize; i < end; i++)
+    mStorage->Wake(i);
+  mRegionSleeping[region] = 0;
+  mRegionCalmFrames[region] = 0;
+  mNumberOfSleepingRegions--;
+  mAwakeRunsDirty = true;
+}
+
+void dtkPhysMassSpring::WakeDisturbed() {
+  if (!mSleepEnabled)
+    return;
+  if (mSleepLayoutDirty)
+    BuildSleepLayout();
+  if (!mStorage->mWakePending)
+    return;
+  mStorage->mWakePending = 0;
+  for (dtkID r = 0; r < mRegionSleeping.size(); r++) {
+    if (!mRegionSleeping[r])
+      continue;
+    dtkID end = dtkID(min(mMassPoints.size(), (r + 1) * mSleepRegionSize));
+    for (dtkID i = r * mSleepRegionSize; i < end; i++) {
+      if (mStorage->mWake[i]) {
+        WakeRegion(r);
+        break;
+      }
+    }
+  }
+}
+
+void dtkPhysMassSpring::WakeUp() {
+  for (dtkID r = 0; r < mRegionSleeping.size(); r++) {
+    if (mRegionSleeping[r])
+      WakeRegion(r);
+  }
+  mStorage->mWakePending = 0;
+}
+
+void dtkPhysMassSpring::UpdateSleeping() {
+  if (!mSleepEnabled)
+    return;
+  if (mSleepLayoutDirty)
+    BuildSleepLayout();
+
+  // 区域内单位质量的动能: sum(m v^2) / 2 sum(m).
+  const dtkPhysMassPointStorage &points = *mStorage;
+  for (dtkID r = 0; r < mRegionSleeping.size(); r++) {
+    mRegionRestless[r] = 0;
+    if (mRegionSleeping[r])
+      continue;
+    dtkID end = dtkID(min(mMassPoints.size(), (r + 1) * mSleepRegionSize));
+    double energy = 0, mass = 0;
+    for (dtkID i = r * mSleepRegionSize; i < end; i++) {
+      energy += points.mMass[i] * dot(points.mVel[i], points.mVel[i]);
+      mass += points.mMass[i];
+    }
+    if (energy <= 2.0 * mSleepThreshold * mass) {
+      mRegionCalmFrames[r]++;
+    } else {
+      mRegionCalmFrames[r] = 0;
+      mRegionRestless[r] = 1;
+    }
+  }
+
+  // 活动的区域唤醒相邻区域与 twins.
+  for (dtkID r = 0; r < mRegionSleeping.size(); r++) {
+    if (!mRegionRestless[r])
+      continue;
+    for (dtkID j = mRegionOffsets[r]; j < mRegionOffsets[r + 1]; j++) {
+      dtkID neighbor = mRegionNeighbors[j];
+      if (mRegionSleeping[neighbor])
+        WakeRegion(neighbor);
+      mRegionCalmFrames[neighbor] = 0;
+    }
+    dtkID end = dtkID(min(mMassPoints.size(), (r + 1) * mSleepRegionSize));
+    for (dtkID i = r * mSleepRegionSize; i < end; i++) {
+      if (!mMassPoints[i]->HasTwin())
+        continue;
+      const vector<dtkPhysMassPoint *> &twins =
+          mMassPoints[i]->GetTwinCluster()->GetMembers();
+      for (dtkID t = 0; t < twins.size(); t++)
+        twins[t]->GetStorage()->Disturb(twins[t]->GetIndex());
+    }
+  }
+
+  for (dtkID r = 0; r < mRegionSleeping.size(); r++) {
+    if (!mRegionSleeping[r] && mRegionCalmFrames[r] >= mSleepFrames)
+      SleepRegion(r);
+  }
+}
+
+void dtkPhysMassSpring::BeginSubsteps() {
+  // 起点是上一宏步结束时的位置, 目标是外部移动后的当前位置.
+  const dtkPhysMassPointStorage &points = *mStorage;
+  mBoundaryPoints.clear();
+  mBoundaryStarts.clear();
+  mBoundaryTargets.clear();
+  for (dtkID i = 0; i < mMassPoints.size(); i++) {
+    if (points.mActive[i] || points.mSleeping[i])
+      continue;
+    mBoundaryPoints.push_back(i);
+    mBoundaryStarts.push_back(points.mPosLastFrame[i]);
+    mBoundaryTargets.push_back(points.LoadPosition(i));
+  }
+}
+
+void dtkPhysMassSpring::InterpolateBoundary(dtkID substep) {
+  double t = double(substep) / double(mSubsteps);
+  for (dtkID j = 0; j < mBoundaryPoints.size(); j++) {
+    mStorage->StorePosition(
+        mBoundaryPoints[j],
+        mBoundaryStarts[j] + (mBoundaryTargets[j] - mBoundaryStarts[j]) * t);
+  }
+}
+
 bool dtkPhysMassSpring::ApplyImpulse(double timeslice) {
   for (dtkID i = 0; i < mMassPoints.size(); i++)
     mMassPoints[i]->ApplyImpulse();
@@ -784,38 +1509,58 @@ void dtkPhysMassSpring::UseMultiThread(const char *fileName) {
 #endif
 
 size_t dtkPhysMassSpring::FindTwins(Ptr ms, double distance) {
-  size_t count = 0;
+  // 与逐对比较的结果相同: 按本对象质点顺序, 各自取距离小于 distance 的
+  // 最近的尚无 twin 的质点, 距离相等时取下标小的.
+  if (!(distance > 0))
+    return 0;
 
-  for (dtkID i = 0; i < this->GetNumberOfMassPoints(); i++) {
-    dtkPhysMassPoint *point1 = this->GetMassPoint(i);
-    if (point1->HasTwin())
+  TwinSearch search;
+  search.other = ms.get();
+  search.distance = distance;
+  // 格子略大于搜索距离, 抵消除法的舍入, 距离内的点只会落在相邻格子.
+  search.cellSize = distance * 1.000001;
+  if (!std::isfinite(search.cellSize))
+    search.cellSize = dtkDoubleMax;
+  search.positions.resize(GetNumberOfMassPoints());
+  for (dtkID i = 0; i < GetNumberOfMassPoints(); i++)
+    search.positions[i] = GetMassPoint(i)->GetPosition();
+  search.candidates.resize(ms->GetNumberOfMassPoints());
+  for (dtkID j = 0; j < ms->GetNumberOfMassPoints(); j++) {
+    dtkPhysMassPoint *point2 = ms->GetMassPoint(j);
+    search.candidates[j] = point2->GetPosition();
+    if (point2->HasTwin())
       continue;
+    TwinCell cell = {
+        twin_cell_coord(search.candidates[j].x, search.cellSize),
+        twin_cell_coord(search.candidates[j].y, search.cellSize),
+        twin_cell_coord(search.candidates[j].z, search.cellSize), j};
+    search.cells.push_back(cell);
+  }
+  sort(search.cells.begin(), search.cells.end());
+
+  // 查询互不相关, 可以并行; 结果只是候选, 匹配在下面按顺序进行.
+  size_t numberOfPoints = search.positions.size();
+  search.nearest.assign(numberOfPoints, dtkErrorID);
+  boost::function<void(dtkID, dtkID)> query =
+      boost::bind(&query_twins, &search, _1, _2);
+  if (mScheduler && numberOfPoints > mGrainSize)
+    ForkJoinRange(numberOfPoints, query);
+  else
+    query(0, dtkID(numberOfPoints));
 
-    double minDistance = dtkDoubleMax;
-    dtkT3<double> pos1 = point1->GetPosition();
-
-    dtkPhysMassPoint *point2;
-    dtkT3<double> pos2;
-    dtkID minDistanceID = 0;
-
-    for (dtkID j = 0; j < ms->GetNumberOfMassPoints(); j++) {
-      point2 = ms->GetMassPoint(j);
-      if (point2->HasTwin())
-        continue;
-      double tempDistance;
-      pos2 = point2->GetPosition();
-      tempDistance = length(pos1 - pos2);
-
-      if (tempDistance < minDistance) {
-        minDistance = tempDistance;
-        minDistanceID = j;
-      }
-    }
-    if (minDistance < distance) {
-      point1->AddTwin(ms->GetMassPoint(minDistanceID));
-      ms->GetMassPoint(minDistanceID)->AddTwin(point1);
-      count++;
-    }
+  size_t count = 0;
+  for (dtkID i = 0; i < numberOfPoints; i++) {
+    dtkPhysMassPoint *point1 = GetMassPoint(i);
+    if (point1->HasTwin() || search.nearest[i] == dtkErrorID)
+      continue;
+    // 最近的候选已被前面的质点占用时, 在剩余质点中重新查找.
+    dtkID j = search.nearest[i];
+    if (ms->GetMassPoint(j)->HasTwin())
+      j = nearest_twin(search, search.positions[i], true);
+    if (j == dtkErrorID)
+      continue;
+    point1->AddTwin(ms->GetMassPoint(j));
+    count++;
   }
 
   return count;
@@ -842,7 +1587,8 @@ void dtkPhysMassSpring::TransportForce(double timeslice) {
   }
   for (dtkID i = 0; i < this->GetNumberOfMassPoints(); i++) {
     dtkPhysMassPoint *point = this->GetMassPoint(i);
-    if (!point->IsActive()) {
+    // 休眠质点的合外力不再清空, 不参与统计.
+    if (!point->IsActive() && !point->IsSleeping()) {
       dtkID label = point->GetLabel();
       if (label != 0) {
         mTransportForces[label] =
@@ -885,7 +1631,7 @@ void dtkPhysMassSpring::SetTriangleMesh(
 }
 
 dtkPhysSpring *dtkPhysMassSpring::GetSpringByPoints(dtkID2 edge) {
-  map<dtkID2, dtkPhysSpring *>::iterator it;
+  unordered_map<dtkID2, dtkPhysSpring *, dtkID2Hash>::iterator it;
   it = mEdgeMap.find(edge);
   if (it != mEdgeMap.end())
     return it->second;
@@ -894,16 +1640,61 @@ dtkPhysSpring *dtkPhysMassSpring::GetSpringByPoints(dtkID2 edge) {
 }
 
 void dtkPhysMassSpring::DeleteSpring(dtkID id1, dtkID id2) {
-  if (id1 > id2)
-    swap(id1, id2);
-  dtkPhysSpring *spring = mEdgeMap[dtkID2(id1, id2)];
-  for (dtkID i = 0; i < mSprings.size(); i++) {
-    if (mSprings[i] == spring) {
-      mSprings.erase(mSprings.begin() + i);
-      break;
-    }
-  }
+  dtkPhysSpring *spring = GetSpringByPoints(sort(id1, id2));
+  if (spring != 0)
+    RemoveSpring(spring);
+}
+
+void dtkPhysMassSpring::DeleteSpring(dtkPhysSpring *spring) {
+  dtkAssert(spring != NULL, NULL_POINTER);
+  RemoveSpring(spring);
+}
+
+void dtkPhysMassSpring::RemoveSpring(dtkPhysSpring *spring) {
+  dtkID index = spring->GetIndex();
+  const vector<dtkID> &ends = mSpringStorage->mEnds;
+  mEdgeMap.erase(dtkID2(ends[index * 2], ends[index * 2 + 1]));
+
+  // 最后一根弹簧补到空位, 与存储中的交换删除保持一致.
+  mSprings[index] = mSprings.back();
+  mSprings[index]->SetIndex(index);
+  mSprings.pop_back();
+  mSpringStorage->RemoveSpring(index);
   delete spring;
+
+  mForceLayoutDirty = true;
+  mImplicitLayoutDirty = true;
+  mPositionLayoutDirty = true;
+  mSleepLayoutDirty = true;
+}
+
+size_t dtkPhysMassSpring::ApplyEdits(const EditBatch &edits) {
+  for (dtkID i = 0; i < edits.spring_stiffness.size(); i++) {
+    dtkPhysSpring *spring =
+        GetSpringByPoints(sort(edits.spring_stiffness[i].first));
+    if (spring != 0)
+      spring->SetStiffness(edits.spring_stiffness[i].second);
+  }
+  for (dtkID i = 0; i < edits.spring_damp.size(); i++) {
+    dtkPhysSpring *spring = GetSpringByPoints(sort(edits.spring_damp[i].first));
+    if (spring != 0)
+      spring->SetDamp(edits.spring_damp[i].second);
+  }
+  for (dtkID i = 0; i < edits.point_mass.size(); i++) {
+    if (edits.point_mass[i].first < mMassPoints.size())
+      mMassPoints[edits.point_mass[i].first]->SetMass(
+          edits.point_mass[i].second);
+  }
+
+  size_t deleted = 0;
+  for (dtkID i = 0; i < edits.delete_springs.size(); i++) {
+    dtkPhysSpring *spring = GetSpringByPoints(sort(edits.delete_springs[i]));
+    if (spring == 0)
+      continue;
+    RemoveSpring(spring);
+    deleted++;
+  }
+  return deleted;
 }
 
 void dtkPhysMassSpring::AbandonTwins() {
@@ -911,4 +1702,29 @@ void dtkPhysMassSpring::AbandonTwins() {
     mMassPoints[i]->AbandonTwins();
   }
 }
+
+void dtkPhysMassSpring::BuildTwinClusters() {
+  mTwinClusters.clear();
+  for (dtkID i = 0; i < mMassPoints.size(); i++) {
+    dtkPhysTwinCluster *cluster = mMassPoints[i]->GetTwinCluster();
+    if (cluster && cluster->GetNumberOfMembers() > 1 &&
+        cluster->GetMembers()[0] == mMassPoints[i])
+      mTwinClusters.push_back(cluster);
+  }
+  mTwinGeneration = dtkPhysTwinCluster::GetGeneration();
+}
+
+void dtkPhysMassSpring::ResolveTwinForces() {
+  if (mTwinGeneration != dtkPhysTwinCluster::GetGeneration())
+    BuildTwinClusters();
+  for (dtkID i = 0; i < mTwinClusters.size(); i++)
+    mTwinClusters[i]->ResolveForces();
+}
+
+void dtkPhysMassSpring::ResolveTwinImpulses() {
+  if (mTwinGeneration != dtkPhysTwinCluster::GetGeneration())
+    BuildTwinClusters();
+  for (dtkID i = 0; i < mTwinClusters.size(); i++)
+    mTwinClusters[i]->ResolveImpulses();
+}
 } // namespace dtk
@@ -27,15 +27,13 @@ dtkPhysMassSpringCollisionResponse::~dtkPhysMassSpringCollisionResponse() {}
 // the function compute the mass points get impluse after collision.
 void dtkPhysMassSpringCollisionResponse::Update(
     double timeslice,
-    vector<dtkIntersectTest::IntersectResult::Ptr> &intersectResults,
+    dtkIntersectTest::IntersectResultView intersectResults,
     const std::vector<dtkInterval<int>> &avoid_1,
     const std::vector<dtkInterval<int>> &avoid_2, double stiffness) {
   for (dtkID i = 0; i < intersectResults.size(); i++) {
-    dtkIntersectTest::IntersectResult::Ptr result = intersectResults[i];
-    dtkCollisionDetectPrimitive *pri_1;
-    dtkCollisionDetectPrimitive *pri_2;
-    result->GetProperty(dtkIntersectTest::INTERSECT_PRIMITIVE_1, pri_1);
-    result->GetProperty(dtkIntersectTest::INTERSECT_PRIMITIVE_2, pri_2);
+    const dtkIntersectTest::IntersectResult &result = intersectResults[i];
+    dtkCollisionDetectPrimitive *pri_1 = result.primitive_1;
+    dtkCollisionDetectPrimitive *pri_2 = result.primitive_2;
 
     // eliminate some primitive pair that need to avoid collision responsing.
     bool needAvoid = false;
@@ -81,14 +79,9 @@ void dtkPhysMassSpringCollisionResponse::Update(
 
     switch (responseType) {
     case SEGMENT_SEGMENT: {
-      dtkDouble2 uv1;
-      result->GetProperty(dtkIntersectTest::INTERSECT_WEIGHT_1, uv1);
-
-      dtkDouble2 uv2;
-      result->GetProperty(dtkIntersectTest::INTERSECT_WEIGHT_2, uv2);
-
-      GK::Vector3 normal;
-      result->GetProperty(dtkIntersectTest::INTERSECT_NORMAL, normal);
+      const dtkDouble3 &uv1 = result.weight_1;
+      const dtkDouble3 &uv2 = result.weight_2;
+      GK::Vector3 normal = result.normal;
 
       // get four mass point of two segs.
       dtkPhysMassPoint *massPoint11 =
@@ -101,10 +94,10 @@ void dtkPhysMassSpringCollisionResponse::Update(
           mMassSprings[pri_2->mMajorID]->GetMassPoint(pri_2->mDetailIDs[1]);
 
       // try
-      dtkDouble3 oriPos11 = massPoint11->GetPosBuffer()[0];
-      dtkDouble3 oriPos12 = massPoint12->GetPosBuffer()[0];
-      dtkDouble3 oriPos21 = massPoint21->GetPosBuffer()[0];
-      dtkDouble3 oriPos22 = massPoint22->GetPosBuffer()[0];
+      dtkDouble3 oriPos11 = massPoint11->GetPosBuffer(0);
+      dtkDouble3 oriPos12 = massPoint12->GetPosBuffer(0);
+      dtkDouble3 oriPos21 = massPoint21->GetPosBuffer(0);
+      dtkDouble3 oriPos22 = massPoint22->GetPosBuffer(0);
 
       // compute vertical distance of two segments.
       double penetrate1 =
@@ -222,14 +215,9 @@ void dtkPhysMassSpringCollisionResponse::Update(
       break;
     }
     case TRIANGLE_SEGMENT: {
-      GK::Vector3 normal;
-      result->GetProperty(dtkIntersectTest::INTERSECT_NORMAL, normal);
-
-      dtkDouble3 uvw1;
-      result->GetProperty(dtkIntersectTest::INTERSECT_WEIGHT_1, uvw1);
-
-      dtkDouble2 uv2;
-      result->GetProperty(dtkIntersectTest::INTERSECT_WEIGHT_2, uv2);
+      const GK::Vector3 &normal = result.normal;
+      const dtkDouble3 &uvw1 = result.weight_1;
+      const dtkDouble3 &uv2 = result.weight_2;
 
       bool isPiercing = false;
       for (dtkID pierceID = 0; pierceID < mPierceSegments.size(); pierceID++) {
@@ -395,14 +383,9 @@ void dtkPhysMassSpringCollisionResponse::Update(
       break;
     }
     case TRIANGLE_TRIANGLE: {
-      GK::Vector3 normal;
-      result->GetProperty(dtkIntersectTest::INTERSECT_NORMAL, normal);
-
-      dtkDouble3 uvw1;
-      result->GetProperty(dtkIntersectTest::INTERSECT_WEIGHT_1, uvw1);
-
-      dtkDouble3 uvw2;
-      result->GetProperty(dtkIntersectTest::INTERSECT_WEIGHT_2, uvw2);
+      const GK::Vector3 &normal = result.normal;
+      const dtkDouble3 &uvw1 = result.weight_1;
+      const dtkDouble3 &uvw2 = result.weight_2;
 
       dtkPhysMassPoint *massPoint11 =
           mMassSprings[pri_1->mMajorID]->GetMassPoint(pri_1->mDetailIDs[0]);
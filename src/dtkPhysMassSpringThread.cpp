@@ -67,7 +67,7 @@ dtkPhysMassSpringThread::dtkPhysMassSpringThread(
 dtkPhysMassSpringThread::~dtkPhysMassSpringThread() {}
 
 void dtkPhysMassSpringThread::constructThreadMesh() {
-  dtkPoints::Ptr mPointsPtr = dtkPointsVector::New();
+  dtkPoints::Ptr mPointsPtr = dtkPointsAligned::New();
   // compute the height of triangle
   double tempRadius = tan(60.0 / 180.0 * dtkPI) * mInterval / 2.0;
   dtkT3<double> oriX;
@@ -34,12 +34,9 @@ dtkPhysMassSpringThreadCollisionResponse::
 pair<dtkDouble3, dtkDouble3>
 dtkPhysMassSpringThreadCollisionResponse::GetVirtualPair(dtkID threadID,
                                                          dtkID id) {
-  PiercedResult::Ptr result = mPiercedResults[threadID][id];
-  dtkCollisionDetectPrimitive *pri_1;
-  dtkCollisionDetectPrimitive *pri_2;
-
-  result->GetProperty(PIERCED_PRIMITIVE_1, pri_1);
-  result->GetProperty(PIERCED_PRIMITIVE_2, pri_2);
+  const PiercedResult &result = mPiercedResults[threadID][id];
+  dtkCollisionDetectPrimitive *pri_1 = result.primitive_1;
+  dtkCollisionDetectPrimitive *pri_2 = result.primitive_2;
 
   dtkPhysMassSpring::Ptr targetMS =
       mPriorResponse->GetMassSpring(pri_1->mMajorID);
@@ -50,8 +47,7 @@ dtkPhysMassSpringThreadCollisionResponse::GetVirtualPair(dtkID threadID,
   dtkPhysMassPoint *massPoint12 = targetMS->GetMassPoint(pri_1->mDetailIDs[1]);
   dtkPhysMassPoint *massPoint13 = targetMS->GetMassPoint(pri_1->mDetailIDs[2]);
 
-  int segmentID;
-  result->GetProperty(PIERCED_SEGMENTID, segmentID);
+  int segmentID = result.segment_id;
 
   dtkPhysMassPoint *massPoint21 = threadMS->GetMassPoint(segmentID * 2);
   dtkPhysMassPoint *massPoint22 = threadMS->GetMassPoint(segmentID * 2 + 2);
@@ -62,11 +58,8 @@ dtkPhysMassSpringThreadCollisionResponse::GetVirtualPair(dtkID threadID,
   dtkDouble3 p21 = massPoint21->GetPosition();
   dtkDouble3 p22 = massPoint22->GetPosition();
 
-  dtkDouble3 uvw;
-  result->GetProperty(PIERCED_WEIGHT_1, uvw);
-
-  dtkDouble2 uv;
-  result->GetProperty(PIERCED_WEIGHT_2, uv);
+  const dtkDouble3 &uvw = result.weight_1;
+  const dtkDouble2 &uv = result.weight_2;
 
   dtkDouble3 pointOnTriangle = p11 * uvw[0] + p12 * uvw[1] + p13 * uvw[2];
   dtkDouble3 pointOnSegment = p21 * uv[0] + p22 * uv[1];
@@ -75,30 +68,21 @@ dtkPhysMassSpringThreadCollisionResponse::GetVirtualPair(dtkID threadID,
 
 void dtkPhysMassSpringThreadCollisionResponse::Update(
     double timeslice,
-    vector<dtkIntersectTest::IntersectResult::Ptr> &internalPiercingResults) {
-  std::vector<dtkIntersectTest::IntersectResult::Ptr> &surfacePiercingResults =
+    dtkIntersectTest::IntersectResultView internalPiercingResults) {
+  std::vector<dtkIntersectTest::IntersectResult> &surfacePiercingResults =
       mPriorResponse->GetPiercingResults();
 
   for (dtkID i = 0; i < surfacePiercingResults.size(); i++) {
     cout << "try surface piercing results" << endl;
 
-    dtkIntersectTest::IntersectResult::Ptr result = surfacePiercingResults[i];
-    dtkCollisionDetectPrimitive *pri_1;
-    dtkCollisionDetectPrimitive *pri_2;
-
-    result->GetProperty(dtkIntersectTest::INTERSECT_PRIMITIVE_1, pri_1);
-    result->GetProperty(dtkIntersectTest::INTERSECT_PRIMITIVE_2, pri_2);
-
-    PiercedResult::Ptr newResult = PiercedResult::New();
-
-    newResult->SetProperty(PIERCED_PRIMITIVE_1, pri_1);
-    newResult->SetProperty(PIERCED_PRIMITIVE_2, pri_2);
+    const dtkIntersectTest::IntersectResult &result = surfacePiercingResults[i];
+    dtkCollisionDetectPrimitive *pri_1 = result.primitive_1;
+    dtkCollisionDetectPrimitive *pri_2 = result.primitive_2;
 
     bool already_pierced = false;
     for (dtkID j = 0; j < mPiercedResults[pri_2->mMajorID].size(); j++) {
-      dtkCollisionDetectPrimitive *f_pri_1;
-      mPiercedResults[pri_2->mMajorID][j]->GetProperty(PIERCED_PRIMITIVE_1,
-                                                       f_pri_1);
+      dtkCollisionDetectPrimitive *f_pri_1 =
+          mPiercedResults[pri_2->mMajorID][j].primitive_1;
 
       if (f_pri_1->mMinorID == pri_1->mMinorID) {
         already_pierced = true;
@@ -110,23 +94,14 @@ void dtkPhysMassSpringThreadCollisionResponse::Update(
 
     cout << "add surface piercing results" << endl;
 
-    dtkDouble3 uvw1;
-    result->GetProperty(dtkIntersectTest::INTERSECT_WEIGHT_1, uvw1);
-    newResult->SetProperty(PIERCED_WEIGHT_1, uvw1);
-
-    dtkDouble2 uv2;
-    uv2[0] = 1;
-    uv2[1] = 0;
-    newResult->SetProperty(PIERCED_WEIGHT_2, uv2);
-
-    int segmentID = 0;
-    newResult->SetProperty(PIERCED_SEGMENTID, segmentID);
-
-    bool valid = true;
-    newResult->SetProperty(PIERCED_VALID, valid);
-
-    bool surface = true;
-    newResult->SetProperty(PIERCED_SURFACE, surface);
+    PiercedResult newResult;
+    newResult.primitive_1 = pri_1;
+    newResult.primitive_2 = pri_2;
+    newResult.weight_1 = result.weight_1;
+    newResult.weight_2 = dtkDouble2(1, 0);
+    newResult.segment_id = 0;
+    newResult.valid = true;
+    newResult.surface = true;
 
     // mAvoidIntervals[pri_2->mMajorID].push_back( dtkInterval<int> ( -1, -1 )
     // );
@@ -142,18 +117,15 @@ void dtkPhysMassSpringThreadCollisionResponse::Update(
   surfacePiercingResults.clear();
 
   for (dtkID i = 0; i < internalPiercingResults.size(); i++) {
-    dtkIntersectTest::IntersectResult::Ptr result = internalPiercingResults[i];
-    dtkCollisionDetectPrimitive *pri_1;
-    dtkCollisionDetectPrimitive *pri_2;
-
-    result->GetProperty(dtkIntersectTest::INTERSECT_PRIMITIVE_1, pri_1);
-    result->GetProperty(dtkIntersectTest::INTERSECT_PRIMITIVE_2, pri_2);
+    const dtkIntersectTest::IntersectResult &result =
+        internalPiercingResults[i];
+    dtkCollisionDetectPrimitive *pri_1 = result.primitive_1;
+    dtkCollisionDetectPrimitive *pri_2 = result.primitive_2;
 
     bool already_pierced = false;
     for (dtkID j = 0; j < mPiercedResults[pri_2->mMajorID].size(); j++) {
-      dtkCollisionDetectPrimitive *f_pri_1;
-      mPiercedResults[pri_2->mMajorID][j]->GetProperty(PIERCED_PRIMITIVE_1,
-                                                       f_pri_1);
+      dtkCollisionDetectPrimitive *f_pri_1 =
+          mPiercedResults[pri_2->mMajorID][j].primitive_1;
 
       if (f_pri_1->mMinorID == pri_1->mMinorID) {
         already_pierced = true;
@@ -165,22 +137,11 @@ void dtkPhysMassSpringThreadCollisionResponse::Update(
 
     // cout<<"add internal piercing results"<<endl;
 
-    PiercedResult::Ptr newResult = PiercedResult::New();
-
-    newResult->SetProperty(PIERCED_PRIMITIVE_1, pri_1);
-    newResult->SetProperty(PIERCED_PRIMITIVE_2, pri_2);
-
-    GK::Object object;
-    result->GetProperty(dtkIntersectTest::INTERSECT_OBJECT, object);
-
-    dtkDouble3 p4;
-    if (const GK::Point3 *ipoint = CGAL::object_cast<GK::Point3>(&object)) {
-      p4 = dtkDouble3(ipoint->x(), ipoint->y(), ipoint->z());
-    } else if (const GK::Segment3 *isegment =
-                   CGAL::object_cast<GK::Segment3>(&object)) {
+    // 线段落在三角形内时没有单个交点, 跳过.
+    if (!result.has_point)
       continue;
-    } else
-      assert(false);
+    const GK::Point3 &ipoint = result.point;
+    dtkDouble3 p4(ipoint.x(), ipoint.y(), ipoint.z());
 
     dtkPhysMassSpring::Ptr targetMS =
         mPriorResponse->GetMassSpring(pri_1->mMajorID);
@@ -195,51 +156,35 @@ void dtkPhysMassSpringThreadCollisionResponse::Update(
     dtkDouble3 p2 = massPoint12->GetPosition();
     dtkDouble3 p3 = massPoint13->GetPosition();
 
-    dtkDouble3 uvw1 = barycentricWeight(p4, p1, p2, p3);
-
-    newResult->SetProperty(PIERCED_WEIGHT_1, uvw1);
-
-    dtkDouble2 uv2;
-    uv2[0] = 1;
-    uv2[1] = 0;
-    newResult->SetProperty(PIERCED_WEIGHT_2, uv2);
-
-    int segmentID = 0;
-    newResult->SetProperty(PIERCED_SEGMENTID, segmentID);
-
-    bool valid = true;
-    newResult->SetProperty(PIERCED_VALID, valid);
-
-    bool surface = false;
-    newResult->SetProperty(PIERCED_SURFACE, surface);
+    PiercedResult newResult;
+    newResult.primitive_1 = pri_1;
+    newResult.primitive_2 = pri_2;
+    newResult.weight_1 = barycentricWeight(p4, p1, p2, p3);
+    newResult.weight_2 = dtkDouble2(1, 0);
+    newResult.segment_id = 0;
+    newResult.valid = true;
+    newResult.surface = false;
 
     // mInternalPiercingTriangleIDs[pri_2->mMajorID] = pri_1->mMinorID;
 
     mPiercedResults[pri_2->mMajorID].push_back(newResult);
   }
 
-  for (std::map<dtkID, std::vector<PiercedResult::Ptr>>::iterator itr =
+  for (std::map<dtkID, std::vector<PiercedResult>>::iterator itr =
            mPiercedResults.begin();
        itr != mPiercedResults.end(); itr++) {
     dtkID threadID = itr->first;
 
     for (dtkID i = 0; i < mPiercedResults[threadID].size(); i++) {
-      PiercedResult::Ptr result = mPiercedResults[threadID][i];
+      PiercedResult &result = mPiercedResults[threadID][i];
 
-      bool valid;
-      result->GetProperty(PIERCED_VALID, valid);
-
-      if (!valid)
+      if (!result.valid)
         continue;
 
-      dtkCollisionDetectPrimitive *pri_1;
-      dtkCollisionDetectPrimitive *pri_2;
-
-      result->GetProperty(PIERCED_PRIMITIVE_1, pri_1);
-      result->GetProperty(PIERCED_PRIMITIVE_2, pri_2);
+      dtkCollisionDetectPrimitive *pri_1 = result.primitive_1;
+      dtkCollisionDetectPrimitive *pri_2 = result.primitive_2;
 
-      dtkDouble3 uvw1;
-      result->GetProperty(PIERCED_WEIGHT_1, uvw1);
+      const dtkDouble3 &uvw1 = result.weight_1;
 
       dtkPhysMassSpring::Ptr targetMS =
           mPriorResponse->GetMassSpring(pri_1->mMajorID);
@@ -253,8 +198,7 @@ void dtkPhysMassSpringThreadCollisionResponse::Update(
       dtkPhysMassPoint *massPoint13 =
           targetMS->GetMassPoint(pri_1->mDetailIDs[2]);
 
-      int segmentID;
-      result->GetProperty(PIERCED_SEGMENTID, segmentID);
+      int segmentID = result.segment_id;
       dtkPhysMassPoint *massPoint21 = threadMS->GetMassPoint(segmentID * 2);
       dtkPhysMassPoint *massPoint22 = threadMS->GetMassPoint(segmentID * 2 + 2);
 
@@ -264,8 +208,7 @@ void dtkPhysMassSpringThreadCollisionResponse::Update(
       dtkDouble3 p21 = massPoint21->GetPosition();
       dtkDouble3 p22 = massPoint22->GetPosition();
 
-      dtkDouble2 uv;
-      result->GetProperty(PIERCED_WEIGHT_2, uv);
+      dtkDouble2 &uv = result.weight_2;
       dtkDouble3 pointOnSegment = p21 * uv[0] + p22 * uv[1];
       dtkDouble3 pointOnTriangle =
           p11 * uvw1[0] + p12 * uvw1[1] + p13 * uvw1[2];
@@ -287,12 +230,12 @@ void dtkPhysMassSpringThreadCollisionResponse::Update(
               (int)mThreads[pri_2->mMajorID]->GetNumberOfSegments() ||
           segmentID < 0) {
         // cout<<"set PIERCED_VALID false"<<endl;
-        result->SetProperty(PIERCED_VALID, false);
+        result.valid = false;
         continue;
       }
 
       dtkDouble3 impulse;
-      result->SetProperty(PIERCED_SEGMENTID, segmentID);
+      result.segment_id = segmentID;
 
       impulse = impulseVec * (200000 * timeslice * 5.0);
       massPoint11->AddForce(impulse * (-uvw1[0] / massPoint11->GetMass()));
@@ -304,21 +247,15 @@ void dtkPhysMassSpringThreadCollisionResponse::Update(
 
       uv[1] = pointOnSegmentID - (int)pointOnSegmentID;
       uv[0] = 1.0 - uv[1];
-
-      result->SetProperty(PIERCED_WEIGHT_2, uv);
     }
 
     int numOfPiercedResults = mPiercedResults[threadID].size();
     // delete
     for (int i = mPiercedResults[threadID].size() - 1; i >= 0; i--) {
-      PiercedResult::Ptr result = mPiercedResults[threadID][i];
-      bool valid;
-      result->GetProperty(PIERCED_VALID, valid);
-      if (!valid) {
+      const PiercedResult &result = mPiercedResults[threadID][i];
+      if (!result.valid) {
         cout << "delete pierced result: " << i << endl;
-        bool surface;
-        result->GetProperty(PIERCED_SURFACE, surface);
-        if (surface) {
+        if (result.surface) {
           mNumerOfSurfacePiercedResults[threadID] =
               mNumerOfSurfacePiercedResults[threadID] - 1;
         }
@@ -328,12 +265,9 @@ void dtkPhysMassSpringThreadCollisionResponse::Update(
 
     mAvoidIntervals[threadID].clear();
     for (dtkID i = 0; i < mPiercedResults[threadID].size(); i++) {
-      PiercedResult::Ptr result = mPiercedResults[threadID][i];
-      bool surface;
-      result->GetProperty(PIERCED_SURFACE, surface);
-      if (surface) {
-        int segmentID;
-        result->GetProperty(PIERCED_SEGMENTID, segmentID);
+      const PiercedResult &result = mPiercedResults[threadID][i];
+      if (result.surface) {
+        int segmentID = result.segment_id;
         // cout<<"avoid intervals: "<<segmentID - 2<<" "<<segmentID + 2<<endl;
         mAvoidIntervals[threadID].push_back(
             dtkInterval<int>(segmentID - 2, segmentID + 2));
@@ -381,28 +315,21 @@ void dtkPhysMassSpringThreadCollisionResponse::Update(
 }
 
 void dtkPhysMassSpringThreadCollisionResponse::PostProcess(double range) {
-  for (std::map<dtkID, std::vector<PiercedResult::Ptr>>::iterator itr =
+  for (std::map<dtkID, std::vector<PiercedResult>>::iterator itr =
            mPiercedResults.begin();
        itr != mPiercedResults.end(); itr++) {
     dtkID threadID = itr->first;
 
     for (dtkID i = 0; i < mPiercedResults[threadID].size(); i++) {
-      PiercedResult::Ptr result = mPiercedResults[threadID][i];
+      const PiercedResult &result = mPiercedResults[threadID][i];
 
-      bool valid;
-      result->GetProperty(PIERCED_VALID, valid);
-
-      if (!valid)
+      if (!result.valid)
         continue;
 
-      dtkCollisionDetectPrimitive *pri_1;
-      dtkCollisionDetectPrimitive *pri_2;
-
-      result->GetProperty(PIERCED_PRIMITIVE_1, pri_1);
-      result->GetProperty(PIERCED_PRIMITIVE_2, pri_2);
+      dtkCollisionDetectPrimitive *pri_1 = result.primitive_1;
+      dtkCollisionDetectPrimitive *pri_2 = result.primitive_2;
 
-      dtkDouble3 uvw;
-      result->GetProperty(PIERCED_WEIGHT_1, uvw);
+      const dtkDouble3 &uvw = result.weight_1;
 
       dtkPhysMassSpring::Ptr targetMS =
           mPriorResponse->GetMassSpring(pri_1->mMajorID);
@@ -416,8 +343,7 @@ void dtkPhysMassSpringThreadCollisionResponse::PostProcess(double range) {
       dtkPhysMassPoint *massPoint13 =
           targetMS->GetMassPoint(pri_1->mDetailIDs[2]);
 
-      int segmentID;
-      result->GetProperty(PIERCED_SEGMENTID, segmentID);
+      int segmentID = result.segment_id;
       dtkPhysMassPoint *massPoint21 = threadMS->GetMassPoint(segmentID * 2);
       dtkPhysMassPoint *massPoint2_mid =
           threadMS->GetMassPoint(segmentID * 2 + 1);
@@ -430,8 +356,7 @@ void dtkPhysMassSpringThreadCollisionResponse::PostProcess(double range) {
       dtkDouble3 p22 = massPoint22->GetPosition();
       dtkDouble3 p2_mid = massPoint2_mid->GetPosition();
 
-      dtkDouble2 uv;
-      result->GetProperty(PIERCED_WEIGHT_2, uv);
+      const dtkDouble2 &uv = result.weight_2;
       dtkDouble3 pointOnSegment = p21 * uv[0] + p22 * uv[1];
       dtkDouble3 pointOnTriangle = p11 * uvw[0] + p12 * uvw[1] + p13 * uvw[2];
 
@@ -0,0 +1,274 @@
+
+/**
+ * @file dtkPhysPositionSolver.cpp
+ * @brief dtkPhysPositionSolver 实现
+ * @author agent (agent@local)
+ * @version 1.0
+ * @date 2026-10-16
+ * @copyright MIT LICENSE
+ * https://github.com/Simple-XX/SimplePhysicsEngine
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-16<td>agent<td>创建文件
+ * </table>
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include <boost/bind/bind.hpp>
+
+#include "dtkPhysPositionSolver.h"
+
+using namespace std;
+using namespace boost::placeholders;
+
+namespace dtk {
+
+dtkPhysPositionSolver::dtkPhysPositionSolver() {
+  mPoints = 0;
+  mSprings = 0;
+  mTimeslice = 0;
+  mScheduler = 0;
+  mGrainSize = 1024;
+  mSolveMode = ColoredSolve;
+  mIterations = 10;
+  mVolumeCompliance = 0;
+  mRelaxation = 1.0;
+}
+
+void dtkPhysPositionSolver::ClearVolumes() {
+  mVolumeIDs.clear();
+  mVolumeRest.clear();
+}
+
+void dtkPhysPositionSolver::AddVolume(const dtkID4 &ids, double restVolume) {
+  for (dtkID k = 0; k < 4; k++)
+    mVolumeIDs.push_back(ids[k]);
+  mVolumeRest.push_back(restVolume);
+}
+
+void dtkPhysPositionSolver::BuildStructure(
+    size_t numberOfPoints, const dtkPhysSpringStorage &springs) {
+  // 约束端点: 先是每根弹簧的两个端点, 再是每个体积约束的四个质点.
+  mSlotPoints = springs.mEnds;
+  mSlotPoints.insert(mSlotPoints.end(), mVolumeIDs.begin(), mVolumeIDs.end());
+  size_t numberOfSprings = springs.GetNumberOfSprings();
+  size_t numberOfConstraints = numberOfSprings + mVolumeRest.size();
+  mSlotOffsets.resize(numberOfConstraints + 1);
+  for (dtkID c = 0; c <= numberOfConstraints; c++)
+    mSlotOffsets[c] = c <= numberOfSprings
+                          ? c * 2
+                          : numberOfSprings * 2 + (c - numberOfSprings) * 4;
+
+  // 质点到约束端点的压缩表, Jacobi 归约时按端点顺序累加.
+  mPointOffsets.assign(numberOfPoints + 1, 0);
+  for (dtkID i = 0; i < mSlotPoints.size(); i++)
+    mPointOffsets[mSlotPoints[i] + 1]++;
+  for (dtkID i = 0; i < numberOfPoints; i++)
+    mPointOffsets[i + 1] += mPointOffsets[i];
+  mPointSlots.resize(mSlotPoints.size());
+  vector<dtkID> cursor(mPointOffsets.begin(), mPointOffsets.end() - 1);
+  for (dtkID i = 0; i < mSlotPoints.size(); i++)
+    mPointSlots[cursor[mSlotPoints[i]]++] = i;
+
+  // 贪心着色: 按约束顺序取所有端点都未使用的最小颜色.
+  mColors.clear();
+  vector<vector<dtkID>> pointColors(numberOfPoints);
+  for (dtkID c = 0; c < numberOfConstraints; c++) {
+    dtkID color = 0;
+    for (dtkID s = mSlotOffsets[c]; s < mSlotOffsets[c + 1]; s++) {
+      const vector<dtkID> &colors = pointColors[mSlotPoints[s]];
+      if (find(colors.begin(), colors.end(), color) != colors.end()) {
+        // 颜色已被某个端点使用, 换下一种颜色后重新检查全部端点.
+        color++;
+        s = mSlotOffsets[c] - 1;
+      }
+    }
+    if (color == mColors.size())
+      mColors.push_back(vector<dtkID>());
+    mColors[color].push_back(c);
+    for (dtkID s = mSlotOffsets[c]; s < mSlotOffsets[c + 1]; s++)
+      pointColors[mSlotPoints[s]].push_back(color);
+  }
+
+  mX.resize(numberOfPoints);
+  mX0.resize(numberOfPoints);
+  mInvMass.resize(numberOfPoints);
+  mLambda.resize(numberOfConstraints);
+  mDeltas.resize(mSlotPoints.size() * 3);
+}
+
+void dtkPhysPositionSolver::Solve(dtkPhysMassPointStorage &points,
+                                  const dtkPhysSpringStorage &springs,
+                                  double timeslice,
+                                  dtkTaskScheduler *scheduler,
+                                  size_t grainSize) {
+  mPoints = &points;
+  mSprings = &springs;
+  mTimeslice = timeslice;
+  mScheduler = scheduler;
+  mGrainSize = max(grainSize, size_t(1));
+
+  ForEachRange(mX.size(),
+               boost::bind(&dtkPhysPositionSolver::_Predict, this, _1, _2));
+  fill(mLambda.begin(), mLambda.end(), 0.0);
+
+  for (dtkID it = 0; it < mIterations; it++) {
+    if (mSolveMode == JacobiSolve) {
+      ForEachRange(mLambda.size(),
+                   boost::bind(&dtkPhysPositionSolver::_SolveJacobi, this, _1,
+                               _2));
+      ForEachRange(mX.size(), boost::bind(&dtkPhysPositionSolver::_GatherJacobi,
+                                          this, _1, _2));
+    } else {
+      for (dtkID i = 0; i < mColors.size(); i++)
+        ForEachRange(mColors[i].size(),
+                     boost::bind(&dtkPhysPositionSolver::_SolveColor, this,
+                                 &mColors[i], _1, _2));
+    }
+  }
+
+  ForEachRange(mX.size(),
+               boost::bind(&dtkPhysPositionSolver::_Finish, this, _1, _2));
+  mPoints = 0;
+  mSprings = 0;
+  mScheduler = 0;
+}
+
+template <typename Function>
+void dtkPhysPositionSolver::ForEachRange(size_t count, const Function &body) {
+  if (!mScheduler || count <= mGrainSize) {
+    body(0, dtkID(count));
+    return;
+  }
+  mScheduler->ForkJoinRange(count, mGrainSize, body);
+}
+
+void dtkPhysPositionSolver::Project(dtkID constraint, double *deltas) {
+  const double h2 = mTimeslice * mTimeslice;
+  size_t numberOfSprings = mSprings->GetNumberOfSprings();
+  dtkID first = mSlotOffsets[constraint];
+  dtkID count = mSlotOffsets[constraint + 1] - first;
+  const dtkID *ids = &mSlotPoints[first];
+
+  // 约束值与各端点的梯度.
+  double value, compliance;
+  dtkT3<double> grads[4];
+  if (constraint < numberOfSprings) {
+    double stiffness = mSprings->mStiffness[constraint];
+    if (!(stiffness > 0))
+      return;
+    double oriLength = mSprings->mOriLength[constraint];
+    dtkT3<double> vec = mX[ids[1]] - mX[ids[0]];
+    double curLength = length(vec);
+    if (!(curLength > 0))
+      return;
+    grads[1] = vec / curLength;
+    grads[0] = -grads[1];
+    value = curLength - oriLength;
+    compliance = oriLength / stiffness;
+  } else {
+    dtkT3<double> e1 = mX[ids[1]] - mX[ids[0]];
+    dtkT3<double> e2 = mX[ids[2]] - mX[ids[0]];
+    dtkT3<double> e3 = mX[ids[3]] - mX[ids[0]];
+    grads[1] = cross(e2, e3) / 6.0;
+    grads[2] = cross(e3, e1) / 6.0;
+    grads[3] = cross(e1, e2) / 6.0;
+    grads[0] = -(grads[1] + grads[2] + grads[3]);
+    value = dot(e1, grads[1]) - mVolumeRest[constraint - numberOfSprings];
+    compliance = mVolumeCompliance;
+  }
+
+  double alpha = compliance / h2;
+  double denominator = alpha;
+  for (dtkID k = 0; k < count; k++)
+    denominator += mInvMass[ids[k]] * dot(grads[k], grads[k]);
+  if (!(denominator > 0))
+    return;
+  double delta = (-value - alpha * mLambda[constraint]) / denominator;
+  mLambda[constraint] += delta;
+
+  for (dtkID k = 0; k < count; k++) {
+    dtkT3<double> move = grads[k] * (mInvMass[ids[k]] * delta);
+    if (deltas) {
+      for (dtkID d = 0; d < 3; d++)
+        deltas[k * 3 + d] = move[d];
+    } else {
+      mX[ids[k]] = mX[ids[k]] + move;
+    }
+  }
+}
+
+void dtkPhysPositionSolver::_Predict(dtkID begin, dtkID end) {
+  const double h = mTimeslice;
+  for (dtkID i = begin; i < end; i++) {
+    mX0[i] = mPoints->LoadPosition(i);
+    // 休眠质点按固定质点投影, 但不写回状态.
+    if (!mPoints->mActive[i] || mPoints->mSleeping[i]) {
+      mInvMass[i] = 0;
+      mX[i] = mX0[i];
+      continue;
+    }
+    mInvMass[i] = 1.0 / mPoints->mMass[i];
+    dtkT3<double> force = mPoints->mForceAccum[i] +
+                          mPoints->mForceDecorator[i] + mPoints->mGravity[i];
+    dtkT3<double> vel = mPoints->mVel[i] + force * (h * mInvMass[i]);
+    mX[i] = mX0[i] + vel * h;
+  }
+}
+
+void dtkPhysPositionSolver::_SolveColor(const vector<dtkID> *color,
+                                        dtkID begin, dtkID end) {
+  for (dtkID i = begin; i < end; i++)
+    Project((*color)[i], 0);
+}
+
+void dtkPhysPositionSolver::_SolveJacobi(dtkID begin, dtkID end) {
+  for (dtkID c = begin; c < end; c++) {
+    double *deltas = &mDeltas[mSlotOffsets[c] * 3];
+    fill(deltas, &mDeltas[mSlotOffsets[c + 1] * 3], 0.0);
+    Project(c, deltas);
+  }
+}
+
+void dtkPhysPositionSolver::_GatherJacobi(dtkID begin, dtkID end) {
+  for (dtkID i = begin; i < end; i++) {
+    dtkID count = mPointOffsets[i + 1] - mPointOffsets[i];
+    if (count == 0)
+      continue;
+    dtkT3<double> move(0, 0, 0);
+    for (dtkID j = mPointOffsets[i]; j < mPointOffsets[i + 1]; j++) {
+      const double *delta = &mDeltas[mPointSlots[j] * 3];
+      move = move + dtkT3<double>(delta[0], delta[1], delta[2]);
+    }
+    mX[i] = mX[i] + move * (mRelaxation / count);
+  }
+}
+
+void dtkPhysPositionSolver::_Finish(dtkID begin, dtkID end) {
+  const double h = mTimeslice;
+  const dtkT3<double> zero(0, 0, 0);
+  for (dtkID i = begin; i < end; i++) {
+    dtkPhysMassPointStorage &points = *mPoints;
+    if (points.mSleeping[i])
+      continue;
+    points.mForceAccum[i] = zero;
+    if (!points.mActive[i]) {
+      // 与欧拉法相同, 固定点的速度由外部移动得到.
+      points.mAccel[i] = zero;
+      points.mVel[i] = (mX0[i] - points.mPosLastFrame[i]) / h;
+      points.mPosLastFrame[i] = mX0[i];
+      points.mImpulse[i] = zero;
+      points.mImpulseNum[i] = 0;
+      continue;
+    }
+    dtkT3<double> vel = (mX[i] - mX0[i]) / h;
+    points.mAccel[i] = (vel - points.mVel[i]) / h;
+    points.mVel[i] = vel;
+    points.mPosLastFrame[i] = mX0[i];
+    points.StorePosition(i, mX[i]);
+  }
+}
+} // namespace dtk
@@ -0,0 +1,70 @@
+
+/**
+ * @file dtkPhysSnapshot.cpp
+ * @brief dtkPhysSnapshot 实现
+ * @author agent (agent@local)
+ * @version 1.0
+ * @date 2026-10-16
+ * @copyright MIT LICENSE
+ * https://github.com/Simple-XX/SimplePhysicsEngine
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-16<td>agent<td>创建文件
+ * </table>
+ */
+
+#include "dtkPhysSnapshot.h"
+
+using namespace std;
+
+namespace dtk {
+const dtkPoints *dtkPhysSnapshot::GetPoints(dtkID id) const {
+  map<dtkID, Entry>::const_iterator itr = mPoints.find(id);
+  if (itr == mPoints.end())
+    return 0;
+  return itr->second.points.get();
+}
+
+const dtkPoints *dtkPhysSnapshot::GetThreadPoints(dtkID id) const {
+  map<dtkID, Entry>::const_iterator itr = mThreadPoints.find(id);
+  if (itr == mThreadPoints.end())
+    return 0;
+  return itr->second.points.get();
+}
+
+void dtkPhysSnapshot::BeginFrame(size_t frame) {
+  mFrame = frame;
+  for (map<dtkID, Entry>::iterator itr = mPoints.begin(); itr != mPoints.end();
+       itr++)
+    itr->second.used = false;
+  for (map<dtkID, Entry>::iterator itr = mThreadPoints.begin();
+       itr != mThreadPoints.end(); itr++)
+    itr->second.used = false;
+}
+
+dtkPointsVector *dtkPhysSnapshot::Acquire(dtkID id, bool thread, size_t size) {
+  Entry &entry = thread ? mThreadPoints[id] : mPoints[id];
+  if (!entry.points || entry.points->GetNumberOfPoints() != size)
+    entry.points = dtkPointsVector::New(size);
+  entry.used = true;
+  return entry.points.get();
+}
+
+void dtkPhysSnapshot::EndFrame() {
+  for (map<dtkID, Entry>::iterator itr = mPoints.begin();
+       itr != mPoints.end();) {
+    if (itr->second.used)
+      itr++;
+    else
+      mPoints.erase(itr++);
+  }
+  for (map<dtkID, Entry>::iterator itr = mThreadPoints.begin();
+       itr != mThreadPoints.end();) {
+    if (itr->second.used)
+      itr++;
+    else
+      mThreadPoints.erase(itr++);
+  }
+}
+} // namespace dtk
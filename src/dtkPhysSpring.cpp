@@ -23,25 +23,439 @@
 using namespace std;
 #endif // DTK_PHYSSPRINGIMPL_DEBUG
 
+#include <algorithm>
+#include <cmath>
+
+#if (defined(__GNUC__) || defined(__clang__)) &&                              \
+    (defined(__x86_64__) || defined(__i386__))
+#define DTK_PHYSSPRING_X86
+#include <immintrin.h>
+#endif
+
 #include "dtkPhysSpring.h"
 
 namespace dtk {
 
+namespace {
+// 弹簧力内核的参数, 端点下标成对存放
+template <typename Real> struct SpringBatch {
+  const dtkID *ends;
+  const Real *ori_length;
+  const Real *stiffness;
+  const Real *damp;
+  const Real *const *pos;
+  const Real *const *vel;
+  double timeslice;
+  Real *const *force;
+};
+
+// 按质点汇总的内核参数, 关联表与 dtkPhysMassSpring 的 DTK_CL 数据布局相同
+template <typename Real> struct GatherBatch {
+  const dtkID *offsets;
+  const dtkID *neighbors;
+  const dtkID *slots;
+  const Real *ori_length;
+  const Real *stiffness;
+  const Real *damp;
+  const Real *const *pos;
+  const Real *const *vel;
+  double timeslice;
+};
+
+// 存储值先提升为 double 再参与计算
+template <typename Real>
+void ScalarSpringForces(const SpringBatch<Real> &batch, dtkID begin,
+                        dtkID end) {
+  for (dtkID i = begin; i < end; i++) {
+    dtkID a = batch.ends[i * 2];
+    dtkID b = batch.ends[i * 2 + 1];
+    double vec[3], dv[3];
+    for (dtkID k = 0; k < 3; k++) {
+      vec[k] = double(batch.pos[k][b]) - double(batch.pos[k][a]);
+      dv[k] = double(batch.vel[k][b]) - double(batch.vel[k][a]);
+    }
+    double curLength =
+        std::sqrt(vec[0] * vec[0] + vec[1] * vec[1] + vec[2] * vec[2]);
+    double dir[3] = {vec[0] / curLength, vec[1] / curLength,
+                     vec[2] / curLength};
+    double oriLength = batch.ori_length[i];
+    double ratio = double(batch.stiffness[i]) / oriLength;
+    double damp = dv[0] * dir[0] + dv[1] * dir[1] + dv[2] * dir[2];
+    double scale = (oriLength - curLength) * ratio -
+                   damp * (batch.timeslice * ratio + double(batch.damp[i]));
+    for (dtkID k = 0; k < 3; k++)
+      batch.force[k][i] = Real(dir[k] * scale);
+  }
+}
+
+// 质点 i 的第 begin 到 end 个关联弹簧的力累加到 sum
+template <typename Real>
+inline void ScalarGatherRange(const GatherBatch<Real> &batch, dtkID i,
+                              dtkID begin, dtkID end, double sum[3]) {
+  for (dtkID j = begin; j < end; j++) {
+    dtkID n = batch.neighbors[j];
+    dtkID s = batch.slots[j] / 2;
+    double vec[3], dv[3];
+    for (dtkID k = 0; k < 3; k++) {
+      vec[k] = double(batch.pos[k][n]) - double(batch.pos[k][i]);
+      dv[k] = double(batch.vel[k][n]) - double(batch.vel[k][i]);
+    }
+    double curLength =
+        std::sqrt(vec[0] * vec[0] + vec[1] * vec[1] + vec[2] * vec[2]);
+    double dir[3] = {vec[0] / curLength, vec[1] / curLength,
+                     vec[2] / curLength};
+    double oriLength = batch.ori_length[s];
+    double ratio = double(batch.stiffness[s]) / oriLength;
+    double damp = dv[0] * dir[0] + dv[1] * dir[1] + dv[2] * dir[2];
+    double scale = (oriLength - curLength) * ratio -
+                   damp * (batch.timeslice * ratio + double(batch.damp[s]));
+    // 以质点 i 为第一个端点, 受力与 dir 反向.
+    for (dtkID k = 0; k < 3; k++)
+      sum[k] -= dir[k] * scale;
+  }
+}
+
+template <typename Real>
+void ScalarGatherForces(const GatherBatch<Real> &batch, dtkID begin,
+                        dtkID end, double *const force[3]) {
+  for (dtkID i = begin; i < end; i++) {
+    double sum[3] = {0, 0, 0};
+    ScalarGatherRange(batch, i, batch.offsets[i], batch.offsets[i + 1], sum);
+    for (dtkID k = 0; k < 3; k++)
+      force[k][i - begin] = sum[k];
+  }
+}
+
+#ifdef DTK_PHYSSPRING_X86
+// 按存储类型读写 4 个元素, float 在寄存器中提升为 double
+__attribute__((target("avx2"))) inline __m256d Load4(const double *p) {
+  return _mm256_loadu_pd(p);
+}
+
+__attribute__((target("avx2"))) inline __m256d Load4(const float *p) {
+  return _mm256_cvtps_pd(_mm_loadu_ps(p));
+}
+
+__attribute__((target("avx2"))) inline __m256d Gather4(const double *p,
+                                                       __m128i index) {
+  return _mm256_i32gather_pd(p, index, 8);
+}
+
+__attribute__((target("avx2"))) inline __m256d Gather4(const float *p,
+                                                       __m128i index) {
+  return _mm256_cvtps_pd(_mm_i32gather_ps(p, index, 4));
+}
+
+__attribute__((target("avx2"))) inline void Store4(double *p, __m256d v) {
+  _mm256_storeu_pd(p, v);
+}
+
+__attribute__((target("avx2"))) inline void Store4(float *p, __m256d v) {
+  _mm_storeu_ps(p, _mm256_cvtpd_ps(v));
+}
+
+// 按存储类型读写 8 个元素
+__attribute__((target("avx512f"))) inline __m512d Load8(const double *p) {
+  return _mm512_loadu_pd(p);
+}
+
+__attribute__((target("avx512f"))) inline __m512d Load8(const float *p) {
+  return _mm512_cvtps_pd(_mm256_loadu_ps(p));
+}
+
+__attribute__((target("avx512f"))) inline __m512d Gather8(const double *p,
+                                                          __m256i index) {
+  return _mm512_i32gather_pd(index, p, 8);
+}
+
+__attribute__((target("avx512f"))) inline __m512d Gather8(const float *p,
+                                                          __m256i index) {
+  return _mm512_cvtps_pd(_mm256_i32gather_ps(p, index, 4));
+}
+
+__attribute__((target("avx512f"))) inline void Store8(double *p, __m512d v) {
+  _mm512_storeu_pd(p, v);
+}
+
+__attribute__((target("avx512f"))) inline void Store8(float *p, __m512d v) {
+  _mm256_storeu_ps(p, _mm512_cvtpd_ps(v));
+}
+
+template <typename Real>
+__attribute__((target("avx2"))) void
+AVX2SpringForces(const SpringBatch<Real> &batch, dtkID begin, dtkID end) {
+  // 8 个端点下标 a0 b0 a1 b1 ... 重排为 a0..a3 b0..b3
+  const __m256i order = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+  const __m256d timeslice = _mm256_set1_pd(batch.timeslice);
+  dtkID i = begin;
+  for (; i + 4 <= end; i += 4) {
+    __m256i ends = _mm256_permutevar8x32_epi32(
+        _mm256_loadu_si256((const __m256i *)(batch.ends + i * 2)), order);
+    __m128i a = _mm256_castsi256_si128(ends);
+    __m128i b = _mm256_extracti128_si256(ends, 1);
+
+    __m256d vec[3], dv[3];
+    for (dtkID k = 0; k < 3; k++) {
+      vec[k] =
+          _mm256_sub_pd(Gather4(batch.pos[k], b), Gather4(batch.pos[k], a));
+      dv[k] = _mm256_sub_pd(Gather4(batch.vel[k], b), Gather4(batch.vel[k], a));
+    }
+    __m256d curLength = _mm256_sqrt_pd(_mm256_add_pd(
+        _mm256_add_pd(_mm256_mul_pd(vec[0], vec[0]),
+                      _mm256_mul_pd(vec[1], vec[1])),
+        _mm256_mul_pd(vec[2], vec[2])));
+    __m256d damp = _mm256_setzero_pd();
+    for (dtkID k = 0; k < 3; k++) {
+      vec[k] = _mm256_div_pd(vec[k], curLength);
+      damp = _mm256_add_pd(damp, _mm256_mul_pd(dv[k], vec[k]));
+    }
+    __m256d oriLength = Load4(batch.ori_length + i);
+    __m256d ratio = _mm256_div_pd(Load4(batch.stiffness + i), oriLength);
+    __m256d scale = _mm256_sub_pd(
+        _mm256_mul_pd(_mm256_sub_pd(oriLength, curLength), ratio),
+        _mm256_mul_pd(damp, _mm256_add_pd(_mm256_mul_pd(timeslice, ratio),
+                                          Load4(batch.damp + i))));
+    for (dtkID k = 0; k < 3; k++)
+      Store4(batch.force[k] + i, _mm256_mul_pd(vec[k], scale));
+  }
+  ScalarSpringForces(batch, i, end);
+}
+
+template <typename Real>
+__attribute__((target("avx512f"))) void
+AVX512SpringForces(const SpringBatch<Real> &batch, dtkID begin, dtkID end) {
+  // 16 个端点下标 a0 b0 a1 b1 ... 重排为 a0..a7 b0..b7
+  const __m512i order = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5,
+                                          7, 9, 11, 13, 15);
+  const __m512d timeslice = _mm512_set1_pd(batch.timeslice);
+  dtkID i = begin;
+  for (; i + 8 <= end; i += 8) {
+    __m512i ends = _mm512_permutexvar_epi32(
+        order, _mm512_loadu_si512((const void *)(batch.ends + i * 2)));
+    __m256i a = _mm512_castsi512_si256(ends);
+    __m256i b = _mm512_extracti64x4_epi64(ends, 1);
+
+    __m512d vec[3], dv[3];
+    for (dtkID k = 0; k < 3; k++) {
+      vec[k] =
+          _mm512_sub_pd(Gather8(batch.pos[k], b), Gather8(batch.pos[k], a));
+      dv[k] = _mm512_sub_pd(Gather8(batch.vel[k], b), Gather8(batch.vel[k], a));
+    }
+    __m512d curLength = _mm512_sqrt_pd(_mm512_add_pd(
+        _mm512_add_pd(_mm512_mul_pd(vec[0], vec[0]),
+                      _mm512_mul_pd(vec[1], vec[1])),
+        _mm512_mul_pd(vec[2], vec[2])));
+    __m512d damp = _mm512_setzero_pd();
+    for (dtkID k = 0; k < 3; k++) {
+      vec[k] = _mm512_div_pd(vec[k], curLength);
+      damp = _mm512_add_pd(damp, _mm512_mul_pd(dv[k], vec[k]));
+    }
+    __m512d oriLength = Load8(batch.ori_length + i);
+    __m512d ratio = _mm512_div_pd(Load8(batch.stiffness + i), oriLength);
+    __m512d scale = _mm512_sub_pd(
+        _mm512_mul_pd(_mm512_sub_pd(oriLength, curLength), ratio),
+        _mm512_mul_pd(damp, _mm512_add_pd(_mm512_mul_pd(timeslice, ratio),
+                                          Load8(batch.damp + i))));
+    for (dtkID k = 0; k < 3; k++)
+      Store8(batch.force[k] + i, _mm512_mul_pd(vec[k], scale));
+  }
+  AVX2SpringForces(batch, i, end);
+}
+
+template <typename Real>
+__attribute__((target("avx2"))) void
+AVX2GatherForces(const GatherBatch<Real> &batch, dtkID begin, dtkID end,
+                 double *const force[3]) {
+  const __m256d timeslice = _mm256_set1_pd(batch.timeslice);
+  for (dtkID i = begin; i < end; i++) {
+    __m256d pos[3], vel[3], acc[3];
+    for (dtkID k = 0; k < 3; k++) {
+      pos[k] = _mm256_set1_pd(batch.pos[k][i]);
+      vel[k] = _mm256_set1_pd(batch.vel[k][i]);
+      acc[k] = _mm256_setzero_pd();
+    }
+    dtkID j = batch.offsets[i];
+    for (; j + 4 <= batch.offsets[i + 1]; j += 4) {
+      __m128i n = _mm_loadu_si128((const __m128i *)(batch.neighbors + j));
+      __m128i s = _mm_srli_epi32(
+          _mm_loadu_si128((const __m128i *)(batch.slots + j)), 1);
+
+      __m256d vec[3], dv[3];
+      for (dtkID k = 0; k < 3; k++) {
+        vec[k] = _mm256_sub_pd(Gather4(batch.pos[k], n), pos[k]);
+        dv[k] = _mm256_sub_pd(Gather4(batch.vel[k], n), vel[k]);
+      }
+      __m256d curLength = _mm256_sqrt_pd(_mm256_add_pd(
+          _mm256_add_pd(_mm256_mul_pd(vec[0], vec[0]),
+                        _mm256_mul_pd(vec[1], vec[1])),
+          _mm256_mul_pd(vec[2], vec[2])));
+      __m256d damp = _mm256_setzero_pd();
+      for (dtkID k = 0; k < 3; k++) {
+        vec[k] = _mm256_div_pd(vec[k], curLength);
+        damp = _mm256_add_pd(damp, _mm256_mul_pd(dv[k], vec[k]));
+      }
+      __m256d oriLength = Gather4(batch.ori_length, s);
+      __m256d ratio = _mm256_div_pd(Gather4(batch.stiffness, s), oriLength);
+      __m256d scale = _mm256_sub_pd(
+          _mm256_mul_pd(_mm256_sub_pd(oriLength, curLength), ratio),
+          _mm256_mul_pd(damp, _mm256_add_pd(_mm256_mul_pd(timeslice, ratio),
+                                            Gather4(batch.damp, s))));
+      for (dtkID k = 0; k < 3; k++)
+        acc[k] = _mm256_sub_pd(acc[k], _mm256_mul_pd(vec[k], scale));
+    }
+
+    double sum[3];
+    for (dtkID k = 0; k < 3; k++) {
+      double lanes[4];
+      _mm256_storeu_pd(lanes, acc[k]);
+      sum[k] = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+    ScalarGatherRange(batch, i, j, batch.offsets[i + 1], sum);
+    for (dtkID k = 0; k < 3; k++)
+      force[k][i - begin] = sum[k];
+  }
+}
+#endif // DTK_PHYSSPRING_X86
+
+dtkPhysSpringKernel::SpringKernel &CurrentSpringKernel() {
+  static dtkPhysSpringKernel::SpringKernel kernel =
+      dtkPhysSpringKernel::GetSupportedSpringKernel();
+  return kernel;
+}
+} // namespace
+
+template <typename Precision>
+dtkID dtkPhysSpringStorageT<Precision>::AddSpring(dtkID first, dtkID second,
+                                                  double oriLength,
+                                                  double stiff, double damp) {
+  mEnds.push_back(first);
+  mEnds.push_back(second);
+  mOriLength.push_back(Real(oriLength));
+  mStiffness.push_back(Real(stiff));
+  mDamp.push_back(Real(damp));
+  return mOriLength.size() - 1;
+}
+
+template <typename Precision>
+void dtkPhysSpringStorageT<Precision>::RemoveSpring(dtkID index) {
+  dtkID last = dtkID(GetNumberOfSprings() - 1);
+  mEnds[index * 2] = mEnds[last * 2];
+  mEnds[index * 2 + 1] = mEnds[last * 2 + 1];
+  mOriLength[index] = mOriLength[last];
+  mStiffness[index] = mStiffness[last];
+  mDamp[index] = mDamp[last];
+  mEnds.resize(last * 2);
+  mOriLength.pop_back();
+  mStiffness.pop_back();
+  mDamp.pop_back();
+}
+
+template <typename Precision>
+void dtkPhysSpringStorageT<Precision>::ComputeForces(
+    dtkID begin, dtkID end, const Real *const pos[3], const Real *const vel[3],
+    double timeslice, Real *const force[3]) const {
+  if (begin >= end)
+    return;
+  SpringBatch<Real> batch = {mEnds.data(), mOriLength.data(), mStiffness.data(),
+                             mDamp.data(), pos,               vel,
+                             timeslice,    force};
+  switch (CurrentSpringKernel()) {
+#ifdef DTK_PHYSSPRING_X86
+  case AVX512Kernel:
+    AVX512SpringForces(batch, begin, end);
+    break;
+  case AVX2Kernel:
+    AVX2SpringForces(batch, begin, end);
+    break;
+#endif
+  default:
+    ScalarSpringForces(batch, begin, end);
+  }
+}
+
+template <typename Precision>
+void dtkPhysSpringStorageT<Precision>::GatherForces(
+    dtkID begin, dtkID end, const dtkID *offsets, const dtkID *neighbors,
+    const dtkID *slots, const Real *const pos[3], const Real *const vel[3],
+    double timeslice, double *const force[3]) const {
+  if (begin >= end)
+    return;
+  GatherBatch<Real> batch = {offsets,           neighbors,
+                             slots,             mOriLength.data(),
+                             mStiffness.data(), mDamp.data(),
+                             pos,               vel,
+                             timeslice};
+  switch (CurrentSpringKernel()) {
+#ifdef DTK_PHYSSPRING_X86
+  case AVX512Kernel:
+  case AVX2Kernel:
+    AVX2GatherForces(batch, begin, end, force);
+    break;
+#endif
+  default:
+    ScalarGatherForces(batch, begin, end, force);
+  }
+}
+
+template class dtkPhysSpringStorageT<dtkDoublePrecision>;
+template class dtkPhysSpringStorageT<dtkMixedPrecision>;
+
+dtkPhysSpringKernel::SpringKernel dtkPhysSpringKernel::GetSpringKernel() {
+  return CurrentSpringKernel();
+}
+
+dtkPhysSpringKernel::SpringKernel
+dtkPhysSpringKernel::SetSpringKernel(SpringKernel kernel) {
+  CurrentSpringKernel() = std::min(kernel, GetSupportedSpringKernel());
+  return CurrentSpringKernel();
+}
+
+dtkPhysSpringKernel::SpringKernel
+dtkPhysSpringKernel::GetSupportedSpringKernel() {
+#ifdef DTK_PHYSSPRING_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f"))
+    return AVX512Kernel;
+  if (__builtin_cpu_supports("avx2"))
+    return AVX2Kernel;
+#endif
+  return ScalarKernel;
+}
+
 dtkPhysSpring::dtkPhysSpring(dtkPhysMassPoint *p1, dtkPhysMassPoint *p2,
                              const double &stiff, const double &damp) {
   mVerteces[0] = p1;
   mVerteces[1] = p2;
 
-  mStiffness = stiff;
-  mDamp = damp;
   GK::Vector3 vec = mVerteces[1]->GetPoint() - mVerteces[0]->GetPoint();
-  mOriLength = length(dtkT3<double>(vec.x(), vec.y(), vec.z()));
+  mStorage = dtkPhysSpringStorage::New();
+  mIndex = mStorage->AddSpring(
+      p1->GetIndex(), p2->GetIndex(),
+      length(dtkT3<double>(vec.x(), vec.y(), vec.z())), stiff, damp);
+}
+
+dtkPhysSpring::dtkPhysSpring(dtkPhysSpringStorage::Ptr storage, dtkID index,
+                             dtkPhysMassPoint *p1, dtkPhysMassPoint *p2) {
+  mVerteces[0] = p1;
+  mVerteces[1] = p2;
+  mStorage = storage;
+  mIndex = index;
 }
 
 dtkPhysSpring::~dtkPhysSpring() {}
 
 bool dtkPhysSpring::Update(double timeslice, ItrMethod method, dtkID iteration,
                            bool limitDeformation) {
+  dtkT3<double> force =
+      ComputeForce(timeslice, method, iteration, limitDeformation);
+  mVerteces[0]->AddForce(force * (-1.0));
+  mVerteces[1]->AddForce(force);
+  return true;
+}
+
+dtkT3<double> dtkPhysSpring::ComputeForce(double timeslice, ItrMethod method,
+                                          dtkID iteration,
+                                          bool limitDeformation) {
   // 方向向量
   dtkT3<double> vec = mVerteces[1]->GetPosition(method, iteration) -
                       mVerteces[0]->GetPosition(method, iteration);
@@ -146,14 +560,13 @@ DTK_PHYSSPRINGIMPL_DEBUG
     }
     */
   }
+  double oriLength = GetOriLength();
+  double stiffness = GetStiffness();
   dtkT3<double> stiffForce =
-      dir * ((mOriLength - curLength) * mStiffness / mOriLength);
+      dir * ((oriLength - curLength) * stiffness / oriLength);
   dtkT3<double> dampForce =
-      -dir *
-      (dot((v1 - v0), dir) * (timeslice * mStiffness / mOriLength + mDamp));
-  dtkT3<double> force = stiffForce + dampForce;
-  mVerteces[0]->AddForce(force * (-1.0));
-  mVerteces[1]->AddForce(force);
-  return true;
+      -dir * (dot((v1 - v0), dir) *
+              (timeslice * stiffness / oriLength + GetDamp()));
+  return stiffForce + dampForce;
 }
 } // namespace dtk
@@ -61,6 +61,9 @@ dtkPhysTetraMassSpring::~dtkPhysTetraMassSpring() {
 
 bool dtkPhysTetraMassSpring::PreUpdate(double timeslice, ItrMethod method,
                                        dtkID iteration) {
+  // XPBD 用体积约束保持形状, 不再施加高度弹簧力.
+  if (method == XPBD)
+    return true;
   for (int i = 0; i < mTetraMesh->GetTetraNum(); i++) {
     dtkID4 tempTetra = mTetraMesh->GetTetraById(i);
     if (tempTetra[0] != dtkErrorID) {
@@ -241,6 +244,7 @@ bool dtkPhysTetraMassSpring::PreUpdate(double timeslice, ItrMethod method,
 void dtkPhysTetraMassSpring::SetTetraMesh(
     dtkStaticTetraMesh::Ptr newTetraMesh) {
   mTetraMesh = newTetraMesh;
+  mPositionLayoutDirty = true;
 
   dtkPoints::Ptr pts = mTetraMesh->GetPoints();
 
@@ -316,8 +320,30 @@ void dtkPhysTetraMassSpring::SetTetraMesh(
   }
 }
 
+void dtkPhysTetraMassSpring::CollectVolumes(dtkPhysPositionSolver &solver) {
+  solver.ClearVolumes();
+  for (int i = 0; i < mTetraMesh->GetTetraNum(); i++) {
+    dtkID4 tetra = mTetraMesh->GetTetraById(i);
+    if (tetra[0] == dtkErrorID)
+      continue;
+    dtkT3<double> ori_positions[4];
+    for (dtkID x = 0; x < 4; x++) {
+      const GK::Point3 &gk_oripoint = mOriPointsPtr->GetPoint(tetra[x]);
+      ori_positions[x] =
+          dtkT3<double>(gk_oripoint.x(), gk_oripoint.y(), gk_oripoint.z());
+    }
+    double restVolume =
+        dot(ori_positions[1] - ori_positions[0],
+            cross(ori_positions[2] - ori_positions[0],
+                  ori_positions[3] - ori_positions[0])) /
+        6.0;
+    solver.AddVolume(tetra, restVolume);
+  }
+}
+
 void dtkPhysTetraMassSpring::DeleteTetra(dtkID i) {
   dtkID4 tetra = mTetraMesh->GetECTable()[i];
+  mPositionLayoutDirty = true;
   mOriLengths.erase(mOriLengths.begin() + i);
   for (int x = 0; x < 4; x++) {
     for (int y = x + 1; y < 4; y++) {
@@ -337,6 +363,7 @@ void dtkPhysTetraMassSpring::AddTetra(dtkID i) {
   dtkID4 tetra = mTetraMesh->GetECTable()[i];
   dtkT3<double> ori_positions[4];
   // dtkPoints::Ptr meshPts = mTetraMesh->GetPoints();
+  mPositionLayoutDirty = true;
 
   // add springs into the tetra.
   for (int x = 0; x < 4; x++) {
@@ -388,6 +415,7 @@ void dtkPhysTetraMassSpring::AddTetra(dtkID i) {
 
 void dtkPhysTetraMassSpring::ReshapeTetra(dtkID i) {
   dtkID4 tetra = mTetraMesh->GetECTable()[i];
+  mPositionLayoutDirty = true;
   dtkT3<double> ori_positions[4];
   // dtkPoints::Ptr meshPts = mTetraMesh->GetPoints();
   for (int x = 0; x < 4; x++) {
@@ -0,0 +1,445 @@
+
+/**
+ * @file dtkTaskScheduler.cpp
+ * @brief dtkTaskScheduler 实现
+ * @author agent (agent@local)
+ * @version 1.0
+ * @date 2026-10-16
+ * @copyright MIT LICENSE
+ * https://github.com/Simple-XX/SimplePhysicsEngine
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-16<td>agent<td>创建文件
+ * </table>
+ */
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "dtkTaskScheduler.h"
+
+using namespace std;
+using namespace boost;
+using namespace boost::placeholders;
+
+namespace dtk {
+// 任务执行时间的滑动平均系数.
+static const double cost_smoothing = 0.2;
+
+// 就绪队列的初始容量. 队列的最大深度取决于窃取的时机, 预热时未必出现,
+// 预先留足容量, 避免稳态下偶尔扩容.
+static const size_t queue_capacity = 256;
+
+// 当前线程所属的调度器与工作线程id, 以及 Execute 的嵌套深度.
+static thread_local const dtkTaskScheduler *current_scheduler = 0;
+static thread_local dtkID current_worker = dtkErrorID;
+static thread_local size_t execute_depth = 0;
+
+// 解析形如 "0-7,16-23" 的处理器列表.
+static void parse_cpu_list(const string &list, vector<dtkID> &cpus) {
+  stringstream stream(list);
+  string range;
+  while (getline(stream, range, ',')) {
+    if (range.empty() || range[0] < '0' || range[0] > '9')
+      continue;
+    size_t dash = range.find('-');
+    dtkID first = dtkID(stoul(range.substr(0, dash)));
+    dtkID last =
+        dash == string::npos ? first : dtkID(stoul(range.substr(dash + 1)));
+    for (dtkID cpu = first; cpu <= last; cpu++)
+      cpus.push_back(cpu);
+  }
+}
+
+static void pin_worker(const vector<dtkID> *cpus, std::atomic<size_t> *pinned,
+                       dtkID worker) {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET((*cpus)[worker % cpus->size()], &set);
+  if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0)
+    (*pinned)++;
+#else
+  (void)cpus;
+  (void)pinned;
+  (void)worker;
+#endif
+}
+
+dtkTaskScheduler::dtkTaskScheduler(size_t numberOfThreads) {
+  mNumberOfThreads = numberOfThreads > 0 ? numberOfThreads : 1;
+  mRemaining = 0;
+  mWorkerFunction = 0;
+  mLive = true;
+  mFrame = 0;
+
+  for (dtkID i = 0; i < mNumberOfThreads; i++) {
+    mQueues.push_back(new WorkerQueue());
+    mQueues.back()->items.resize(queue_capacity);
+  }
+  mBusyTimes.resize(mNumberOfThreads, 0);
+
+  for (dtkID i = 0; i < mNumberOfThreads; i++)
+    mThreadGroup.add_thread(
+        new boost::thread(&dtkTaskScheduler::WorkerLoop, this, i));
+}
+
+dtkTaskScheduler::~dtkTaskScheduler() {
+  {
+    boost::unique_lock<boost::mutex> lock(mStateMutex);
+    mLive = false;
+  }
+  mWakeCondition.notify_all();
+  mThreadGroup.join_all();
+
+  ClearTasks();
+  for (dtkID i = 0; i < mQueues.size(); i++)
+    delete mQueues[i];
+}
+
+dtkID dtkTaskScheduler::AddTask(const TaskFunction &function, dtkID worker) {
+  Task *task = new Task();
+  task->function = function;
+  task->worker =
+      worker < mNumberOfThreads ? worker : mTasks.size() % mNumberOfThreads;
+  task->numberOfPredecessors = 0;
+  task->pending = 0;
+  task->cost = 0;
+  mTasks.push_back(task);
+  return mTasks.size() - 1;
+}
+
+void dtkTaskScheduler::AddDependency(dtkID before, dtkID after) {
+  assert(before < mTasks.size() && after < mTasks.size());
+  assert(before != after);
+  mTasks[before]->successors.push_back(after);
+  mTasks[after]->numberOfPredecessors++;
+}
+
+void dtkTaskScheduler::ClearTasks() {
+  for (dtkID i = 0; i < mTasks.size(); i++)
+    delete mTasks[i];
+  mTasks.clear();
+}
+
+void dtkTaskScheduler::Run() {
+  if (mTasks.empty())
+    return;
+
+  boost::unique_lock<boost::mutex> runLock(mRunMutex);
+
+  for (dtkID i = 0; i < mTasks.size(); i++)
+    mTasks[i]->pending = mTasks[i]->numberOfPredecessors;
+  mRemaining = mTasks.size();
+  for (dtkID i = 0; i < mNumberOfThreads; i++)
+    mBusyTimes[i] = 0;
+
+  for (dtkID i = 0; i < mTasks.size(); i++) {
+    if (mTasks[i]->numberOfPredecessors == 0) {
+      Item item = {i, 0, 0, 0, 0, 0, 0};
+      Push(mTasks[i]->worker, item);
+    }
+  }
+
+  {
+    boost::unique_lock<boost::mutex> lock(mStateMutex);
+    mFrame++;
+  }
+  mWakeCondition.notify_all();
+
+  boost::unique_lock<boost::mutex> lock(mStateMutex);
+  while (mRemaining > 0)
+    mDoneCondition.wait(lock);
+}
+
+void dtkTaskScheduler::ForkJoin(const vector<TaskFunction> &functions) {
+  ForkJoinItems(functions.size(), 1, 0, 0, functions.data());
+}
+
+void dtkTaskScheduler::ForkJoinItems(size_t count, size_t grainSize,
+                                     RangeInvoker invoker, const void *range,
+                                     const TaskFunction *functions) {
+  if (count == 0)
+    return;
+  grainSize = grainSize > 0 ? grainSize : 1;
+  size_t numberOfItems = (count + grainSize - 1) / grainSize;
+
+  if (!IsWorkerThread()) {
+    // 外部线程: 子任务计入 mRemaining, 像一次 Run 一样分发并等待.
+    boost::unique_lock<boost::mutex> runLock(mRunMutex);
+    mRemaining = numberOfItems;
+    for (dtkID i = 0; i < numberOfItems; i++)
+      Push(i % mNumberOfThreads, MakeItem(count, grainSize, invoker, range,
+                                          functions, i, &mRemaining));
+    {
+      boost::unique_lock<boost::mutex> lock(mStateMutex);
+      mFrame++;
+    }
+    mWakeCondition.notify_all();
+
+    boost::unique_lock<boost::mutex> lock(mStateMutex);
+    while (mRemaining > 0)
+      mDoneCondition.wait(lock);
+    return;
+  }
+
+  dtkID id = current_worker;
+  std::atomic<size_t> remaining(numberOfItems);
+  {
+    // 倒序放入, 自己从队尾先取到第一个子任务.
+    WorkerQueue *queue = mQueues[id];
+    boost::unique_lock<boost::mutex> lock(queue->mutex);
+    for (dtkID i = numberOfItems; i > 0; i--)
+      queue->PushBack(MakeItem(count, grainSize, invoker, range, functions,
+                               i - 1, &remaining));
+  }
+
+  while (remaining > 0) {
+    Item item;
+    if (Pop(id, item) || Steal(id, item))
+      Execute(id, item);
+    else
+      boost::this_thread::yield();
+  }
+}
+
+dtkTaskScheduler::Item
+dtkTaskScheduler::MakeItem(size_t count, size_t grainSize,
+                           RangeInvoker invoker, const void *range,
+                           const TaskFunction *functions, dtkID i,
+                           std::atomic<size_t> *remaining) const {
+  Item item = {dtkErrorID, 0, remaining, 0, 0, 0, 0};
+  if (functions != 0) {
+    item.function = &functions[i];
+    return item;
+  }
+  item.invoker = invoker;
+  item.range = range;
+  item.begin = dtkID(i * grainSize);
+  item.end = dtkID(count < item.begin + grainSize ? count
+                                                  : item.begin + grainSize);
+  return item;
+}
+
+void dtkTaskScheduler::RunOnEachWorker(const WorkerFunction &function) {
+  boost::unique_lock<boost::mutex> runLock(mRunMutex);
+  // 先发布函数再设置计数, 仍在上一次 Run 任务循环中的线程会退出循环.
+  mWorkerFunction = &function;
+  mRemaining = mNumberOfThreads;
+  {
+    boost::unique_lock<boost::mutex> lock(mStateMutex);
+    mFrame++;
+  }
+  mWakeCondition.notify_all();
+
+  boost::unique_lock<boost::mutex> lock(mStateMutex);
+  while (mRemaining > 0)
+    mDoneCondition.wait(lock);
+  mWorkerFunction = 0;
+}
+
+size_t dtkTaskScheduler::PinWorkers() {
+  vector<dtkID> cpus = GetProcessorOrder();
+  if (cpus.empty())
+    return 0;
+  std::atomic<size_t> pinned(0);
+  RunOnEachWorker(boost::bind(&pin_worker, &cpus, &pinned, _1));
+  return pinned;
+}
+
+vector<dtkID> dtkTaskScheduler::GetProcessorOrder() {
+  vector<dtkID> cpus;
+  for (dtkID node = 0;; node++) {
+    ifstream file("/sys/devices/system/node/node" + to_string(node) +
+                  "/cpulist");
+    if (!file)
+      break;
+    string list;
+    getline(file, list);
+    parse_cpu_list(list, cpus);
+  }
+  if (cpus.empty()) {
+    for (dtkID i = 0; i < boost::thread::hardware_concurrency(); i++)
+      cpus.push_back(i);
+  }
+  return cpus;
+}
+
+bool dtkTaskScheduler::IsWorkerThread() const {
+  return current_scheduler == this;
+}
+
+void dtkTaskScheduler::SetTaskWorker(dtkID task, dtkID worker) {
+  assert(task < mTasks.size());
+  if (worker < mNumberOfThreads)
+    mTasks[task]->worker = worker;
+}
+
+dtkID dtkTaskScheduler::GetTaskWorker(dtkID task) const {
+  assert(task < mTasks.size());
+  return mTasks[task]->worker;
+}
+
+double dtkTaskScheduler::GetTaskCost(dtkID task) const {
+  assert(task < mTasks.size());
+  return mTasks[task]->cost;
+}
+
+double dtkTaskScheduler::GetImbalanceRatio() const {
+  double sum = 0;
+  double max = 0;
+  for (dtkID i = 0; i < mNumberOfThreads; i++) {
+    sum += mBusyTimes[i];
+    if (mBusyTimes[i] > max)
+      max = mBusyTimes[i];
+  }
+  if (sum == 0)
+    return 1;
+  return max * mNumberOfThreads / sum;
+}
+
+void dtkTaskScheduler::WorkerLoop(dtkID id) {
+  current_scheduler = this;
+  current_worker = id;
+
+  size_t frame = 0;
+  do {
+    const WorkerFunction *function;
+    {
+      boost::unique_lock<boost::mutex> lock(mStateMutex);
+      while (mLive && mFrame == frame)
+        mWakeCondition.wait(lock);
+      if (!mLive)
+        break;
+      frame = mFrame;
+      function = mWorkerFunction;
+    }
+
+    if (function != 0) {
+      (*function)(id);
+      if (--mRemaining == 0) {
+        boost::unique_lock<boost::mutex> lock(mStateMutex);
+        mDoneCondition.notify_all();
+      }
+      continue;
+    }
+
+    // 依赖未满足时队列可能暂时为空, 让出时间片等待其它线程.
+    while (mRemaining > 0 && mWorkerFunction == 0) {
+      Item item;
+      if (Pop(id, item) || Steal(id, item))
+        Execute(id, item);
+      else
+        boost::this_thread::yield();
+    }
+  } while (true);
+}
+
+bool dtkTaskScheduler::Pop(dtkID id, Item &item) {
+  WorkerQueue *queue = mQueues[id];
+  boost::unique_lock<boost::mutex> lock(queue->mutex);
+  if (queue->size == 0)
+    return false;
+  item = queue->PopBack();
+  return true;
+}
+
+bool dtkTaskScheduler::Steal(dtkID id, Item &item) {
+  for (dtkID i = 1; i < mNumberOfThreads; i++) {
+    WorkerQueue *queue = mQueues[(id + i) % mNumberOfThreads];
+    boost::unique_lock<boost::mutex> lock(queue->mutex);
+    if (queue->size == 0)
+      continue;
+    item = queue->PopFront();
+    return true;
+  }
+  return false;
+}
+
+void dtkTaskScheduler::Push(dtkID id, const Item &item) {
+  WorkerQueue *queue = mQueues[id];
+  boost::unique_lock<boost::mutex> lock(queue->mutex);
+  queue->PushBack(item);
+}
+
+void dtkTaskScheduler::WorkerQueue::PushBack(const Item &item) {
+  if (size == items.size()) {
+    // 装满时按原顺序搬到两倍大小的新缓冲, 队头回到 0.
+    vector<Item> grown(items.empty() ? 16 : items.size() * 2);
+    for (dtkID i = 0; i < size; i++)
+      grown[i] = items[(head + i) % items.size()];
+    items.swap(grown);
+    head = 0;
+  }
+  items[(head + size) % items.size()] = item;
+  size++;
+}
+
+dtkTaskScheduler::Item dtkTaskScheduler::WorkerQueue::PopBack() {
+  size--;
+  return items[(head + size) % items.size()];
+}
+
+dtkTaskScheduler::Item dtkTaskScheduler::WorkerQueue::PopFront() {
+  Item item = items[head];
+  head = (head + 1) % items.size();
+  size--;
+  return item;
+}
+
+void dtkTaskScheduler::Execute(dtkID id, const Item &item) {
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  execute_depth++;
+  if (item.invoker != 0)
+    item.invoker(item.range, item.begin, item.end);
+  else if (item.function != 0)
+    (*item.function)();
+  else
+    mTasks[item.task]->function();
+  execute_depth--;
+  double duration = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+
+  // 每个线程只写自己的忙碌时间, Run 返回前由 mRemaining 同步.
+  // 等待子任务时嵌套执行的时间已计入外层.
+  if (execute_depth == 0)
+    mBusyTimes[id] += duration;
+
+  if (item.task == dtkErrorID) {
+    if (--(*item.remaining) == 0 && item.remaining == &mRemaining) {
+      boost::unique_lock<boost::mutex> lock(mStateMutex);
+      mDoneCondition.notify_all();
+    }
+    return;
+  }
+
+  Task *current = mTasks[item.task];
+  if (current->cost == 0)
+    current->cost = duration;
+  else
+    current->cost += (duration - current->cost) * cost_smoothing;
+
+  // 后继放回其首选线程的队列, 保持对象数据在同一核心上.
+  for (dtkID i = 0; i < current->successors.size(); i++) {
+    Task *successor = mTasks[current->successors[i]];
+    if (--successor->pending == 0) {
+      Item next = {current->successors[i], 0, 0, 0, 0, 0, 0};
+      Push(successor->worker, next);
+    }
+  }
+
+  if (--mRemaining == 0) {
+    boost::unique_lock<boost::mutex> lock(mStateMutex);
+    mDoneCondition.notify_all();
+  }
+}
+} // namespace dtk
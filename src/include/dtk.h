@@ -49,7 +49,7 @@
  * - different length vector of any type
  * - define struct dtkT2 dtkt3 dtkt4
  *
- * dtkPoints (dtkPointsVector)
+ * dtkPoints (dtkPointsVector, dtkPointsAligned)
  * - points container, used in many graphical element in DTK, such as Mesh,
  * Graph dtkPointsReader dtkPointsWriter
  * - points I/O from file.
@@ -189,6 +189,7 @@
 #include "dtkTxOP.h"
 
 #include "dtkPoints.h"
+#include "dtkPointsAligned.h"
 #include "dtkPointsVector.h"
 
 #include "dtkIDTypes.h"
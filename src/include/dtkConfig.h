@@ -37,6 +37,14 @@
 // Comment this line if you don't want to use CUDA.
 #define DTK_GLM
 
+// Uncomment this line (or configure with -DDTK_MIXED_PRECISION_OPT=ON) to store
+// spring parameters, staged mass point state and k-DOP intervals in float.
+// Kernels and reductions still use double.
+// Persistent state (positions, velocities, forces) always stays double; the
+// float copies are staged on top of it each step, so this mode adds memory
+// traffic for the staging instead of halving the state.
+// #define DTK_MIXED_PRECISION
+
 #include <limits>
 
 namespace dtk {
@@ -24,6 +24,7 @@
 #include <CGAL/basic.h>
 
 #include "dtkConfig.h"
+#include "dtkPrecision.h"
 #include "dtkSign.h"
 #include "dtkTx.h"
 
@@ -131,18 +132,21 @@ inline std::ostream &operator<<(std::ostream &stream,
  * @author
  * @note
  * 用于k-Dops碰撞检测算法。
+ * 区间按 dtkPhysPrecision 存储, 单精度时由 Extend 向外取整, 包围盒不会变小.
+ * 区间数不超过预定义轴数, 按最大数目内联存放, 不做堆分配.
  */
 class dtkDiscreteOrientationPolytope {
 public:
   typedef CGAL::Exact_predicates_inexact_constructions_kernel K;
-  typedef K::FT Float;
+  typedef dtkPhysPrecision::Storage Float;
+  typedef dtkInterval<Float> Interval;
   typedef CGAL::Vector_3<K> Vector3;
   const static Vector3 mPredefinedAxis[13];
 
 public:
   dtkDiscreteOrientationPolytope(size_t half_k) {
+    assert(half_k <= 13);
     mHalfK = half_k;
-    mIntervals.resize(mHalfK);
   }
 
   ~dtkDiscreteOrientationPolytope() {}
@@ -161,8 +165,30 @@ public:
         static_cast<const dtkDiscreteOrientationPolytope &>(*this)[n]);
   }
 
+  // 所有区间置为空
+  void Reset() {
+    for (size_t k = 0; k < mHalfK; k++) {
+      mIntervals[k].mLower = std::numeric_limits<Float>::max();
+      mIntervals[k].mUpper = -std::numeric_limits<Float>::max();
+    }
+  }
+
+  /**
+   * @brief		扩展第 k 个区间使其包含 value
+   * @param[in]	k : 区间id
+   * @param[in]	value : 投影值, 按双精度计算
+   */
+  void Extend(size_t k, double value) {
+    Float lower = dtkPhysPrecision::RoundDown(value);
+    Float upper = dtkPhysPrecision::RoundUp(value);
+    if (lower < mIntervals[k].mLower)
+      mIntervals[k].mLower = lower;
+    if (upper > mIntervals[k].mUpper)
+      mIntervals[k].mUpper = upper;
+  }
+
   size_t mHalfK;
-  std::vector<dtkInterval<Float>> mIntervals;
+  Interval mIntervals[13]; /**< 前 mHalfK 个区间有效 */
 };
 
 inline std::ostream &operator<<(std::ostream &stream,
@@ -85,6 +85,14 @@ inline dtkID2 sort(const dtkID &id0, const dtkID &id1) {
 
 inline dtkID2 sort(const dtkID2 &id) { return sort(id.a, id.b); }
 
+// 无序容器使用的 dtkID2 散列, 两个下标拼成 64 位后做乘法混合
+struct dtkID2Hash {
+  size_t operator()(const dtkID2 &id) const {
+    dtkDWORD key = (dtkDWORD(id.a) << 32) | id.b;
+    return size_t((key * 0x9E3779B97F4A7C15ull) >> 16);
+  }
+};
+
 struct dtkID3 {
   dtkID a, b, c;
 
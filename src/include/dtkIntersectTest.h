@@ -17,11 +17,14 @@
 #ifndef SIMPLEPHYSICSENGINE_DTKINTERSECTTEST_H
 #define SIMPLEPHYSICSENGINE_DTKINTERSECTTEST_H
 
+#include <vector>
+
 #include "dtkGraphicsKernel.h"
 #include "dtkIDTypes.h"
-#include "dtkProperty.h"
 
 namespace dtk {
+class dtkCollisionDetectPrimitive;
+
 /**
  * @class <dtkIntersectTest>
  * @brief A group of small intesection test functions
@@ -30,19 +33,53 @@ namespace dtk {
  */
 class dtkIntersectTest {
 public:
-  enum IntersectResultType {
-    INTERSECT_PRIMITIVE_1, /**< represent the primitive1 for intersect testing
-                            */
-    INTERSECT_PRIMITIVE_2, /**< represent the primitive2 for intersect testing
-                            */
-    INTERSECT_NORMAL,      /**< the normal of interest. */
-    INTERSECT_WEIGHT_1,    /**< represent the intersect weight of primitive 1 */
-    INTERSECT_WEIGHT_2,    /**< represent the intersect weight of primitive 2 */
-    INTERSECT_OBJECT       /**< represent the intersect object from CGAL */
+  /**
+   * @brief 相交测试结果
+   * @note 定长的值类型, 按值存放在连续的缓冲中, 不再逐个分配.
+   * 权重按图元顶点的顺序存放, 线段只用前两个分量, 球只用第一个分量.
+   */
+  typedef struct {
+    dtkCollisionDetectPrimitive *primitive_1; /**< 参与测试的图元 1 */
+    dtkCollisionDetectPrimitive *primitive_2; /**< 参与测试的图元 2 */
+    GK::Vector3 normal;  /**< 作用方向, 长度为穿透深度 */
+    dtkDouble3 weight_1; /**< 作用点在图元 1 上的权重 */
+    dtkDouble3 weight_2; /**< 作用点在图元 2 上的权重 */
+    GK::Point3 point;    /**< 三角形与线段的交点, 仅精确测试 */
+    bool has_point;      /**< 精确测试交于一点时为 true */
+  } IntersectResult;
+
+  /**
+   * @brief 一段连续相交结果的只读视图
+   * @note 不持有内存, 只在得到它的调用期间有效.
+   */
+  class IntersectResultView {
+  public:
+    IntersectResultView() : mData(0), mSize(0) {}
+
+    IntersectResultView(const IntersectResult *data, size_t size)
+        : mData(data), mSize(size) {}
+
+    IntersectResultView(const std::vector<IntersectResult> &results)
+        : mData(results.empty() ? 0 : &results[0]), mSize(results.size()) {}
+
+    size_t size() const { return mSize; }
+
+    bool empty() const { return mSize == 0; }
+
+    const IntersectResult &operator[](size_t i) const {
+      assert(i < mSize);
+      return mData[i];
+    }
+
+    const IntersectResult *begin() const { return mData; }
+
+    const IntersectResult *end() const { return mData + mSize; }
+
+  private:
+    const IntersectResult *mData;
+    size_t mSize;
   };
 
-  typedef dtkProperty<IntersectResultType> IntersectResult;
-
 public:
   // Test
   // 3D
@@ -92,28 +129,28 @@ public:
 
   // Improved Intersect For Collision Detect Respones
   static bool DoIntersect(const GK::Segment3 &seg_1, const GK::Segment3 &seg_2,
-                          IntersectResult::Ptr &result);
+                          IntersectResult &result);
   static bool DoIntersect(const GK::Triangle3 &triangle_1,
                           const GK::Triangle3 &triangle_2,
-                          IntersectResult::Ptr &result);
+                          IntersectResult &result);
   static bool DoIntersect(const GK::Triangle3 &triangle,
                           const GK::Segment3 &segment,
-                          IntersectResult::Ptr &result);
+                          IntersectResult &result);
   // Do Distance Intersect
   static bool DoDistanceIntersect(const GK::Segment3 &seg_1,
                                   const GK::Segment3 &seg_2, double distance,
-                                  IntersectResult::Ptr &result);
+                                  IntersectResult &result);
   static bool DoDistanceIntersect(const GK::Triangle3 &tri,
                                   const GK::Segment3 &seg, double distance,
-                                  IntersectResult::Ptr &result,
+                                  IntersectResult &result,
                                   dtkID invert = 0);
   static bool DoDistanceIntersect(const GK::Triangle3 &tri_1,
                                   const GK::Triangle3 &tri_2, double distance,
-                                  IntersectResult::Ptr &result,
+                                  IntersectResult &result,
                                   dtkID invert = 0);
   static bool DoDistanceIntersect(const GK::Triangle3 &tri,
                                   const GK::Sphere3 &sphere, double distance,
-                                  IntersectResult::Ptr &result);
+                                  IntersectResult &result);
 
   // deprecated
   static bool Test(const GK::BBox3 &box1, const GK::BBox3 &box2);
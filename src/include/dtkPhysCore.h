@@ -17,12 +17,17 @@
 #ifndef SIMPLEPHYSICSENGINE_DTKPHYSCORE_H
 #define SIMPLEPHYSICSENGINE_DTKPHYSCORE_H
 
+#include <atomic>
+#include <deque>
+#include <future>
 #include <map>
 #include <memory>
 #include <set>
+#include <utility>
 #include <vector>
 
-#include <boost/thread/barrier.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/thread/thread.hpp>
 #include <boost/utility.hpp>
 
@@ -40,6 +45,9 @@
 
 #include "dtkPhysKnotPlanner.h"
 
+#include "dtkPhysSnapshot.h"
+#include "dtkTaskScheduler.h"
+
 namespace dtk {
 class dtkPhysCore : public boost::noncopyable {
 public:
@@ -64,8 +72,7 @@ public:
     double strength;
     bool self;
     void (*custom_handle)(
-        const std::vector<dtkIntersectTest::IntersectResult::Ptr>
-            &intersectResults,
+        dtkIntersectTest::IntersectResultView intersectResults,
         void *pContext);
     void *pContext;
     CollisionResponseType responseType;
@@ -81,10 +88,13 @@ public:
     dtkCollisionDetectStage::HierarchyPair hierarchy_pair;
     double viscosityCoef;
     void (*custom_handle)(
-        const std::vector<dtkIntersectTest::IntersectResult::Ptr>
-            &intersectResults,
+        dtkIntersectTest::IntersectResultView intersectResults,
         void *pContext);
     void *pContext;
+    std::vector<dtkIntersectTest::IntersectResult>
+        intersect_results; /**< 复用的单个粒子检测结果缓冲. */
+    std::vector<dtkIntersectTest::IntersectResult>
+        particle_intersect_results; /**< 复用的全部粒子检测结果缓冲. */
   } ObstacleSet; // 障碍集.
 
   /**
@@ -104,6 +114,23 @@ public:
     double slave_ratio;
   } AdherePointSet; // 固定点集.
 
+  /**
+   * @brief 预先解析的碰撞响应集.
+   * @note 由 ResolveResponseSet 建立, 更新时不再查找 map.
+   * 指针在 Reallocate 重建任务图前保持有效.
+   */
+  typedef struct {
+    dtkID id;
+    CollisionResponseSet *response_set;
+    const std::vector<dtkInterval<int>> *avoid_1;
+    const std::vector<dtkInterval<int>> *avoid_2;
+    dtkPhysKnotPlanner *knot_planner; /**< 打结识别, 仅 KNOTPLANNING. */
+    dtkCollisionDetectHierarchyKDOPS *thread_hierarchy; /**< 仅内部碰撞. */
+    const std::vector<dtkInterval<int>> *internal_intervals;
+    std::vector<dtkIntersectTest::IntersectResult>
+        intersect_results; /**< 复用的检测结果缓冲. */
+  } ResponseDescriptor; // 预解析的碰撞响应集.
+
 public:
   typedef std::shared_ptr<dtkPhysCore> Ptr;
 
@@ -121,6 +148,36 @@ public:
    */
   void Update(double timeslice);
 
+  /**
+   * @brief 由仿真线程执行一次 Update.
+   * @param[in]	timeslice : 更新时间间隔
+   * @return 完成后得到该帧的帧号
+   * @note	 仿真线程未启动时自动启动, 请求按提交顺序执行.
+   */
+  std::future<size_t> UpdateAsync(double timeslice);
+
+  /**
+   * @brief 启动固定频率的仿真线程.
+   * @param[in]	timeslice : 每步的时间间隔, 同时也是实际的步进周期(秒)
+   * @note
+   * 仿真线程运行期间不要直接调用 Update, 可用 UpdateAsync 插入额外的步,
+   * 用 GetLatestFrame 与 GetSnapshot 读取结果.
+   */
+  void StartFixedRateUpdate(double timeslice);
+
+  /**
+   * @brief 停止仿真线程, 等待正在执行的一帧结束.
+   * @note
+   * 尚未执行的 UpdateAsync 请求被丢弃, 对应的 future 得到
+   * std::future_error(broken_promise). 之后的 UpdateAsync 会重新启动仿真线程.
+   */
+  void StopFixedRateUpdate();
+
+  /**
+   * @brief 最近完成的帧号, 不阻塞.
+   */
+  size_t GetLatestFrame() const { return mLatestFrame; }
+
   /**
    * @brief 新建更新多线程.
    * @param[in]	n : 更新线程数
@@ -128,6 +185,49 @@ public:
    */
   void SetNumberOfThreads(size_t n);
 
+  /**
+   * @brief 设置是否把工作线程绑定到处理器核心.
+   * @param[in]	pinned : 为 true 时按 NUMA 节点绑核
+   * @note
+   * 绑核后每个弹簧束的点集在其首选线程上重新分配, 按首次写入落在本地节点.
+   * 对已有的线程立即生效, 设为 false 只影响之后新建的线程.
+   */
+  void SetThreadAffinity(bool pinned);
+
+  bool IsThreadAffinity() const { return mPinThreads; }
+
+  typedef struct {
+    size_t number_of_threads; /**< 线程数, 1 表示单线程更新 */
+    double frame_time;        /**< 平均每帧耗时, 单位秒 */
+  } ThreadCalibration;
+
+  /**
+   * @brief 运行当前场景若干帧, 选出每帧耗时最短的线程数并应用.
+   * @param[in]	timeslice : 每帧的时间间隔
+   * @param[in]	frames : 每种线程数测量的帧数
+   * @param[in]	maxThreads : 最多尝试的线程数, 0 表示处理器核心数
+   * @param[out]	report : 每种线程数的测量结果, 可为空
+   * @return 选中的线程数
+   * @note 测量会推进场景, 不能与 StartFixedRateUpdate 同时使用.
+   */
+  size_t CalibrateNumberOfThreads(double timeslice, size_t frames = 10,
+                                  size_t maxThreads = 0,
+                                  std::vector<ThreadCalibration> *report = 0);
+
+  /**
+   * @brief 设置重新分配的不均衡度阈值.
+   * @param[in]	threshold : 最忙线程与平均忙碌时间之比, 超过时重新分配
+   */
+  void SetRebalanceThreshold(double threshold) {
+    mRebalanceThreshold = threshold;
+  }
+
+  /**
+   * @brief 上一帧多线程更新的负载不均衡度.
+   * @return 最忙线程与平均忙碌时间之比, 单线程时为 1
+   */
+  double GetImbalanceRatio() const { return mImbalanceRatio; }
+
   /**
    * @brief 从文件获取点集新建弹簧图元.
    * @param[in]	filename : 输入文件名
@@ -199,16 +299,14 @@ public:
   void CreateCollisionResponse(
       dtkID object1_id, dtkID object2_id, double strength,
       void (*custom_handle)(
-          const std::vector<dtkIntersectTest::IntersectResult::Ptr>
-              &intersectResults,
+          dtkIntersectTest::IntersectResultView intersectResults,
           void *pContext) = 0,
       void *pContext = 0);
 
   void CreateSutureResponse(
       dtkID object_id, dtkID thread_id, double strength,
       void (*custom_handle)(
-          const std::vector<dtkIntersectTest::IntersectResult::Ptr>
-              &intersectResults,
+          dtkIntersectTest::IntersectResultView intersectResults,
           void *pContext) = 0,
       void *pContext = 0);
 
@@ -241,6 +339,18 @@ public:
    */
   void DetachAllMassSpring();
 
+  /**
+   * @brief 设置对象在每个宏步内的子步数.
+   * @param[in]	id : 质量弹簧或缝合线id
+   * @param[in]	substeps : 子步数, 1 表示与宏步相同
+   * @note
+   * 前 k - 1 个子步不做碰撞检测, 固定点沿本宏步的位移插值;
+   * 最后一个子步照常参与碰撞检测, 接触冲量在该子步施加.
+   * 相连的对象通过 twins 簇共享力, 取各自设置的最大值.
+   */
+  void SetSubsteps(dtkID id, size_t substeps);
+  size_t GetSubsteps(dtkID id) const;
+
   dtkPhysMassSpring::Ptr GetMassSpring(dtkID id);
 
   dtkPhysMassSpring::Ptr GetTetraMassSpring(dtkID id);
@@ -249,6 +359,25 @@ public:
 
   dtkPoints::Ptr GetThreadPoints(dtkID id);
 
+  /**
+   * @brief 开关流水线模式.
+   * @param[in]	pipelined : 为 true 时每帧结束发布点集快照
+   * @note
+   * 流水线模式下渲染等读者通过 GetSnapshot 读取上一帧的结果,
+   * 不必与 Update 互斥, 也不必自行拷贝点集.
+   */
+  void SetPipelined(bool pipelined);
+
+  bool IsPipelined() const { return mPipelined; }
+
+  /**
+   * @brief 最近发布的点集快照, 可以在任意线程调用.
+   * @return 快照, 尚未发布时为空
+   */
+  dtkPhysSnapshot::ConstPtr GetSnapshot() const {
+    return std::atomic_load(&mFrontSnapshot);
+  }
+
   dtkCollisionDetectHierarchyKDOPS::Ptr
   GetCollisionDetectHierarchy(dtkID id, CollisionHierarchyType type);
 
@@ -265,8 +394,7 @@ public:
   void ExecuteCustomDetectTriangleArea(
       dtkID id, dtkID targetID,
       void (*custom_handle)(
-          const std::vector<dtkIntersectTest::IntersectResult::Ptr>
-              &intersectResults,
+          dtkIntersectTest::IntersectResultView intersectResults,
           void *pContext),
       void *pContext = 0);
 
@@ -279,8 +407,7 @@ public:
   void CreateObstacleForParticleSystem(
       dtkID particlesystem_id, dtkID object_id, double viscosityCoef,
       void (*custom_handle)(
-          const std::vector<dtkIntersectTest::IntersectResult::Ptr>
-              &intersectResults,
+          dtkIntersectTest::IntersectResultView intersectResults,
           void *pContext) = 0,
       void *pContext = 0);
 
@@ -306,20 +433,118 @@ private:
 
   void Reallocate();
 
+  /**
+   * @brief 把分配结果中的主质量弹簧展开为整个弹簧束.
+   */
+  void ExpandConnectedMassSprings();
+
+  /**
+   * @brief 按测得的任务耗时重新分配首选线程
+   * @note 复用 AllocateDetails, 权重由点数与碰撞对估计换成实际执行时间.
+   */
+  void Rebalance();
+
+  /**
+   * @brief 根据当前对象与碰撞响应集重建多线程任务图
+   * @note
+   * 每个弹簧束的两次迭代, 每棵碰撞检测树的更新, 每个碰撞响应集各为一个任务,
+   * 粒子系统, 障碍集, 设备力反馈与缝合线的后处理也按对象拆成任务,
+   * 依赖只建立在真正共享数据的任务之间, 由 mScheduler 负责窃取调度.
+   */
+  void BuildTaskGraph();
+
+  /**
+   * @brief 把 mScheduler 传给碰撞检测阶段, 碰撞检测树与质量弹簧
+   * @note 所有子系统共用一组工作线程, 嵌套的并行通过 ForkJoin 完成.
+   */
+  void ShareTaskScheduler();
+
+  /**
+   * @brief 在工作线程上重新分配分到该线程的质量弹簧
+   * @param[in]	touches : 每个工作线程的质量弹簧
+   * @param[in]	worker : 当前工作线程id
+   */
+  void _FirstTouch(
+      const std::vector<std::vector<dtkPhysMassSpring *>> *touches,
+      dtkID worker);
+
   void RebundleConnectedMassSpring();
+  /**
+   * @brief 把设置的子步数写入对象, 相连的对象取最大值.
+   */
+  void ResolveSubsteps();
 
   void CreateCollisionResponse(
       dtkID object1_id, CollisionHierarchyType obj1_type, dtkID object2_id,
       CollisionHierarchyType obj2_type, double strength,
       void (*custom_handle)(
-          const std::vector<dtkIntersectTest::IntersectResult::Ptr>
-              &intersectResults,
+          dtkIntersectTest::IntersectResultView intersectResults,
           void *pContext) = 0,
       void *pContext = 0);
 
   void _Update_s(double timeslice);
   void _Update_mt(double timeslice);
 
+  /**
+   * @brief 解析碰撞响应集用到的对象, 结果写入 descriptor
+   * @param[in]	id : 碰撞响应集id
+   * @param[in]	internal : 是否为内部碰撞响应集
+   * @param[out]	descriptor : 预解析的碰撞响应集
+   */
+  void ResolveResponseSet(dtkID id, bool internal,
+                          ResponseDescriptor &descriptor);
+
+  // 任务图中的任务, 也供单线程更新复用.
+  void _UpdateBundle(dtkID bundle, dtkID iteration);
+  /**
+   * @brief 质量弹簧休眠时, 其碰撞检测树跳过更新
+   * @param[in]	id : 质量弹簧id, 与碰撞检测树id相同
+   * @param[in]	massSpring : 质量弹簧
+   */
+  void _SyncHierarchySleeping(dtkID id, dtkPhysMassSpring *massSpring);
+  /**
+   * @brief 子步数大于 1 的对象先走 k - 1 个不做碰撞检测的子步
+   * @param[in]	massSprings : 质量弹簧, 相连的对象必须在同一组中
+   */
+  void _UpdateFreeSubsteps(const std::vector<dtkPhysMassSpring *> &massSprings);
+  void _UpdateCollisionResponseSet(ResponseDescriptor &descriptor);
+  void _UpdateInternalCollisionResponseSet(ResponseDescriptor &descriptor);
+  void _UpdateAdherePointSets();
+  void _UpdateParticleSystem(dtkPhysParticleSystem *particleSystem);
+  void _UpdateObstacleSet(ObstacleSet &obstacleSet);
+  void _UpdateDeviceForceFeedback(dtkID deviceLabel,
+                                  dtkT3<double> &forceFeedback);
+  void _UpdateKnotPlanner(dtkPhysKnotPlanner *knotPlanner);
+  void _SmoothSutureThread(dtkPhysMassSpringThread *thread,
+                           dtkPoints *threadPoints);
+
+  /**
+   * @brief 选出可写的后台快照, 并为每个点集准备拷贝目标
+   */
+  void PrepareSnapshot();
+
+  /**
+   * @brief 拷贝一个点集到后台快照
+   * @param[in]	id : 质量弹簧或缝合线的编号
+   * @param[in]	thread : 是否为缝合线的点集
+   */
+  void _CopySnapshotPoints(dtkID id, bool thread);
+  /**
+   * @brief 后台快照与前台快照原子交换
+   */
+  void PublishSnapshot();
+
+  /**
+   * @brief 仿真线程主循环, 先处理 UpdateAsync 请求, 再按固定频率步进
+   */
+  void DriverLoop();
+
+  /**
+   * @brief 启动仿真线程, 旧线程尚未退出时先释放锁等待其结束
+   * @param[in]	lock : 调用者持有的 mDriverMutex
+   */
+  void StartDriver(boost::unique_lock<boost::mutex> &lock);
+
 public:
   const static size_t mPairOffset = 1000;
   // Collision Detect
@@ -356,6 +581,11 @@ public:
 
   std::map<dtkID, std::set<dtkID>> mConnectMasterMap;
 
+  // Multi-rate
+  std::map<dtkID, size_t> mSubsteps; /**< 设置的子步数, 未设置时为 1. */
+  std::vector<dtkPhysMassSpring *>
+      mSubstepMassSprings; /**< 单线程更新时参与子步的质量弹簧. */
+
   // Adhere
   std::vector<AdherePointSet> mAdherePointSets;
   std::map<dtkID, std::map<dtkID, size_t>> mAdhereCounts;
@@ -380,13 +610,50 @@ public:
 public:
   size_t mNumberOfThreads; /**< 构建多线程数. */
 
-  bool mLive; /**< 核是否存活， 析构时置0,杀死循环检测更新线程. */
-
   double mTimeslice; /**< 更新的时间间隔. */
 
-  boost::thread_group *mThreadGroup;
-  boost::barrier *mEnterBarrier;
-  boost::barrier *mExitBarrier;
+  dtkTaskScheduler::Ptr mScheduler; /**< 多线程任务图调度器. */
+  bool mPinThreads; /**< 工作线程是否绑核. */
+
+  std::vector<std::vector<dtkPhysMassSpring *>>
+      mBundles; /**< 弹簧束, 相连的质量弹簧必须在同一个任务中更新. */
+  std::vector<std::vector<dtkID>>
+      mBundleIDs; /**< 弹簧束中每个质量弹簧的id. */
+  std::vector<ResponseDescriptor>
+      mResponseDescriptors; /**< 碰撞响应集的预解析表. */
+  std::vector<ResponseDescriptor>
+      mInternalResponseDescriptors; /**< 内部碰撞响应集的预解析表. */
+  ResponseDescriptor
+      mSerialDescriptor; /**< 单线程更新时复用的碰撞响应集描述. */
+
+  // Load Balance
+  const static size_t mRebalanceInterval = 30; /**< 两次重新分配的最小帧数. */
+  std::vector<std::multimap<dtkID, dtkID>>
+      mBalanceTasks; /**< 每个分配阶段中分配ID到任务的映射. */
+  double mRebalanceThreshold;   /**< 触发重新分配的不均衡度. */
+  double mImbalanceRatio;       /**< 上一帧的不均衡度. */
+  size_t mFramesSinceRebalance; /**< 距上次重新分配的帧数. */
+
+  // Snapshot
+  bool mPipelined; /**< 是否每帧发布点集快照. */
+  size_t mFrame;   /**< 已更新的帧数. */
+  dtkPhysSnapshot::Ptr
+      mFrontSnapshot; /**< 已发布的快照, 只通过原子操作访问. */
+  dtkPhysSnapshot::Ptr mBackSnapshot; /**< 正在填写的快照. */
+  typedef std::map<dtkID, std::pair<const dtkPoints *, dtkPointsVector *>>
+      SnapshotCopies;
+  SnapshotCopies mSnapshotCopies; /**< 本帧质量弹簧点集的拷贝, 源与目标. */
+  SnapshotCopies mThreadSnapshotCopies; /**< 本帧缝合线点集的拷贝. */
+
+  // Driver
+  std::atomic<size_t> mLatestFrame; /**< 最近完成的帧号. */
+  bool mDriverLive;                 /**< 仿真线程是否运行. */
+  double mFixedTimeslice; /**< 固定频率步进的时间间隔, 0 表示不步进. */
+  std::deque<std::pair<double, std::promise<size_t>>>
+      mAsyncRequests; /**< 等待执行的 UpdateAsync 请求. */
+  boost::mutex mDriverMutex;
+  boost::condition_variable mDriverCondition;
+  boost::thread mDriverThread;
 
   // Allocator
   std::vector<std::vector<std::vector<dtkID>>>
@@ -0,0 +1,137 @@
+
+/**
+ * @file dtkPhysImplicitSolver.h
+ * @brief dtkPhysImplicitSolver 头文件
+ * @author agent (agent@local)
+ * @version 1.0
+ * @date 2026-10-16
+ * @copyright MIT LICENSE
+ * https://github.com/Simple-XX/SimplePhysicsEngine
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-16<td>agent<td>创建文件
+ * </table>
+ */
+
+#ifndef SIMPLEPHYSICSENGINE_DTKPHYSIMPLICITSOLVER_H
+#define SIMPLEPHYSICSENGINE_DTKPHYSIMPLICITSOLVER_H
+
+#include <memory>
+#include <vector>
+
+#include <boost/utility.hpp>
+
+#include "dtkIDTypes.h"
+#include "dtkPhysMassPoint.h"
+#include "dtkPhysSpring.h"
+#include "dtkTaskScheduler.h"
+
+namespace dtk {
+/**
+ * @class <dtkPhysImplicitSolver>
+ * @brief 质量弹簧的隐式欧拉求解器
+ * @author <>
+ * @note
+ * 求解 (M - h D - h^2 K) dv = h (f + h K v), K, D 为弹簧力对位置, 速度的雅可比.
+ * 矩阵按 3x3 块的压缩行格式存放, 拓扑不变时只重新填值, 结构跨帧复用.
+ * 用块 Jacobi 预条件共轭梯度求解, 按行分块, 可在调度器上并行.
+ * 压缩状态的弹簧不计几何刚度, 保证矩阵对称正定.
+ * 固定质点的速度增量恒为 0.
+ */
+class dtkPhysImplicitSolver : public boost::noncopyable {
+public:
+  typedef std::shared_ptr<dtkPhysImplicitSolver> Ptr;
+
+  static Ptr New() { return Ptr(new dtkPhysImplicitSolver()); }
+
+public:
+  /**
+   * @brief		按弹簧端点建立矩阵结构
+   * @param[in]	numberOfPoints : 质点数
+   * @param[in]	ends : 每根弹簧两个端点的下标
+   */
+  void BuildStructure(size_t numberOfPoints, const std::vector<dtkID> &ends);
+
+  /**
+   * @brief		组装并求解一步隐式欧拉
+   * @param[in]	points : 质点状态, 合外力取自 mForceAccum
+   * @param[in]	springs : 弹簧参数
+   * @param[in]	pos : 质点位置的 x, y, z 分量数组
+   * @param[in]	vel : 质点速度的 x, y, z 分量数组
+   * @param[in]	timeslice : 时间间隔
+   * @param[in]	scheduler : 非空时按行分块并行
+   * @param[in]	grainSize : 每个子任务处理的行数
+   * @return 共轭梯度的迭代次数
+   * @note 结果写入 points 的 mAccel, 即 dv / h
+   */
+  size_t Solve(dtkPhysMassPointStorage &points,
+               const dtkPhysSpringStorage &springs,
+               const dtkReal *const pos[3], const dtkReal *const vel[3],
+               double timeslice, dtkTaskScheduler *scheduler,
+               size_t grainSize);
+
+  void SetTolerance(double tolerance) { mTolerance = tolerance; }
+  double GetTolerance() const { return mTolerance; }
+
+  void SetMaxIterations(size_t iterations) { mMaxIterations = iterations; }
+  size_t GetMaxIterations() const { return mMaxIterations; }
+
+  // 上一次求解的迭代次数与相对残差
+  size_t GetIterations() const { return mIterations; }
+  double GetResidual() const { return mResidual; }
+
+private:
+  dtkPhysImplicitSolver();
+
+  dtkID FindBlock(dtkID row, dtkID column) const;
+
+  void Assemble(dtkPhysMassPointStorage &points,
+                const dtkPhysSpringStorage &springs,
+                const dtkReal *const pos[3], const dtkReal *const vel[3],
+                double timeslice);
+
+  /**
+   * @brief		按行分块执行, 每块的部分和写入 mPartials
+   */
+  template <typename Function> void ForEachChunk(const Function &body);
+
+  template <typename Function>
+  void _Chunk(const Function *body, dtkID begin, dtkID end);
+
+  double SumPartials() const;
+
+  // 共轭梯度的各步, 返回本块的部分和
+  double _Multiply(dtkID begin, dtkID end);
+  double _Step(dtkID begin, dtkID end, double alpha);
+  double _Precondition(dtkID begin, dtkID end);
+  double _Direction(dtkID begin, dtkID end, double beta);
+
+private:
+  std::vector<dtkID> mRowOffsets;    /**< 每行第一个块的位置 */
+  std::vector<dtkID> mColumns;       /**< 每个块的列 */
+  std::vector<dtkID> mDiagonals;     /**< 每行对角块的位置 */
+  std::vector<dtkID> mSpringBlocks;  /**< 每根弹簧的 aa, bb, ab, ba 块 */
+  std::vector<double> mBlocks;       /**< 块的值, 每块 9 个 double */
+  std::vector<double> mInvDiagonals; /**< 对角块的逆, 预条件用 */
+  std::vector<char> mFixed;          /**< 固定质点 */
+
+  std::vector<double> mRhs; /**< 右端项 */
+  std::vector<double> mX;   /**< 速度增量 */
+  std::vector<double> mR;   /**< 残差 */
+  std::vector<double> mZ;   /**< 预条件后的残差 */
+  std::vector<double> mP;   /**< 搜索方向 */
+  std::vector<double> mQ;   /**< A 乘搜索方向 */
+
+  std::vector<double> mPartials; /**< 每块的部分和, 按块顺序求和 */
+  dtkTaskScheduler *mScheduler;  /**< 本次求解使用的调度器 */
+  size_t mGrainSize;             /**< 每块的行数 */
+
+  double mTolerance;     /**< 相对残差阈值 */
+  size_t mMaxIterations; /**< 最大迭代次数 */
+  size_t mIterations;    /**< 上一次求解的迭代次数 */
+  double mResidual;      /**< 上一次求解的相对残差 */
+};
+} // namespace dtk
+
+#endif /* SIMPLEPHYSICSENGINE_DTKPHYSIMPLICITSOLVER_H */
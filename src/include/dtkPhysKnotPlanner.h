@@ -40,7 +40,7 @@ public:
 
 public:
   ~dtkPhysKnotPlanner();
-  void KnotRecognition(std::vector<dtkIntersectTest::IntersectResult::Ptr> &);
+  void KnotRecognition(dtkIntersectTest::IntersectResultView);
 
   void DoKnotFormation();
 
@@ -17,6 +17,12 @@
 #ifndef SIMPLEPHYSICSENGINE_DTKPHYSMASSPOINT_H
 #define SIMPLEPHYSICSENGINE_DTKPHYSMASSPOINT_H
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <boost/utility.hpp>
+
 #include "dtkGraphicsKernel.h"
 #include "dtkIDTypes.h"
 #include "dtkPoints.h"
@@ -40,8 +46,211 @@ enum ItrMethod {
   Heun, /**< Heun https://zh.wikipedia.org/wiki/Heun%E6%96%B9%E6%B3%95 （二阶）
          */
   Collision, /**< */
-  Verlet     /**< Position-Based / Verlet Integration
+  Verlet,    /**< Position-Based / Verlet Integration
                 https://en.wikipedia.org/wiki/Verlet_integration （二阶） */
+  Implicit,  /**< 隐式欧拉, 由 dtkPhysImplicitSolver 求解速度增量 （一阶） */
+  XPBD       /**< 基于位置的约束投影, 由 dtkPhysPositionSolver 求解 （一阶） */
+};
+
+/**
+ * @class <dtkPhysMassPointStorage>
+ * @brief 质点状态的结构数组存储
+ * @author <>
+ * @note
+ * 同一个质量弹簧的质点状态按字段连续存放, 更新时按下标顺序流式访问.
+ * 位置仍保存在与网格, 碰撞检测树共用的 dtkPoints 中.
+ * dtkPhysMassPoint 只保存存储与下标, 作为访问单个质点的代理.
+ */
+class dtkPhysMassPointStorage : public boost::noncopyable {
+public:
+  typedef std::shared_ptr<dtkPhysMassPointStorage> Ptr;
+
+  static Ptr New(dtkPoints::Ptr pts = dtkPoints::Ptr()) {
+    return Ptr(new dtkPhysMassPointStorage(pts));
+  }
+
+public:
+  /**
+   * @brief		添加质点
+   * @param[in]	pointID : 质点在点集中的id
+   * @return 质点在存储中的下标
+   */
+  dtkID AddPoint(dtkID pointID, const double &mass = 1.0,
+                 const dtkT3<double> &vel = dtkT3<double>(0, 0, 0),
+                 double pointDamp = 1.0, double pointResistence = 2.5,
+                 dtkDouble3 gravityAccel = dtkT3<double>(0, 0, 0));
+
+  size_t GetNumberOfPoints() const { return mPointIDs.size(); }
+
+  void SetPoints(dtkPoints::Ptr pts) {
+    mPts = pts;
+    mAligned = dynamic_cast<dtkPointsAligned *>(pts.get());
+  }
+  dtkPoints::Ptr GetPoints() { return mPts; }
+
+  /**
+   * @brief		按顺序更新一段质点, 与逐个调用 dtkPhysMassPoint::Update 相同
+   * @param[in]	begin : 起始下标
+   * @param[in]	end : 结束下标, 不包含
+   * @param[in]	timeslice : 时间间隔
+   * @param[in]	method : 迭代算法
+   * @param[in]	iteration : 迭代次数
+   */
+  void Update(dtkID begin, dtkID end, double timeslice, ItrMethod method,
+              dtkID iteration);
+
+  // 按迭代算法取位置, 速度, 加速度
+  dtkT3<double> GetPosition(dtkID i, ItrMethod method = Euler,
+                            dtkID iteration = 0) const;
+  dtkT3<double> GetVel(dtkID i, ItrMethod method = Euler,
+                       dtkID iteration = 0) const;
+  dtkT3<double> GetAccel(dtkID i, ItrMethod method = Euler,
+                         dtkID iteration = 0) const;
+
+  void SetPosition(dtkID i, const dtkT3<double> &newPos) {
+    StorePosition(i, newPos);
+  }
+
+  // 点集中的当前坐标, 对齐点集直接读写, 不经过 GK::Point3
+  dtkT3<double> LoadPosition(dtkID i) const {
+    if (mAligned) {
+      const double *coord = mAligned->GetCoord(mPointIDs[i]);
+      return dtkT3<double>(coord[0], coord[1], coord[2]);
+    }
+    const GK::Point3 &point = mPts->GetPoint(mPointIDs[i]);
+    return dtkT3<double>(point.x(), point.y(), point.z());
+  }
+  void StorePosition(dtkID i, const dtkT3<double> &pos) {
+    if (mAligned)
+      mAligned->SetCoord(mPointIDs[i], pos.x, pos.y, pos.z);
+    else
+      mPts->SetPoint(mPointIDs[i], GK::Point3(pos.x, pos.y, pos.z));
+  }
+
+  void SetActive(dtkID i, bool newActive);
+
+  void ApplyImpulse(dtkID i);
+
+  dtkT3<double> GetAndClearImpulse(dtkID i);
+
+  void ResetDynamicState(dtkID i);
+
+  /**
+   * @brief		质点休眠, 清空速度与各次迭代的中间状态
+   * @note 休眠质点不再积分, 任何迭代算法读到的都是当前位置与零速度
+   */
+  void Sleep(dtkID i);
+  void Wake(dtkID i);
+
+  // 休眠质点受到冲量, 控制输入等扰动时记录唤醒请求
+  void Disturb(dtkID i) {
+    if (mSleeping[i]) {
+      mWake[i] = 1;
+      mWakePending = 1;
+    }
+  }
+
+  /**
+   * @brief		在当前线程上重新分配全部状态数组
+   * @note 由负责更新的工作线程调用, 使数组页落在该线程的 NUMA 节点上
+   */
+  void Relocate();
+
+private:
+  dtkPhysMassPointStorage(dtkPoints::Ptr pts) : mWakePending(0) {
+    SetPoints(pts);
+  }
+
+public:
+  dtkPoints::Ptr mPts;          /**< 共用的点集 */
+  dtkPointsAligned *mAligned;   /**< 点集为对齐点集时的直接指针 */
+  std::vector<dtkID> mPointIDs; /**< 质点在点集中的id */
+
+  std::vector<dtkT3<double>> mVel;            /**< 质点速度 */
+  std::vector<dtkT3<double>> mAccel;          /**< 质点加速度 */
+  std::vector<dtkT3<double>> mForceAccum;     /**< 合外力 */
+  std::vector<dtkT3<double>> mGravity;        /**< 重力 */
+  std::vector<dtkT3<double>> mResistance;     /**< 阻力 */
+  std::vector<dtkT3<double>> mPosLastFrame;   /**< 上一帧位置 */
+  std::vector<dtkT3<double>> mForceDecorator; /**< 恒力 */
+  std::vector<dtkT3<double>> mImpulse;        /**< 冲量 */
+
+  std::vector<double> mMass;       /**< 质量 */
+  std::vector<double> mResistCoef; /**< 阻力系数 */
+  std::vector<double> mPointDamp;  /**< 阻尼 */
+  std::vector<size_t> mImpulseNum; /**< 冲量数 */
+
+  // 标志用 char 存放, 避免 vector<bool> 的按位打包使并行写互相干扰
+  std::vector<char> mActive;  /**< 质点是否活动 */
+  std::vector<char> mCollide; /**< 是否发生碰撞 */
+  std::vector<dtkID> mLabel;  /**< 标记 */
+
+  std::vector<char> mSleeping; /**< 质点是否休眠 */
+  std::vector<char> mWake;     /**< 休眠时受到扰动, 等待唤醒 */
+  char mWakePending;           /**< 存在等待唤醒的质点 */
+
+  // 每次迭代的中间状态, 按迭代序号分开存放
+  std::vector<dtkT3<double>> mPosBuffers[3];
+  std::vector<dtkT3<double>> mVelBuffers[3];
+  std::vector<dtkT3<double>> mAccelBuffers[3];
+};
+
+class dtkPhysMassPoint;
+
+/**
+ * @class <dtkPhysTwinCluster>
+ * @brief 互为 twins 的质点组成的簇
+ * @author <>
+ * @note
+ * AddTwin 按并查集合并两个质点所在的簇, 小簇并入大簇, 成员直接指向合并后的簇.
+ * 簇内任意两个质点互为 twins, 成员可以属于不同的质量弹簧.
+ * 力与冲量只写入成员自己的存储, 不再跨对象转发;
+ * 所有成员写完后由 ResolveForces, ResolveImpulses 每簇合并一次, 写回各成员.
+ */
+class dtkPhysTwinCluster : public boost::noncopyable {
+public:
+  typedef std::shared_ptr<dtkPhysTwinCluster> Ptr;
+
+  static Ptr New() { return Ptr(new dtkPhysTwinCluster()); }
+
+public:
+  /**
+   * @brief		合并两个质点所在的簇, 没有簇的质点先建立单成员的簇
+   */
+  static void Merge(dtkPhysMassPoint *point1, dtkPhysMassPoint *point2);
+
+  /**
+   * @brief		质点离开所在的簇
+   */
+  static void Leave(dtkPhysMassPoint *point);
+
+  /**
+   * @brief		合并成员的合外力
+   * @note
+   * 未休眠成员的合力按质量分给各未休眠成员, 加速度相同.
+   * 质量相同时与原先每个 twin 取 1/n 的力一致.
+   */
+  void ResolveForces();
+
+  /**
+   * @brief		合并成员的冲量与冲量数, 每个成员得到全部冲量
+   */
+  void ResolveImpulses();
+
+  const std::vector<dtkPhysMassPoint *> &GetMembers() const {
+    return mMembers;
+  }
+  size_t GetNumberOfMembers() const { return mMembers.size(); }
+
+  // 簇的结构每次改变时递增, 质量弹簧据此重建自己负责的簇
+  static size_t GetGeneration() { return sGeneration.load(); }
+
+private:
+  dtkPhysTwinCluster() {}
+
+private:
+  std::vector<dtkPhysMassPoint *> mMembers; /**< 成员 */
+  static std::atomic<size_t> sGeneration;  /**< 簇结构的版本 */
 };
 
 /**
@@ -49,15 +258,19 @@ enum ItrMethod {
  * @brief 物理弹性质点
  * @author <>
  * @note
- * 物理弹性质点
+ * 物理弹性质点, 状态保存在 dtkPhysMassPointStorage 中, 本类只是代理.
+ * 析构时离开所在的 twins 簇, 簇中记录的是质点地址, 因此不可复制.
  */
-class dtkPhysMassPoint {
+class dtkPhysMassPoint : public boost::noncopyable {
 public:
   dtkPhysMassPoint(dtkID id, dtkPoints::Ptr pts, const double &mass = 1.0,
                    const dtkT3<double> &vel = dtkT3<double>(0, 0, 0),
                    double pointDamp = 1.0, double pointResistence = 2.5,
                    dtkDouble3 gravityAccel = dtkT3<double>(0, 0, 0));
 
+  // 代理存储中已有的质点
+  dtkPhysMassPoint(dtkPhysMassPointStorage::Ptr storage, dtkID index);
+
 public:
   virtual ~dtkPhysMassPoint();
 
@@ -77,43 +290,55 @@ public:
    * @brief		传递冲量
    * @note	根据冲量改变质点状态。
    */
-  void ApplyImpulse();
-  dtkT3<double> GetAndClearImpulse();
+  void ApplyImpulse() { mStorage->ApplyImpulse(mIndex); }
+  dtkT3<double> GetAndClearImpulse() {
+    return mStorage->GetAndClearImpulse(mIndex);
+  }
 
-  const GK::Point3 &GetPoint() { return mPts->GetPoint(mID); }
-  dtkPoints::Ptr GetPoints() { return mPts; }
-  dtkID GetPointID() { return mID; }
-  void SetPointID(dtkID id) { mID = id; }
+  const GK::Point3 &GetPoint() {
+    return mStorage->mPts->GetPoint(mStorage->mPointIDs[mIndex]);
+  }
+  dtkPoints::Ptr GetPoints() { return mStorage->mPts; }
+  dtkID GetPointID() { return mStorage->mPointIDs[mIndex]; }
+  void SetPointID(dtkID id) { mStorage->mPointIDs[mIndex] = id; }
+
+  // 质点在存储中的下标
+  dtkID GetIndex() const { return mIndex; }
+  dtkPhysMassPointStorage::Ptr GetStorage() { return mStorage; }
 
   // 获取位置，用于更新
 
-  dtkT3<double> GetPosition(ItrMethod method = Euler, dtkID iteration = 0);
-  dtkT3<double> GetLastFramePosition() { return mPosLastFrame; }
+  dtkT3<double> GetPosition(ItrMethod method = Euler, dtkID iteration = 0) {
+    return mStorage->GetPosition(mIndex, method, iteration);
+  }
+  dtkT3<double> GetLastFramePosition() {
+    return mStorage->mPosLastFrame[mIndex];
+  }
 
   // 更新位置
 
   /**
    * @brief		更新质点位置
    * @param[in]	newPos : 新位置
-   * @param[in]	passToTwin : 更新邻居
+   * @param[in]	passToTwin : 同时更新簇内的其它质点
    * @note twin是当前点有同步关系的点
    */
-  void SetPosition(dtkT3<double> newPos, bool passToTwin = true) {
-    mPts->SetPoint(this->mID, GK::Point3(newPos[0], newPos[1], newPos[2]));
-    if (passToTwin && mTwins.size() > 0) {
-      for (dtkID i = 0; i < mTwins.size(); i++) {
-        mTwins[i]->SetPosition(newPos, false);
-      }
-    }
+  void SetPosition(dtkT3<double> newPos, bool passToTwin = true);
+  void SetPosition(dtkT3<double> newPos, dtkID iteration) {
+    mStorage->mPosBuffers[iteration][mIndex] = newPos;
   }
-  void SetPosition(dtkT3<double> newPos, dtkID iteration);
 
-  dtkT3<double> GetVel(ItrMethod method = Euler, dtkID iteration = 0);
-  dtkT3<double> GetAccel(ItrMethod method = Euler, dtkID iteration = 0);
+  dtkT3<double> GetVel(ItrMethod method = Euler, dtkID iteration = 0) {
+    return mStorage->GetVel(mIndex, method, iteration);
+  }
+  dtkT3<double> GetAccel(ItrMethod method = Euler, dtkID iteration = 0) {
+    return mStorage->GetAccel(mIndex, method, iteration);
+  }
 
   // this cannot be used during the update
   void SetVel(dtkT3<double> newVel, bool passToTwin = true) {
-    mVel = newVel;
+    mStorage->mVel[mIndex] = newVel;
+    mStorage->Disturb(mIndex);
     /*if(  passToTwin && mTwins.size() > 0 )
     {
             for( dtkID i = 0; i < mTwins.size(); i++ )
@@ -123,11 +348,14 @@ public:
     }*/
   }
 
-  void SetVel(dtkT3<double> newVel, dtkID iteration);
+  void SetVel(dtkT3<double> newVel, dtkID iteration) {
+    mStorage->mVelBuffers[iteration][mIndex] = newVel;
+  }
 
   // this cannot be used during the update
   void SetPoint(GK::Point3 &newPos, bool passToTwin = true) {
-    mPts->SetPoint(this->mID, newPos);
+    mStorage->mPts->SetPoint(mStorage->mPointIDs[mIndex], newPos);
+    mStorage->Disturb(mIndex);
     /*if( mTwins.size() > 0 && passToTwin )
     {
             for( dtkID i = 0; i < mTwins.size(); i++ )
@@ -138,144 +366,134 @@ public:
   }
 
   // 修改质量
-  void SetMass(const double &mass) { mMass = mass; }
-  const double &GetMass() { return mMass; }
+  void SetMass(const double &mass) { mStorage->mMass[mIndex] = mass; }
+  const double &GetMass() { return mStorage->mMass[mIndex]; }
 
   // 修改阻力系数
-  void SetResistCoef(const double &resistCoef) { mResistCoef = resistCoef; }
-  const double &GetResistCoef() { return mResistCoef; }
+  void SetResistCoef(const double &resistCoef) {
+    mStorage->mResistCoef[mIndex] = resistCoef;
+  }
+  const double &GetResistCoef() { return mStorage->mResistCoef[mIndex]; }
 
   // 恒力
-  void SetForceDecorator(const dtkT3<double> &fd) { mForceDecorator = fd; }
+  void SetForceDecorator(const dtkT3<double> &fd) {
+    mStorage->mForceDecorator[mIndex] = fd;
+    mStorage->Disturb(mIndex);
+  }
   void AddForceDecorator(const dtkT3<double> &newFD) {
-    mForceDecorator = mForceDecorator + newFD;
+    mStorage->mForceDecorator[mIndex] =
+        mStorage->mForceDecorator[mIndex] + newFD;
+    mStorage->Disturb(mIndex);
+  }
+  const dtkT3<double> &GetForceDecorator() {
+    return mStorage->mForceDecorator[mIndex];
   }
-  const dtkT3<double> &GetForceDecorator() { return mForceDecorator; }
 
-  // 冲量
-  void SetImpulse(const dtkT3<double> &impulse, bool passToTwin = true) {
-    mImpulse = impulse;
-    if (mTwins.size() > 0 && passToTwin) {
-      for (dtkID i = 0; i < mTwins.size(); i++) {
-        mTwins[i]->SetImpulse(impulse, false);
-      }
-    }
+  // 冲量, 只写本质点, twins 簇在 ResolveImpulses 时合并
+  void SetImpulse(const dtkT3<double> &impulse) {
+    mStorage->mImpulse[mIndex] = impulse;
+    mStorage->Disturb(mIndex);
   }
-  void AddImpulse(const dtkT3<double> &newImpulse, bool passToTwin = true) {
-    mImpulse = mImpulse + newImpulse;
-    mImpulseNum++;
-    if (mTwins.size() > 0 && passToTwin) {
-      for (dtkID i = 0; i < mTwins.size(); i++) {
-        mTwins[i]->AddImpulse(newImpulse, false);
-      }
-    }
+  void AddImpulse(const dtkT3<double> &newImpulse) {
+    mStorage->mImpulse[mIndex] = mStorage->mImpulse[mIndex] + newImpulse;
+    mStorage->mImpulseNum[mIndex]++;
+    mStorage->Disturb(mIndex);
   }
-  const dtkT3<double> &GetImpulse() { return mImpulse; }
+  const dtkT3<double> &GetImpulse() { return mStorage->mImpulse[mIndex]; }
 
-  void AddForce(const dtkT3<double> &f, bool passToTwin = true) {
-    mForceAccum = mForceAccum + f / (double)(mTwins.size() + 1);
-    if (mTwins.size() > 0 && passToTwin) {
-      for (dtkID i = 0; i < mTwins.size(); i++) {
-        mTwins[i]->AddForce(f, false);
-      }
-    }
+  // 只写本质点, twins 簇在 ResolveForces 时合并
+  void AddForce(const dtkT3<double> &f) {
+    mStorage->mForceAccum[mIndex] = mStorage->mForceAccum[mIndex] + f;
   }
 
-  const dtkT3<double> &GetForceAccum() { return mForceAccum; }
+  const dtkT3<double> &GetForceAccum() {
+    return mStorage->mForceAccum[mIndex];
+  }
   void SetForceAccum(dtkT3<double> newForceAccum) {
-    mForceAccum = newForceAccum;
+    mStorage->mForceAccum[mIndex] = newForceAccum;
   }
 
   void SetActive(bool newActive, bool passToTwin = true);
-  bool IsActive() { return mActive; }
+  bool IsActive() { return mStorage->mActive[mIndex] != 0; }
+  bool IsSleeping() { return mStorage->mSleeping[mIndex] != 0; }
 
-  void SetCollide(bool newCollide) { mCollide = newCollide; }
-  bool GetCollide() { return mCollide; }
+  void SetCollide(bool newCollide) { mStorage->mCollide[mIndex] = newCollide; }
+  bool GetCollide() { return mStorage->mCollide[mIndex] != 0; }
 
   // 点阻尼
-  void SetPointDamp(double newPointDamp) { mPointDamp = newPointDamp; }
-  double GetPointDamp() { return mPointDamp; }
+  void SetPointDamp(double newPointDamp) {
+    mStorage->mPointDamp[mIndex] = newPointDamp;
+  }
+  double GetPointDamp() { return mStorage->mPointDamp[mIndex]; }
 
   // 重力
-  void SetGravity(dtkT3<double> gravity) { mGravity = gravity; }
-  dtkT3<double> GetGravity() { return mGravity; }
+  void SetGravity(dtkT3<double> gravity) {
+    mStorage->mGravity[mIndex] = gravity;
+    mStorage->Disturb(mIndex);
+  }
+  dtkT3<double> GetGravity() { return mStorage->mGravity[mIndex]; }
 
   // the list of vector represent the mass point state in each iteration.
-  std::vector<dtkT3<double>> GetPosBuffer() { return mPosBuffers; }
-  std::vector<dtkT3<double>> GetVelBuffer() { return mVelBuffers; }
-  std::vector<dtkT3<double>> GetAccelBuffer() { return mAccelBuffers; }
+  std::vector<dtkT3<double>> GetPosBuffer() {
+    return GetBuffer(mStorage->mPosBuffers);
+  }
+  std::vector<dtkT3<double>> GetVelBuffer() {
+    return GetBuffer(mStorage->mVelBuffers);
+  }
+  std::vector<dtkT3<double>> GetAccelBuffer() {
+    return GetBuffer(mStorage->mAccelBuffers);
+  }
+
+  // 单次迭代的缓冲位置, 直接读存储, 不复制整个缓冲
+  const dtkT3<double> &GetPosBuffer(dtkID iteration) const {
+    return mStorage->mPosBuffers[iteration][mIndex];
+  }
 
   //		std::vector< dtkT3<double> > mPosBuffers;
   //      dtkT3<double> mImpulse;
 
-  void AddTwin(dtkPhysMassPoint *newTwin) { mTwins.push_back(newTwin); }
+  void AddTwin(dtkPhysMassPoint *newTwin) {
+    dtkPhysTwinCluster::Merge(this, newTwin);
+  }
 
-  void AbandonTwins() { mTwins.clear(); }
+  void AbandonTwins() {
+    if (mTwinCluster)
+      dtkPhysTwinCluster::Leave(this);
+  }
 
-  //      dtkPhysMassPoint* GetTwin()
-  //{
-  //	return mTwin;
-  //}
+  // 所在的 twins 簇, 没有 twin 时可能为空
+  dtkPhysTwinCluster *GetTwinCluster() { return mTwinCluster.get(); }
 
   bool HasTwin() {
-    if (mTwins.size() != 0)
-      return true;
-    else
-      return false;
+    return mTwinCluster && mTwinCluster->GetNumberOfMembers() > 1;
   }
 
-  dtkID GetLabel() { return mLabel; }
+  dtkID GetLabel() { return mStorage->mLabel[mIndex]; }
 
   void SetLabel(dtkID label) {
     // avoid using 0 as label
     assert(label != 0);
-    mLabel = label;
+    mStorage->mLabel[mIndex] = label;
   }
 
   // 停止
-  void ResetDynamicState() {
-    mVel = 0;
-    mAccel = 0;
-    for (dtkID i = 0; i < 3; i++) {
-      mVelBuffers[i] = 0;
-      mAccelBuffers[i] = 0;
-    }
-  }
+  void ResetDynamicState() { mStorage->ResetDynamicState(mIndex); }
 
 private:
-  dtkID mID;
-  // the position at the last iteration.
-  dtkPoints::Ptr mPts;
-
-  dtkT3<double> mVel;        /**< 质点速度 */
-  dtkT3<double> mAccel;      /**< 质点加速度 */
-  dtkT3<double> mForceAccum; /**< 合外力 */
-  dtkT3<double> mGravity;    /**< 重力 */
-  dtkT3<double> mResistance; /**< 阻力 */
-
-  // the position at the last iteration.
-  dtkT3<double> mPosLastFrame; /**< 上一帧位置 */
-  double mMass;                /**< 质量 */
-  double mResistCoef;          /**< 阻力系数 */
-  double mPointDamp;           /**< 阻尼 */
-
-  std::vector<dtkT3<double>> mVelBuffers;
-  std::vector<dtkT3<double>> mAccelBuffers;
-  std::vector<dtkT3<double>> mPosBuffers;
-
-  dtkT3<double> mForceDecorator; // 已有力
-
-  size_t mImpulseNum;     /**< 冲量数 */
-  dtkT3<double> mImpulse; /**< 冲量 */
-
-  bool mActive;  /**< 质点是否活动，速度是否为零 */
-  bool mCollide; /**< 是否发生碰撞 */
+  std::vector<dtkT3<double>>
+  GetBuffer(const std::vector<dtkT3<double>> (&buffers)[3]) const {
+    std::vector<dtkT3<double>> buffer(3);
+    for (dtkID i = 0; i < 3; i++)
+      buffer[i] = buffers[i][mIndex];
+    return buffer;
+  }
 
-  dtkID mLabel;
+private:
+  dtkPhysMassPointStorage::Ptr mStorage; /**< 质点状态存储 */
+  dtkID mIndex;                          /**< 质点在存储中的下标 */
+  dtkPhysTwinCluster::Ptr mTwinCluster;  /**< 所在的 twins 簇 */
 
-public:
-  // Test Feature
-  std::vector<dtkPhysMassPoint *> mTwins;
+  friend class dtkPhysTwinCluster;
 };
 } // namespace dtk
 
@@ -19,17 +19,22 @@
 
 #include <map>
 #include <memory>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #ifdef DTK_CL
 #include <CL/cl.h>
 #endif
 
+#include "dtkPhysImplicitSolver.h"
 #include "dtkPhysMassPoint.h"
+#include "dtkPhysPositionSolver.h"
 #include "dtkPhysSpring.h"
 #include "dtkPoints.h"
 #include "dtkPointsVector.h"
 #include "dtkStaticTriangleMesh.h"
+#include "dtkTaskScheduler.h"
 
 using namespace std;
 
@@ -50,6 +55,14 @@ public:
                                      defaultGravityAccel));
   }
 
+  // 单个对象内部弹簧力的累加方式
+  enum ForceMode {
+    SerialForce = 0, /**< 逐个弹簧顺序累加 */
+    ColoredForce,    /**< 按图着色分批, 同一批弹簧不共享质点 */
+    BufferedForce,   /**< 先写入每根弹簧的力缓冲, 再按质点归约 */
+    GatherForce      /**< 按质点的关联表直接计算并累加, 不经过弹簧力缓冲 */
+  };
+
 public:
   virtual ~dtkPhysMassSpring();
   dtkPhysMassSpring(double defaultMass, double defaultK, double defaultDamp,
@@ -75,16 +88,44 @@ public:
                   const double &damp = 0);
   void DeleteSpring(dtkID p1, dtkID p2);
 
+  /**
+   * @brief		删除弹簧, 最后一根弹簧移到它的位置
+   * @param[in]	spring : 弹簧, 指针在删除前一直有效, 可作为稳定的句柄
+   * @note	O(1), 弹簧下标会变化, 需要长期引用弹簧时保存指针或端点
+   */
+  void DeleteSpring(dtkPhysSpring *spring);
+
   void SetSpringStiffness(int id, double newK);
   void SetSpringDamp(int id, double newDamp);
   void SetPointMass(int id, double newMass);
 
+  /**
+   * @brief 一次切割等操作产生的全部修改
+   * @note 弹簧按端点指定, 不受删除引起的下标变化影响.
+   */
+  typedef struct {
+    std::vector<dtkID2> delete_springs; /**< 删除的弹簧 */
+    std::vector<std::pair<dtkID2, double>> spring_stiffness; /**< 新刚度 */
+    std::vector<std::pair<dtkID2, double>> spring_damp;      /**< 新阻尼 */
+    std::vector<std::pair<dtkID, double>> point_mass;        /**< 新质量 */
+  } EditBatch;
+
+  /**
+   * @brief		一遍应用一批修改
+   * @param[in]	edits : 修改集合, 先修改参数, 再删除弹簧
+   * @return 实际删除的弹簧数, 不存在的弹簧与质点被忽略
+   * @note	每次删除为 O(1), 拓扑相关的布局在下一次更新时只重建一次
+   */
+  size_t ApplyEdits(const EditBatch &edits);
+
   /**
    * @brief		更新弹簧及质点状态
    * @param[in]	timeslice : 更新时间间隔
    * @param[in]	method : 迭代更新算法
    * @param[in]	limitDeformation : 弹簧弹性限度
-   * @note			更新弹簧及质点状态
+   * @note
+   * 更新弹簧及质点状态. 只合并本对象更新时已累加的 twins 力,
+   * 与其他对象有 twins 时须用 UpdateConnected 或 dtkPhysCore 一起更新.
    * @return
    *	true update successfully \n
    *	false update failure \n
@@ -92,6 +133,23 @@ public:
   bool Update(double timeslice, ItrMethod method = Euler,
               bool limitDeformation = false);
 
+  /**
+   * @brief		一起更新由 twins 相连的多个质量弹簧
+   * @param[in]	massSprings : 簇内成员所在的全部对象
+   * @param[in]	timeslice : 更新时间间隔
+   * @param[in]	method : 迭代更新算法
+   * @param[in]	limitDeformation : 弹簧弹性限度
+   * @note
+   * 每次迭代在所有对象的 UpdateStrings 之后统一 ResolveTwinForces,
+   * 簇上的质点都按合外力积分. 不含碰撞响应, 冲量由调用者在迭代之间处理.
+   * @return
+   *	true update successfully \n
+   *	false update failure \n
+   */
+  static bool UpdateConnected(
+      const std::vector<dtkPhysMassSpring *> &massSprings, double timeslice,
+      ItrMethod method = Euler, bool limitDeformation = false);
+
   /**
    * @brief		单线程更新弹簧及质点状态
    * @param[in]	timeslice : 更新时间间隔
@@ -143,21 +201,77 @@ public:
   bool UpdateMassPoints(double timeslice, ItrMethod method = Euler,
                         dtkID iteration = 0);
 
+  /**
+   * @brief		隐式欧拉: 组装弹簧雅可比并求解速度增量
+   * @param[in]	timeslice : 时间间隔
+   * @note	在 UpdateStrings 之后, UpdateMassPoints 之前调用.
+   */
+  bool SolveImplicit(double timeslice);
+
+  // 隐式求解器, 可调整收敛阈值与最大迭代次数
+  dtkPhysImplicitSolver::Ptr GetImplicitSolver() {
+    if (!mImplicitSolver)
+      mImplicitSolver = dtkPhysImplicitSolver::New();
+    return mImplicitSolver;
+  }
+
+  /**
+   * @brief		XPBD: 预测位置后迭代投影弹簧与体积约束
+   * @param[in]	timeslice : 时间间隔
+   * @note	直接写回位置与速度, 不需要 UpdateStrings 与 UpdateMassPoints.
+   */
+  bool SolvePositions(double timeslice);
+
+  // 约束求解器, 可调整迭代次数与求解方式
+  dtkPhysPositionSolver::Ptr GetPositionSolver() {
+    if (!mPositionSolver)
+      mPositionSolver = dtkPhysPositionSolver::New();
+    return mPositionSolver;
+  }
+
   // 从三角网格添加质量弹簧
 
   void SetTriangleMesh(dtkStaticTriangleMesh::Ptr newTriangleMesh);
 
-  // 寻找周围距离小于distance的twins点.
-
-  size_t FindTwins(Ptr, double distance);
+  /**
+   * @brief		寻找周围距离小于distance的twins点
+   * @param[in]	ms : 另一个质量弹簧
+   * @param[in]	distance : 搜索距离
+   * @return 新建的 twins 对数
+   * @note
+   * 按质点顺序各自取最近的尚无 twin 的点, 距离相等时取下标小的.
+   * 用边长为 distance 的均匀网格查找, 查询可在调度器上并行.
+   */
+  size_t FindTwins(Ptr ms, double distance);
   void AbandonTwins();
 
+  /**
+   * @brief		合并本对象负责的 twins 簇上的合外力
+   * @note
+   * 每个簇由第一个成员所在的对象负责, 只合并一次.
+   * 须在簇内所有对象的 UpdateStrings 之后, UpdateMassPoints 之前调用.
+   */
+  void ResolveTwinForces();
+
+  /**
+   * @brief		合并本对象负责的 twins 簇上的冲量
+   * @note	须在碰撞响应之后, 簇内任何对象 ApplyImpulse 之前调用
+   */
+  void ResolveTwinImpulses();
+
   void RegisterLabel(dtkID label);
 
   void TransportForce(double timeslice);
 
-  const dtkT3<double> &GetTransportForce(dtkID label) {
-    return mTransportForces[label];
+  /**
+   * @brief 取设备的传递力, 未注册的设备返回零
+   * @note 只查找不插入, 多个设备任务可以同时调用.
+   */
+  const dtkT3<double> &GetTransportForce(dtkID label) const {
+    static const dtkT3<double> zero(0, 0, 0);
+    std::map<dtkID, dtkT3<double>>::const_iterator itr =
+        mTransportForces.find(label);
+    return itr != mTransportForces.end() ? itr->second : zero;
   }
 
   void ConvertImpulseToForce(double timeslice);
@@ -166,10 +280,94 @@ public:
 
   bool IsUnderControl() { return mUnderControl; }
 
-  void SetUnderControl(bool underControl) { mUnderControl = underControl; }
+  void SetUnderControl(bool underControl) {
+    mUnderControl = underControl;
+    if (underControl)
+      WakeUp();
+  }
+
+  /**
+   * @brief		开启按动能的自动休眠
+   * @param[in]	threshold : 区域内单位质量动能的阈值
+   * @param[in]	frames : 连续低于阈值的帧数, 达到后区域休眠
+   * @param[in]	regionSize : 每个区域的质点数, 按质点下标连续划分
+   * @note
+   * 休眠区域不计算弹簧力, 不积分. 冲量, 控制输入, 活动的相邻区域与
+   * 活动的 twins 会唤醒区域. 全部区域休眠时整个对象休眠.
+   */
+  void EnableSleeping(double threshold, size_t frames = 30,
+                      size_t regionSize = 256);
+  void DisableSleeping();
+  bool IsSleepingEnabled() const { return mSleepEnabled; }
+
+  /**
+   * @brief		按本帧各区域的动能更新休眠状态
+   * @note	每帧所有迭代结束后调用一次
+   */
+  void UpdateSleeping();
+
+  // 处理冲量, 控制输入等留下的唤醒请求
+  void WakeDisturbed();
+
+  // 唤醒全部区域
+  void WakeUp();
+
+  bool IsSleeping() const {
+    return mSleepEnabled && !mRegionSleeping.empty() &&
+           mNumberOfSleepingRegions == mRegionSleeping.size();
+  }
+  size_t GetNumberOfRegions() const { return mRegionSleeping.size(); }
+  size_t GetNumberOfSleepingRegions() const {
+    return mNumberOfSleepingRegions;
+  }
+
+  /**
+   * @brief		设置每个宏步内的子步数
+   * @param[in]	substeps : 子步数, 1 表示与宏步相同
+   * @note	由 dtkPhysCore::SetSubsteps 设置, 相连的对象取相同的值
+   */
+  void SetSubsteps(size_t substeps) {
+    mSubsteps = substeps > 0 ? substeps : 1;
+  }
+  size_t GetSubsteps() const { return mSubsteps; }
+
+  /**
+   * @brief		记录固定质点在本宏步的起点与目标位置
+   * @note	固定质点在宏步开始前被移动到目标位置, 子步中沿直线插值
+   */
+  void BeginSubsteps();
+
+  /**
+   * @brief		把固定质点放到第 substep 个子步结束时的位置
+   * @param[in]	substep : 子步序号, 从 1 开始, 等于子步数时为目标位置
+   */
+  void InterpolateBoundary(dtkID substep);
 
   dtkPhysSpring *GetSpringByPoints(dtkID2);
 
+  /**
+   * @brief		设置并行累加弹簧力使用的调度器
+   * @param[in]	scheduler : 任务调度器
+   * @note			只有在该调度器的工作线程中更新时才会并行
+   */
+  void SetTaskScheduler(dtkTaskScheduler::Ptr scheduler) {
+    mScheduler = scheduler;
+  }
+
+  void SetForceMode(ForceMode mode) { mForceMode = mode; }
+  ForceMode GetForceMode() const { return mForceMode; }
+
+  /**
+   * @brief		在调用线程上重新分配点集与力缓冲
+   * @note			绑核后在对象所属的工作线程上调用, 内存按首次写入落在本地节点
+   */
+  void FirstTouch();
+
+  // 每个子任务处理的弹簧或质点数, 总数不超过它时不拆分
+  void SetGrainSize(size_t grainSize) {
+    mGrainSize = grainSize > 0 ? grainSize : 1;
+  }
+
 #ifdef DTK_CL
   /**
    * OpenCL related initialisations.
@@ -198,12 +396,14 @@ public:
 
 protected:
   dtkPoints::Ptr mPts;                         /**< 点集 */
+  dtkPhysMassPointStorage::Ptr mStorage;       /**< 质点状态数组 */
   std::vector<dtkPhysMassPoint *> mMassPoints; /**< 质点集 */
+  dtkPhysSpringStorage::Ptr mSpringStorage;    /**< 弹簧参数数组 */
   std::vector<dtkPhysSpring *> mSprings;       /**< 弹簧 */
 
   // 边集
-  std::map<dtkID2, dtkPhysSpring *>
-      mEdgeMap; /**< map from spring specified by dtkID2 to spring id */
+  std::unordered_map<dtkID2, dtkPhysSpring *, dtkID2Hash>
+      mEdgeMap; /**< map from spring specified by dtkID2 to spring */
 
   double mDefaultMass;             /**< 质量 */
   double mDefaultStiff;            /**< 弹簧刚性系数，弹性系数 */
@@ -214,11 +414,106 @@ protected:
 
   bool mUnderControl; /**< 弹簧受控 */
 
+  size_t mSubsteps;                            /**< 每个宏步的子步数 */
+  std::vector<dtkID> mBoundaryPoints;          /**< 本宏步的固定质点 */
+  std::vector<dtkT3<double>> mBoundaryStarts;  /**< 固定质点的起点 */
+  std::vector<dtkT3<double>> mBoundaryTargets; /**< 固定质点的目标位置 */
+
+  // 本对象负责的 twins 簇, 簇结构的版本变化后重建
+  void BuildTwinClusters();
+  std::vector<dtkPhysTwinCluster *> mTwinClusters; /**< 负责的 twins 簇 */
+  size_t mTwinGeneration; /**< mTwinClusters 对应的簇结构版本 */
+
   std::vector<dtkID> mLabels; // 标记点集, 可给予Transport力
 
   std::map<dtkID, dtkT3<double>> mTransportForces; //
   dtkT3<double> mImpulseForce;                     // 瞬时力
 
+  /**
+   * @brief		向约束求解器提供体积约束, 拓扑改变后的下一帧调用
+   * @param[in]	solver : 约束求解器
+   * @note	默认没有体积约束, 四面体网格重写.
+   */
+  virtual void CollectVolumes(dtkPhysPositionSolver &solver);
+
+  bool mPositionLayoutDirty; /**< 拓扑改变后需要重建约束着色 */
+
+private:
+  // 从弹簧表, 边索引与参数存储中移除弹簧, 不检查是否存在
+  void RemoveSpring(dtkPhysSpring *spring);
+
+  bool IsParallelForce(size_t count) const;
+  void BuildForceLayout();
+  // 按 mGrainSize 分块交给调度器, body 以 (begin, end) 调用
+  template <typename Function>
+  void ForkJoinRange(size_t count, const Function &body) {
+    mScheduler->ForkJoinRange(count, mGrainSize, body);
+  }
+  void _UpdateColoredSprings(const std::vector<dtkID> *batch, dtkID begin,
+                             dtkID end, double timeslice, ItrMethod method,
+                             dtkID iteration, bool limitDeformation);
+  void ResizeForceBuffers();
+  void _StageMassPoints(dtkID begin, dtkID end, ItrMethod method,
+                        dtkID iteration);
+  void _ComputeSpringForces(dtkID begin, dtkID end, double timeslice);
+  void _GatherSpringForces(dtkID begin, dtkID end);
+  void _GatherIncidentForces(dtkID begin, dtkID end, double timeslice);
+  void _UpdateMassPointRange(dtkID begin, dtkID end, double timeslice,
+                             ItrMethod method, dtkID iteration);
+  void _ComputeAwakeSpringForces(dtkID begin, dtkID end, double timeslice);
+
+  void BuildSleepLayout();
+  void BuildAwakeRuns();
+  void SleepRegion(dtkID region);
+  void WakeRegion(dtkID region);
+
+  /**
+   * @brief		依次取出 [begin, end) 与活动区间的交集
+   * @param[in]	runs : 活动区间, 起止成对存放
+   * @param[in,out]	cursor : 游标, 第一次调用前置 0
+   * @param[out]	first, last : 交集
+   * @return 没有更多交集时为 false
+   * @note 没有休眠区域时直接返回整段
+   */
+  bool NextAwakeRange(const std::vector<dtkID> &runs, dtkID begin, dtkID end,
+                      dtkID &cursor, dtkID &first, dtkID &last) const;
+
+  dtkTaskScheduler::Ptr mScheduler; /**< 并行累加力的调度器 */
+  ForceMode mForceMode;             /**< 弹簧力的累加方式 */
+  size_t mGrainSize;                /**< 每个子任务处理的元素数 */
+
+  bool mForceLayoutDirty; /**< 拓扑改变后需要重建着色与关联表 */
+
+  bool mImplicitLayoutDirty; /**< 拓扑改变后需要重建矩阵结构 */
+  dtkPhysImplicitSolver::Ptr mImplicitSolver; /**< 隐式欧拉求解器 */
+  dtkPhysPositionSolver::Ptr mPositionSolver; /**< XPBD 约束求解器 */
+
+  std::vector<std::vector<dtkID>> mSpringColors; /**< 每种颜色的弹簧 */
+  std::vector<dtkReal> mSpringForces[3]; /**< 每根弹簧的力, 按分量存放 */
+  std::vector<dtkReal> mStagePos[3]; /**< 本次迭代的质点位置, 按分量存放 */
+  std::vector<dtkReal> mStageVel[3]; /**< 本次迭代的质点速度, 按分量存放 */
+  std::vector<dtkID> mIncidentOffsets; /**< 质点关联弹簧的起始位置 */
+  std::vector<dtkID> mIncidentSprings; /**< 弹簧id * 2 + 端点序号 */
+  std::vector<dtkID> mIncidentNeighbors; /**< 关联弹簧另一端的质点 */
+
+  bool mSleepEnabled;                   /**< 是否自动休眠 */
+  double mSleepThreshold;               /**< 单位质量动能的阈值 */
+  size_t mSleepFrames;                  /**< 休眠前需要连续平静的帧数 */
+  size_t mSleepRegionSize;              /**< 每个区域的质点数 */
+  bool mSleepLayoutDirty;               /**< 拓扑改变后需要重新划分区域 */
+  bool mAwakeRunsDirty;                 /**< 休眠区域改变后需要重建活动区间 */
+  bool mStageSleeping;                  /**< 休眠质点的暂存状态需要刷新 */
+  size_t mNumberOfSleepingRegions;      /**< 休眠的区域数 */
+  std::vector<char> mRegionSleeping;    /**< 区域是否休眠 */
+  std::vector<char> mRegionRestless;    /**< 本帧动能超过阈值的区域 */
+  std::vector<dtkID> mRegionCalmFrames; /**< 区域连续平静的帧数 */
+  std::vector<dtkID> mRegionOffsets;    /**< 区域邻接表的起始位置 */
+  std::vector<dtkID> mRegionNeighbors;  /**< 由弹簧相连的区域 */
+  std::vector<dtkID> mAwakePointRuns;   /**< 活动质点的连续区间 */
+  std::vector<dtkID> mAwakeSpringRuns;  /**< 至少一端活动的弹簧区间 */
+
+protected:
+
 #ifdef DTK_CL
   bool mUseMultiThread;
   // OpenCL
@@ -43,11 +43,10 @@ public:
 public:
   ~dtkPhysMassSpringCollisionResponse();
 
-  void
-  Update(double timeslice,
-         std::vector<dtkIntersectTest::IntersectResult::Ptr> &intersectResults,
-         const std::vector<dtkInterval<int>> &avoid_1,
-         const std::vector<dtkInterval<int>> &avoid_2, double stiffness);
+  void Update(double timeslice,
+              dtkIntersectTest::IntersectResultView intersectResults,
+              const std::vector<dtkInterval<int>> &avoid_1,
+              const std::vector<dtkInterval<int>> &avoid_2, double stiffness);
 
   void AddPierceSegment(dtkID majorID, dtkID minorID) {
     mPierceSegments.push_back(dtkID2(majorID, minorID));
@@ -64,7 +63,7 @@ public:
     return mMassSprings[majorID];
   }
 
-  std::vector<dtkIntersectTest::IntersectResult::Ptr> &GetPiercingResults() {
+  std::vector<dtkIntersectTest::IntersectResult> &GetPiercingResults() {
     return mPiercingResults;
   }
 
@@ -76,7 +75,7 @@ private:
 
   std::vector<dtkID2> mPierceSegments;
 
-  std::vector<dtkIntersectTest::IntersectResult::Ptr> mPiercingResults;
+  std::vector<dtkIntersectTest::IntersectResult> mPiercingResults;
 };
 } // namespace dtk
 
@@ -34,17 +34,18 @@ public:
     int segmentID;
   };
 
-  enum PiercedResultType {
-    PIERCED_PRIMITIVE_1,
-    PIERCED_PRIMITIVE_2,
-    PIERCED_WEIGHT_1,
-    PIERCED_WEIGHT_2,
-    PIERCED_SEGMENTID,
-    PIERCED_SURFACE,
-    PIERCED_VALID
-  };
-
-  typedef dtkProperty<PiercedResultType> PiercedResult;
+  /**
+   * @brief 线穿过表面后保持的穿刺记录
+   */
+  typedef struct {
+    dtkCollisionDetectPrimitive *primitive_1; /**< 被穿过的三角形 */
+    dtkCollisionDetectPrimitive *primitive_2; /**< 穿过的线段 */
+    dtkDouble3 weight_1; /**< 穿刺点在三角形上的重心坐标 */
+    dtkDouble2 weight_2; /**< 穿刺点在所在线段上的权重 */
+    int segment_id;      /**< 穿刺点所在的线段 */
+    bool surface;        /**< 表面穿刺, 否则为内部穿刺 */
+    bool valid;          /**< 滑出线的两端后置为 false 并删除 */
+  } PiercedResult;
 
   typedef std::shared_ptr<dtkPhysMassSpringThreadCollisionResponse> Ptr;
 
@@ -68,8 +69,7 @@ public:
   ~dtkPhysMassSpringThreadCollisionResponse();
 
   void Update(double timeslice,
-              std::vector<dtkIntersectTest::IntersectResult::Ptr>
-                  &internalPiercingResults);
+              dtkIntersectTest::IntersectResultView internalPiercingResults);
 
   void PostProcess(double range);
 
@@ -78,7 +78,7 @@ public:
 
     mThreadHeadInsides[i] = false;
     mNumerOfSurfacePiercedResults[i] = 0;
-    mPiercedResults[i] = std::vector<PiercedResult::Ptr>();
+    mPiercedResults[i] = std::vector<PiercedResult>();
     mAvoidIntervals[i] = std::vector<dtkInterval<int>>();
     mInternalIntervals[i] = std::vector<dtkInterval<int>>();
 
@@ -116,7 +116,7 @@ private:
 
   std::map<dtkID, int> mNumerOfSurfacePiercedResults;
 
-  std::map<dtkID, std::vector<PiercedResult::Ptr>> mPiercedResults;
+  std::map<dtkID, std::vector<PiercedResult>> mPiercedResults;
 
   std::map<dtkID, std::vector<dtkInterval<int>>> mAvoidIntervals;
 
@@ -0,0 +1,153 @@
+
+/**
+ * @file dtkPhysPositionSolver.h
+ * @brief dtkPhysPositionSolver 头文件
+ * @author agent (agent@local)
+ * @version 1.0
+ * @date 2026-10-16
+ * @copyright MIT LICENSE
+ * https://github.com/Simple-XX/SimplePhysicsEngine
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-16<td>agent<td>创建文件
+ * </table>
+ */
+
+#ifndef SIMPLEPHYSICSENGINE_DTKPHYSPOSITIONSOLVER_H
+#define SIMPLEPHYSICSENGINE_DTKPHYSPOSITIONSOLVER_H
+
+#include <memory>
+#include <vector>
+
+#include <boost/utility.hpp>
+
+#include "dtkIDTypes.h"
+#include "dtkPhysMassPoint.h"
+#include "dtkPhysSpring.h"
+#include "dtkTaskScheduler.h"
+
+namespace dtk {
+/**
+ * @class <dtkPhysPositionSolver>
+ * @brief 基于位置的约束求解器 (XPBD)
+ * @author <>
+ * @note
+ * 弹簧作为距离约束, 柔度为 原长 / 刚度, 刚度为 0 的弹簧不参与求解.
+ * 四面体作为体积约束, 柔度由 SetVolumeCompliance 指定.
+ * 每帧先用外力预测位置, 再迭代固定次数投影约束, 最后由位移求速度.
+ * 图着色 Gauss-Seidel 同色约束之间没有公共质点, 可以并行投影.
+ * Jacobi 每次迭代先计算全部约束的修正量, 再按质点平均累加.
+ * 迭代次数固定, 计算量与形变大小无关, 任何时间步长下都不会发散.
+ */
+class dtkPhysPositionSolver : public boost::noncopyable {
+public:
+  typedef std::shared_ptr<dtkPhysPositionSolver> Ptr;
+
+  enum SolveMode {
+    ColoredSolve = 0, /**< 图着色 Gauss-Seidel */
+    JacobiSolve       /**< Jacobi */
+  };
+
+  static Ptr New() { return Ptr(new dtkPhysPositionSolver()); }
+
+public:
+  void ClearVolumes();
+
+  /**
+   * @brief		添加体积约束
+   * @param[in]	ids : 四个质点的下标
+   * @param[in]	restVolume : 有向的静止体积
+   */
+  void AddVolume(const dtkID4 &ids, double restVolume);
+
+  size_t GetNumberOfVolumes() const { return mVolumeRest.size(); }
+
+  /**
+   * @brief		按弹簧与体积约束建立着色与关联表
+   * @param[in]	numberOfPoints : 质点数
+   * @param[in]	springs : 弹簧参数, 端点下标决定距离约束
+   */
+  void BuildStructure(size_t numberOfPoints,
+                      const dtkPhysSpringStorage &springs);
+
+  /**
+   * @brief		推进一帧
+   * @param[in]	points : 质点状态, 外力取自 mForceAccum
+   * @param[in]	springs : 弹簧参数
+   * @param[in]	timeslice : 时间间隔
+   * @param[in]	scheduler : 非空时分块并行
+   * @param[in]	grainSize : 每个子任务处理的约束或质点数
+   * @note 写回位置, 速度与加速度, 并清空合外力
+   */
+  void Solve(dtkPhysMassPointStorage &points,
+             const dtkPhysSpringStorage &springs, double timeslice,
+             dtkTaskScheduler *scheduler, size_t grainSize);
+
+  void SetSolveMode(SolveMode mode) { mSolveMode = mode; }
+  SolveMode GetSolveMode() const { return mSolveMode; }
+
+  // 每帧的约束迭代次数
+  void SetIterations(size_t iterations) { mIterations = iterations; }
+  size_t GetIterations() const { return mIterations; }
+
+  // 体积约束的柔度, 0 表示不可压缩
+  void SetVolumeCompliance(double compliance) {
+    mVolumeCompliance = compliance;
+  }
+  double GetVolumeCompliance() const { return mVolumeCompliance; }
+
+  // Jacobi 的松弛系数, 乘在平均后的修正量上
+  void SetRelaxation(double relaxation) { mRelaxation = relaxation; }
+  double GetRelaxation() const { return mRelaxation; }
+
+private:
+  dtkPhysPositionSolver();
+
+  template <typename Function>
+  void ForEachRange(size_t count, const Function &body);
+
+  /**
+   * @brief		投影一个约束
+   * @param[in]	constraint : 约束id, 小于弹簧数时为距离约束
+   * @param[out]	deltas : 非空时只写入修正量, 否则直接修改位置
+   */
+  void Project(dtkID constraint, double *deltas);
+
+  void _Predict(dtkID begin, dtkID end);
+  void _SolveColor(const std::vector<dtkID> *color, dtkID begin, dtkID end);
+  void _SolveJacobi(dtkID begin, dtkID end);
+  void _GatherJacobi(dtkID begin, dtkID end);
+  void _Finish(dtkID begin, dtkID end);
+
+private:
+  std::vector<dtkID> mVolumeIDs;    /**< 每个体积约束的四个质点 */
+  std::vector<double> mVolumeRest;  /**< 静止体积 */
+  std::vector<dtkID> mSlotOffsets;  /**< 每个约束第一个端点的位置 */
+  std::vector<dtkID> mSlotPoints;   /**< 约束端点对应的质点 */
+  std::vector<dtkID> mPointOffsets; /**< 每个质点第一个关联端点的位置 */
+  std::vector<dtkID> mPointSlots;   /**< 质点关联的约束端点 */
+
+  std::vector<std::vector<dtkID>> mColors; /**< 每种颜色的约束 */
+
+  std::vector<dtkT3<double>> mX;  /**< 预测位置 */
+  std::vector<dtkT3<double>> mX0; /**< 本帧起始位置 */
+  std::vector<double> mInvMass;   /**< 质量的倒数, 固定质点为 0 */
+  std::vector<double> mLambda;    /**< 每个约束累计的拉格朗日乘子 */
+  std::vector<double> mDeltas;    /**< Jacobi 中每个端点的修正量 */
+
+  // 本次 Solve 的输入
+  dtkPhysMassPointStorage *mPoints;
+  const dtkPhysSpringStorage *mSprings;
+  double mTimeslice;
+  dtkTaskScheduler *mScheduler;
+  size_t mGrainSize;
+
+  SolveMode mSolveMode;     /**< 求解方式 */
+  size_t mIterations;       /**< 每帧的迭代次数 */
+  double mVolumeCompliance; /**< 体积约束的柔度 */
+  double mRelaxation;       /**< Jacobi 的松弛系数 */
+};
+} // namespace dtk
+
+#endif /* SIMPLEPHYSICSENGINE_DTKPHYSPOSITIONSOLVER_H */
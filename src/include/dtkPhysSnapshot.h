@@ -0,0 +1,101 @@
+
+/**
+ * @file dtkPhysSnapshot.h
+ * @brief dtkPhysSnapshot 头文件
+ * @author agent (agent@local)
+ * @version 1.0
+ * @date 2026-10-16
+ * @copyright MIT LICENSE
+ * https://github.com/Simple-XX/SimplePhysicsEngine
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-16<td>agent<td>创建文件
+ * </table>
+ */
+
+#ifndef SIMPLEPHYSICSENGINE_DTKPHYSSNAPSHOT_H
+#define SIMPLEPHYSICSENGINE_DTKPHYSSNAPSHOT_H
+
+#include <map>
+#include <memory>
+
+#include <boost/utility.hpp>
+
+#include "dtkConfig.h"
+#include "dtkIDTypes.h"
+#include "dtkPoints.h"
+
+namespace dtk {
+/**
+ * @class <dtkPhysSnapshot>
+ * @brief 一帧结束时所有点集的只读快照
+ * @author <>
+ * @note
+ * 由 dtkPhysCore 在流水线模式下填写并整体发布, 发布后不再修改.
+ * 读者持有 ConstPtr 期间快照不会被复用, 因此读取无需加锁.
+ */
+class dtkPhysSnapshot : public boost::noncopyable {
+public:
+  typedef std::shared_ptr<dtkPhysSnapshot> Ptr;
+
+  typedef std::shared_ptr<const dtkPhysSnapshot> ConstPtr;
+
+  static Ptr New() { return Ptr(new dtkPhysSnapshot()); }
+
+public:
+  /**
+   * @brief 快照对应的帧号
+   */
+  inline size_t GetFrame() const { return mFrame; }
+
+  /**
+   * @brief 质量弹簧的点集
+   * @param[in]	id : 质量弹簧id
+   * @return 点集, 快照中没有该对象时返回 0
+   */
+  const dtkPoints *GetPoints(dtkID id) const;
+
+  /**
+   * @brief 平滑后的缝合线点集
+   * @param[in]	id : 缝合线id
+   * @return 点集, 快照中没有该对象时返回 0
+   */
+  const dtkPoints *GetThreadPoints(dtkID id) const;
+
+  /**
+   * @brief 开始填写新的一帧, 之后用 Acquire 取得目标点集
+   * @param[in]	frame : 帧号
+   */
+  void BeginFrame(size_t frame);
+
+  /**
+   * @brief 取得本帧要写入的点集, 大小不变时复用上次的存储
+   * @param[in]	id : 对象id
+   * @param[in]	thread : 是否为缝合线的平滑点集
+   * @param[in]	size : 点数
+   * @return 要写入的点集
+   */
+  dtkPointsVector *Acquire(dtkID id, bool thread, size_t size);
+
+  /**
+   * @brief 结束填写, 删除本帧没有 Acquire 的对象
+   */
+  void EndFrame();
+
+private:
+  dtkPhysSnapshot() : mFrame(0) {}
+
+  struct Entry {
+    dtkPointsVector::Ptr points; /**< 点集存储 */
+    bool used;                   /**< 本帧是否写入 */
+  };
+
+  size_t mFrame; /**< 帧号 */
+
+  std::map<dtkID, Entry> mPoints;       /**< 质量弹簧的点集 */
+  std::map<dtkID, Entry> mThreadPoints; /**< 缝合线的平滑点集 */
+};
+} // namespace dtk
+
+#endif /* SIMPLEPHYSICSENGINE_DTKPHYSSNAPSHOT_H */
@@ -17,26 +17,170 @@
 #ifndef SIMPLEPHYSICSENGINE_DTKPHYSSPRING_H
 #define SIMPLEPHYSICSENGINE_DTKPHYSSPRING_H
 
+#include <memory>
+#include <vector>
+
+#include <boost/utility.hpp>
+
 #include "dtkIDTypes.h"
 #include "dtkPhysMassPoint.h"
+#include "dtkPrecision.h"
 
 namespace dtk {
+/**
+ * @class <dtkPhysSpringKernel>
+ * @brief 弹簧力内核的选择
+ * @author <>
+ * @note
+ * 内核在运行时按处理器支持的指令集选择 AVX-512, AVX2 或标量实现,
+ * 所有精度的弹簧存储共用同一个选择.
+ */
+class dtkPhysSpringKernel {
+public:
+  enum SpringKernel {
+    ScalarKernel = 0, /**< 逐根计算 */
+    AVX2Kernel,       /**< 一次计算 4 根 */
+    AVX512Kernel      /**< 一次计算 8 根 */
+  };
+
+  /**
+   * @brief		当前使用的内核
+   */
+  static SpringKernel GetSpringKernel();
+
+  /**
+   * @brief		指定内核, 处理器不支持时退回到支持的最宽内核
+   * @return 实际使用的内核
+   */
+  static SpringKernel SetSpringKernel(SpringKernel kernel);
+
+  /**
+   * @brief		处理器支持的最宽内核
+   */
+  static SpringKernel GetSupportedSpringKernel();
+};
+
+/**
+ * @class <dtkPhysSpringStorageT>
+ * @brief 弹簧参数的结构数组存储
+ * @author <>
+ * @note
+ * 端点下标, 原长, 刚度与阻尼按字段连续存放, 弹簧力由批量内核一次计算多根.
+ * 端点下标指向所属质量弹簧的 dtkPhysMassPointStorage.
+ * 参数与内核的输入输出按 Precision::Storage 存放, 内核读入后提升为 double
+ * 计算, 按质点的汇总也用 double 累加.
+ * 实现中显式实例化了 dtkDoublePrecision 与 dtkMixedPrecision.
+ */
+template <typename Precision>
+class dtkPhysSpringStorageT : public dtkPhysSpringKernel,
+                              public boost::noncopyable {
+public:
+  typedef std::shared_ptr<dtkPhysSpringStorageT> Ptr;
+  typedef typename Precision::Storage Real;
+
+  static Ptr New() { return Ptr(new dtkPhysSpringStorageT()); }
+
+public:
+  /**
+   * @brief		添加弹簧
+   * @param[in]	first : 第一个端点在质点存储中的下标
+   * @param[in]	second : 第二个端点在质点存储中的下标
+   * @return 弹簧在存储中的下标
+   */
+  dtkID AddSpring(dtkID first, dtkID second, double oriLength, double stiff,
+                  double damp);
+
+  /**
+   * @brief		删除弹簧, 最后一根弹簧移到 index
+   */
+  void RemoveSpring(dtkID index);
+
+  size_t GetNumberOfSprings() const { return mOriLength.size(); }
+
+  /**
+   * @brief		批量计算一段弹簧作用在第二个端点上的力
+   * @param[in]	begin : 起始下标
+   * @param[in]	end : 结束下标, 不包含
+   * @param[in]	pos : 质点位置的 x, y, z 分量数组
+   * @param[in]	vel : 质点速度的 x, y, z 分量数组
+   * @param[in]	timeslice : 时间间隔
+   * @param[out]	force : 每根弹簧的力的 x, y, z 分量数组
+   * @note 与 dtkPhysSpring::ComputeForce 公式相同, 第一个端点受反向的力
+   */
+  void ComputeForces(dtkID begin, dtkID end, const Real *const pos[3],
+                     const Real *const vel[3], double timeslice,
+                     Real *const force[3]) const;
+
+  /**
+   * @brief		按质点的关联表汇总一段质点受到的弹簧力
+   * @param[in]	begin : 起始质点下标
+   * @param[in]	end : 结束质点下标, 不包含
+   * @param[in]	offsets : 每个质点第一个关联弹簧的位置, 共质点数 + 1 个
+   * @param[in]	neighbors : 每个关联弹簧另一端的质点
+   * @param[in]	slots : 每个关联弹簧的 弹簧id * 2 + 端点序号
+   * @param[in]	pos : 质点位置的 x, y, z 分量数组
+   * @param[in]	vel : 质点速度的 x, y, z 分量数组
+   * @param[in]	timeslice : 时间间隔
+   * @param[out]	force : 质点 begin + j 的合力写入第 j 个元素
+   * @note 每根弹簧在两个端点各算一次, 质点只写自己的结果, 可以分段并行.
+   * 关联弹簧通常不足 8 根, AVX-512 内核同样一次计算 4 根.
+   */
+  void GatherForces(dtkID begin, dtkID end, const dtkID *offsets,
+                    const dtkID *neighbors, const dtkID *slots,
+                    const Real *const pos[3], const Real *const vel[3],
+                    double timeslice, double *const force[3]) const;
+
+private:
+  dtkPhysSpringStorageT() {}
+
+public:
+  std::vector<dtkID> mEnds;     /**< 每根弹簧两个端点的下标 */
+  std::vector<Real> mOriLength; /**< 原长 */
+  std::vector<Real> mStiffness; /**< 刚度 */
+  std::vector<Real> mDamp;      /**< 阻尼 */
+};
+
+// 按 DTK_MIXED_PRECISION 选择精度的弹簧存储
+typedef dtkPhysSpringStorageT<dtkPhysPrecision> dtkPhysSpringStorage;
+
+/**
+ * @class <dtkPhysSpring>
+ * @brief 弹簧
+ * @author <>
+ * @note
+ * 弹簧参数保存在 dtkPhysSpringStorage 中, 本类只是代理.
+ */
 class dtkPhysSpring {
 public:
   dtkPhysSpring(dtkPhysMassPoint *p1, dtkPhysMassPoint *p2,
                 const double &stiff = 5, const double &damp = 0);
 
+  // 代理存储中已有的弹簧
+  dtkPhysSpring(dtkPhysSpringStorage::Ptr storage, dtkID index,
+                dtkPhysMassPoint *p1, dtkPhysMassPoint *p2);
+
   dtkPhysMassPoint *GetFirstVertex() { return mVerteces[0]; }
   dtkPhysMassPoint *GetSecondVertex() { return mVerteces[1]; }
 
   // 更新力到质点,迭代更新
   bool Update(double timeslice, ItrMethod method = Euler, dtkID iteration = 0,
               bool limitDeformation = false);
-  void SetStiffness(double newStiffness) { mStiffness = newStiffness; }
-  void SetDamp(double newDamp) { mDamp = newDamp; }
-  double GetOriLength() { return mOriLength; }
-  double GetStiffness() { return mStiffness; }
-  double GetDamp() { return mDamp; }
+
+  // 只计算作用在第二个质点上的弹簧力, 第一个质点受反向的力, 不写入质点
+  dtkT3<double> ComputeForce(double timeslice, ItrMethod method = Euler,
+                             dtkID iteration = 0,
+                             bool limitDeformation = false);
+  void SetStiffness(double newStiffness) {
+    mStorage->mStiffness[mIndex] = newStiffness;
+  }
+  void SetDamp(double newDamp) { mStorage->mDamp[mIndex] = newDamp; }
+  double GetOriLength() { return mStorage->mOriLength[mIndex]; }
+  double GetStiffness() { return mStorage->mStiffness[mIndex]; }
+  double GetDamp() { return mStorage->mDamp[mIndex]; }
+
+  // 弹簧在存储中的下标, 存储删除弹簧后由所属质量弹簧修正
+  dtkID GetIndex() const { return mIndex; }
+  void SetIndex(dtkID index) { mIndex = index; }
 
 public:
   virtual ~dtkPhysSpring();
@@ -44,9 +188,8 @@ public:
 private:
   dtkPhysMassPoint *mVerteces[2]; /**< 弹簧两个质点 */
 
-  double mOriLength; /**< 长度 */
-  double mStiffness; /**< 刚度 */
-  double mDamp;      /**<  阻尼 */
+  dtkPhysSpringStorage::Ptr mStorage; /**< 参数存储 */
+  dtkID mIndex;                       /**< 在存储中的下标 */
 };
 } // namespace dtk
 
@@ -81,6 +81,9 @@ protected:
                          double defaultPointResistence = 2.5,
                          dtkDouble3 defaultGravityAccel = dtkDouble3(0, 0, 0));
 
+  // 每个有效四面体添加一个体积约束, 静止体积取自原始点集
+  void CollectVolumes(dtkPhysPositionSolver &solver);
+
 protected:
   // 四面体网格
 
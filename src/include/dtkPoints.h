@@ -48,9 +48,13 @@ public:
 
   virtual void InsertPoint(dtkID id, const GK::Point3 &coord) = 0;
   virtual void DeletePoint(dtkID id) = 0;
+
+  // 在调用线程上重新分配存储, 使内存按首次写入落在该线程的 NUMA 节点
+  virtual void Relocate() {}
 };
 } // namespace dtk
 
+#include "dtkPointsAligned.h"
 #include "dtkPointsVector.h"
 
 #endif /* SIMPLEPHYSICSENGINE_DTKPOINTS_H */
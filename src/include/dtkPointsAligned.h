@@ -0,0 +1,182 @@
+
+/**
+ * @file dtkPointsAligned.h
+ * @brief  dtkPointsAligned 头文件
+ * @author agent (agent@local)
+ * @version 1.0
+ * @date 2026-10-16
+ * @copyright MIT LICENSE
+ * https://github.com/Simple-XX/SimplePhysicsEngine
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-16<td>agent<td>创建文件
+ * </table>
+ */
+
+#ifndef SIMPLEPHYSICSENGINE_DTKPOINTSALIGNED_H
+#define SIMPLEPHYSICSENGINE_DTKPOINTSALIGNED_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <boost/align/aligned_allocator.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "dtkConfig.h"
+#include "dtkPoints.h"
+
+namespace dtk {
+/**
+ * @class <dtkPointsAligned>
+ * @brief 按 32 字节对齐的双精度点集
+ * @author <>
+ * @note
+ * 每个点占 4 个 double (x, y, z, 0), 积分内核通过非虚的 GetCoord/SetCoord
+ * 直接读写, 不经过 GK::Point3 转换.
+ * GetPoint 仍需返回引用, 因此另存一份 GK::Point3, 只在写入后第一次
+ * GetPoint 或 Begin 时整体刷新, 积分时只写对齐数组.
+ */
+class dtkPointsAligned : public dtkPoints {
+public:
+  typedef std::shared_ptr<dtkPointsAligned> Ptr;
+
+  static dtkPointsAligned::Ptr New() {
+    return dtkPointsAligned::Ptr(new dtkPointsAligned());
+  }
+
+  static dtkPointsAligned::Ptr New(size_t size) {
+    return dtkPointsAligned::Ptr(new dtkPointsAligned(size));
+  }
+
+  static dtkPointsAligned::Ptr New(const std::vector<GK::Point3> &coords) {
+    return dtkPointsAligned::Ptr(new dtkPointsAligned(coords));
+  }
+
+public:
+  inline const GK::Point3 &GetPoint(dtkID id) const {
+    if (mPointsDirty.load(std::memory_order_acquire))
+      SyncPoints();
+    return mPoints[id];
+  }
+
+  inline bool SetPoint(dtkID id, const GK::Point3 &coord) {
+    if (id >= mPoints.size())
+      Resize(id + 1);
+    SetCoord(id, coord.x(), coord.y(), coord.z());
+    return true;
+  }
+
+  /**
+   * @brief		点的坐标, 不检查越界
+   * @return 指向 x, y, z 的指针, 按 32 字节对齐
+   */
+  inline const double *GetCoord(dtkID id) const { return &mCoords[id * 4]; }
+
+  /**
+   * @brief		修改点的坐标, 不检查越界
+   */
+  inline void SetCoord(dtkID id, double x, double y, double z) {
+    double *coord = &mCoords[id * 4];
+    coord[0] = x;
+    coord[1] = y;
+    coord[2] = z;
+    // 先读后写, 已标记时不再写共享的标志.
+    if (!mPointsDirty.load(std::memory_order_relaxed))
+      mPointsDirty.store(true, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief		按对齐数组刷新 GetPoint 返回的坐标
+   * @note	可与其他读者并发调用, 不能与写入并发.
+   */
+  void SyncPoints() const {
+    boost::unique_lock<boost::mutex> lock(mSyncMutex);
+    if (!mPointsDirty.load(std::memory_order_relaxed))
+      return;
+    for (dtkID i = 0; i < mPoints.size(); i++)
+      mPoints[i] = GK::Point3(mCoords[i * 4], mCoords[i * 4 + 1],
+                              mCoords[i * 4 + 2]);
+    mPointsDirty.store(false, std::memory_order_release);
+  }
+
+  inline void InsertPoint(dtkID id, const GK::Point3 &coord) {
+    dtkAssert(id <= mPoints.size());
+    SyncPoints();
+    const double c[4] = {coord.x(), coord.y(), coord.z(), 0};
+    mCoords.insert(mCoords.begin() + id * 4, c, c + 4);
+    mPoints.insert(mPoints.begin() + id, coord);
+  }
+
+  inline void DeletePoint(dtkID id) {
+    dtkAssert(id < mPoints.size());
+    SyncPoints();
+    mCoords.erase(mCoords.begin() + id * 4, mCoords.begin() + id * 4 + 4);
+    mPoints.erase(mPoints.begin() + id);
+  }
+
+  void Relocate() {
+    SyncPoints();
+    CoordVector(mCoords).swap(mCoords);
+    std::vector<GK::Point3>(mPoints).swap(mPoints);
+  }
+
+  size_t GetNumberOfPoints() const { return mPoints.size(); }
+
+  dtkID GetMaxID() const { return static_cast<dtkID>(mPoints.size() - 1); }
+
+  void Begin() const {
+    SyncPoints();
+    mCurPos = 0;
+  }
+
+  bool Next(dtkID &id, GK::Point3 &coord) const {
+    bool retVal = false;
+
+    if (mCurPos < mPoints.size()) {
+      id = static_cast<dtkID>(mCurPos);
+      coord = mPoints[mCurPos++];
+      retVal = true;
+    }
+
+    return retVal;
+  }
+
+private:
+  dtkPointsAligned() : mPointsDirty(false) { mCurPos = 0; }
+
+  dtkPointsAligned(size_t size) : mPointsDirty(false) {
+    mCurPos = 0;
+    Resize(size);
+  }
+
+  dtkPointsAligned(const std::vector<GK::Point3> &coords)
+      : mPointsDirty(false) {
+    mCurPos = 0;
+    Resize(coords.size());
+    for (dtkID i = 0; i < coords.size(); i++)
+      SetCoord(i, coords[i].x(), coords[i].y(), coords[i].z());
+  }
+
+  void Resize(size_t size) {
+    SyncPoints();
+    mCoords.resize(size * 4, 0.0);
+    mPoints.resize(size, GK::Point3(0, 0, 0));
+  }
+
+private:
+  typedef std::vector<double, boost::alignment::aligned_allocator<double, 32>>
+      CoordVector;
+
+  CoordVector mCoords; /**< 坐标, 每个点 4 个 double */
+  mutable std::vector<GK::Point3> mPoints; /**< GetPoint 返回的坐标 */
+  mutable std::atomic<bool> mPointsDirty;  /**< mPoints 落后于 mCoords */
+  mutable boost::mutex mSyncMutex;
+
+  // MCurPos's value is modified all the time, even in a const member function.
+  mutable size_t mCurPos;
+};
+} // namespace dtk
+
+#endif /* SIMPLEPHYSICSENGINE_DTKPOINTSALIGNED_H */
@@ -68,6 +68,8 @@ public:
     mCoords.erase(mCoords.begin() + id);
   }
 
+  void Relocate() { std::vector<GK::Point3>(mCoords).swap(mCoords); }
+
   size_t GetNumberOfPoints() const { return mCoords.size(); }
 
   dtkID GetMaxID() const { return static_cast<dtkID>(mCoords.size() - 1); }
@@ -0,0 +1,72 @@
+
+/**
+ * @file dtkPrecision.h
+ * @brief dtkPrecision 头文件
+ * @author agent (agent@local)
+ * @version 1.0
+ * @date 2026-10-16
+ * @copyright MIT LICENSE
+ * https://github.com/Simple-XX/SimplePhysicsEngine
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-16<td>agent<td>创建文件
+ * </table>
+ */
+
+#ifndef SIMPLEPHYSICSENGINE_DTKPRECISION_H
+#define SIMPLEPHYSICSENGINE_DTKPRECISION_H
+
+#include <cmath>
+#include <limits>
+
+#include "dtkConfig.h"
+
+namespace dtk {
+/**
+ * @class <dtkPrecisionPolicy>
+ * @brief 批量数据的存储精度
+ * @author <>
+ * @note
+ * Storage 为弹簧参数, 暂存的质点状态与 k-DOP 区间的存储类型.
+ * Accum 为内核计算与归约累加使用的类型, 始终为 double.
+ * 存储为 float 时读入后提升为 double 计算, 写回时再截断.
+ */
+template <typename StorageType> struct dtkPrecisionPolicy {
+  typedef StorageType Storage; /**< 存储类型 */
+  typedef double Accum;        /**< 计算与累加类型 */
+
+  /**
+   * @brief		转换为不大于 value 的存储值
+   */
+  static Storage RoundDown(Accum value) {
+    Storage result = static_cast<Storage>(value);
+    if (result > value)
+      result = std::nextafter(result, -std::numeric_limits<Storage>::max());
+    return result;
+  }
+
+  /**
+   * @brief		转换为不小于 value 的存储值
+   */
+  static Storage RoundUp(Accum value) {
+    Storage result = static_cast<Storage>(value);
+    if (result < value)
+      result = std::nextafter(result, std::numeric_limits<Storage>::max());
+    return result;
+  }
+};
+
+typedef dtkPrecisionPolicy<double> dtkDoublePrecision; /**< 全部为 double */
+typedef dtkPrecisionPolicy<float> dtkMixedPrecision;   /**< float 存储 */
+
+#ifdef DTK_MIXED_PRECISION
+typedef dtkMixedPrecision dtkPhysPrecision;
+#else
+typedef dtkDoublePrecision dtkPhysPrecision;
+#endif
+
+typedef dtkPhysPrecision::Storage dtkReal; /**< 批量数据的存储类型 */
+} // namespace dtk
+
+#endif /* SIMPLEPHYSICSENGINE_DTKPRECISION_H */
@@ -0,0 +1,268 @@
+
+/**
+ * @file dtkTaskScheduler.h
+ * @brief dtkTaskScheduler 头文件
+ * @author agent (agent@local)
+ * @version 1.0
+ * @date 2026-10-16
+ * @copyright MIT LICENSE
+ * https://github.com/Simple-XX/SimplePhysicsEngine
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-16<td>agent<td>创建文件
+ * </table>
+ */
+
+#ifndef SIMPLEPHYSICSENGINE_DTKTASKSCHEDULER_H
+#define SIMPLEPHYSICSENGINE_DTKTASKSCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/utility.hpp>
+
+#include "dtkConfig.h"
+#include "dtkIDTypes.h"
+
+namespace dtk {
+/**
+ * @class <dtkTaskScheduler>
+ * @brief 带工作窃取的任务图调度器
+ * @author <>
+ * @note
+ * 任务之间的依赖由 AddDependency 显式给出, 前驱全部完成后任务才进入就绪队列.
+ * 每个工作线程拥有自己的双端队列, 从队尾取任务, 空闲时从其它线程的队头窃取.
+ * 任务图建立后可以反复 Run, 每次 Run 阻塞到全部任务完成.
+ * 每个任务的执行时间与每个线程的忙碌时间都会被记录, 供调用者调整首选线程.
+ * 任务内部可以用 ForkJoin 派生临时子任务, 等待期间当前线程继续执行其它任务.
+ * ForkJoinRange 按区间拆分, 子任务只引用调用者的函数对象, 稳态下不分配内存.
+ * 物理核心, 碰撞检测阶段与碰撞检测树共用一个调度器, 不再各自创建线程.
+ */
+class dtkTaskScheduler : public boost::noncopyable {
+public:
+  typedef std::shared_ptr<dtkTaskScheduler> Ptr;
+
+  typedef boost::function<void()> TaskFunction;
+
+  typedef boost::function<void(dtkID)> WorkerFunction;
+
+  static Ptr New(size_t numberOfThreads) {
+    return Ptr(new dtkTaskScheduler(numberOfThreads));
+  }
+
+public:
+  ~dtkTaskScheduler();
+
+  /**
+   * @brief 添加任务
+   * @param[in]	function : 任务函数
+   * @param[in]	worker : 首选的工作线程, 越界时按轮转分配
+   * @return 任务id
+   */
+  dtkID AddTask(const TaskFunction &function, dtkID worker = dtkErrorID);
+
+  /**
+   * @brief 添加依赖, after 必须在 before 完成后执行
+   * @param[in]	before : 前驱任务id
+   * @param[in]	after : 后继任务id
+   */
+  void AddDependency(dtkID before, dtkID after);
+
+  /**
+   * @brief 清空任务图
+   * @note 不能在 Run 期间调用
+   */
+  void ClearTasks();
+
+  /**
+   * @brief 执行一次任务图, 阻塞直到所有任务完成
+   */
+  void Run();
+
+  /**
+   * @brief 派生一组临时子任务并等待全部完成
+   * @param[in]	functions : 子任务函数
+   * @note
+   * 工作线程中调用时, 等待期间当前线程继续执行队列中的任务, 因此可以嵌套调用.
+   * 其它线程调用时子任务分发给工作线程, 与 Run 互斥, 调用者阻塞等待.
+   * 所有子系统共用同一组工作线程, 并发度不超过线程数.
+   */
+  void ForkJoin(const std::vector<TaskFunction> &functions);
+
+  /**
+   * @brief 把 [0, count) 按 grainSize 分块, 派生子任务并等待全部完成
+   * @param[in]	count : 元素数
+   * @param[in]	grainSize : 每块的元素数
+   * @param[in]	function : 以 (begin, end) 调用, 可以是 boost::bind 的结果
+   * @note
+   * 子任务只保存 function 的地址与区间, 不构造 TaskFunction,
+   * 队列容量稳定后不分配内存. 嵌套与并发规则与 ForkJoin 相同.
+   */
+  template <typename Function>
+  void ForkJoinRange(size_t count, size_t grainSize, const Function &function) {
+    ForkJoinItems(count, grainSize, &InvokeRange<Function>, &function, 0);
+  }
+
+  /**
+   * @brief 在每个工作线程上各执行一次函数, 阻塞直到全部完成
+   * @param[in]	function : 参数为工作线程id
+   * @note 不能在 Run 期间调用, 用于绑核与按线程首次写入内存
+   */
+  void RunOnEachWorker(const WorkerFunction &function);
+
+  /**
+   * @brief 把工作线程依次绑定到处理器核心
+   * @return 成功绑定的线程数, 不支持的平台返回 0
+   * @note 核心按 NUMA 节点排列, 相邻的工作线程优先落在同一节点上
+   */
+  size_t PinWorkers();
+
+  /**
+   * @brief 按 NUMA 节点排列的处理器编号
+   * @note 读取不到节点信息时按编号顺序返回全部处理器
+   */
+  static std::vector<dtkID> GetProcessorOrder();
+
+  /**
+   * @brief 当前线程是否为本调度器的工作线程
+   */
+  bool IsWorkerThread() const;
+
+  /**
+   * @brief 修改任务的首选工作线程, 下一次 Run 生效
+   * @param[in]	task : 任务id
+   * @param[in]	worker : 首选的工作线程, 越界时保持不变
+   */
+  void SetTaskWorker(dtkID task, dtkID worker);
+
+  dtkID GetTaskWorker(dtkID task) const;
+
+  /**
+   * @brief 任务的平滑执行时间
+   * @param[in]	task : 任务id
+   * @return 执行时间的指数滑动平均, 单位秒
+   */
+  double GetTaskCost(dtkID task) const;
+
+  /**
+   * @brief 上一次 Run 的负载不均衡度
+   * @return 最忙线程与平均忙碌时间之比, 1 表示完全均衡
+   */
+  double GetImbalanceRatio() const;
+
+  inline size_t GetNumberOfThreads() const { return mNumberOfThreads; }
+
+  inline size_t GetNumberOfTasks() const { return mTasks.size(); }
+
+private:
+  dtkTaskScheduler(size_t numberOfThreads);
+
+  /**
+   * @brief 工作线程主循环
+   * @param[in]	id : 工作线程id
+   */
+  void WorkerLoop(dtkID id);
+
+  struct Item;
+
+  bool Pop(dtkID id, Item &item);
+
+  bool Steal(dtkID id, Item &item);
+
+  void Push(dtkID id, const Item &item);
+
+  void Execute(dtkID id, const Item &item);
+
+  typedef void (*RangeInvoker)(const void *function, dtkID begin, dtkID end);
+
+  template <typename Function>
+  static void InvokeRange(const void *function, dtkID begin, dtkID end) {
+    (*static_cast<const Function *>(function))(begin, end);
+  }
+
+  /**
+   * @brief ForkJoin 与 ForkJoinRange 的公共部分
+   * @param[in]	count : 元素数, functions 非空时为函数个数
+   * @param[in]	grainSize : 每个子任务的元素数
+   * @param[in]	invoker : 区间函数的调用入口, functions 非空时不使用
+   * @param[in]	range : 区间函数
+   * @param[in]	functions : 非空时第 i 个子任务执行 functions[i]
+   */
+  void ForkJoinItems(size_t count, size_t grainSize, RangeInvoker invoker,
+                     const void *range, const TaskFunction *functions);
+
+  Item MakeItem(size_t count, size_t grainSize, RangeInvoker invoker,
+                const void *range, const TaskFunction *functions, dtkID i,
+                std::atomic<size_t> *remaining) const;
+
+private:
+  struct Task {
+    TaskFunction function;         /**< 任务函数 */
+    dtkID worker;                  /**< 首选工作线程 */
+    std::vector<dtkID> successors; /**< 后继任务 */
+    size_t numberOfPredecessors;   /**< 前驱任务数 */
+    std::atomic<size_t> pending;   /**< 本次 Run 中尚未完成的前驱数 */
+    double cost;                   /**< 执行时间的滑动平均, 单位秒 */
+  };
+
+  /**
+   * @brief 就绪队列中的一项, 任务图中的任务或 ForkJoin 的临时子任务
+   */
+  struct Item {
+    dtkID task;                     /**< 任务id, 临时子任务为 dtkErrorID */
+    const TaskFunction *function;   /**< 临时子任务的函数 */
+    std::atomic<size_t> *remaining; /**< 临时子任务所属组的未完成数 */
+    RangeInvoker invoker;           /**< 非空时以区间调用 range */
+    const void *range;              /**< ForkJoinRange 的区间函数 */
+    dtkID begin;                    /**< 区间起点 */
+    dtkID end;                      /**< 区间终点 */
+  };
+
+  /**
+   * @brief 工作线程的双端队列
+   * @note 环形缓冲, 预留初始容量, 只在装满时扩容, 入队出队不分配内存.
+   */
+  struct WorkerQueue {
+    boost::mutex mutex;
+    std::vector<Item> items; /**< 环形缓冲 */
+    size_t head;             /**< 队头位置 */
+    size_t size;             /**< 元素数 */
+
+    WorkerQueue() : head(0), size(0) {}
+
+    void PushBack(const Item &item);
+    Item PopBack();
+    Item PopFront();
+  };
+
+  size_t mNumberOfThreads; /**< 工作线程数 */
+
+  std::vector<Task *> mTasks;         /**< 任务图 */
+  std::vector<WorkerQueue *> mQueues; /**< 每个工作线程的就绪队列 */
+  std::vector<double> mBusyTimes;     /**< 本次 Run 中每个线程的忙碌时间 */
+
+  std::atomic<size_t> mRemaining; /**< 本次 Run 中尚未完成的任务数 */
+
+  /** RunOnEachWorker 的函数, 非空时工作线程离开任务循环 */
+  std::atomic<const WorkerFunction *> mWorkerFunction;
+
+  bool mLive;    /**< 析构时置 false, 结束工作线程 */
+  size_t mFrame; /**< Run 的次数, 用于唤醒工作线程 */
+
+  boost::mutex mRunMutex; /**< Run, RunOnEachWorker 与外部 ForkJoin 互斥 */
+  boost::mutex mStateMutex;
+  boost::condition_variable mWakeCondition; /**< 唤醒工作线程 */
+  boost::condition_variable mDoneCondition; /**< 通知 Run 已完成 */
+
+  boost::thread_group mThreadGroup;
+};
+} // namespace dtk
+
+#endif /* SIMPLEPHYSICSENGINE_DTKTASKSCHEDULER_H */
@@ -0,0 +1,301 @@
+
+/**
+ * @file allocation.cpp
+ * @brief 稳态更新的堆分配测试
+ * @author agent (agent@local)
+ * @version 1.0
+ * @date 2026-10-16
+ * @copyright MIT LICENSE
+ * https://github.com/Simple-XX/SimplePhysicsEngine
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-16<td>agent<td>创建文件
+ * </table>
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <boost/bind/bind.hpp>
+#include <dtkPhysCore.h>
+#include <dtkPhysMassSpring.h>
+#include <dtkTaskScheduler.h>
+#include <gtest/gtest.h>
+
+#include "cloth.h"
+
+// 替换全局分配器, 统计 operator new 与 operator new[] 的调用次数
+namespace {
+std::atomic<size_t> allocations(0);
+}
+
+void *operator new(size_t size) {
+  allocations++;
+  void *p = std::malloc(size > 0 ? size : 1);
+  if (p == 0)
+    throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+void *operator new[](size_t size) {
+  allocations++;
+  void *p = std::malloc(size > 0 ? size : 1);
+  if (p == 0)
+    throw std::bad_alloc();
+  return p;
+}
+
+void operator delete[](void *p) noexcept { std::free(p); }
+
+void operator delete[](void *p, size_t) noexcept { std::free(p); }
+
+namespace {
+using namespace boost::placeholders;
+
+const int kWidth = 16;
+const double kTimeslice = 0.001;
+const int kWarmUpFrames = 5;
+// 接触数在绳子落稳前会变化, 结果缓冲的容量需要更多帧才稳定
+const int kCoreWarmUpFrames = 50;
+const int kFrames = 20;
+
+// 第一行固定; 相邻两块布料的重合列互为 twin
+dtk::dtkPhysMassSpring::Ptr BuildCloth(double x0) {
+  Cloth cloth;
+  cloth.width = kWidth;
+  cloth.x0 = x0;
+  cloth.pointDamp = 0.999;
+  for (int x = 0; x < kWidth; x++)
+    cloth.pinned.push_back(x);
+  return cloth.Build();
+}
+
+struct Scene {
+  dtk::dtkPhysMassSpring::Ptr cloths[2];
+  std::vector<dtk::dtkPhysMassSpring *> connected;
+  dtk::ItrMethod method;
+  size_t frame;
+
+  explicit Scene(dtk::ItrMethod itrMethod) : method(itrMethod), frame(0) {
+    cloths[0] = BuildCloth(0);
+    cloths[1] = BuildCloth((kWidth - 1) * 0.1);
+    cloths[0]->FindTwins(cloths[1], 0.01);
+    connected.push_back(cloths[0].get());
+    connected.push_back(cloths[1].get());
+  }
+
+  // 与 dtkPhysCore 相同的两次迭代, 中间写入冲量代替碰撞响应.
+  // UpdateConnected 不含碰撞响应, 这里按 dtkPhysCore 的顺序逐步调用.
+  void StepCollision() {
+    for (int k = 0; k < 2; k++) {
+      cloths[k]->WakeDisturbed();
+      cloths[k]->PreUpdate(kTimeslice, dtk::Collision, 0);
+      cloths[k]->UpdateStrings(kTimeslice, dtk::Collision, 0, true);
+    }
+    for (int k = 0; k < 2; k++)
+      cloths[k]->ResolveTwinForces();
+    for (int k = 0; k < 2; k++) {
+      cloths[k]->TransportForce(kTimeslice);
+      cloths[k]->UpdateMassPoints(kTimeslice, dtk::Collision, 0);
+      cloths[k]->PostUpdate(dtk::Collision, 0);
+    }
+
+    cloths[0]->GetMassPoint(kWidth * kWidth - 1)->AddImpulse(
+        dtk::dtkT3<double>(0, 0.01, 0));
+    for (int k = 0; k < 2; k++)
+      cloths[k]->ResolveTwinImpulses();
+    for (int k = 0; k < 2; k++) {
+      cloths[k]->WakeDisturbed();
+      cloths[k]->ApplyImpulse(kTimeslice);
+      cloths[k]->PreUpdate(kTimeslice, dtk::Collision, 1);
+      cloths[k]->UpdateStrings(kTimeslice, dtk::Collision, 1, true);
+    }
+    for (int k = 0; k < 2; k++)
+      cloths[k]->ResolveTwinForces();
+    for (int k = 0; k < 2; k++) {
+      cloths[k]->UpdateMassPoints(kTimeslice, dtk::Collision, 1);
+      cloths[k]->PostUpdate(dtk::Collision, 1);
+      cloths[k]->UpdateSleeping();
+    }
+  }
+
+  void Step() {
+    if (method == dtk::Collision) {
+      StepCollision();
+    } else {
+      dtk::dtkPhysMassSpring::UpdateConnected(connected, kTimeslice, method);
+    }
+    frame++;
+  }
+};
+
+// 预热后每帧的分配次数之和
+size_t CountAllocations(Scene &scene,
+                        const dtk::dtkTaskScheduler::Ptr &scheduler) {
+  if (scheduler) {
+    // 在工作线程中更新, 对象内部才会并行.
+    scheduler->ClearTasks();
+    scheduler->AddTask(boost::bind(&Scene::Step, &scene));
+  }
+  size_t count = 0;
+  for (int frame = 0; frame < kWarmUpFrames + kFrames; frame++) {
+    size_t before = allocations;
+    if (scheduler)
+      scheduler->Run();
+    else
+      scene.Step();
+    if (frame >= kWarmUpFrames)
+      count += allocations - before;
+  }
+  return count;
+}
+
+void AddRange(std::atomic<size_t> *sum, dtk::dtkID begin, dtk::dtkID end) {
+  for (dtk::dtkID i = begin; i < end; i++)
+    (*sum) += i;
+}
+
+// 碰撞响应的回调, 累加每帧的接触数
+void CountContacts(dtk::dtkIntersectTest::IntersectResultView intersectResults,
+                   void *pContext) {
+  *static_cast<size_t *>(pContext) += intersectResults.size();
+}
+
+// 固定的三角形平板与落在上面的绳子, 绳子的线段与平板一直保持接触
+struct CoreScene {
+  dtk::dtkPhysCore::Ptr core;
+  size_t contacts;
+
+  explicit CoreScene(size_t numberOfThreads)
+      : core(dtk::dtkPhysCore::New()), contacts(0) {
+    if (numberOfThreads > 1)
+      core->SetNumberOfThreads(numberOfThreads);
+    // 按实测耗时重新分配线程是拓扑上的重新规划, 不属于稳态更新.
+    core->SetRebalanceThreshold(dtkDoubleMax);
+
+    std::string plate = ::testing::TempDir() + "allocation_plate.txt";
+    std::ofstream plateFile(plate.c_str());
+    plateFile << kWidth * kWidth << " " << kWidth * kWidth - 1 << "\n";
+    for (int i = 0; i < kWidth * kWidth; i++)
+      plateFile << i << " " << (i % kWidth) * 0.1 << " 0 "
+                << (i / kWidth) * 0.1 << "\n";
+    plateFile << (kWidth - 1) * (kWidth - 1) * 2 << "\n";
+    for (int y = 0; y + 1 < kWidth; y++) {
+      for (int x = 0; x + 1 < kWidth; x++) {
+        int i = y * kWidth + x;
+        plateFile << i << " " << i + kWidth << " " << i + 1 << "\n";
+        plateFile << i + 1 << " " << i + kWidth << " " << i + kWidth + 1
+                  << "\n";
+      }
+    }
+    plateFile.close();
+
+    std::string rope = ::testing::TempDir() + "allocation_rope.txt";
+    std::ofstream ropeFile(rope.c_str());
+    ropeFile << kWidth << " " << kWidth - 1 << "\n";
+    for (int i = 0; i < kWidth; i++)
+      ropeFile << i << " " << i * 0.1 << " 0.02 " << kWidth * 0.05 << "\n";
+    ropeFile << kWidth - 1 << "\n";
+    for (int i = 0; i + 1 < kWidth; i++)
+      ropeFile << i << " " << i + 1 << "\n";
+    ropeFile.close();
+
+    core->CreateTriangleMassSpring(plate.c_str(), 0, 1.0, 200, 0.5, 0.999, 0.0,
+                                   dtk::dtkT3<double>(0, 0, 0));
+    dtk::dtkPhysMassSpring::Ptr plateMassSpring = core->GetMassSpring(0);
+    for (dtk::dtkID i = 0; i < plateMassSpring->GetNumberOfMassPoints(); i++)
+      plateMassSpring->GetMassPoint(i)->SetActive(false);
+    core->CreateMassSpring(rope.c_str(), 1, 0.1, 200, 0.5, 0.999, 0.0,
+                           dtk::dtkT3<double>(0, -9.8, 0), 0.05);
+    core->CreateCollisionResponse(0, 1, 1000, &CountContacts, &contacts);
+  }
+};
+
+// 预热后每帧的分配次数之和, 同时统计这些帧的接触数
+size_t CountCoreAllocations(CoreScene &scene, size_t *contacts) {
+  size_t count = 0;
+  for (int frame = 0; frame < kCoreWarmUpFrames + kFrames; frame++) {
+    if (frame == kCoreWarmUpFrames)
+      scene.contacts = 0;
+    size_t before = allocations;
+    scene.core->Update(kTimeslice);
+    if (frame >= kCoreWarmUpFrames)
+      count += allocations - before;
+  }
+  *contacts = scene.contacts;
+  return count;
+}
+
+void NestedRange(const dtk::dtkTaskScheduler::Ptr *scheduler,
+                 std::atomic<size_t> *sum, dtk::dtkID begin, dtk::dtkID end) {
+  for (dtk::dtkID i = begin; i < end; i++)
+    (*scheduler)->ForkJoinRange(64, 8, boost::bind(&AddRange, sum, _1, _2));
+}
+} // namespace
+
+TEST(allocation, 调度器) {
+  dtk::dtkTaskScheduler::Ptr scheduler = dtk::dtkTaskScheduler::New(4);
+  std::atomic<size_t> sum(0);
+  size_t count = 0;
+  for (int frame = 0; frame < kWarmUpFrames + kFrames; frame++) {
+    size_t before = allocations;
+    scheduler->ForkJoinRange(1000, 7, boost::bind(&AddRange, &sum, _1, _2));
+    scheduler->ForkJoinRange(
+        16, 1, boost::bind(&NestedRange, &scheduler, &sum, _1, _2));
+    if (frame >= kWarmUpFrames)
+      count += allocations - before;
+  }
+  EXPECT_EQ(sum, size_t(kWarmUpFrames + kFrames) * (499500 + 16 * 2016));
+  EXPECT_EQ(count, 0u);
+}
+
+TEST(allocation, 单线程更新) {
+  const dtk::ItrMethod methods[] = {dtk::Collision, dtk::Euler, dtk::RK4,
+                                    dtk::Implicit, dtk::XPBD};
+  for (dtk::ItrMethod method : methods) {
+    Scene scene(method);
+    EXPECT_EQ(CountAllocations(scene, dtk::dtkTaskScheduler::Ptr()), 0u)
+        << "method " << method;
+  }
+}
+
+TEST(allocation, 并行更新) {
+  dtk::dtkTaskScheduler::Ptr scheduler = dtk::dtkTaskScheduler::New(4);
+  const dtk::dtkPhysMassSpring::ForceMode modes[] = {
+      dtk::dtkPhysMassSpring::ColoredForce,
+      dtk::dtkPhysMassSpring::BufferedForce,
+      dtk::dtkPhysMassSpring::GatherForce};
+  const dtk::ItrMethod methods[] = {dtk::Collision, dtk::Implicit, dtk::XPBD};
+  for (dtk::dtkPhysMassSpring::ForceMode mode : modes) {
+    for (dtk::ItrMethod method : methods) {
+      Scene scene(method);
+      for (int k = 0; k < 2; k++) {
+        scene.cloths[k]->SetTaskScheduler(scheduler);
+        scene.cloths[k]->SetForceMode(mode);
+        scene.cloths[k]->SetGrainSize(32);
+      }
+      EXPECT_EQ(CountAllocations(scene, scheduler), 0u)
+          << "mode " << mode << " method " << method;
+    }
+  }
+  scheduler->ClearTasks();
+}
+
+TEST(allocation, 带接触的核心更新) {
+  const size_t threads[] = {1, 4};
+  for (size_t n : threads) {
+    CoreScene scene(n);
+    size_t contacts = 0;
+    EXPECT_EQ(CountCoreAllocations(scene, &contacts), 0u) << "threads " << n;
+    EXPECT_GT(contacts, 0u) << "threads " << n;
+  }
+}
@@ -0,0 +1,87 @@
+
+/**
+ * @file cloth.h
+ * @brief 单元测试共用的方形布料
+ * @author agent (agent@local)
+ * @version 1.0
+ * @date 2026-10-16
+ * @copyright MIT LICENSE
+ * https://github.com/Simple-XX/SimplePhysicsEngine
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-16<td>agent<td>创建文件
+ * </table>
+ */
+
+#ifndef SIMPLEPHYSICSENGINE_TEST_CLOTH_H
+#define SIMPLEPHYSICSENGINE_TEST_CLOTH_H
+
+#include <cmath>
+#include <vector>
+
+#include <dtkPhysMassSpring.h>
+#include <dtkPointsVector.h>
+
+/**
+ * @brief y = 0 平面上的方形布料, 第 i 个质点位于第 i / width 行第 i % width 列
+ * @note 弹簧为相邻行列的结构弹簧与每格一根剪切弹簧.
+ */
+struct Cloth {
+  int width = 10;
+  double spacing = 0.1;
+  double x0 = 0;           /**< 第一列的 x 坐标 */
+  double mass = 1.0;       /**< 每个质点的质量 */
+  double stiffness = 200;  /**< 弹簧刚度 */
+  double damping = 0.5;    /**< 弹簧阻尼 */
+  double pointDamp = 1.0;  /**< 质点速度衰减 */
+  double gravity = -9.8;   /**< y 方向的重力加速度 */
+  std::vector<int> pinned; /**< 固定的质点 */
+
+  int GetNumberOfPoints() const { return width * width; }
+
+  dtk::dtkT3<double> Position(int i) const {
+    return dtk::dtkT3<double>(x0 + (i % width) * spacing, 0,
+                              (i / width) * spacing);
+  }
+
+  // 对每根弹簧调用 add(first, second, restLength)
+  template <typename AddSpring> void ForEachSpring(AddSpring add) const {
+    for (int y = 0; y < width; y++) {
+      for (int x = 0; x < width; x++) {
+        int i = y * width + x;
+        if (x + 1 < width)
+          add(i, i + 1, spacing);
+        if (y + 1 < width)
+          add(i, i + width, spacing);
+        if (x + 1 < width && y + 1 < width)
+          add(i, i + width + 1, spacing * std::sqrt(2.0));
+      }
+    }
+  }
+
+  dtk::dtkPhysMassSpring::Ptr Build() const {
+    dtk::dtkPoints::Ptr points =
+        dtk::dtkPointsVector::New(GetNumberOfPoints());
+    for (int i = 0; i < GetNumberOfPoints(); i++) {
+      dtk::dtkT3<double> p = Position(i);
+      points->SetPoint(i, dtk::GK::Point3(p.x, p.y, p.z));
+    }
+    dtk::dtkPhysMassSpring::Ptr cloth =
+        dtk::dtkPhysMassSpring::New(mass, stiffness, damping, pointDamp, 0.0);
+    cloth->SetPoints(points);
+    for (int i = 0; i < GetNumberOfPoints(); i++)
+      cloth->AddMassPoint(i, mass, dtk::dtkT3<double>(0, 0, 0), pointDamp,
+                          0.0, dtk::dtkT3<double>(0, gravity, 0));
+    // 剪切弹簧的静止长度由 AddSpring 按初始位置计算
+    dtk::dtkPhysMassSpring *target = cloth.get();
+    ForEachSpring([this, target](int i, int j, double) {
+      target->AddSpring(i, j, stiffness, damping);
+    });
+    for (int i : pinned)
+      cloth->GetMassPoint(i)->SetActive(false);
+    return cloth;
+  }
+};
+
+#endif /* SIMPLEPHYSICSENGINE_TEST_CLOTH_H */
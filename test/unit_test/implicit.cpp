@@ -0,0 +1,142 @@
+
+/**
+ * @file implicit.cpp
+ * @brief 隐式积分的稳定性与确定性测试
+ * @author agent (agent@local)
+ * @version 1.0
+ * @date 2026-10-16
+ * @copyright MIT LICENSE
+ * https://github.com/Simple-XX/SimplePhysicsEngine
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-16<td>agent<td>创建文件
+ * </table>
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include <boost/bind/bind.hpp>
+#include <dtkPhysMassSpring.h>
+#include <dtkTaskScheduler.h>
+#include <gtest/gtest.h>
+
+#include "cloth.h"
+
+namespace {
+const int kWidth = 20;
+const double kMass = 0.01;
+const double kStiffness = 2000;
+const double kSpacing = 0.05;
+const double kDuration = 1.0;
+const double kShortDuration = 0.2;
+
+// 第一行两端固定
+dtk::dtkPhysMassSpring::Ptr BuildCloth() {
+  Cloth cloth;
+  cloth.width = kWidth;
+  cloth.spacing = kSpacing;
+  cloth.mass = kMass;
+  cloth.stiffness = kStiffness;
+  cloth.damping = 5;
+  cloth.pinned = {0, kWidth - 1};
+  return cloth.Build();
+}
+
+struct Scene {
+  dtk::dtkPhysMassSpring::Ptr cloth;
+  double timeslice;
+  dtk::ItrMethod method;
+
+  Scene(double h, dtk::ItrMethod itrMethod)
+      : cloth(BuildCloth()), timeslice(h), method(itrMethod) {}
+
+  void Step() { cloth->Update(timeslice, method); }
+
+  // 布料已发散时返回无穷大
+  double MaxDistance() const {
+    double result = 0;
+    for (int i = 0; i < kWidth * kWidth; i++) {
+      const dtk::GK::Point3 &p = cloth->GetPoint(i);
+      for (int k = 0; k < 3; k++) {
+        if (!std::isfinite(p[k]))
+          return INFINITY;
+        result = std::max(result, std::fabs(p[k]));
+      }
+    }
+    return result;
+  }
+};
+
+// 模拟 duration 秒, 有调度器时在工作线程中更新, 对象内部才会并行
+void Simulate(Scene &scene, double duration,
+              const dtk::dtkTaskScheduler::Ptr &scheduler,
+              dtk::dtkPhysMassSpring::ForceMode mode =
+                  dtk::dtkPhysMassSpring::SerialForce) {
+  int steps = (int)std::lround(duration / scene.timeslice);
+  // 分块求和的顺序只取决于粒度, 串行与并行使用相同粒度
+  scene.cloth->SetGrainSize(32);
+  if (scheduler) {
+    scene.cloth->SetTaskScheduler(scheduler);
+    scene.cloth->SetForceMode(mode);
+    scheduler->ClearTasks();
+    scheduler->AddTask(boost::bind(&Scene::Step, &scene));
+  }
+  for (int i = 0; i < steps; i++) {
+    if (scheduler)
+      scheduler->Run();
+    else
+      scene.Step();
+  }
+  if (scheduler)
+    scheduler->ClearTasks();
+}
+} // namespace
+
+TEST(implicit, 显式发散隐式有界) {
+  const double timeslices[] = {5e-4, 2e-3, 1e-2};
+  for (double h : timeslices) {
+    Scene euler(h, dtk::Euler);
+    Simulate(euler, kDuration, dtk::dtkTaskScheduler::Ptr());
+    EXPECT_GT(euler.MaxDistance(), 1e3) << "h " << h;
+
+    Scene implicit(h, dtk::Implicit);
+    Simulate(implicit, kDuration, dtk::dtkTaskScheduler::Ptr());
+    // 布料边长 0.95, 下垂后仍应在几倍边长以内
+    EXPECT_LT(implicit.MaxDistance(), 5.0) << "h " << h;
+  }
+}
+
+// 同一累加方式下结果与线程数无关; 着色与按质点汇集的累加顺序不同于逐个弹簧,
+// 只有缓冲模式与单线程更新逐位一致
+TEST(implicit, 多线程结果一致) {
+  dtk::dtkTaskScheduler::Ptr single = dtk::dtkTaskScheduler::New(1);
+  dtk::dtkTaskScheduler::Ptr scheduler = dtk::dtkTaskScheduler::New(4);
+  const dtk::dtkPhysMassSpring::ForceMode modes[] = {
+      dtk::dtkPhysMassSpring::ColoredForce,
+      dtk::dtkPhysMassSpring::BufferedForce,
+      dtk::dtkPhysMassSpring::GatherForce};
+  const double timeslices[] = {2e-3, 1e-2};
+  for (double h : timeslices) {
+    Scene serial(h, dtk::Implicit);
+    Simulate(serial, kShortDuration, dtk::dtkTaskScheduler::Ptr());
+    for (dtk::dtkPhysMassSpring::ForceMode mode : modes) {
+      Scene one(h, dtk::Implicit);
+      Simulate(one, kShortDuration, single, mode);
+      Scene threaded(h, dtk::Implicit);
+      Simulate(threaded, kShortDuration, scheduler, mode);
+      for (int i = 0; i < kWidth * kWidth; i++) {
+        const dtk::GK::Point3 &a = one.cloth->GetPoint(i);
+        const dtk::GK::Point3 &b = threaded.cloth->GetPoint(i);
+        const dtk::GK::Point3 &c = serial.cloth->GetPoint(i);
+        for (int k = 0; k < 3; k++) {
+          ASSERT_EQ(a[k], b[k])
+              << "h " << h << " mode " << mode << " point " << i;
+          if (mode == dtk::dtkPhysMassSpring::BufferedForce)
+            ASSERT_EQ(c[k], b[k]) << "h " << h << " point " << i;
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,198 @@
+
+/**
+ * @file intersect.cpp
+ * @brief 相交测试结果与结果缓冲复用的测试
+ * @author agent (agent@local)
+ * @version 1.0
+ * @date 2026-10-16
+ * @copyright MIT LICENSE
+ * https://github.com/Simple-XX/SimplePhysicsEngine
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-16<td>agent<td>创建文件
+ * </table>
+ */
+
+#include <vector>
+
+#include <dtkCollisionDetectHierarchyKDOPS.h>
+#include <dtkCollisionDetectStage.h>
+#include <dtkIntersectTest.h>
+#include <dtkPointsVector.h>
+#include <gtest/gtest.h>
+
+namespace {
+const double kTolerance = 1e-9;
+const double kSegmentExtend = 0.1;
+
+typedef dtk::dtkIntersectTest::IntersectResult IntersectResult;
+
+/**
+ * y = 0 平面上的单位正方形, 两个三角形的法向都是 +y;
+ * 线段在三角形 0 的上方或穿过它, 与三角形 1 离得足够远.
+ */
+struct Scene {
+  dtk::dtkPoints::Ptr trianglePoints;
+  dtk::dtkPoints::Ptr segmentPoints;
+  dtk::dtkCollisionDetectHierarchy::Ptr triangles;
+  dtk::dtkCollisionDetectHierarchy::Ptr segments;
+  dtk::dtkCollisionDetectStage::Ptr stage;
+
+  Scene()
+      : trianglePoints(dtk::dtkPointsVector::New(4)),
+        segmentPoints(dtk::dtkPointsVector::New(2)),
+        triangles(dtk::dtkCollisionDetectHierarchyKDOPS::New(3)),
+        segments(dtk::dtkCollisionDetectHierarchyKDOPS::New(3)),
+        stage(dtk::dtkCollisionDetectStage::New()) {
+    trianglePoints->SetPoint(0, dtk::GK::Point3(0, 0, 0));
+    trianglePoints->SetPoint(1, dtk::GK::Point3(1, 0, 0));
+    trianglePoints->SetPoint(2, dtk::GK::Point3(0, 0, 1));
+    trianglePoints->SetPoint(3, dtk::GK::Point3(1, 0, 1));
+    const dtk::dtkID3 faces[] = {dtk::dtkID3(0, 2, 1), dtk::dtkID3(1, 2, 3)};
+    for (dtk::dtkID i = 0; i < 2; i++) {
+      dtk::dtkCollisionDetectPrimitive *primitive =
+          triangles->InsertTriangle(trianglePoints, faces[i]);
+      primitive->mMajorID = 0;
+      primitive->mMinorID = i;
+    }
+
+    MoveSegment(dtk::GK::Point3(0.1, 0.05, 0.2),
+                dtk::GK::Point3(0.3, 0.05, 0.2));
+    dtk::dtkCollisionDetectPrimitive *primitive =
+        segments->InsertSegment(segmentPoints, dtk::dtkID2(0, 1));
+    primitive->SetExtend(kSegmentExtend);
+    primitive->mMajorID = 1;
+    primitive->mMinorID = 0;
+
+    dtk::dtkCollisionDetectHierarchy::Ptr hierarchies[] = {triangles,
+                                                           segments};
+    for (dtk::dtkCollisionDetectHierarchy::Ptr hierarchy : hierarchies) {
+      hierarchy->AutoSetMaxLevel();
+      hierarchy->Build();
+      stage->AddHierarchy(hierarchy);
+    }
+  }
+
+  void MoveSegment(const dtk::GK::Point3 &p0, const dtk::GK::Point3 &p1) {
+    segmentPoints->SetPoint(0, p0);
+    segmentPoints->SetPoint(1, p1);
+  }
+
+  // 线段层在前, 检验结果中三角形总是 primitive_1
+  dtk::dtkCollisionDetectStage::HierarchyPair Pair() const {
+    return dtk::dtkCollisionDetectStage::HierarchyPair(segments, triangles);
+  }
+};
+
+void ExpectNear(const dtk::GK::Vector3 &actual, double x, double y, double z) {
+  EXPECT_NEAR(actual[0], x, kTolerance);
+  EXPECT_NEAR(actual[1], y, kTolerance);
+  EXPECT_NEAR(actual[2], z, kTolerance);
+}
+
+void ExpectNear(const dtk::dtkDouble3 &actual, double x, double y, double z) {
+  EXPECT_NEAR(actual[0], x, kTolerance);
+  EXPECT_NEAR(actual[1], y, kTolerance);
+  EXPECT_NEAR(actual[2], z, kTolerance);
+}
+
+// 线段在三角形 0 上方 0.05 处, 两端都在厚度之内
+void ExpectDistanceResult(Scene &scene, const IntersectResult &result) {
+  EXPECT_EQ(result.primitive_1, scene.triangles->GetPrimitive(0));
+  EXPECT_EQ(result.primitive_2, scene.segments->GetPrimitive(0));
+  EXPECT_EQ(result.primitive_1->GetType(),
+            dtk::dtkCollisionDetectPrimitive::TRIANGLE);
+  EXPECT_EQ(result.primitive_2->GetType(),
+            dtk::dtkCollisionDetectPrimitive::SEGMENT);
+  // 两端的穿透深度都是 0.1 - 0.05, 法向长度为两者之和
+  ExpectNear(result.normal, 0, 0.1, 0);
+  // 线段中点 (0.2, 0.2) 在三角形 (0, 2, 1) 上的重心坐标
+  ExpectNear(result.weight_1, 0.6, 0.2, 0.2);
+  ExpectNear(result.weight_2, 0.5, 0.5, 0);
+  EXPECT_FALSE(result.has_point);
+}
+} // namespace
+
+TEST(intersect, 带间隔的三角形与线段) {
+  Scene scene;
+  std::vector<IntersectResult> results;
+  scene.stage->DoIntersect(scene.Pair(), results, false, false);
+  ASSERT_EQ(results.size(), 1u);
+  ExpectDistanceResult(scene, results[0]);
+}
+
+TEST(intersect, 三角形与线段交于一点) {
+  Scene scene;
+  scene.MoveSegment(dtk::GK::Point3(0.25, -0.5, 0.25),
+                    dtk::GK::Point3(0.25, 0.5, 0.25));
+  scene.stage->Update();
+  std::vector<IntersectResult> results;
+  scene.stage->DoIntersect(scene.Pair(), results, false, true);
+  ASSERT_EQ(results.size(), 1u);
+  EXPECT_EQ(results[0].primitive_1, scene.triangles->GetPrimitive(0));
+  EXPECT_EQ(results[0].primitive_2, scene.segments->GetPrimitive(0));
+  ASSERT_TRUE(results[0].has_point);
+  EXPECT_NEAR(results[0].point.x(), 0.25, kTolerance);
+  EXPECT_NEAR(results[0].point.y(), 0, kTolerance);
+  EXPECT_NEAR(results[0].point.z(), 0.25, kTolerance);
+}
+
+TEST(intersect, 三角形与球) {
+  // 球的测试只检查法向 (0, 2, 1) 的反面一侧
+  dtk::GK::Triangle3 triangle(dtk::GK::Point3(0, 0, 0),
+                              dtk::GK::Point3(0, 0, 1),
+                              dtk::GK::Point3(1, 0, 0));
+  IntersectResult result;
+  result.has_point = true;
+  ASSERT_TRUE(dtk::dtkIntersectTest::DoDistanceIntersect(
+      triangle, dtk::GK::Sphere3(dtk::GK::Point3(0.2, -0.05, 0.2), 0.01), 0.1,
+      result));
+  // 图元由 dtkCollisionDetectBasic 填写, 单独测试时为空
+  EXPECT_EQ(result.primitive_1, (dtk::dtkCollisionDetectPrimitive *)0);
+  EXPECT_EQ(result.primitive_2, (dtk::dtkCollisionDetectPrimitive *)0);
+  ExpectNear(result.normal, 0, -0.05, 0);
+  ExpectNear(result.weight_1, 0.6, 0.2, 0.2);
+  ExpectNear(result.weight_2, 1, 0, 0);
+  // 每次命中都重新初始化, 不保留上一次的交点
+  EXPECT_FALSE(result.has_point);
+
+  EXPECT_FALSE(dtk::dtkIntersectTest::DoDistanceIntersect(
+      triangle, dtk::GK::Sphere3(dtk::GK::Point3(0.2, -0.2, 0.2), 0.01), 0.1,
+      result));
+}
+
+TEST(intersect, 结果缓冲跨帧复用) {
+  Scene scene;
+  std::vector<IntersectResult> results;
+  scene.stage->DoIntersect(scene.Pair(), results, false, false);
+  ASSERT_EQ(results.size(), 1u);
+  const IntersectResult *data = results.data();
+  size_t capacity = results.capacity();
+
+  for (int frame = 0; frame < 4; frame++) {
+    // 与 dtkPhysCore 一样每帧清空后重新填写, 容量保留
+    results.clear();
+    if (frame == 1)
+      scene.MoveSegment(dtk::GK::Point3(0.1, 0.5, 0.2),
+                        dtk::GK::Point3(0.3, 0.5, 0.2));
+    else
+      scene.MoveSegment(dtk::GK::Point3(0.1, 0.05, 0.2),
+                        dtk::GK::Point3(0.3, 0.05, 0.2));
+    scene.stage->Update();
+    scene.stage->DoIntersect(scene.Pair(), results, false, false);
+    if (frame == 1) {
+      EXPECT_TRUE(results.empty());
+    } else {
+      ASSERT_EQ(results.size(), 1u) << "frame " << frame;
+      ExpectDistanceResult(scene, results[0]);
+    }
+    EXPECT_EQ(results.data(), data) << "frame " << frame;
+    EXPECT_EQ(results.capacity(), capacity) << "frame " << frame;
+  }
+
+  // 不清空时追加在已有结果之后
+  scene.stage->DoIntersect(scene.Pair(), results, false, false);
+  ASSERT_EQ(results.size(), 2u);
+  ExpectDistanceResult(scene, results[1]);
+}
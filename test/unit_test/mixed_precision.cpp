@@ -0,0 +1,212 @@
+
+/**
+ * @file mixed_precision.cpp
+ * @brief 混合精度存储测试
+ * @author agent (agent@local)
+ * @version 1.0
+ * @date 2026-10-16
+ * @copyright MIT LICENSE
+ * https://github.com/Simple-XX/SimplePhysicsEngine
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-16<td>agent<td>创建文件
+ * </table>
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+#include <dtkCollisionDetectHierarchyKDOPS.h>
+#include <dtkCollisionDetectNodeKDOPS.h>
+#include <dtkPhysMassSpring.h>
+#include <dtkPhysSpring.h>
+#include <dtkPrecision.h>
+#include <gtest/gtest.h>
+
+#include "cloth.h"
+
+namespace {
+const int kWidth = 12;
+const int kPoints = kWidth * kWidth;
+
+Cloth Grid() {
+  Cloth cloth;
+  cloth.width = kWidth;
+  cloth.stiffness = 2000;
+  cloth.damping = 5;
+  return cloth;
+}
+
+// 布料的弹簧存储, 质点位置由调用者给出
+template <typename Precision>
+typename dtk::dtkPhysSpringStorageT<Precision>::Ptr BuildCloth() {
+  typename dtk::dtkPhysSpringStorageT<Precision>::Ptr springs =
+      dtk::dtkPhysSpringStorageT<Precision>::New();
+  const Cloth cloth = Grid();
+  dtk::dtkPhysSpringStorageT<Precision> *target = springs.get();
+  cloth.ForEachSpring([&cloth, target](int i, int j, double rest) {
+    target->AddSpring(i, j, rest, cloth.stiffness, cloth.damping);
+  });
+  return springs;
+}
+
+// 双精度构建中布料以 1 ms 步长运行 1 秒后采样点的坐标
+struct Sample {
+  dtk::ItrMethod method;
+  int point;
+  double x, y, z;
+};
+
+const Sample kDoubleTrajectory[] = {
+    {dtk::Collision, 17, 0.50077216004470548, -0.034363643902185548,
+     -0.095630999030863847},
+    {dtk::Collision, 78, 0.60685421738666701, -0.043443749000132752,
+     -0.56590763279814849},
+    {dtk::Collision, 143, 1.1176502049622015, -0.16872882112170354,
+     -1.0218080453582923},
+    {dtk::Implicit, 17, 0.50138210955901297, -0.047001411264430491,
+     -0.089777514080880402},
+    {dtk::Implicit, 78, 0.608978776762787, -0.063069882717676842,
+     -0.5773648424016965},
+    {dtk::Implicit, 143, 1.1190697014618192, -0.20563308936835345,
+     -1.037087767906427}};
+
+// 第一行固定的布料, 由 dtkPhysMassSpring 按构建选择的精度积分
+dtk::dtkPhysMassSpring::Ptr SimulateCloth(dtk::ItrMethod method) {
+  Cloth cloth = Grid();
+  for (int x = 0; x < kWidth; x++)
+    cloth.pinned.push_back(x);
+  dtk::dtkPhysMassSpring::Ptr massSpring = cloth.Build();
+  for (int step = 0; step < 1000; step++)
+    massSpring->Update(0.001, method);
+  return massSpring;
+}
+} // namespace
+
+TEST(mixed_precision, 保守舍入) {
+  const double values[] = {0.1, 1.0 / 3.0, -2.0 / 7.0, 1e10 + 1, 1.0};
+  for (double value : values) {
+    float down = dtk::dtkMixedPrecision::RoundDown(value);
+    float up = dtk::dtkMixedPrecision::RoundUp(value);
+    EXPECT_LE(down, value);
+    EXPECT_GE(up, value);
+    EXPECT_LE(std::nextafter(down, up), up);
+    EXPECT_EQ(dtk::dtkDoublePrecision::RoundDown(value), value);
+    EXPECT_EQ(dtk::dtkDoublePrecision::RoundUp(value), value);
+  }
+  // 可精确表示的值不扩大
+  EXPECT_EQ(dtk::dtkMixedPrecision::RoundDown(1.0), 1.0f);
+  EXPECT_EQ(dtk::dtkMixedPrecision::RoundUp(1.0), 1.0f);
+}
+
+TEST(mixed_precision, 弹簧力) {
+  typedef dtk::dtkPhysSpringStorageT<dtk::dtkDoublePrecision> DoubleStorage;
+  typedef dtk::dtkPhysSpringStorageT<dtk::dtkMixedPrecision> FloatStorage;
+  DoubleStorage::Ptr doubleSprings = BuildCloth<dtk::dtkDoublePrecision>();
+  FloatStorage::Ptr floatSprings = BuildCloth<dtk::dtkMixedPrecision>();
+  size_t numberOfSprings = doubleSprings->GetNumberOfSprings();
+
+  std::vector<double> doublePos[3], doubleVel[3], doubleForce[3];
+  std::vector<float> floatPos[3], floatVel[3], floatForce[3];
+  for (int k = 0; k < 3; k++) {
+    doublePos[k].resize(kPoints);
+    doubleVel[k].resize(kPoints);
+    doubleForce[k].resize(numberOfSprings);
+    floatForce[k].resize(numberOfSprings);
+    for (int i = 0; i < kPoints; i++) {
+      double offset = std::sin(i * 7.0 + k) * 0.02;
+      double base = k == 0 ? (i % kWidth) * 0.1
+                           : (k == 2 ? (i / kWidth) * 0.1 : 0.0);
+      doublePos[k][i] = base + offset;
+      doubleVel[k][i] = std::cos(i * 3.0 + k) * 0.5;
+    }
+    floatPos[k].assign(doublePos[k].begin(), doublePos[k].end());
+    floatVel[k].assign(doubleVel[k].begin(), doubleVel[k].end());
+  }
+
+  const double *dp[3] = {doublePos[0].data(), doublePos[1].data(),
+                         doublePos[2].data()};
+  const double *dv[3] = {doubleVel[0].data(), doubleVel[1].data(),
+                         doubleVel[2].data()};
+  double *df[3] = {doubleForce[0].data(), doubleForce[1].data(),
+                   doubleForce[2].data()};
+  const float *fp[3] = {floatPos[0].data(), floatPos[1].data(),
+                        floatPos[2].data()};
+  const float *fv[3] = {floatVel[0].data(), floatVel[1].data(),
+                        floatVel[2].data()};
+  float *ff[3] = {floatForce[0].data(), floatForce[1].data(),
+                  floatForce[2].data()};
+  doubleSprings->ComputeForces(0, dtk::dtkID(numberOfSprings), dp, dv, 0.001,
+                               df);
+  floatSprings->ComputeForces(0, dtk::dtkID(numberOfSprings), fp, fv, 0.001,
+                              ff);
+
+  double maxForce = 0;
+  for (int k = 0; k < 3; k++)
+    for (size_t s = 0; s < numberOfSprings; s++)
+      maxForce = std::max(maxForce, std::fabs(doubleForce[k][s]));
+  ASSERT_GT(maxForce, 0);
+  for (int k = 0; k < 3; k++)
+    for (size_t s = 0; s < numberOfSprings; s++)
+      EXPECT_NEAR(floatForce[k][s], doubleForce[k][s], maxForce * 1e-4);
+}
+
+TEST(mixed_precision, 引擎轨迹) {
+  // 持久状态始终为 double, float 暂存的量化误差约 1e-7, 1 秒内不应被放大;
+  // 双精度构建只允许编译器浮点收缩带来的差异
+  const bool mixed = std::is_same<dtk::dtkReal, float>::value;
+  const double tolerance = mixed ? 1e-5 : 1e-8;
+  for (dtk::ItrMethod method : {dtk::Collision, dtk::Implicit}) {
+    dtk::dtkPhysMassSpring::Ptr massSpring = SimulateCloth(method);
+    for (const Sample &sample : kDoubleTrajectory) {
+      if (sample.method != method)
+        continue;
+      const dtk::GK::Point3 &p = massSpring->GetPoint(sample.point);
+      EXPECT_NEAR(p[0], sample.x, tolerance)
+          << "method " << method << " point " << sample.point;
+      EXPECT_NEAR(p[1], sample.y, tolerance)
+          << "method " << method << " point " << sample.point;
+      EXPECT_NEAR(p[2], sample.z, tolerance)
+          << "method " << method << " point " << sample.point;
+    }
+  }
+}
+
+TEST(mixed_precision, 包围盒包含全部点) {
+  // 变形后的布料上建树, 区间按存储精度向外取整, 投影不会落在区间外
+  dtk::dtkPhysMassSpring::Ptr massSpring = SimulateCloth(dtk::Collision);
+  dtk::dtkPoints::Ptr points = massSpring->GetPoints();
+  dtk::dtkCollisionDetectHierarchyKDOPS::Ptr hierarchy =
+      dtk::dtkCollisionDetectHierarchyKDOPS::New(3);
+  for (int y = 0; y + 1 < kWidth; y++) {
+    for (int x = 0; x + 1 < kWidth; x++) {
+      int i = y * kWidth + x;
+      hierarchy->InsertTriangle(points,
+                                dtk::dtkID3(i, i + kWidth, i + 1));
+      hierarchy->InsertTriangle(points,
+                                dtk::dtkID3(i + 1, i + kWidth, i + kWidth + 1));
+    }
+  }
+  hierarchy->AutoSetMaxLevel();
+  hierarchy->Build();
+  // 再积分一段时间后刷新包围盒
+  for (int step = 0; step < 100; step++)
+    massSpring->Update(0.001, dtk::Collision);
+  hierarchy->Update();
+
+  const dtk::GK::KDOP &kdop =
+      static_cast<dtk::dtkCollisionDetectNodeKDOPS *>(hierarchy->GetRoot())
+          ->GetKDOP();
+  for (int i = 0; i < kPoints; i++) {
+    dtk::GK::Vector3 vec = points->GetPoint(i) - hierarchy->GetOrigin();
+    for (size_t k = 0; k < kdop.mHalfK; k++) {
+      double extend =
+          dtk::GK::DotProduct(vec, dtk::GK::KDOP::mPredefinedAxis[k]);
+      EXPECT_LE(kdop.mIntervals[k].mLower, extend) << "point " << i;
+      EXPECT_GE(kdop.mIntervals[k].mUpper, extend) << "point " << i;
+    }
+  }
+}
@@ -0,0 +1,177 @@
+
+/**
+ * @file position_solver.cpp
+ * @brief 基于位置的约束求解器测试
+ * @author agent (agent@local)
+ * @version 1.0
+ * @date 2026-10-16
+ * @copyright MIT LICENSE
+ * https://github.com/Simple-XX/SimplePhysicsEngine
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-16<td>agent<td>创建文件
+ * </table>
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include <dtkPhysPositionSolver.h>
+#include <dtkPointsVector.h>
+#include <dtkTaskScheduler.h>
+#include <gtest/gtest.h>
+
+#include "cloth.h"
+
+namespace {
+const int kWidth = 8;
+const double kSpacing = 0.1;
+const double kTimeslice = 0.01;
+const size_t kGrainSize = 16;
+
+const int kPoints = kWidth * kWidth + kWidth;
+
+Cloth Grid() {
+  Cloth cloth;
+  cloth.width = kWidth;
+  cloth.spacing = kSpacing;
+  return cloth;
+}
+
+// 静止位置: 方形布料, 最后两行之间的下方再放一排点
+dtk::dtkT3<double> RestPosition(int i) {
+  if (i >= kWidth * kWidth)
+    return dtk::dtkT3<double>((i % kWidth + 0.5) * kSpacing, -kSpacing,
+                              (kWidth - 1.5) * kSpacing);
+  return Grid().Position(i);
+}
+
+// 最后两行的一个三角形与其下方一点组成的四面体, 相邻四面体共享质点
+dtk::dtkID4 Tetrahedron(int x) {
+  int row = (kWidth - 1) * kWidth;
+  return dtk::dtkID4(row + x, row + x + 1, row - kWidth + x,
+                     kWidth * kWidth + x);
+}
+
+double Volume(const dtk::dtkT3<double> p[4]) {
+  return dot(cross(p[1] - p[0], p[2] - p[0]), p[3] - p[0]) / 6.0;
+}
+
+double RestVolume(const dtk::dtkID4 &ids) {
+  dtk::dtkT3<double> p[4];
+  for (int k = 0; k < 4; k++)
+    p[k] = RestPosition(ids[k]);
+  return Volume(p);
+}
+
+// 布料的结构与剪切弹簧作为距离约束, 四面体作为体积约束, 约束之间共享质点
+struct Scene {
+  dtk::dtkPoints::Ptr points;
+  dtk::dtkPhysMassPointStorage::Ptr storage;
+  dtk::dtkPhysSpringStorage::Ptr springs;
+  dtk::dtkPhysPositionSolver::Ptr solver;
+
+  // stretch 为初始坐标相对静止位置的缩放, 各质点再加一个确定的扰动
+  Scene(double stretch, double stiffness, const dtk::dtkDouble3 &gravity)
+      : points(dtk::dtkPointsVector::New(kPoints)),
+        storage(dtk::dtkPhysMassPointStorage::New(points)),
+        springs(dtk::dtkPhysSpringStorage::New()),
+        solver(dtk::dtkPhysPositionSolver::New()) {
+    for (int i = 0; i < kPoints; i++) {
+      dtk::dtkT3<double> p = RestPosition(i) * stretch;
+      double jitter = 0.01 * kSpacing * ((i * 7) % 5 - 2);
+      points->SetPoint(i, dtk::GK::Point3(p.x + jitter, p.y, p.z - jitter));
+      storage->AddPoint(i, 0.01, dtk::dtkT3<double>(0, 0, 0), 1.0, 0.0,
+                        gravity);
+    }
+    dtk::dtkPhysSpringStorage *target = springs.get();
+    Grid().ForEachSpring([target, stiffness](int i, int j, double rest) {
+      target->AddSpring(i, j, rest, stiffness, 0);
+    });
+    for (int x = 0; x + 1 < kWidth; x++)
+      solver->AddVolume(Tetrahedron(x), RestVolume(Tetrahedron(x)));
+    solver->BuildStructure(storage->GetNumberOfPoints(), *springs);
+  }
+
+  double CurrentVolume(int x) const {
+    dtk::dtkID4 ids = Tetrahedron(x);
+    dtk::dtkT3<double> p[4];
+    for (int k = 0; k < 4; k++)
+      p[k] = storage->LoadPosition(ids[k]);
+    return Volume(p);
+  }
+
+  // 距离约束的最大相对误差
+  double MaxStretch() const {
+    double result = 0;
+    for (dtk::dtkID s = 0; s < springs->GetNumberOfSprings(); s++) {
+      dtk::dtkT3<double> a = storage->LoadPosition(springs->mEnds[s * 2]);
+      dtk::dtkT3<double> b = storage->LoadPosition(springs->mEnds[s * 2 + 1]);
+      double rest = springs->mOriLength[s];
+      result = std::max(result, std::fabs(length(b - a) - rest) / rest);
+    }
+    return result;
+  }
+
+  void Simulate(int frames, dtk::dtkTaskScheduler *scheduler) {
+    for (int i = 0; i < frames; i++)
+      solver->Solve(*storage, *springs, kTimeslice, scheduler, kGrainSize);
+  }
+};
+} // namespace
+
+TEST(position_solver, 约束收敛) {
+  const dtk::dtkPhysPositionSolver::SolveMode modes[] = {
+      dtk::dtkPhysPositionSolver::ColoredSolve,
+      dtk::dtkPhysPositionSolver::JacobiSolve};
+  // Jacobi 每次迭代只传播一层, 需要更多迭代
+  const size_t iterations[] = {200, 1000};
+  for (dtk::dtkPhysPositionSolver::SolveMode mode : modes) {
+    // 拉伸 5% 且几乎不可伸长, 无外力; 一帧之内的迭代应使约束全部满足
+    Scene scene(1.05, 1e9, dtk::dtkT3<double>(0, 0, 0));
+    scene.solver->SetSolveMode(mode);
+    scene.solver->SetIterations(iterations[mode]);
+    scene.solver->SetVolumeCompliance(0);
+    EXPECT_GT(scene.MaxStretch(), 0.04);
+    scene.Simulate(1, 0);
+    EXPECT_LT(scene.MaxStretch(), 1e-3) << "mode " << mode;
+    for (int x = 0; x + 1 < kWidth; x++) {
+      double rest = RestVolume(Tetrahedron(x));
+      EXPECT_NEAR(scene.CurrentVolume(x), rest, std::fabs(rest) * 1e-3)
+          << "mode " << mode << " volume " << x;
+    }
+  }
+}
+
+TEST(position_solver, 多线程结果一致) {
+  dtk::dtkTaskScheduler::Ptr scheduler = dtk::dtkTaskScheduler::New(4);
+  const dtk::dtkPhysPositionSolver::SolveMode modes[] = {
+      dtk::dtkPhysPositionSolver::ColoredSolve,
+      dtk::dtkPhysPositionSolver::JacobiSolve};
+  for (dtk::dtkPhysPositionSolver::SolveMode mode : modes) {
+    Scene serial(1.05, 2000, dtk::dtkT3<double>(0, -9.8, 0));
+    Scene threaded(1.05, 2000, dtk::dtkT3<double>(0, -9.8, 0));
+    Scene *scenes[] = {&serial, &threaded};
+    for (Scene *scene : scenes) {
+      scene->solver->SetSolveMode(mode);
+      scene->solver->SetVolumeCompliance(1e-6);
+      scene->storage->SetActive(0, false);
+      scene->storage->SetActive(kWidth - 1, false);
+    }
+    serial.Simulate(30, 0);
+    threaded.Simulate(30, scheduler.get());
+    for (dtk::dtkID i = 0; i < serial.storage->GetNumberOfPoints(); i++) {
+      dtk::dtkT3<double> a = serial.storage->LoadPosition(i);
+      dtk::dtkT3<double> b = threaded.storage->LoadPosition(i);
+      dtk::dtkT3<double> va = serial.storage->mVel[i];
+      dtk::dtkT3<double> vb = threaded.storage->mVel[i];
+      ASSERT_EQ(a.x, b.x) << "mode " << mode << " point " << i;
+      ASSERT_EQ(a.y, b.y) << "mode " << mode << " point " << i;
+      ASSERT_EQ(a.z, b.z) << "mode " << mode << " point " << i;
+      ASSERT_EQ(va.x, vb.x) << "mode " << mode << " point " << i;
+      ASSERT_EQ(va.y, vb.y) << "mode " << mode << " point " << i;
+      ASSERT_EQ(va.z, vb.z) << "mode " << mode << " point " << i;
+    }
+  }
+}
@@ -0,0 +1,225 @@
+
+/**
+ * @file twins.cpp
+ * @brief FindTwins 的网格查找测试
+ * @author agent (agent@local)
+ * @version 1.0
+ * @date 2026-10-16
+ * @copyright MIT LICENSE
+ * https://github.com/Simple-XX/SimplePhysicsEngine
+ * @par change log:
+ * <table>
+ * <tr><th>Date<th>Author<th>Description
+ * <tr><td>2026-10-16<td>agent<td>创建文件
+ * </table>
+ */
+
+#include <map>
+#include <vector>
+
+#include <dtkPhysMassSpring.h>
+#include <dtkPointsVector.h>
+#include <dtkTaskScheduler.h>
+#include <gtest/gtest.h>
+
+#include "cloth.h"
+
+namespace {
+typedef std::vector<dtk::dtkT3<double>> Positions;
+
+dtk::dtkPhysMassSpring::Ptr BuildPoints(const Positions &positions) {
+  dtk::dtkPoints::Ptr points = dtk::dtkPointsVector::New(positions.size());
+  for (size_t i = 0; i < positions.size(); i++)
+    points->SetPoint(i, dtk::GK::Point3(positions[i].x, positions[i].y,
+                                        positions[i].z));
+  dtk::dtkPhysMassSpring::Ptr ms = dtk::dtkPhysMassSpring::New();
+  ms->SetPoints(points);
+  for (size_t i = 0; i < positions.size(); i++)
+    ms->AddMassPoint(i);
+  return ms;
+}
+
+// 原先的逐对比较, taken 为已有 twin 的被搜索质点
+std::vector<dtk::dtkID> BruteForce(const Positions &positions,
+                                   const Positions &candidates,
+                                   std::vector<bool> taken, double distance) {
+  std::vector<dtk::dtkID> result(positions.size(), dtk::dtkErrorID);
+  for (size_t i = 0; i < positions.size(); i++) {
+    double minDistance = dtkDoubleMax;
+    dtk::dtkID minDistanceID = 0;
+    for (size_t j = 0; j < candidates.size(); j++) {
+      if (taken[j])
+        continue;
+      double tempDistance = length(positions[i] - candidates[j]);
+      if (tempDistance < minDistance) {
+        minDistance = tempDistance;
+        minDistanceID = j;
+      }
+    }
+    if (minDistance < distance) {
+      result[i] = minDistanceID;
+      taken[minDistanceID] = true;
+    }
+  }
+  return result;
+}
+
+// 每个质点在另一个对象中的 twin, 没有时为 dtkErrorID
+std::vector<dtk::dtkID> Twins(const dtk::dtkPhysMassSpring::Ptr &ms,
+                              const dtk::dtkPhysMassSpring::Ptr &other) {
+  std::map<dtk::dtkPhysMassPoint *, dtk::dtkID> ids;
+  for (dtk::dtkID j = 0; j < other->GetNumberOfMassPoints(); j++)
+    ids[other->GetMassPoint(j)] = j;
+  std::vector<dtk::dtkID> result(ms->GetNumberOfMassPoints(), dtk::dtkErrorID);
+  for (dtk::dtkID i = 0; i < ms->GetNumberOfMassPoints(); i++) {
+    dtk::dtkPhysMassPoint *point = ms->GetMassPoint(i);
+    if (!point->HasTwin())
+      continue;
+    const std::vector<dtk::dtkPhysMassPoint *> &members =
+        point->GetTwinCluster()->GetMembers();
+    EXPECT_EQ(members.size(), 2u) << "point " << i;
+    for (size_t k = 0; k < members.size(); k++) {
+      if (ids.count(members[k]))
+        result[i] = ids[members[k]];
+    }
+  }
+  return result;
+}
+
+// 用网格查找并与逐对比较对照, 被搜索对象中 taken 的质点预先与额外的点结成 twin
+void Check(const Positions &positions, const Positions &candidates,
+           const std::vector<bool> &taken, double distance,
+           const dtk::dtkTaskScheduler::Ptr &scheduler) {
+  dtk::dtkPhysMassSpring::Ptr ms = BuildPoints(positions);
+  dtk::dtkPhysMassSpring::Ptr other = BuildPoints(candidates);
+  dtk::dtkPhysMassSpring::Ptr holder =
+      BuildPoints(Positions(candidates.size(), dtk::dtkT3<double>(0, 0, 0)));
+  for (size_t j = 0; j < candidates.size(); j++) {
+    if (taken[j])
+      holder->GetMassPoint(j)->AddTwin(other->GetMassPoint(j));
+  }
+  if (scheduler) {
+    ms->SetTaskScheduler(scheduler);
+    ms->SetGrainSize(8);
+  }
+
+  std::vector<dtk::dtkID> expected =
+      BruteForce(positions, candidates, taken, distance);
+  size_t count = 0;
+  for (size_t i = 0; i < expected.size(); i++)
+    count += expected[i] != dtk::dtkErrorID;
+  EXPECT_EQ(ms->FindTwins(other, distance), count);
+  std::vector<dtk::dtkID> twins = Twins(ms, other);
+  for (size_t i = 0; i < expected.size(); i++)
+    EXPECT_EQ(twins[i], expected[i]) << "point " << i;
+}
+
+// 格子边长与 FindTwins 相同, 坐标取格子边长的整数倍时正好落在格子边界上
+double CellSize(double distance) { return distance * 1.000001; }
+
+// 确定的伪随机数, 坐标量化到步长的整数倍, 使等距的情况大量出现
+double Quantized(unsigned &seed, int range, double step) {
+  seed = seed * 1103515245u + 12345u;
+  return int((seed >> 16) % range) * step;
+}
+} // namespace
+
+TEST(twins, 等距取下标小的) {
+  // 被搜索的点在整数坐标上, 本对象的点在两点连线中点或四点中心
+  Positions candidates, positions;
+  for (int y = 0; y < 4; y++)
+    for (int x = 0; x < 4; x++)
+      candidates.push_back(dtk::dtkT3<double>(x, y, 0));
+  for (int y = 0; y < 3; y++) {
+    for (int x = 0; x < 3; x++) {
+      positions.push_back(dtk::dtkT3<double>(x + 0.5, y, 0));
+      positions.push_back(dtk::dtkT3<double>(x + 0.5, y + 0.5, 0));
+    }
+  }
+  std::vector<bool> taken(candidates.size(), false);
+  Check(positions, candidates, taken, 0.6, dtk::dtkTaskScheduler::Ptr());
+  Check(positions, candidates, taken, 0.75, dtk::dtkTaskScheduler::Ptr());
+  // 正好等于搜索距离的不算
+  Check(positions, candidates, taken, 0.5, dtk::dtkTaskScheduler::Ptr());
+}
+
+TEST(twins, 格子边界) {
+  const double distance = 0.3;
+  const double cell = CellSize(distance);
+  Positions candidates, positions;
+  for (int x = -3; x <= 3; x++) {
+    // 被搜索的点正好在格子边界上, 本对象的点在边界两侧
+    candidates.push_back(dtk::dtkT3<double>(x * cell, 0, 0));
+    candidates.push_back(dtk::dtkT3<double>(x * cell, x * cell, -x * cell));
+    positions.push_back(dtk::dtkT3<double>(x * cell - distance * 0.999, 0, 0));
+    positions.push_back(dtk::dtkT3<double>(x * cell + distance * 0.5, 0, 0));
+    positions.push_back(
+        dtk::dtkT3<double>(x * cell, x * cell + distance * 0.999, -x * cell));
+  }
+  std::vector<bool> taken(candidates.size(), false);
+  Check(positions, candidates, taken, distance, dtk::dtkTaskScheduler::Ptr());
+  // 本对象的点也在边界上, 与被搜索的点相隔一个格子, 两侧等距
+  Positions shifted(candidates);
+  for (size_t i = 0; i < shifted.size(); i++)
+    shifted[i].x += cell;
+  Check(shifted, candidates, taken, cell, dtk::dtkTaskScheduler::Ptr());
+  Check(shifted, candidates, taken, cell * 1.5, dtk::dtkTaskScheduler::Ptr());
+}
+
+TEST(twins, 随机点) {
+  dtk::dtkTaskScheduler::Ptr scheduler = dtk::dtkTaskScheduler::New(4);
+  const double distance = 0.25;
+  // 粗的步长使等距大量出现, 细的步长使距离接近搜索距离的点对跨过格子
+  const int ranges[] = {40, 100000};
+  const double steps[] = {0.05, 0.00005};
+  unsigned seed = 1;
+  for (int round = 0; round < 16; round++) {
+    int range = ranges[round % 2];
+    double step = steps[round % 2];
+    Positions positions(200), candidates(300);
+    for (size_t i = 0; i < positions.size(); i++)
+      positions[i] = dtk::dtkT3<double>(Quantized(seed, range, step),
+                                        Quantized(seed, range, step),
+                                        Quantized(seed, range / 5, step));
+    for (size_t j = 0; j < candidates.size(); j++)
+      candidates[j] = dtk::dtkT3<double>(Quantized(seed, range, step),
+                                         Quantized(seed, range, step),
+                                         Quantized(seed, range / 5, step));
+    std::vector<bool> taken(candidates.size(), false);
+    for (size_t j = round; j < candidates.size(); j += 9)
+      taken[j] = true;
+    Check(positions, candidates, taken, distance,
+          dtk::dtkTaskScheduler::Ptr());
+    Check(positions, candidates, taken, distance, scheduler);
+  }
+}
+
+TEST(twins, 相连对象一起更新) {
+  // 两块布料的重合列互为 twin, 质量相同, 按合外力积分后应始终重合
+  const int width = 6;
+  const dtk::ItrMethod methods[] = {dtk::Euler, dtk::Mid, dtk::RK4};
+  for (dtk::ItrMethod method : methods) {
+    Cloth cloth;
+    cloth.width = width;
+    for (int x = 0; x < width; x++)
+      cloth.pinned.push_back(x);
+    dtk::dtkPhysMassSpring::Ptr left = cloth.Build();
+    cloth.x0 = (width - 1) * cloth.spacing;
+    dtk::dtkPhysMassSpring::Ptr right = cloth.Build();
+    ASSERT_EQ(left->FindTwins(right, 0.01), size_t(width));
+
+    std::vector<dtk::dtkPhysMassSpring *> connected;
+    connected.push_back(left.get());
+    connected.push_back(right.get());
+    for (int frame = 0; frame < 200; frame++)
+      dtk::dtkPhysMassSpring::UpdateConnected(connected, 0.001, method);
+    for (int y = 1; y < width; y++) {
+      const dtk::GK::Point3 &a = left->GetPoint(y * width + width - 1);
+      const dtk::GK::Point3 &b = right->GetPoint(y * width);
+      // 布料在重力下已经下垂
+      EXPECT_LT(a[1], -1e-3) << "method " << method << " row " << y;
+      for (int k = 0; k < 3; k++)
+        EXPECT_EQ(a[k], b[k]) << "method " << method << " row " << y;
+    }
+  }
+}